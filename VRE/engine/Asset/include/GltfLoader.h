@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <MeshCooker.h>
+#include <MeshFile.h>
+#include <ThreadPool.h>
+#include <VirtualFileSystem.h>
+#include <glm/glm.hpp>
+
+namespace VRE
+{
+	struct GltfPrimitive
+	{
+		//Emptied once the primitive is cooked
+		SourceMesh Mesh;
+		//Set when GltfLoadSettings::Cook is and the primitive has triangles
+		std::shared_ptr<MeshFile> Cooked;
+		//-1 without a material
+		int32_t Material = -1;
+	};
+
+	struct GltfMesh
+	{
+		std::string Name;
+		std::vector<GltfPrimitive> Primitives;
+	};
+
+	struct GltfNode
+	{
+		std::string Name;
+		int32_t Mesh = -1;
+		int32_t Parent = -1;
+		glm::mat4 LocalTransform = glm::mat4(1.0f);
+		//Only filled for nodes in the scene
+		glm::mat4 WorldTransform = glm::mat4(1.0f);
+		//Reachable from the scene's roots, nodes outside the default scene are loaded but not placed
+		bool bInScene = false;
+	};
+
+	struct GltfImage
+	{
+		std::string Name;
+		std::string MimeType;
+		//Still encoded: PNG, JPEG or KTX2
+		std::vector<std::byte> Data;
+	};
+
+	struct GltfScene
+	{
+		std::vector<GltfMesh> Meshes;
+		std::vector<GltfNode> Nodes;
+		std::vector<GltfImage> Images;
+		std::vector<uint32_t> RootNodes;
+	};
+
+	//Reads the glTF file itself and every external buffer and image, nullopt if the file is missing
+	using GltfFileLoader = std::function<std::optional<FileData>(const std::string& path)>;
+
+	struct GltfLoadSettings
+	{
+		//Cooks every primitive into an in memory .vmesh on the worker that decoded it
+		std::optional<MeshCookSettings> Cook;
+		bool bLoadImages = true;
+	};
+
+	// glTF 2.0 import, .gltf with external or data URI buffers and binary .glb. The JSON is parsed on the calling
+	// thread, then buffers, and after them images and mesh primitives, are decoded as independent tasks on pool, and
+	// node transforms are resolved in one pass over the hierarchy. Without a pool, or when the caller is itself a
+	// worker of it, pass nullptr and everything runs inline. Throws std::runtime_error on malformed files and on
+	// required extensions that aren't supported.
+	GltfScene LoadGltf(const std::string& path, const GltfFileLoader& fileLoader, const GltfLoadSettings& settings = {}, ThreadPool* pool = nullptr);
+	//Loads through the engine's virtual file system
+	GltfScene LoadGltf(const std::string& path, const GltfLoadSettings& settings = {}, ThreadPool* pool = nullptr);
+
+	//Relative URIs of the external files a .gltf or .glb references, e.g. to hash them along with it
+	std::vector<std::string> GetGltfDependencies(std::span<const std::byte> bytes);
+
+	//Every primitive of every node reachable from the roots in world space, merged into one mesh like an OBJ import
+	SourceMesh FlattenGltfScene(const GltfScene& scene);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <MeshFile.h>
+#include <MeshOptimizer.h>
+#include <glm/glm.hpp>
+
+namespace VRE
+{
+	// Mesh as imported from a source format, one vertex per unique attribute combination
+	struct SourceMesh
+	{
+		std::vector<glm::vec3> Positions;
+		//Optional, generated from the triangles when empty
+		std::vector<glm::vec3> Normals;
+		//Optional
+		std::vector<glm::vec2> TexCoords;
+		std::vector<uint32_t> Indices;
+	};
+
+	struct MeshCookSettings
+	{
+		MeshVertexLayout VertexLayout = MeshVertexLayout::Interleaved;
+		MeshVertexFormat VertexFormat = MeshVertexFormat::Quantized;
+		//Including the full detail LOD, generation stops early once simplification stalls
+		uint32_t MaxLodCount = 4;
+		//Each LOD aims for this fraction of the previous one's triangles
+		float LodReduction = 0.5f;
+		uint32_t MaxMeshletVertices = 64;
+		uint32_t MaxMeshletTriangles = 124;
+		//Vertex cache, overdraw and vertex fetch ordering, see MeshOptimizer.h
+		bool bOptimize = true;
+		//How much vertex cache efficiency overdraw ordering may give up, 1 keeps the cache order as it is
+		float OverdrawThreshold = 1.05f;
+	};
+
+	//Vertex cache behaviour of the full detail LOD as imported and as cooked
+	struct MeshCookStatistics
+	{
+		VertexCacheStatistics Before;
+		VertexCacheStatistics After;
+	};
+
+	//Octahedral mapping of a unit vector onto [-1, 1]^2, as stored by MeshVertexFormat::Quantized
+	glm::vec2 EncodeOctahedral(const glm::vec3& normal);
+	glm::vec3 DecodeOctahedral(const glm::vec2& encoded);
+
+	//Covers everything in settings that changes the output, seeds the source content hash
+	uint64_t HashCookSettings(const MeshCookSettings& settings);
+
+	// Builds a complete .vmesh file: GPU vertex layout, LODs by vertex clustering sharing one vertex buffer, and
+	// meshlets for every LOD. Throws on meshes that reference vertices they don't have.
+	std::vector<std::byte> CookMesh(const SourceMesh& mesh, const MeshCookSettings& settings, uint64_t sourceHash,
+		MeshCookStatistics* statistics = nullptr);
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <VirtualFileSystem.h>
+
+namespace VRE
+{
+	// Cooked mesh (.vmesh) written by vre_cook. Every section is already in the layout the GPU consumes and 16 byte
+	// aligned in the file, so loading is a memory mapping plus copies into staging memory, nothing is parsed or
+	// converted. All LODs share the vertex data and index into it.
+	constexpr uint32_t k_MeshMagic = 0x4853454D; // "MESH"
+	//Bump whenever the layout or the cooker output changes, older files are recooked
+	constexpr uint32_t k_MeshVersion = 4;
+	constexpr uint32_t k_MeshSectionAlignment = 16;
+
+	enum class MeshVertexLayout : uint32_t
+	{
+		//One MeshVertex stream
+		Interleaved = 0,
+		//Positions first, then the remaining attributes as a second stream, for depth only passes
+		Streamed = 1
+	};
+
+	enum class MeshVertexFormat : uint32_t
+	{
+		//32-bit floats, MeshVertex or MeshVertexAttributes
+		Float = 0,
+		//Half the size: MeshVertexQuantized or MeshPositionQuantized plus MeshVertexAttributesQuantized
+		Quantized = 1
+	};
+
+	struct MeshVertex
+	{
+		float Position[3];
+		float Normal[3];
+		float TexCoord[2];
+	};
+
+	//Attribute stream of the streamed layout
+	struct MeshVertexAttributes
+	{
+		float Normal[3];
+		float TexCoord[2];
+	};
+
+	// Positions are 16-bit UNORM across the mesh bounds (the fourth component only pads), normals octahedral
+	// encoded 16-bit SNORM and texture coordinates halves; the vertex shader undoes the position and normal encoding
+	struct MeshVertexQuantized
+	{
+		uint16_t Position[4];
+		int16_t Normal[2];
+		uint16_t TexCoord[2];
+	};
+
+	//Position stream of the streamed quantized layout
+	struct MeshPositionQuantized
+	{
+		uint16_t Position[4];
+	};
+
+	//Attribute stream of the streamed quantized layout
+	struct MeshVertexAttributesQuantized
+	{
+		int16_t Normal[2];
+		uint16_t TexCoord[2];
+	};
+
+	struct MeshBounds
+	{
+		float Min[3];
+		float Max[3];
+		float Center[3];
+		float Radius;
+	};
+
+	struct MeshLod
+	{
+		uint32_t FirstIndex = 0;
+		uint32_t IndexCount = 0;
+		uint32_t FirstMeshlet = 0;
+		uint32_t MeshletCount = 0;
+		//Object space distance the simplification may move a surface, 0 for the full detail LOD
+		float Error = 0.0f;
+		uint32_t Padding = 0;
+	};
+
+	struct Meshlet
+	{
+		//Into the meshlet vertex section
+		uint32_t VertexOffset = 0;
+		//Byte offset into the meshlet triangle section, three local vertex indices per triangle
+		uint32_t TriangleOffset = 0;
+		uint32_t VertexCount = 0;
+		uint32_t TriangleCount = 0;
+		float Center[3] = {};
+		float Radius = 0.0f;
+		// Normal cone of the triangles: every triangle faces away from a viewer at v, relative to Center, once
+		// dot(-v, ConeAxis) >= ConeCutoff * length(v) + Radius. A cutoff of 1 never culls.
+		float ConeAxis[3] = {};
+		float ConeCutoff = 1.0f;
+	};
+
+	struct MeshSectionRange
+	{
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+	};
+
+	enum class MeshSection : uint32_t
+	{
+		Vertices = 0,
+		Indices = 1,
+		Lods = 2,
+		Meshlets = 3,
+		//uint32_t mesh vertex indices referenced by meshlets
+		MeshletVertices = 4,
+		//uint8_t triangles, each meshlet's run padded to 4 bytes
+		MeshletTriangles = 5,
+		Count = 6
+	};
+
+	struct MeshFileHeader
+	{
+		uint32_t Magic = k_MeshMagic;
+		uint32_t Version = k_MeshVersion;
+		//Hash of the source file and cook settings, vre_cook skips sources whose hash didn't change
+		uint64_t SourceHash = 0;
+		MeshVertexLayout VertexLayout = MeshVertexLayout::Interleaved;
+		uint32_t VertexCount = 0;
+		//Indices of every LOD together
+		uint32_t IndexCount = 0;
+		//2 or 4 bytes
+		uint32_t IndexSize = 4;
+		uint32_t LodCount = 0;
+		uint32_t MeshletCount = 0;
+		//Offset of the attribute stream inside the vertex section, 0 for the interleaved layout
+		uint64_t AttributeStreamOffset = 0;
+		MeshBounds Bounds = {};
+		MeshSectionRange Sections[static_cast<uint32_t>(MeshSection::Count)] = {};
+		//Quantized positions decode as Bounds.Min + value * (Bounds.Max - Bounds.Min)
+		MeshVertexFormat VertexFormat = MeshVertexFormat::Float;
+		uint32_t Reserved = 0;
+	};
+
+	static_assert(sizeof(MeshFileHeader) % k_MeshSectionAlignment == 0, "Sections start aligned right after the header");
+
+	class MeshFile
+	{
+		public:
+			//Reads through the shared VirtualFileSystem, nullptr if the file is missing, invalid or from an older cooker
+			static std::shared_ptr<MeshFile> Open(std::string_view path);
+			static std::shared_ptr<MeshFile> Load(FileData data);
+			//Whether a file of fileSize bytes starting with header is a current .vmesh whose sections fit it
+			static bool IsValidHeader(const MeshFileHeader& header, uint64_t fileSize);
+
+			const MeshFileHeader& GetHeader() const { return m_Header; }
+			std::span<const std::byte> GetSection(MeshSection section) const;
+			std::span<const MeshLod> GetLods() const;
+			std::span<const Meshlet> GetMeshlets() const;
+			std::span<const uint32_t> GetMeshletVertices() const;
+
+		private:
+			FileData m_Data;
+			MeshFileHeader m_Header;
+	};
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace VRE
+{
+	//Entries of the simulated post transform cache; small enough that every GPU keeps at least this many vertices
+	constexpr uint32_t k_VertexCacheSize = 16;
+
+	struct VertexCacheStatistics
+	{
+		//Vertex shader invocations per triangle, 0.5 is the ideal for large regular meshes and 3 the worst case
+		float Acmr = 0.0f;
+		//Vertex shader invocations per referenced vertex, 1 is ideal
+		float Atvr = 0.0f;
+	};
+
+	//Runs indices through a FIFO cache of cacheSize entries
+	VertexCacheStatistics AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = k_VertexCacheSize);
+
+	// Reorders triangles for the post transform vertex cache with Tipsify (Sander et al. 2007): fans around the
+	// vertex that stays cached the longest, jumping to dead ends only when the fan runs dry. Returns where every
+	// cluster of the new order starts, each cluster begins with a cold cache.
+	std::vector<uint32_t> OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize = k_VertexCacheSize);
+
+	// Splits the clusters of OptimizeVertexCache further wherever that costs less than threshold times the current
+	// ACMR, then sorts them so outward facing ones draw first and occlude what lies behind them.
+	void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const uint32_t> clusters, std::span<const glm::vec3> positions,
+		float threshold = 1.05f, uint32_t cacheSize = k_VertexCacheSize);
+
+	// Renumbers vertices in the order indices first reference them so fetches walk the vertex buffer forwards.
+	// Rewrites indices and returns the remap table, old index to new one; unreferenced vertices map to ~0u and are
+	// dropped by RemapVertices.
+	std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, size_t vertexCount);
+	//Number of vertices kept by a remap table
+	size_t GetRemappedVertexCount(std::span<const uint32_t> remap);
+
+	template<typename T> std::vector<T> RemapVertices(std::span<const T> vertices, std::span<const uint32_t> remap)
+	{
+		std::vector<T> result(GetRemappedVertexCount(remap));
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			if (remap[i] != ~0u)
+			{
+				result[remap[i]] = vertices[i];
+			}
+		}
+		return result;
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string_view>
+#include <MeshCooker.h>
+
+namespace VRE
+{
+	// Wavefront OBJ import for vre_cook. Every object and group is merged into one mesh, polygons are fanned into
+	// triangles and materials are ignored. Throws std::runtime_error on malformed input.
+	SourceMesh LoadObj(std::string_view text);
+}
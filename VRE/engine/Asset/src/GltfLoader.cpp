@@ -0,0 +1,949 @@
+#include <GltfLoader.h>
+#include <FileReader.h>
+#include <Json.h>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace VRE
+{
+	constexpr uint32_t k_GlbMagic = 0x46546C67;
+	constexpr uint32_t k_GlbChunkJson = 0x4E4F534A;
+	constexpr uint32_t k_GlbChunkBin = 0x004E4942;
+
+	constexpr uint32_t k_ComponentByte = 5120;
+	constexpr uint32_t k_ComponentUnsignedByte = 5121;
+	constexpr uint32_t k_ComponentShort = 5122;
+	constexpr uint32_t k_ComponentUnsignedShort = 5123;
+	constexpr uint32_t k_ComponentUnsignedInt = 5125;
+	constexpr uint32_t k_ComponentFloat = 5126;
+
+	constexpr uint32_t k_ModeTriangles = 4;
+	constexpr uint32_t k_ModeTriangleStrip = 5;
+	constexpr uint32_t k_ModeTriangleFan = 6;
+
+	//Required extensions that don't change how geometry or images decode; materials aren't imported at all
+	static bool IsExtensionSupported(std::string_view extension)
+	{
+		return extension == "KHR_mesh_quantization" || extension == "KHR_texture_basisu" || extension == "KHR_texture_transform"
+			|| extension.starts_with("KHR_materials_");
+	}
+
+	struct GltfDocument
+	{
+		JsonValue Json;
+		//The BIN chunk of a .glb, empty for .gltf
+		std::span<const std::byte> BinaryChunk;
+	};
+
+	struct GltfBufferView
+	{
+		uint32_t Buffer = 0;
+		size_t Offset = 0;
+		size_t Length = 0;
+		//0 means tightly packed
+		size_t Stride = 0;
+	};
+
+	// Everything a decode task reads, written before the tasks start and read only while they run
+	struct GltfContext
+	{
+		const JsonValue* Json = nullptr;
+		std::vector<std::span<const std::byte>> Buffers;
+		std::vector<GltfBufferView> BufferViews;
+	};
+
+	// Accessor resolved down to bytes: element i starts at Bytes[i * Stride]
+	struct GltfAccessorData
+	{
+		std::span<const std::byte> Bytes;
+		size_t Stride = 0;
+		uint32_t ComponentType = k_ComponentFloat;
+		uint32_t ComponentCount = 1;
+		uint32_t Count = 0;
+		bool bNormalized = false;
+	};
+
+	// Runs tasks on the pool, or inline without one, and rethrows the first failure in Wait. Always waits for its
+	// tasks before it goes away, they reference the caller's locals.
+	class GltfTaskGroup
+	{
+		public:
+			explicit GltfTaskGroup(ThreadPool* pool) : m_Pool(pool) {}
+
+			~GltfTaskGroup()
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Done.wait(lock, [this] { return m_Running == 0; });
+			}
+
+			void Run(std::function<void()> task)
+			{
+				if (!m_Pool)
+				{
+					Execute(task);
+					return;
+				}
+				{
+					std::lock_guard lock(m_Mutex);
+					m_Running++;
+				}
+				m_Pool->Submit([this, task = std::move(task)]
+				{
+					Execute(task);
+					std::lock_guard lock(m_Mutex);
+					m_Running--;
+					m_Done.notify_all();
+				});
+			}
+
+			void Wait()
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Done.wait(lock, [this] { return m_Running == 0; });
+				if (m_Error)
+				{
+					std::rethrow_exception(std::exchange(m_Error, nullptr));
+				}
+			}
+
+		private:
+			void Execute(const std::function<void()>& task)
+			{
+				try
+				{
+					task();
+				}
+				catch (...)
+				{
+					std::lock_guard lock(m_Mutex);
+					if (!m_Error)
+					{
+						m_Error = std::current_exception();
+					}
+				}
+			}
+
+		private:
+			ThreadPool* m_Pool;
+			std::mutex m_Mutex;
+			std::condition_variable m_Done;
+			size_t m_Running = 0;
+			std::exception_ptr m_Error;
+	};
+
+	template<typename T> static T ReadValue(std::span<const std::byte> bytes, size_t offset)
+	{
+		T value;
+		std::memcpy(&value, bytes.data() + offset, sizeof(T));
+		return value;
+	}
+
+	static GltfDocument ParseDocument(std::span<const std::byte> bytes)
+	{
+		GltfDocument document;
+		if (bytes.size() < 12 || ReadValue<uint32_t>(bytes, 0) != k_GlbMagic)
+		{
+			document.Json = JsonValue::Parse({ reinterpret_cast<const char*>(bytes.data()), bytes.size() });
+			return document;
+		}
+
+		if (ReadValue<uint32_t>(bytes, 4) != 2 || ReadValue<uint32_t>(bytes, 8) > bytes.size())
+		{
+			throw std::runtime_error("Unsupported or truncated GLB file!");
+		}
+		bytes = bytes.first(ReadValue<uint32_t>(bytes, 8));
+		std::optional<std::span<const std::byte>> jsonChunk;
+		for (size_t offset = 12; offset + 8 <= bytes.size();)
+		{
+			const uint32_t length = ReadValue<uint32_t>(bytes, offset);
+			const uint32_t type = ReadValue<uint32_t>(bytes, offset + 4);
+			if (length > bytes.size() - offset - 8)
+			{
+				throw std::runtime_error("Truncated GLB chunk!");
+			}
+			const std::span<const std::byte> chunk = bytes.subspan(offset + 8, length);
+			if (type == k_GlbChunkJson && !jsonChunk)
+			{
+				jsonChunk = chunk;
+			}
+			else if (type == k_GlbChunkBin && document.BinaryChunk.empty())
+			{
+				document.BinaryChunk = chunk;
+			}
+			//Chunks are 4 byte aligned, unknown chunk types are skipped
+			offset += 8 + ((size_t(length) + 3) & ~size_t(3));
+		}
+		if (!jsonChunk)
+		{
+			throw std::runtime_error("GLB file without a JSON chunk!");
+		}
+		document.Json = JsonValue::Parse({ reinterpret_cast<const char*>(jsonChunk->data()), jsonChunk->size() });
+		return document;
+	}
+
+	static std::string DecodePercentEscapes(std::string_view uri)
+	{
+		std::string decoded;
+		decoded.reserve(uri.size());
+		for (size_t i = 0; i < uri.size(); i++)
+		{
+			uint32_t value = 0;
+			if (uri[i] == '%' && i + 2 < uri.size() && std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16).ptr == uri.data() + i + 3)
+			{
+				decoded += static_cast<char>(value);
+				i += 2;
+			}
+			else
+			{
+				decoded += uri[i];
+			}
+		}
+		return decoded;
+	}
+
+	static std::vector<std::byte> DecodeBase64(std::string_view text)
+	{
+		std::array<int8_t, 256> lookup;
+		lookup.fill(-1);
+		constexpr std::string_view k_Alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		for (size_t i = 0; i < k_Alphabet.size(); i++)
+		{
+			lookup[static_cast<uint8_t>(k_Alphabet[i])] = static_cast<int8_t>(i);
+		}
+
+		std::vector<std::byte> bytes;
+		bytes.reserve(text.size() / 4 * 3);
+		uint32_t bits = 0;
+		uint32_t bitCount = 0;
+		for (const char c : text)
+		{
+			if (c == '=')
+			{
+				break;
+			}
+			const int8_t value = lookup[static_cast<uint8_t>(c)];
+			if (value < 0)
+			{
+				throw std::runtime_error("Invalid base64 data URI!");
+			}
+			bits = (bits << 6) | uint32_t(value);
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				bytes.push_back(static_cast<std::byte>((bits >> bitCount) & 0xFF));
+			}
+		}
+		return bytes;
+	}
+
+	//Only base64 data URIs exist in glTF; mime type is whatever precedes ";base64,"
+	static bool IsDataUri(std::string_view uri)
+	{
+		return uri.starts_with("data:");
+	}
+
+	static std::vector<std::byte> DecodeDataUri(std::string_view uri, std::string* mimeType = nullptr)
+	{
+		const size_t separator = uri.find(";base64,");
+		if (separator == std::string_view::npos)
+		{
+			throw std::runtime_error("Only base64 data URIs are supported!");
+		}
+		if (mimeType)
+		{
+			*mimeType = uri.substr(5, separator - 5);
+		}
+		return DecodeBase64(uri.substr(separator + 8));
+	}
+
+	static std::string ResolveUri(const std::string& gltfPath, std::string_view uri)
+	{
+		return (std::filesystem::path(gltfPath).parent_path() / DecodePercentEscapes(uri)).generic_string();
+	}
+
+	static GltfAccessorData ResolveAccessor(const GltfContext& context, uint32_t index)
+	{
+		const JsonValue::Array& accessors = (*context.Json)["accessors"].AsArray();
+		if (index >= accessors.size())
+		{
+			throw std::runtime_error("glTF accessor index out of range!");
+		}
+		const JsonValue& accessor = accessors[index];
+
+		static constexpr std::pair<std::string_view, uint32_t> k_Types[] = {
+			{ "SCALAR", 1 }, { "VEC2", 2 }, { "VEC3", 3 }, { "VEC4", 4 }, { "MAT2", 4 }, { "MAT3", 9 }, { "MAT4", 16 }
+		};
+		GltfAccessorData data{
+			.Bytes = {},
+			.Stride = 0,
+			.ComponentType = accessor.GetIndex("componentType", 0),
+			.ComponentCount = 1,
+			.Count = accessor.GetIndex("count", 0),
+			.bNormalized = accessor.GetBool("normalized", false)
+		};
+		const std::string_view type = accessor.GetString("type");
+		const auto typeIt = std::ranges::find(k_Types, type, &std::pair<std::string_view, uint32_t>::first);
+		if (typeIt == std::end(k_Types))
+		{
+			throw std::runtime_error("Unknown glTF accessor type!");
+		}
+		data.ComponentCount = typeIt->second;
+
+		size_t componentSize = 0;
+		switch (data.ComponentType)
+		{
+			case k_ComponentByte: case k_ComponentUnsignedByte: componentSize = 1; break;
+			case k_ComponentShort: case k_ComponentUnsignedShort: componentSize = 2; break;
+			case k_ComponentUnsignedInt: case k_ComponentFloat: componentSize = 4; break;
+			default: throw std::runtime_error("Unknown glTF component type!");
+		}
+		const size_t elementSize = componentSize * data.ComponentCount;
+
+		//Accessors without a buffer view are all zeros until sparse values override some elements
+		if (!accessor.Find("bufferView"))
+		{
+			return data;
+		}
+		const uint32_t viewIndex = accessor.GetIndex("bufferView", 0);
+		if (viewIndex >= context.BufferViews.size())
+		{
+			throw std::runtime_error("glTF buffer view index out of range!");
+		}
+		const GltfBufferView& view = context.BufferViews[viewIndex];
+		data.Stride = view.Stride != 0 ? view.Stride : elementSize;
+		const size_t offset = accessor.GetIndex("byteOffset", 0);
+		const size_t span = data.Count == 0 ? 0 : (size_t(data.Count) - 1) * data.Stride + elementSize;
+		if (offset > view.Length || span > view.Length - offset)
+		{
+			throw std::runtime_error("glTF accessor reads past its buffer view!");
+		}
+		data.Bytes = context.Buffers[view.Buffer].subspan(view.Offset + offset, span);
+		return data;
+	}
+
+	static float ReadComponent(const GltfAccessorData& data, std::span<const std::byte> bytes, size_t offset)
+	{
+		switch (data.ComponentType)
+		{
+			case k_ComponentFloat: return ReadValue<float>(bytes, offset);
+			case k_ComponentByte:
+			{
+				const float value = ReadValue<int8_t>(bytes, offset);
+				return data.bNormalized ? std::max(value / 127.0f, -1.0f) : value;
+			}
+			case k_ComponentUnsignedByte:
+			{
+				const float value = ReadValue<uint8_t>(bytes, offset);
+				return data.bNormalized ? value / 255.0f : value;
+			}
+			case k_ComponentShort:
+			{
+				const float value = ReadValue<int16_t>(bytes, offset);
+				return data.bNormalized ? std::max(value / 32767.0f, -1.0f) : value;
+			}
+			case k_ComponentUnsignedShort:
+			{
+				const float value = ReadValue<uint16_t>(bytes, offset);
+				return data.bNormalized ? value / 65535.0f : value;
+			}
+			default: return static_cast<float>(ReadValue<uint32_t>(bytes, offset));
+		}
+	}
+
+	static uint32_t ReadIndex(uint32_t componentType, std::span<const std::byte> bytes, size_t offset)
+	{
+		switch (componentType)
+		{
+			case k_ComponentUnsignedByte: return ReadValue<uint8_t>(bytes, offset);
+			case k_ComponentUnsignedShort: return ReadValue<uint16_t>(bytes, offset);
+			case k_ComponentUnsignedInt: return ReadValue<uint32_t>(bytes, offset);
+			default: throw std::runtime_error("glTF indices have to be unsigned integers!");
+		}
+	}
+
+	static size_t GetComponentSize(uint32_t componentType)
+	{
+		return componentType == k_ComponentByte || componentType == k_ComponentUnsignedByte ? 1
+			: componentType == k_ComponentShort || componentType == k_ComponentUnsignedShort ? 2 : 4;
+	}
+
+	//Applies the sparse substitutions of an accessor to values already read from its dense part
+	template<typename T, typename ReadFunction> static void ApplySparse(const GltfContext& context, const JsonValue& accessor,
+		const GltfAccessorData& data, std::vector<T>& values, uint32_t componentCount, ReadFunction read)
+	{
+		const JsonValue* sparse = accessor.Find("sparse");
+		if (!sparse)
+		{
+			return;
+		}
+		const uint32_t count = sparse->GetIndex("count", 0);
+		const JsonValue& indices = (*sparse)["indices"];
+		const JsonValue& sparseValues = (*sparse)["values"];
+		const uint32_t indexType = indices.GetIndex("componentType", 0);
+		const size_t indexSize = GetComponentSize(indexType);
+		const size_t valueSize = GetComponentSize(data.ComponentType) * data.ComponentCount;
+
+		const auto resolve = [&](const JsonValue& source, size_t elementSize)
+		{
+			const uint32_t viewIndex = source.GetIndex("bufferView", 0);
+			if (viewIndex >= context.BufferViews.size())
+			{
+				throw std::runtime_error("glTF buffer view index out of range!");
+			}
+			const GltfBufferView& view = context.BufferViews[viewIndex];
+			const size_t offset = source.GetIndex("byteOffset", 0);
+			if (offset > view.Length || size_t(count) * elementSize > view.Length - offset)
+			{
+				throw std::runtime_error("glTF sparse accessor reads past its buffer view!");
+			}
+			return context.Buffers[view.Buffer].subspan(view.Offset + offset, size_t(count) * elementSize);
+		};
+		const std::span<const std::byte> indexBytes = resolve(indices, indexSize);
+		const std::span<const std::byte> valueBytes = resolve(sparseValues, valueSize);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const uint32_t element = ReadIndex(indexType, indexBytes, i * indexSize);
+			if (element >= data.Count)
+			{
+				throw std::runtime_error("glTF sparse index out of range!");
+			}
+			for (uint32_t component = 0; component < componentCount; component++)
+			{
+				values[size_t(element) * componentCount + component] = read(valueBytes, i * valueSize + component * GetComponentSize(data.ComponentType));
+			}
+		}
+	}
+
+	//Reads the first componentCount components of every element as floats, normalized integers already mapped to [-1, 1]
+	static std::vector<float> ReadFloats(const GltfContext& context, uint32_t index, uint32_t componentCount)
+	{
+		const GltfAccessorData data = ResolveAccessor(context, index);
+		if (data.ComponentCount < componentCount)
+		{
+			throw std::runtime_error("glTF accessor has too few components!");
+		}
+		const size_t componentSize = GetComponentSize(data.ComponentType);
+		std::vector<float> values(size_t(data.Count) * componentCount, 0.0f);
+		if (!data.Bytes.empty())
+		{
+			for (uint32_t element = 0; element < data.Count; element++)
+			{
+				for (uint32_t component = 0; component < componentCount; component++)
+				{
+					values[size_t(element) * componentCount + component] = ReadComponent(data, data.Bytes, element * data.Stride + component * componentSize);
+				}
+			}
+		}
+		ApplySparse(context, (*context.Json)["accessors"].AsArray()[index], data, values, componentCount,
+			[&data](std::span<const std::byte> bytes, size_t offset) { return ReadComponent(data, bytes, offset); });
+		return values;
+	}
+
+	static std::vector<uint32_t> ReadIndices(const GltfContext& context, uint32_t index)
+	{
+		const GltfAccessorData data = ResolveAccessor(context, index);
+		if (data.ComponentCount != 1)
+		{
+			throw std::runtime_error("glTF indices have to be scalars!");
+		}
+		std::vector<uint32_t> values(data.Count, 0);
+		if (!data.Bytes.empty())
+		{
+			for (uint32_t element = 0; element < data.Count; element++)
+			{
+				values[element] = ReadIndex(data.ComponentType, data.Bytes, element * data.Stride);
+			}
+		}
+		ApplySparse(context, (*context.Json)["accessors"].AsArray()[index], data, values, 1,
+			[&data](std::span<const std::byte> bytes, size_t offset) { return ReadIndex(data.ComponentType, bytes, offset); });
+		return values;
+	}
+
+	static std::optional<SourceMesh> DecodePrimitive(const GltfContext& context, const JsonValue& primitive)
+	{
+		const uint32_t mode = primitive.GetIndex("mode", k_ModeTriangles);
+		if (mode != k_ModeTriangles && mode != k_ModeTriangleStrip && mode != k_ModeTriangleFan)
+		{
+			//Points and lines have nothing to cook
+			return std::nullopt;
+		}
+		const JsonValue& attributes = primitive["attributes"];
+		if (!attributes.Find("POSITION"))
+		{
+			throw std::runtime_error("glTF primitive without positions!");
+		}
+
+		SourceMesh mesh;
+		const std::vector<float> positions = ReadFloats(context, attributes.GetIndex("POSITION", 0), 3);
+		mesh.Positions.resize(positions.size() / 3);
+		std::memcpy(mesh.Positions.data(), positions.data(), positions.size() * sizeof(float));
+		if (attributes.Find("NORMAL"))
+		{
+			const std::vector<float> normals = ReadFloats(context, attributes.GetIndex("NORMAL", 0), 3);
+			if (normals.size() == positions.size())
+			{
+				mesh.Normals.resize(mesh.Positions.size());
+				std::memcpy(mesh.Normals.data(), normals.data(), normals.size() * sizeof(float));
+			}
+		}
+		if (attributes.Find("TEXCOORD_0"))
+		{
+			//glTF already puts v = 0 at the top like Vulkan
+			const std::vector<float> texCoords = ReadFloats(context, attributes.GetIndex("TEXCOORD_0", 0), 2);
+			if (texCoords.size() / 2 == mesh.Positions.size())
+			{
+				mesh.TexCoords.resize(mesh.Positions.size());
+				std::memcpy(mesh.TexCoords.data(), texCoords.data(), texCoords.size() * sizeof(float));
+			}
+		}
+
+		std::vector<uint32_t> indices;
+		if (primitive.Find("indices"))
+		{
+			indices = ReadIndices(context, primitive.GetIndex("indices", 0));
+		}
+		else
+		{
+			indices.resize(mesh.Positions.size());
+			for (uint32_t i = 0; i < indices.size(); i++)
+			{
+				indices[i] = i;
+			}
+		}
+		if (std::ranges::any_of(indices, [&mesh](uint32_t index) { return index >= mesh.Positions.size(); }))
+		{
+			throw std::runtime_error("glTF primitive index out of range!");
+		}
+
+		if (mode == k_ModeTriangles)
+		{
+			indices.resize(indices.size() / 3 * 3);
+			mesh.Indices = std::move(indices);
+		}
+		else
+		{
+			mesh.Indices.reserve(indices.size() < 3 ? 0 : (indices.size() - 2) * 3);
+			for (size_t i = 2; i < indices.size(); i++)
+			{
+				if (mode == k_ModeTriangleFan)
+				{
+					mesh.Indices.insert(mesh.Indices.end(), { indices[0], indices[i - 1], indices[i] });
+				}
+				else if (i % 2 == 0)
+				{
+					mesh.Indices.insert(mesh.Indices.end(), { indices[i - 2], indices[i - 1], indices[i] });
+				}
+				else
+				{
+					//Every other strip triangle is mirrored, swap two corners to keep the winding
+					mesh.Indices.insert(mesh.Indices.end(), { indices[i - 1], indices[i - 2], indices[i] });
+				}
+			}
+		}
+		return mesh;
+	}
+
+	static glm::mat4 ParseNodeTransform(const JsonValue& node)
+	{
+		if (const JsonValue* matrix = node.Find("matrix"))
+		{
+			const JsonValue::Array& values = matrix->AsArray();
+			if (values.size() != 16)
+			{
+				throw std::runtime_error("glTF node matrix needs 16 values!");
+			}
+			//Column major like glm
+			glm::mat4 transform;
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				glm::value_ptr(transform)[i] = static_cast<float>(values[i].AsNumber());
+			}
+			return transform;
+		}
+
+		const auto readVector = [&node](std::string_view key, size_t size, std::array<float, 4> value)
+		{
+			if (const JsonValue* member = node.Find(key))
+			{
+				const JsonValue::Array& values = member->AsArray();
+				if (values.size() != size)
+				{
+					throw std::runtime_error("glTF node " + std::string(key) + " has the wrong size!");
+				}
+				for (size_t i = 0; i < size; i++)
+				{
+					value[i] = static_cast<float>(values[i].AsNumber());
+				}
+			}
+			return value;
+		};
+		const std::array<float, 4> translation = readVector("translation", 3, { 0.0f, 0.0f, 0.0f, 0.0f });
+		const std::array<float, 4> rotation = readVector("rotation", 4, { 0.0f, 0.0f, 0.0f, 1.0f });
+		const std::array<float, 4> scale = readVector("scale", 3, { 1.0f, 1.0f, 1.0f, 0.0f });
+		//glTF stores quaternions as x, y, z, w
+		const glm::quat orientation(rotation[3], rotation[0], rotation[1], rotation[2]);
+		glm::mat4 transform = glm::mat4_cast(orientation);
+		transform[0] *= scale[0];
+		transform[1] *= scale[1];
+		transform[2] *= scale[2];
+		transform[3] = glm::vec4(translation[0], translation[1], translation[2], 1.0f);
+		return transform;
+	}
+
+	//Links children to parents and walks down from the roots once, so the cost stays linear in the node count
+	static void ResolveHierarchy(const JsonValue& json, GltfScene& scene)
+	{
+		const size_t nodeCount = scene.Nodes.size();
+		std::vector<uint32_t> childOffsets(nodeCount + 1, 0);
+		std::vector<uint32_t> children;
+		for (size_t i = 0; i < nodeCount; i++)
+		{
+			childOffsets[i] = static_cast<uint32_t>(children.size());
+			if (const JsonValue* nodeChildren = json["nodes"].AsArray()[i].Find("children"))
+			{
+				for (const JsonValue& child : nodeChildren->AsArray())
+				{
+					const double index = child.AsNumber();
+					if (index < 0.0 || index >= double(nodeCount) || scene.Nodes[size_t(index)].Parent >= 0 || size_t(index) == i)
+					{
+						throw std::runtime_error("glTF node hierarchy is not a forest!");
+					}
+					scene.Nodes[size_t(index)].Parent = static_cast<int32_t>(i);
+					children.push_back(static_cast<uint32_t>(index));
+				}
+			}
+		}
+		childOffsets[nodeCount] = static_cast<uint32_t>(children.size());
+
+		const JsonValue& scenes = json["scenes"];
+		if (scenes.GetSize() > 0)
+		{
+			const uint32_t sceneIndex = json.GetIndex("scene", 0);
+			if (sceneIndex >= scenes.GetSize())
+			{
+				throw std::runtime_error("glTF scene index out of range!");
+			}
+			const JsonValue& rootNodes = scenes.AsArray()[sceneIndex]["nodes"];
+			for (size_t i = 0; i < rootNodes.GetSize(); i++)
+			{
+				const double index = rootNodes.AsArray()[i].AsNumber();
+				if (index < 0.0 || index >= double(nodeCount) || scene.Nodes[size_t(index)].Parent >= 0)
+				{
+					throw std::runtime_error("glTF scene root is not a root node!");
+				}
+				scene.RootNodes.push_back(static_cast<uint32_t>(index));
+			}
+		}
+		else
+		{
+			for (uint32_t i = 0; i < scene.Nodes.size(); i++)
+			{
+				if (scene.Nodes[i].Parent < 0)
+				{
+					scene.RootNodes.push_back(i);
+				}
+			}
+		}
+
+		//Explicit stack, scene graphs can be deeper than the call stack
+		std::vector<uint32_t> stack(scene.RootNodes.rbegin(), scene.RootNodes.rend());
+		while (!stack.empty())
+		{
+			const uint32_t index = stack.back();
+			stack.pop_back();
+			GltfNode& node = scene.Nodes[index];
+			node.WorldTransform = node.Parent >= 0 ? scene.Nodes[node.Parent].WorldTransform * node.LocalTransform : node.LocalTransform;
+			node.bInScene = true;
+			for (uint32_t child = childOffsets[index + 1]; child > childOffsets[index]; child--)
+			{
+				stack.push_back(children[child - 1]);
+			}
+		}
+	}
+
+	GltfScene LoadGltf(const std::string& path, const GltfFileLoader& fileLoader, const GltfLoadSettings& settings, ThreadPool* pool)
+	{
+		const std::optional<FileData> file = fileLoader(path);
+		if (!file)
+		{
+			throw std::runtime_error("Could not open " + path + "!");
+		}
+		const GltfDocument document = ParseDocument(file->GetBytes());
+		const JsonValue& json = document.Json;
+		if (!json.IsObject() || !json["asset"].GetString("version").starts_with("2."))
+		{
+			throw std::runtime_error("Only glTF 2.0 is supported!");
+		}
+		if (const JsonValue* required = json.Find("extensionsRequired"))
+		{
+			for (const JsonValue& extension : required->AsArray())
+			{
+				if (!IsExtensionSupported(extension.AsString()))
+				{
+					throw std::runtime_error("Unsupported required glTF extension " + extension.AsString() + "!");
+				}
+			}
+		}
+
+		//Buffers first, every other decode step reads from them
+		GltfContext context{ .Json = &json, .Buffers = {}, .BufferViews = {} };
+		const JsonValue& buffers = json["buffers"];
+		std::vector<std::optional<FileData>> bufferFiles(buffers.GetSize());
+		std::vector<std::vector<std::byte>> bufferData(buffers.GetSize());
+		context.Buffers.resize(buffers.GetSize());
+		GltfTaskGroup bufferTasks(pool);
+		for (size_t i = 0; i < buffers.GetSize(); i++)
+		{
+			bufferTasks.Run([&, i]
+			{
+				const JsonValue& buffer = buffers.AsArray()[i];
+				const std::string_view uri = buffer.GetString("uri");
+				if (uri.empty())
+				{
+					if (i != 0 || document.BinaryChunk.empty())
+					{
+						throw std::runtime_error("glTF buffer without a URI outside of a GLB!");
+					}
+					context.Buffers[i] = document.BinaryChunk;
+				}
+				else if (IsDataUri(uri))
+				{
+					bufferData[i] = DecodeDataUri(uri);
+					context.Buffers[i] = bufferData[i];
+				}
+				else
+				{
+					bufferFiles[i] = fileLoader(ResolveUri(path, uri));
+					if (!bufferFiles[i])
+					{
+						throw std::runtime_error("Could not open glTF buffer " + std::string(uri) + "!");
+					}
+					context.Buffers[i] = bufferFiles[i]->GetBytes();
+				}
+				const uint32_t length = buffer.GetIndex("byteLength", 0);
+				if (context.Buffers[i].size() < length)
+				{
+					throw std::runtime_error("glTF buffer is shorter than its byteLength!");
+				}
+				context.Buffers[i] = context.Buffers[i].first(length);
+			});
+		}
+
+		//Nodes only need the JSON, parse them while the buffers load
+		GltfScene scene;
+		const JsonValue& nodes = json["nodes"];
+		const size_t meshCount = json["meshes"].GetSize();
+		scene.Nodes.resize(nodes.GetSize());
+		for (size_t i = 0; i < nodes.GetSize(); i++)
+		{
+			const JsonValue& node = nodes.AsArray()[i];
+			GltfNode& result = scene.Nodes[i];
+			result.Name = node.GetString("name");
+			result.LocalTransform = ParseNodeTransform(node);
+			if (node.Find("mesh"))
+			{
+				const uint32_t mesh = node.GetIndex("mesh", 0);
+				if (mesh >= meshCount)
+				{
+					throw std::runtime_error("glTF node mesh index out of range!");
+				}
+				result.Mesh = static_cast<int32_t>(mesh);
+			}
+		}
+		ResolveHierarchy(json, scene);
+		bufferTasks.Wait();
+
+		const JsonValue& bufferViews = json["bufferViews"];
+		context.BufferViews.reserve(bufferViews.GetSize());
+		for (size_t i = 0; i < bufferViews.GetSize(); i++)
+		{
+			const JsonValue& view = bufferViews.AsArray()[i];
+			const GltfBufferView result{
+				.Buffer = view.GetIndex("buffer", 0),
+				.Offset = view.GetIndex("byteOffset", 0),
+				.Length = view.GetIndex("byteLength", 0),
+				.Stride = view.GetIndex("byteStride", 0)
+			};
+			if (result.Buffer >= context.Buffers.size() || result.Offset > context.Buffers[result.Buffer].size()
+				|| result.Length > context.Buffers[result.Buffer].size() - result.Offset)
+			{
+				throw std::runtime_error("glTF buffer view out of range!");
+			}
+			context.BufferViews.push_back(result);
+		}
+
+		//Every primitive and every image is its own task, results go into slots sized up front
+		const JsonValue& meshes = json["meshes"];
+		const JsonValue& images = json["images"];
+		std::vector<std::vector<std::optional<GltfPrimitive>>> primitives(meshes.GetSize());
+		for (size_t i = 0; i < meshes.GetSize(); i++)
+		{
+			primitives[i].resize(meshes.AsArray()[i]["primitives"].GetSize());
+		}
+		scene.Images.resize(settings.bLoadImages ? images.GetSize() : 0);
+
+		GltfTaskGroup decodeTasks(pool);
+		for (size_t mesh = 0; mesh < primitives.size(); mesh++)
+		{
+			for (size_t primitive = 0; primitive < primitives[mesh].size(); primitive++)
+			{
+				decodeTasks.Run([&, mesh, primitive]
+				{
+					const JsonValue& source = meshes.AsArray()[mesh]["primitives"].AsArray()[primitive];
+					std::optional<SourceMesh> decoded = DecodePrimitive(context, source);
+					if (!decoded)
+					{
+						return;
+					}
+					GltfPrimitive result{ .Mesh = std::move(*decoded), .Cooked = nullptr, .Material = -1 };
+					if (source.Find("material"))
+					{
+						result.Material = static_cast<int32_t>(source.GetIndex("material", 0));
+					}
+					if (settings.Cook && !result.Mesh.Indices.empty())
+					{
+						result.Cooked = MeshFile::Load(FileData(CookMesh(result.Mesh, *settings.Cook, 0)));
+						result.Mesh = {};
+					}
+					primitives[mesh][primitive] = std::move(result);
+				});
+			}
+		}
+		for (size_t i = 0; i < scene.Images.size(); i++)
+		{
+			decodeTasks.Run([&, i]
+			{
+				const JsonValue& image = images.AsArray()[i];
+				GltfImage& result = scene.Images[i];
+				result.Name = image.GetString("name");
+				result.MimeType = image.GetString("mimeType");
+				const std::string_view uri = image.GetString("uri");
+				if (image.Find("bufferView"))
+				{
+					const uint32_t viewIndex = image.GetIndex("bufferView", 0);
+					if (viewIndex >= context.BufferViews.size())
+					{
+						throw std::runtime_error("glTF buffer view index out of range!");
+					}
+					const GltfBufferView& view = context.BufferViews[viewIndex];
+					const std::span<const std::byte> bytes = context.Buffers[view.Buffer].subspan(view.Offset, view.Length);
+					result.Data.assign(bytes.begin(), bytes.end());
+				}
+				else if (IsDataUri(uri))
+				{
+					result.Data = DecodeDataUri(uri, &result.MimeType);
+				}
+				else if (!uri.empty())
+				{
+					std::optional<FileData> data = fileLoader(ResolveUri(path, uri));
+					if (!data)
+					{
+						throw std::runtime_error("Could not open glTF image " + std::string(uri) + "!");
+					}
+					result.Data.assign(data->GetBytes().begin(), data->GetBytes().end());
+				}
+			});
+		}
+		decodeTasks.Wait();
+
+		scene.Meshes.resize(meshes.GetSize());
+		for (size_t mesh = 0; mesh < primitives.size(); mesh++)
+		{
+			scene.Meshes[mesh].Name = meshes.AsArray()[mesh].GetString("name");
+			for (std::optional<GltfPrimitive>& primitive : primitives[mesh])
+			{
+				if (primitive)
+				{
+					scene.Meshes[mesh].Primitives.push_back(std::move(*primitive));
+				}
+			}
+		}
+		return scene;
+	}
+
+	GltfScene LoadGltf(const std::string& path, const GltfLoadSettings& settings, ThreadPool* pool)
+	{
+		return LoadGltf(path, [](const std::string& filePath) { return FileReader::GetFileSystem().ReadFile(filePath); }, settings, pool);
+	}
+
+	std::vector<std::string> GetGltfDependencies(std::span<const std::byte> bytes)
+	{
+		const GltfDocument document = ParseDocument(bytes);
+		std::vector<std::string> dependencies;
+		for (const std::string_view collection : { "buffers", "images" })
+		{
+			const JsonValue& entries = document.Json[collection];
+			for (size_t i = 0; i < entries.GetSize(); i++)
+			{
+				const std::string_view uri = entries.AsArray()[i].GetString("uri");
+				if (!uri.empty() && !IsDataUri(uri))
+				{
+					dependencies.push_back(DecodePercentEscapes(uri));
+				}
+			}
+		}
+		return dependencies;
+	}
+
+	SourceMesh FlattenGltfScene(const GltfScene& scene)
+	{
+		//Attributes missing on any instanced primitive are dropped for the whole mesh, as in the OBJ import
+		bool bHasNormals = true;
+		bool bHasTexCoords = true;
+		for (const GltfNode& node : scene.Nodes)
+		{
+			for (const GltfPrimitive& primitive : node.bInScene && node.Mesh >= 0 ? std::span(scene.Meshes[node.Mesh].Primitives) : std::span<const GltfPrimitive>())
+			{
+				bHasNormals &= !primitive.Mesh.Normals.empty();
+				bHasTexCoords &= !primitive.Mesh.TexCoords.empty();
+			}
+		}
+
+		SourceMesh result;
+		for (const GltfNode& node : scene.Nodes)
+		{
+			if (!node.bInScene || node.Mesh < 0)
+			{
+				continue;
+			}
+
+			const glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(node.WorldTransform)));
+			//Mirroring transforms turn the triangles inside out
+			const bool bFlip = glm::determinant(glm::mat3(node.WorldTransform)) < 0.0f;
+			for (const GltfPrimitive& primitive : scene.Meshes[node.Mesh].Primitives)
+			{
+				const uint32_t baseVertex = static_cast<uint32_t>(result.Positions.size());
+				for (size_t i = 0; i < primitive.Mesh.Positions.size(); i++)
+				{
+					result.Positions.push_back(glm::vec3(node.WorldTransform * glm::vec4(primitive.Mesh.Positions[i], 1.0f)));
+					if (bHasNormals)
+					{
+						result.Normals.push_back(glm::normalize(normalTransform * primitive.Mesh.Normals[i]));
+					}
+					if (bHasTexCoords)
+					{
+						result.TexCoords.push_back(primitive.Mesh.TexCoords[i]);
+					}
+				}
+				for (size_t i = 0; i < primitive.Mesh.Indices.size(); i += 3)
+				{
+					const uint32_t second = primitive.Mesh.Indices[i + (bFlip ? 2 : 1)];
+					const uint32_t third = primitive.Mesh.Indices[i + (bFlip ? 1 : 2)];
+					result.Indices.insert(result.Indices.end(), { baseVertex + primitive.Mesh.Indices[i], baseVertex + second, baseVertex + third });
+				}
+			}
+		}
+		return result;
+	}
+}
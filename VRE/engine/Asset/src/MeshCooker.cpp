@@ -0,0 +1,479 @@
+#include <MeshCooker.h>
+#include <Hash.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <glm/gtc/packing.hpp>
+
+namespace VRE
+{
+	//Finest clustering grid tried for a LOD, along the largest axis of the bounds
+	constexpr uint32_t k_MaxClusterGrid = 1024;
+	//A LOD that doesn't drop at least this fraction of the previous one's triangles ends the chain
+	constexpr float k_MinLodProgress = 0.1f;
+
+	struct MeshletBuild
+	{
+		std::vector<Meshlet> Meshlets;
+		std::vector<uint32_t> Vertices;
+		std::vector<uint8_t> Triangles;
+	};
+
+	uint64_t HashCookSettings(const MeshCookSettings& settings)
+	{
+		const uint32_t values[] = {
+			k_MeshVersion,
+			static_cast<uint32_t>(settings.VertexLayout),
+			static_cast<uint32_t>(settings.VertexFormat),
+			settings.MaxLodCount,
+			std::bit_cast<uint32_t>(settings.LodReduction),
+			settings.MaxMeshletVertices,
+			settings.MaxMeshletTriangles,
+			settings.bOptimize ? 1u : 0u,
+			std::bit_cast<uint32_t>(settings.OverdrawThreshold)
+		};
+		return HashBytes(std::as_bytes(std::span(values)));
+	}
+
+	glm::vec2 EncodeOctahedral(const glm::vec3& normal)
+	{
+		//Project onto the octahedron, then fold the lower half over the diagonals
+		const glm::vec3 n = normal / std::max(std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z), 1e-20f);
+		if (n.z >= 0.0f)
+		{
+			return { n.x, n.y };
+		}
+		return { (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f) };
+	}
+
+	glm::vec3 DecodeOctahedral(const glm::vec2& encoded)
+	{
+		glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+		const float fold = std::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -fold : fold;
+		n.y += n.y >= 0.0f ? -fold : fold;
+		return glm::normalize(n);
+	}
+
+	struct QuantizedAttributes
+	{
+		int16_t Normal[2];
+		uint16_t TexCoord[2];
+	};
+
+	static QuantizedAttributes QuantizeAttributes(const glm::vec3& normal, const glm::vec2& texCoord)
+	{
+		const glm::vec2 octahedral = EncodeOctahedral(normal);
+		return {
+			{ static_cast<int16_t>(glm::packSnorm1x16(octahedral.x)), static_cast<int16_t>(glm::packSnorm1x16(octahedral.y)) },
+			{ glm::packHalf1x16(texCoord.x), glm::packHalf1x16(texCoord.y) }
+		};
+	}
+
+	static std::vector<glm::vec3> GenerateNormals(const SourceMesh& mesh)
+	{
+		//Area weighted face normals, the cross product's length already is twice the area
+		std::vector<glm::vec3> normals(mesh.Positions.size(), glm::vec3(0.0f));
+		for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+		{
+			const uint32_t a = mesh.Indices[i];
+			const uint32_t b = mesh.Indices[i + 1];
+			const uint32_t c = mesh.Indices[i + 2];
+			const glm::vec3 normal = glm::cross(mesh.Positions[b] - mesh.Positions[a], mesh.Positions[c] - mesh.Positions[a]);
+			normals[a] += normal;
+			normals[b] += normal;
+			normals[c] += normal;
+		}
+		for (glm::vec3& normal : normals)
+		{
+			const float length = glm::length(normal);
+			normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+		}
+		return normals;
+	}
+
+	static MeshBounds ComputeBounds(std::span<const glm::vec3> positions)
+	{
+		glm::vec3 min(0.0f);
+		glm::vec3 max(0.0f);
+		if (!positions.empty())
+		{
+			min = max = positions[0];
+		}
+		for (const glm::vec3& position : positions)
+		{
+			min = glm::min(min, position);
+			max = glm::max(max, position);
+		}
+		const glm::vec3 center = (min + max) * 0.5f;
+		float radius = 0.0f;
+		for (const glm::vec3& position : positions)
+		{
+			radius = std::max(radius, glm::length(position - center));
+		}
+		return { { min.x, min.y, min.z }, { max.x, max.y, max.z }, { center.x, center.y, center.z }, radius };
+	}
+
+	//Merges all vertices in a cell of a grid with gridSize cells along the largest axis into the one closest to
+	//their average and drops the triangles that collapse
+	static std::vector<uint32_t> SimplifyClusters(std::span<const glm::vec3> positions, std::span<const uint32_t> indices,
+		const MeshBounds& bounds, uint32_t gridSize, float& cellSize)
+	{
+		const glm::vec3 min(bounds.Min[0], bounds.Min[1], bounds.Min[2]);
+		const glm::vec3 extent = glm::vec3(bounds.Max[0], bounds.Max[1], bounds.Max[2]) - min;
+		cellSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f)) / static_cast<float>(gridSize);
+		const auto cellOf = [&](uint32_t vertex)
+		{
+			const glm::uvec3 cell = glm::min(glm::uvec3((positions[vertex] - min) / cellSize), glm::uvec3(gridSize - 1));
+			return (uint64_t(cell.z) * gridSize + cell.y) * gridSize + cell.x;
+		};
+
+		struct Cluster
+		{
+			glm::vec3 Sum = glm::vec3(0.0f);
+			uint32_t Count = 0;
+			uint32_t Representative = 0;
+			float Distance = std::numeric_limits<float>::max();
+		};
+		std::unordered_map<uint64_t, Cluster> clusters;
+		for (uint32_t index : indices)
+		{
+			Cluster& cluster = clusters[cellOf(index)];
+			cluster.Sum += positions[index];
+			cluster.Count++;
+		}
+		for (uint32_t index : indices)
+		{
+			Cluster& cluster = clusters[cellOf(index)];
+			const float distance = glm::length(positions[index] - cluster.Sum / static_cast<float>(cluster.Count));
+			if (distance < cluster.Distance)
+			{
+				cluster.Representative = index;
+				cluster.Distance = distance;
+			}
+		}
+
+		using Triangle = std::array<uint32_t, 3>;
+		const auto hashTriangle = [](const Triangle& triangle) { return HashBytes(std::as_bytes(std::span(triangle))); };
+		std::vector<uint32_t> simplified;
+		std::unordered_set<Triangle, decltype(hashTriangle)> emitted(0, hashTriangle);
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const uint32_t a = clusters[cellOf(indices[i])].Representative;
+			const uint32_t b = clusters[cellOf(indices[i + 1])].Representative;
+			const uint32_t c = clusters[cellOf(indices[i + 2])].Representative;
+			if (a == b || b == c || a == c)
+			{
+				continue;
+			}
+			//Several source triangles often collapse onto the same one, rotate so the smallest index leads and keep one
+			Triangle triangle = { a, b, c };
+			std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+			if (emitted.insert(triangle).second)
+			{
+				simplified.insert(simplified.end(), triangle.begin(), triangle.end());
+			}
+		}
+		return simplified;
+	}
+
+	static void BuildMeshlets(std::span<const glm::vec3> positions, std::span<const uint32_t> indices, const MeshCookSettings& settings, MeshletBuild& build)
+	{
+		const uint32_t maxVertices = std::clamp(settings.MaxMeshletVertices, 3u, 256u);
+		const uint32_t maxTriangles = std::max(settings.MaxMeshletTriangles, 1u);
+		Meshlet meshlet;
+		std::vector<uint32_t> localVertices;
+
+		const auto flush = [&]()
+		{
+			if (meshlet.TriangleCount == 0)
+			{
+				return;
+			}
+			glm::vec3 min = positions[localVertices[0]];
+			glm::vec3 max = min;
+			for (uint32_t vertex : localVertices)
+			{
+				min = glm::min(min, positions[vertex]);
+				max = glm::max(max, positions[vertex]);
+			}
+			const glm::vec3 center = (min + max) * 0.5f;
+			for (uint32_t vertex : localVertices)
+			{
+				meshlet.Radius = std::max(meshlet.Radius, glm::length(positions[vertex] - center));
+			}
+			std::memcpy(meshlet.Center, &center, sizeof(meshlet.Center));
+
+			//Cone around the average facing, its half angle reaches the triangle furthest from the axis
+			std::vector<glm::vec3> triangleNormals;
+			glm::vec3 axis(0.0f);
+			for (uint32_t triangle = 0; triangle < meshlet.TriangleCount; triangle++)
+			{
+				const uint8_t* corners = build.Triangles.data() + meshlet.TriangleOffset + triangle * 3;
+				const glm::vec3& a = positions[localVertices[corners[0]]];
+				const glm::vec3 normal = glm::cross(positions[localVertices[corners[1]]] - a, positions[localVertices[corners[2]]] - a);
+				const float length = glm::length(normal);
+				if (length > 0.0f)
+				{
+					triangleNormals.push_back(normal / length);
+					axis += triangleNormals.back();
+				}
+			}
+			const float axisLength = glm::length(axis);
+			float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+			for (const glm::vec3& normal : triangleNormals)
+			{
+				minDot = std::min(minDot, glm::dot(normal, axis / axisLength));
+			}
+			if (minDot > 0.0f)
+			{
+				const glm::vec3 coneAxis = axis / axisLength;
+				std::memcpy(meshlet.ConeAxis, &coneAxis, sizeof(meshlet.ConeAxis));
+				//Sine of the half angle; viewed within 90 degrees minus that of the axis, every triangle is back facing
+				meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+			}
+			meshlet.VertexCount = static_cast<uint32_t>(localVertices.size());
+			build.Vertices.insert(build.Vertices.end(), localVertices.begin(), localVertices.end());
+			build.Triangles.resize((build.Triangles.size() + 3) & ~size_t(3));
+			build.Meshlets.push_back(meshlet);
+
+			localVertices.clear();
+			meshlet = { .VertexOffset = static_cast<uint32_t>(build.Vertices.size()), .TriangleOffset = static_cast<uint32_t>(build.Triangles.size()) };
+		};
+
+		meshlet = { .VertexOffset = static_cast<uint32_t>(build.Vertices.size()), .TriangleOffset = static_cast<uint32_t>(build.Triangles.size()) };
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			uint32_t newVertices = 0;
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				newVertices += std::ranges::find(localVertices, indices[i + corner]) == localVertices.end() ? 1 : 0;
+			}
+			if (localVertices.size() + newVertices > maxVertices || meshlet.TriangleCount == maxTriangles)
+			{
+				flush();
+			}
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				auto vertexIt = std::ranges::find(localVertices, indices[i + corner]);
+				if (vertexIt == localVertices.end())
+				{
+					localVertices.push_back(indices[i + corner]);
+					vertexIt = localVertices.end() - 1;
+				}
+				build.Triangles.push_back(static_cast<uint8_t>(vertexIt - localVertices.begin()));
+			}
+			meshlet.TriangleCount++;
+		}
+		flush();
+	}
+
+	template<typename T> static MeshSectionRange AppendSection(std::vector<std::byte>& file, std::span<const T> data)
+	{
+		file.resize((file.size() + k_MeshSectionAlignment - 1) & ~size_t(k_MeshSectionAlignment - 1));
+		const MeshSectionRange range{ .Offset = file.size(), .Size = data.size_bytes() };
+		const std::span<const std::byte> bytes = std::as_bytes(data);
+		file.insert(file.end(), bytes.begin(), bytes.end());
+		return range;
+	}
+
+	std::vector<std::byte> CookMesh(const SourceMesh& mesh, const MeshCookSettings& settings, uint64_t sourceHash,
+		MeshCookStatistics* statistics)
+	{
+		size_t vertexCount = mesh.Positions.size();
+		if ((!mesh.Normals.empty() && mesh.Normals.size() != vertexCount) || (!mesh.TexCoords.empty() && mesh.TexCoords.size() != vertexCount)
+			|| mesh.Indices.size() % 3 != 0 || vertexCount > std::numeric_limits<uint32_t>::max())
+		{
+			throw std::runtime_error("Mesh attributes don't match up!");
+		}
+		if (std::ranges::any_of(mesh.Indices, [vertexCount](uint32_t index) { return index >= vertexCount; }))
+		{
+			throw std::runtime_error("Mesh index out of range!");
+		}
+
+		const MeshBounds sourceBounds = ComputeBounds(mesh.Positions);
+
+		//LOD chain, each one simplified from the previous so the cluster grids nest
+		std::vector<std::vector<uint32_t>> lodIndices = { mesh.Indices };
+		std::vector<float> lodErrors = { 0.0f };
+		while (lodIndices.size() < settings.MaxLodCount)
+		{
+			const std::vector<uint32_t>& previous = lodIndices.back();
+			const size_t target = static_cast<size_t>(static_cast<float>(previous.size() / 3) * settings.LodReduction);
+			std::vector<uint32_t> best;
+			float bestCellSize = 0.0f;
+			//Coarser grids drop more triangles, find the finest one that reaches the target
+			uint32_t low = 1;
+			uint32_t high = k_MaxClusterGrid;
+			while (low <= high)
+			{
+				const uint32_t gridSize = (low + high) / 2;
+				float cellSize = 0.0f;
+				std::vector<uint32_t> simplified = SimplifyClusters(mesh.Positions, previous, sourceBounds, gridSize, cellSize);
+				if (simplified.size() / 3 <= target)
+				{
+					best = std::move(simplified);
+					bestCellSize = cellSize;
+					low = gridSize + 1;
+				}
+				else
+				{
+					high = gridSize - 1;
+				}
+			}
+			if (best.empty() || static_cast<float>(best.size()) > static_cast<float>(previous.size()) * (1.0f - k_MinLodProgress))
+			{
+				break;
+			}
+			lodIndices.push_back(std::move(best));
+			lodErrors.push_back(bestCellSize * 1.7320508f);
+		}
+
+		if (statistics)
+		{
+			statistics->Before = AnalyzeVertexCache(mesh.Indices, vertexCount);
+		}
+		if (settings.bOptimize)
+		{
+			for (std::vector<uint32_t>& lod : lodIndices)
+			{
+				const std::vector<uint32_t> clusters = OptimizeVertexCache(lod, vertexCount);
+				OptimizeOverdraw(lod, clusters, mesh.Positions, settings.OverdrawThreshold);
+			}
+		}
+
+		std::vector<MeshLod> lods;
+		std::vector<uint32_t> indices;
+		for (size_t lod = 0; lod < lodIndices.size(); lod++)
+		{
+			lods.push_back({ .FirstIndex = static_cast<uint32_t>(indices.size()), .IndexCount = static_cast<uint32_t>(lodIndices[lod].size()), .Error = lodErrors[lod] });
+			indices.insert(indices.end(), lodIndices[lod].begin(), lodIndices[lod].end());
+		}
+
+		//All LODs share the vertices, renumber them in the order the LODs reference them, full detail first
+		std::vector<glm::vec3> positions = mesh.Positions;
+		std::vector<glm::vec3> normals = mesh.Normals.empty() ? GenerateNormals(mesh) : mesh.Normals;
+		std::vector<glm::vec2> texCoords = mesh.TexCoords;
+		if (settings.bOptimize)
+		{
+			const std::vector<uint32_t> remap = OptimizeVertexFetch(indices, vertexCount);
+			positions = RemapVertices<glm::vec3>(positions, remap);
+			normals = RemapVertices<glm::vec3>(normals, remap);
+			if (!texCoords.empty())
+			{
+				texCoords = RemapVertices<glm::vec2>(texCoords, remap);
+			}
+			vertexCount = positions.size();
+		}
+		if (statistics)
+		{
+			statistics->After = AnalyzeVertexCache(std::span(indices).first(lods[0].IndexCount), vertexCount);
+		}
+		const MeshBounds bounds = ComputeBounds(positions);
+
+		MeshletBuild meshlets;
+		for (MeshLod& lod : lods)
+		{
+			lod.FirstMeshlet = static_cast<uint32_t>(meshlets.Meshlets.size());
+			BuildMeshlets(positions, std::span(indices).subspan(lod.FirstIndex, lod.IndexCount), settings, meshlets);
+			lod.MeshletCount = static_cast<uint32_t>(meshlets.Meshlets.size()) - lod.FirstMeshlet;
+		}
+
+		MeshFileHeader header{
+			.SourceHash = sourceHash,
+			.VertexLayout = settings.VertexLayout,
+			.VertexCount = static_cast<uint32_t>(vertexCount),
+			.IndexCount = static_cast<uint32_t>(indices.size()),
+			.IndexSize = vertexCount <= 0x10000 ? 2u : 4u,
+			.LodCount = static_cast<uint32_t>(lods.size()),
+			.MeshletCount = static_cast<uint32_t>(meshlets.Meshlets.size()),
+			.Bounds = bounds
+		};
+
+		std::vector<std::byte> vertexData;
+		const auto texCoord = [&texCoords](size_t vertex) { return texCoords.empty() ? glm::vec2(0.0f) : texCoords[vertex]; };
+		const glm::vec3 boundsMin(bounds.Min[0], bounds.Min[1], bounds.Min[2]);
+		const glm::vec3 boundsExtent = glm::vec3(bounds.Max[0], bounds.Max[1], bounds.Max[2]) - boundsMin;
+		const auto quantizePosition = [&](const glm::vec3& position, uint16_t (&result)[4])
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				result[axis] = glm::packUnorm1x16(boundsExtent[axis] > 0.0f ? (position[axis] - boundsMin[axis]) / boundsExtent[axis] : 0.0f);
+			}
+			result[3] = 0;
+		};
+		header.VertexFormat = settings.VertexFormat;
+		if (settings.VertexFormat == MeshVertexFormat::Quantized && settings.VertexLayout == MeshVertexLayout::Interleaved)
+		{
+			std::vector<MeshVertexQuantized> vertices(vertexCount);
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				const QuantizedAttributes attributes = QuantizeAttributes(normals[i], texCoord(i));
+				quantizePosition(positions[i], vertices[i].Position);
+				std::memcpy(vertices[i].Normal, attributes.Normal, sizeof(attributes.Normal));
+				std::memcpy(vertices[i].TexCoord, attributes.TexCoord, sizeof(attributes.TexCoord));
+			}
+			AppendSection<MeshVertexQuantized>(vertexData, vertices);
+		}
+		else if (settings.VertexFormat == MeshVertexFormat::Quantized)
+		{
+			std::vector<MeshPositionQuantized> quantizedPositions(vertexCount);
+			std::vector<MeshVertexAttributesQuantized> attributes(vertexCount);
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				const QuantizedAttributes quantized = QuantizeAttributes(normals[i], texCoord(i));
+				quantizePosition(positions[i], quantizedPositions[i].Position);
+				std::memcpy(attributes[i].Normal, quantized.Normal, sizeof(quantized.Normal));
+				std::memcpy(attributes[i].TexCoord, quantized.TexCoord, sizeof(quantized.TexCoord));
+			}
+			AppendSection<MeshPositionQuantized>(vertexData, quantizedPositions);
+			header.AttributeStreamOffset = AppendSection<MeshVertexAttributesQuantized>(vertexData, attributes).Offset;
+		}
+		else if (settings.VertexLayout == MeshVertexLayout::Interleaved)
+		{
+			std::vector<MeshVertex> vertices(vertexCount);
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				const glm::vec2 uv = texCoord(i);
+				vertices[i] = { { positions[i].x, positions[i].y, positions[i].z }, { normals[i].x, normals[i].y, normals[i].z }, { uv.x, uv.y } };
+			}
+			AppendSection<MeshVertex>(vertexData, vertices);
+		}
+		else
+		{
+			std::vector<MeshVertexAttributes> attributes(vertexCount);
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				const glm::vec2 uv = texCoord(i);
+				attributes[i] = { { normals[i].x, normals[i].y, normals[i].z }, { uv.x, uv.y } };
+			}
+			AppendSection<glm::vec3>(vertexData, positions);
+			header.AttributeStreamOffset = AppendSection<MeshVertexAttributes>(vertexData, attributes).Offset;
+		}
+
+		std::vector<std::byte> file(sizeof(MeshFileHeader));
+		const auto sectionOf = [&header](MeshSection section) -> MeshSectionRange& { return header.Sections[static_cast<uint32_t>(section)]; };
+		sectionOf(MeshSection::Vertices) = AppendSection<std::byte>(file, vertexData);
+		if (header.IndexSize == 2)
+		{
+			std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+			sectionOf(MeshSection::Indices) = AppendSection<uint16_t>(file, shortIndices);
+		}
+		else
+		{
+			sectionOf(MeshSection::Indices) = AppendSection<uint32_t>(file, indices);
+		}
+		sectionOf(MeshSection::Lods) = AppendSection<MeshLod>(file, lods);
+		sectionOf(MeshSection::Meshlets) = AppendSection<Meshlet>(file, meshlets.Meshlets);
+		sectionOf(MeshSection::MeshletVertices) = AppendSection<uint32_t>(file, meshlets.Vertices);
+		sectionOf(MeshSection::MeshletTriangles) = AppendSection<uint8_t>(file, meshlets.Triangles);
+		std::memcpy(file.data(), &header, sizeof(header));
+		return file;
+	}
+}
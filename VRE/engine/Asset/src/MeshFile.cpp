@@ -0,0 +1,74 @@
+#include <MeshFile.h>
+#include <FileReader.h>
+#include <cstring>
+
+namespace VRE
+{
+	std::shared_ptr<MeshFile> MeshFile::Open(std::string_view path)
+	{
+		std::optional<FileData> data = FileReader::GetFileSystem().ReadFile(path);
+		return data ? Load(std::move(*data)) : nullptr;
+	}
+
+	std::shared_ptr<MeshFile> MeshFile::Load(FileData data)
+	{
+		const std::span<const std::byte> bytes = data.GetBytes();
+		if (bytes.size() < sizeof(MeshFileHeader))
+		{
+			return nullptr;
+		}
+		auto file = std::make_shared<MeshFile>();
+		std::memcpy(&file->m_Header, bytes.data(), sizeof(MeshFileHeader));
+		if (!IsValidHeader(file->m_Header, bytes.size()))
+		{
+			return nullptr;
+		}
+		file->m_Data = std::move(data);
+		return file;
+	}
+
+	bool MeshFile::IsValidHeader(const MeshFileHeader& header, uint64_t fileSize)
+	{
+		if (header.Magic != k_MeshMagic || header.Version != k_MeshVersion || (header.IndexSize != 2 && header.IndexSize != 4)
+			|| header.VertexLayout > MeshVertexLayout::Streamed || header.VertexFormat > MeshVertexFormat::Quantized)
+		{
+			return false;
+		}
+		for (const MeshSectionRange& section : header.Sections)
+		{
+			//Owned data comes from a vector, mapped data from a page aligned mapping, both keep the sections aligned
+			if (section.Offset % k_MeshSectionAlignment != 0 || section.Offset > fileSize || section.Size > fileSize - section.Offset)
+			{
+				return false;
+			}
+		}
+		const auto sectionSize = [&header](MeshSection section) { return header.Sections[static_cast<uint32_t>(section)].Size; };
+		return sectionSize(MeshSection::Lods) == header.LodCount * sizeof(MeshLod)
+			&& sectionSize(MeshSection::Meshlets) == header.MeshletCount * sizeof(Meshlet)
+			&& sectionSize(MeshSection::Indices) == uint64_t(header.IndexCount) * header.IndexSize;
+	}
+
+	std::span<const std::byte> MeshFile::GetSection(MeshSection section) const
+	{
+		const MeshSectionRange& range = m_Header.Sections[static_cast<uint32_t>(section)];
+		return m_Data.GetBytes().subspan(range.Offset, range.Size);
+	}
+
+	std::span<const MeshLod> MeshFile::GetLods() const
+	{
+		const std::span<const std::byte> bytes = GetSection(MeshSection::Lods);
+		return { reinterpret_cast<const MeshLod*>(bytes.data()), bytes.size() / sizeof(MeshLod) };
+	}
+
+	std::span<const Meshlet> MeshFile::GetMeshlets() const
+	{
+		const std::span<const std::byte> bytes = GetSection(MeshSection::Meshlets);
+		return { reinterpret_cast<const Meshlet*>(bytes.data()), bytes.size() / sizeof(Meshlet) };
+	}
+
+	std::span<const uint32_t> MeshFile::GetMeshletVertices() const
+	{
+		const std::span<const std::byte> bytes = GetSection(MeshSection::MeshletVertices);
+		return { reinterpret_cast<const uint32_t*>(bytes.data()), bytes.size() / sizeof(uint32_t) };
+	}
+}
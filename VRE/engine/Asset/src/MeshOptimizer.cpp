@@ -0,0 +1,284 @@
+#include <MeshOptimizer.h>
+#include <algorithm>
+#include <numeric>
+
+namespace VRE
+{
+	//Triangles around each vertex, as offsets into one shared list
+	struct VertexAdjacency
+	{
+		std::vector<uint32_t> Offsets;
+		std::vector<uint32_t> Triangles;
+	};
+
+	static VertexAdjacency BuildAdjacency(std::span<const uint32_t> indices, size_t vertexCount)
+	{
+		VertexAdjacency adjacency;
+		adjacency.Offsets.assign(vertexCount + 1, 0);
+		for (uint32_t index : indices)
+		{
+			adjacency.Offsets[index + 1]++;
+		}
+		std::partial_sum(adjacency.Offsets.begin(), adjacency.Offsets.end(), adjacency.Offsets.begin());
+
+		std::vector<uint32_t> cursor(adjacency.Offsets.begin(), adjacency.Offsets.end() - 1);
+		adjacency.Triangles.resize(indices.size());
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			adjacency.Triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+		return adjacency;
+	}
+
+	//Cache misses of a FIFO cache; timestamps make the lookup O(1), a vertex is cached while it was loaded less
+	//than cacheSize misses ago
+	class VertexCacheSimulation
+	{
+		public:
+			VertexCacheSimulation(size_t vertexCount, uint32_t cacheSize) : m_LoadTime(vertexCount, 0), m_CacheSize(cacheSize) {}
+
+			bool Access(uint32_t vertex)
+			{
+				if (m_LoadTime[vertex] != 0 && m_Time - m_LoadTime[vertex] < m_CacheSize)
+				{
+					return false;
+				}
+				m_LoadTime[vertex] = ++m_Time;
+				return true;
+			}
+
+			//Every vertex counts as evicted afterwards
+			void Flush() { m_Time += m_CacheSize; }
+
+		private:
+			std::vector<uint64_t> m_LoadTime;
+			uint64_t m_Time = 0;
+			uint32_t m_CacheSize;
+	};
+
+	VertexCacheStatistics AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheSimulation cache(vertexCount, cacheSize);
+		std::vector<bool> bReferenced(vertexCount, false);
+		size_t misses = 0;
+		size_t referenced = 0;
+		for (uint32_t index : indices)
+		{
+			misses += cache.Access(index) ? 1 : 0;
+			if (!bReferenced[index])
+			{
+				bReferenced[index] = true;
+				referenced++;
+			}
+		}
+		return {
+			.Acmr = indices.size() < 3 ? 0.0f : static_cast<float>(misses) / static_cast<float>(indices.size() / 3),
+			.Atvr = referenced == 0 ? 0.0f : static_cast<float>(misses) / static_cast<float>(referenced)
+		};
+	}
+
+	std::vector<uint32_t> OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		const VertexAdjacency adjacency = BuildAdjacency(indices, vertexCount);
+		std::vector<uint32_t> liveTriangles(vertexCount);
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			liveTriangles[vertex] = adjacency.Offsets[vertex + 1] - adjacency.Offsets[vertex];
+		}
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> bEmitted(triangleCount, false);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		std::vector<uint32_t> clusters;
+
+		//Time starts past the cache size so untouched vertices read as evicted
+		uint32_t time = cacheSize + 1;
+		uint32_t cursor = 0;
+		int64_t fanVertex = vertexCount > 0 && triangleCount > 0 ? 0 : -1;
+		bool bNewCluster = true;
+		while (fanVertex >= 0)
+		{
+			if (bNewCluster)
+			{
+				clusters.push_back(static_cast<uint32_t>(result.size() / 3));
+				bNewCluster = false;
+			}
+
+			candidates.clear();
+			for (uint32_t i = adjacency.Offsets[fanVertex]; i < adjacency.Offsets[fanVertex + 1]; i++)
+			{
+				const uint32_t triangle = adjacency.Triangles[i];
+				if (bEmitted[triangle])
+				{
+					continue;
+				}
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					const uint32_t vertex = indices[triangle * 3 + corner];
+					result.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					liveTriangles[vertex]--;
+					if (time - cacheTime[vertex] > cacheSize)
+					{
+						cacheTime[vertex] = time++;
+					}
+				}
+				bEmitted[triangle] = true;
+			}
+
+			//Next fan: the candidate cached longest that won't drop out of the cache while its fan is emitted
+			fanVertex = -1;
+			int64_t bestPriority = -1;
+			for (uint32_t vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0)
+				{
+					continue;
+				}
+				int64_t priority = 0;
+				if (int64_t(time) - cacheTime[vertex] + 2 * int64_t(liveTriangles[vertex]) <= int64_t(cacheSize))
+				{
+					priority = time - cacheTime[vertex];
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fanVertex = vertex;
+				}
+			}
+			if (fanVertex >= 0)
+			{
+				continue;
+			}
+
+			//Dead end, the most recently touched vertex with triangles left, then the first one in index order
+			bNewCluster = true;
+			while (!deadEnds.empty() && fanVertex < 0)
+			{
+				if (liveTriangles[deadEnds.back()] > 0)
+				{
+					fanVertex = deadEnds.back();
+				}
+				deadEnds.pop_back();
+			}
+			while (fanVertex < 0 && cursor < vertexCount)
+			{
+				if (liveTriangles[cursor] > 0)
+				{
+					fanVertex = cursor;
+				}
+				cursor++;
+			}
+		}
+
+		std::ranges::copy(result, indices.begin());
+		return clusters;
+	}
+
+	void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const uint32_t> clusters, std::span<const glm::vec3> positions,
+		float threshold, uint32_t cacheSize)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (clusters.empty() || triangleCount == 0)
+		{
+			return;
+		}
+		const float targetAcmr = AnalyzeVertexCache(indices, positions.size(), cacheSize).Acmr * threshold;
+
+		//Soft boundaries: end a cluster wherever its own ACMR, starting cold, is already below the target
+		std::vector<uint32_t> splits;
+		VertexCacheSimulation cache(positions.size(), cacheSize);
+		for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+		{
+			const uint32_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+			uint32_t start = clusters[cluster];
+			uint32_t misses = 0;
+			cache.Flush();
+			splits.push_back(start);
+			for (uint32_t triangle = start; triangle < end; triangle++)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					misses += cache.Access(indices[triangle * 3 + corner]) ? 1 : 0;
+				}
+				if (triangle + 1 < end && static_cast<float>(misses) <= targetAcmr * static_cast<float>(triangle + 1 - start))
+				{
+					start = triangle + 1;
+					misses = 0;
+					cache.Flush();
+					splits.push_back(start);
+				}
+			}
+		}
+
+		//Area weighted centroid and normal per cluster, sorted by how far the cluster faces away from the mesh center
+		struct ClusterKey
+		{
+			uint32_t Cluster;
+			float Sort;
+		};
+		glm::vec3 meshCentroid(0.0f);
+		for (const glm::vec3& position : positions)
+		{
+			meshCentroid += position;
+		}
+		meshCentroid /= static_cast<float>(std::max<size_t>(positions.size(), 1));
+
+		std::vector<ClusterKey> keys(splits.size());
+		for (uint32_t cluster = 0; cluster < splits.size(); cluster++)
+		{
+			const uint32_t end = cluster + 1 < splits.size() ? splits[cluster + 1] : triangleCount;
+			glm::vec3 centroid(0.0f);
+			glm::vec3 normal(0.0f);
+			float area = 0.0f;
+			for (uint32_t triangle = splits[cluster]; triangle < end; triangle++)
+			{
+				const glm::vec3& a = positions[indices[triangle * 3]];
+				const glm::vec3& b = positions[indices[triangle * 3 + 1]];
+				const glm::vec3& c = positions[indices[triangle * 3 + 2]];
+				const glm::vec3 weightedNormal = glm::cross(b - a, c - a);
+				const float triangleArea = glm::length(weightedNormal);
+				centroid += (a + b + c) * (triangleArea / 3.0f);
+				normal += weightedNormal;
+				area += triangleArea;
+			}
+			centroid = area > 0.0f ? centroid / area : positions[indices[splits[cluster] * 3]];
+			const float normalLength = glm::length(normal);
+			keys[cluster] = { .Cluster = cluster, .Sort = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f };
+		}
+		std::ranges::stable_sort(keys, [](const ClusterKey& a, const ClusterKey& b) { return a.Sort > b.Sort; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (const ClusterKey& key : keys)
+		{
+			const uint32_t end = key.Cluster + 1 < splits.size() ? splits[key.Cluster + 1] : triangleCount;
+			result.insert(result.end(), indices.begin() + splits[key.Cluster] * 3, indices.begin() + end * 3);
+		}
+		std::ranges::copy(result, indices.begin());
+	}
+
+	std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, size_t vertexCount)
+	{
+		std::vector<uint32_t> remap(vertexCount, ~0u);
+		uint32_t nextVertex = 0;
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == ~0u)
+			{
+				remap[index] = nextVertex++;
+			}
+			index = remap[index];
+		}
+		return remap;
+	}
+
+	size_t GetRemappedVertexCount(std::span<const uint32_t> remap)
+	{
+		return static_cast<size_t>(std::ranges::count_if(remap, [](uint32_t index) { return index != ~0u; }));
+	}
+}
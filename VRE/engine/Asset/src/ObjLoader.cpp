@@ -0,0 +1,170 @@
+#include <ObjLoader.h>
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace VRE
+{
+	struct ObjCorner
+	{
+		int32_t Position = 0;
+		int32_t TexCoord = 0;
+		int32_t Normal = 0;
+
+		bool operator==(const ObjCorner&) const = default;
+	};
+
+	struct ObjCornerHash
+	{
+		size_t operator()(const ObjCorner& corner) const
+		{
+			return (size_t(uint32_t(corner.Position)) * 73856093u) ^ (size_t(uint32_t(corner.TexCoord)) * 19349663u) ^ (size_t(uint32_t(corner.Normal)) * 83492791u);
+		}
+	};
+
+	static std::string_view NextToken(std::string_view& line)
+	{
+		const size_t begin = line.find_first_not_of(" \t");
+		if (begin == std::string_view::npos)
+		{
+			line = {};
+			return {};
+		}
+		const size_t end = line.find_first_of(" \t", begin);
+		const std::string_view token = line.substr(begin, end - begin);
+		line = end == std::string_view::npos ? std::string_view() : line.substr(end);
+		return token;
+	}
+
+	static float ParseFloat(std::string_view token)
+	{
+		float value = 0.0f;
+		if (token.empty() || std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc())
+		{
+			throw std::runtime_error("Malformed number in OBJ file!");
+		}
+		return value;
+	}
+
+	//OBJ indices count from 1, negative ones from the end; 0 means absent and anything else out of range throws
+	static int32_t ResolveIndex(std::string_view token, size_t count)
+	{
+		if (token.empty())
+		{
+			return 0;
+		}
+		int32_t index = 0;
+		if (std::from_chars(token.data(), token.data() + token.size(), index).ec != std::errc() || index == 0)
+		{
+			throw std::runtime_error("Malformed face in OBJ file!");
+		}
+		const int64_t resolved = index > 0 ? index : int64_t(count) + index + 1;
+		if (resolved < 1 || resolved > int64_t(count))
+		{
+			throw std::runtime_error("OBJ face index out of range!");
+		}
+		return static_cast<int32_t>(resolved);
+	}
+
+	SourceMesh LoadObj(std::string_view text)
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> texCoords;
+		std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> vertexLookup;
+		std::vector<ObjCorner> corners;
+		std::vector<uint32_t> indices;
+		std::vector<uint32_t> polygon;
+
+		while (!text.empty())
+		{
+			const size_t lineEnd = text.find('\n');
+			std::string_view line = text.substr(0, lineEnd);
+			text = lineEnd == std::string_view::npos ? std::string_view() : text.substr(lineEnd + 1);
+			if (!line.empty() && line.back() == '\r')
+			{
+				line.remove_suffix(1);
+			}
+
+			const std::string_view keyword = NextToken(line);
+			if (keyword == "v")
+			{
+				const float x = ParseFloat(NextToken(line));
+				const float y = ParseFloat(NextToken(line));
+				positions.emplace_back(x, y, ParseFloat(NextToken(line)));
+			}
+			else if (keyword == "vn")
+			{
+				const float x = ParseFloat(NextToken(line));
+				const float y = ParseFloat(NextToken(line));
+				normals.emplace_back(x, y, ParseFloat(NextToken(line)));
+			}
+			else if (keyword == "vt")
+			{
+				//OBJ puts v = 0 at the bottom, Vulkan samples with v = 0 at the top
+				const float u = ParseFloat(NextToken(line));
+				const std::string_view v = NextToken(line);
+				texCoords.emplace_back(u, 1.0f - (v.empty() ? 0.0f : ParseFloat(v)));
+			}
+			else if (keyword == "f")
+			{
+				polygon.clear();
+				for (std::string_view token = NextToken(line); !token.empty(); token = NextToken(line))
+				{
+					//v, v/vt, v//vn or v/vt/vn
+					const size_t firstSlash = token.find('/');
+					const size_t secondSlash = firstSlash == std::string_view::npos ? std::string_view::npos : token.find('/', firstSlash + 1);
+					ObjCorner corner{ .Position = ResolveIndex(token.substr(0, firstSlash), positions.size()) };
+					if (corner.Position == 0)
+					{
+						throw std::runtime_error("OBJ face corner without a position!");
+					}
+					if (firstSlash != std::string_view::npos)
+					{
+						corner.TexCoord = ResolveIndex(token.substr(firstSlash + 1, secondSlash - firstSlash - 1), texCoords.size());
+					}
+					if (secondSlash != std::string_view::npos)
+					{
+						corner.Normal = ResolveIndex(token.substr(secondSlash + 1), normals.size());
+					}
+
+					const auto [vertexIt, bInserted] = vertexLookup.try_emplace(corner, static_cast<uint32_t>(corners.size()));
+					if (bInserted)
+					{
+						corners.push_back(corner);
+					}
+					polygon.push_back(vertexIt->second);
+				}
+				if (polygon.size() < 3)
+				{
+					throw std::runtime_error("OBJ face with less than three corners!");
+				}
+				for (size_t i = 1; i + 1 < polygon.size(); i++)
+				{
+					indices.insert(indices.end(), { polygon[0], polygon[i], polygon[i + 1] });
+				}
+			}
+		}
+
+		//Normals or texture coordinates missing on any corner are dropped for the whole mesh, normals get regenerated
+		const bool bHasNormals = !corners.empty() && std::ranges::all_of(corners, [](const ObjCorner& corner) { return corner.Normal != 0; });
+		const bool bHasTexCoords = !corners.empty() && std::ranges::all_of(corners, [](const ObjCorner& corner) { return corner.TexCoord != 0; });
+		SourceMesh mesh;
+		mesh.Indices = std::move(indices);
+		mesh.Positions.reserve(corners.size());
+		for (const ObjCorner& corner : corners)
+		{
+			mesh.Positions.push_back(positions[corner.Position - 1]);
+			if (bHasNormals)
+			{
+				mesh.Normals.push_back(normals[corner.Normal - 1]);
+			}
+			if (bHasTexCoords)
+			{
+				mesh.TexCoords.push_back(texCoords[corner.TexCoord - 1]);
+			}
+		}
+		return mesh;
+	}
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <Window.h>
 #include <Renderer.h>
 #include <Singleton.h>
@@ -10,6 +11,8 @@ namespace VRE
 	class Application : public Singleton<Application>{
 		public:
 			void Run();			
+			//glTF scene loaded once the renderer is up, none if empty
+			void SetScenePath(const std::string& path) { m_ScenePath = path; }
 
 		private:
 			void Init();
@@ -19,5 +22,6 @@ namespace VRE
 		private:
 			std::unique_ptr<Window> m_Window;
 			std::unique_ptr<Renderer> m_Renderer;
+			std::string m_ScenePath;
 	};
 }
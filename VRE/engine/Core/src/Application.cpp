@@ -15,6 +15,10 @@ namespace VRE
 		m_Window = std::make_unique<Window>(WindowInfo(s_WINDOW_TITLE, s_WINDOW_WIDTH, s_WINDOW_HEIGHT));
 		m_Renderer = std::make_unique<Renderer>();
 		m_Renderer->Init();
+		if (!m_ScenePath.empty())
+		{
+			m_Renderer->LoadScene(m_ScenePath);
+		}
 		m_Renderer->Run();
 	}
 
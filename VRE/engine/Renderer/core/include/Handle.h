@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace VRE
+{
+	// 32-bit typed handle: low 20 bits index into a pool, high 12 bits hold the generation of that slot.
+	// Generation 0 is never handed out, so a default constructed handle is always invalid.
+	template<typename Tag> class Handle
+	{
+		public:
+			static constexpr uint32_t k_IndexBits = 20;
+			static constexpr uint32_t k_GenerationBits = 32 - k_IndexBits;
+			static constexpr uint32_t k_MaxIndex = (1u << k_IndexBits) - 1;
+			static constexpr uint32_t k_MaxGeneration = (1u << k_GenerationBits) - 1;
+
+		public:
+			Handle() = default;
+			Handle(uint32_t index, uint32_t generation)
+				: m_Value((generation << k_IndexBits) | index)
+			{
+				assert(index <= k_MaxIndex && generation <= k_MaxGeneration);
+			}
+
+			uint32_t GetIndex() const { return m_Value & k_MaxIndex; }
+			uint32_t GetGeneration() const { return m_Value >> k_IndexBits; }
+			uint32_t GetValue() const { return m_Value; }
+			bool IsValid() const { return GetGeneration() != 0; }
+
+			bool operator==(const Handle&) const = default;
+
+		private:
+			uint32_t m_Value = 0;
+	};
+
+	struct BufferTag;
+	struct TextureTag;
+	struct PipelineTag;
+	struct ResidencyTag;
+	struct MeshTag;
+	struct GeometryTag;
+	using BufferHandle = Handle<BufferTag>;
+	using TextureHandle = Handle<TextureTag>;
+	using PipelineHandle = Handle<PipelineTag>;
+	using ResidencyHandle = Handle<ResidencyTag>;
+	using MeshHandle = Handle<MeshTag>;
+	using GeometryHandle = Handle<GeometryTag>;
+
+	// Hands out handles for one resource type and detects stale ones. Resource data itself lives in
+	// structure-of-arrays storage owned by the backend, indexed by Handle::GetIndex().
+	template<typename Tag> class HandlePool
+	{
+		public:
+			Handle<Tag> Allocate()
+			{
+				uint32_t index;
+				if (!m_FreeIndices.empty())
+				{
+					index = m_FreeIndices.back();
+					m_FreeIndices.pop_back();
+				}
+				else
+				{
+					index = static_cast<uint32_t>(m_Generations.size());
+					assert(index <= Handle<Tag>::k_MaxIndex);
+					m_Generations.push_back(1);
+				}
+				return Handle<Tag>(index, m_Generations[index]);
+			}
+
+			void Free(Handle<Tag> handle)
+			{
+				assert(IsAlive(handle));
+				//Bump the generation so every copy of the freed handle turns stale, skipping the invalid generation 0
+				uint32_t& generation = m_Generations[handle.GetIndex()];
+				generation = generation == Handle<Tag>::k_MaxGeneration ? 1 : generation + 1;
+				m_FreeIndices.push_back(handle.GetIndex());
+			}
+
+			bool IsAlive(Handle<Tag> handle) const
+			{
+				return handle.IsValid() && handle.GetIndex() < m_Generations.size() && m_Generations[handle.GetIndex()] == handle.GetGeneration();
+			}
+
+			//Current generation of a slot, rebuilds the live handle for code that walks storage by index
+			uint32_t GetGeneration(uint32_t index) const { return m_Generations[index]; }
+
+			//Number of slots ever created, structure-of-arrays storage has to be at least this large
+			uint32_t GetCapacity() const { return static_cast<uint32_t>(m_Generations.size()); }
+			uint32_t GetAliveCount() const { return GetCapacity() - static_cast<uint32_t>(m_FreeIndices.size()); }
+
+		private:
+			std::vector<uint32_t> m_Generations;
+			std::vector<uint32_t> m_FreeIndices;
+	};
+}
+
+template<typename Tag> struct std::hash<VRE::Handle<Tag>>
+{
+	size_t operator()(const VRE::Handle<Tag>& handle) const { return std::hash<uint32_t>{}(handle.GetValue()); }
+};
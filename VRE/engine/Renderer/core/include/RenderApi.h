@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <RenderStats.h>
+
 namespace VRE
 {
 	class RenderApi
@@ -19,6 +22,9 @@ namespace VRE
 			virtual void Init() = 0;
 			virtual void CleanUp() = 0;
 			virtual void DrawFrame() = 0;
+			virtual const RenderStats& GetStats() = 0;
+			//Replaces the scene drawn every frame with the default scene of a glTF file
+			virtual void LoadScene(const std::string& path) = 0;
 			API GetAPI() { return m_API; }
 
 		protected:
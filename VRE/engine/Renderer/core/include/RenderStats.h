@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace VRE
+{
+	struct MemoryHeapStats
+	{
+		uint64_t Size = 0;
+		//How much this process may use before the driver/OS starts paging or failing allocations
+		uint64_t Budget = 0;
+		uint64_t Usage = 0;
+		bool bDeviceLocal = false;
+	};
+
+	struct RenderStats
+	{
+		uint64_t FrameNumber = 0;
+		std::vector<MemoryHeapStats> MemoryHeaps;
+
+		uint32_t StreamableResourceCount = 0;
+		uint64_t StreamableResidentBytes = 0;
+		uint64_t EvictedBytes = 0;
+		//Optional allocations refused because their heap was close to its budget
+		uint32_t DeclinedAllocations = 0;
+
+		//Meshes drawn last frame and the draw calls that took, multi draws count once
+		uint32_t MeshDraws = 0;
+		uint32_t MeshDrawCalls = 0;
+
+		//Render graph passes recorded and culled last frame, and the pipeline and split barriers it placed between them
+		uint32_t RenderPasses = 0;
+		uint32_t CulledRenderPasses = 0;
+		uint32_t RenderGraphBarriers = 0;
+		uint32_t RenderGraphSplitBarriers = 0;
+		//Passes replayed from a command buffer recorded in an earlier frame instead of recorded again
+		uint32_t CachedRenderPasses = 0;
+		//Memory backing the render graph's transient images, and what they would take without aliasing
+		uint64_t TransientMemoryBytes = 0;
+		uint64_t TransientRequestedBytes = 0;
+	};
+}
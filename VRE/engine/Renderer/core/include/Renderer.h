@@ -13,6 +13,8 @@ namespace VRE
 			void Init();
 			void DrawFrame();
 			void CleanUp();
+			const RenderStats& GetStats();
+			void LoadScene(const std::string& path);
 
 		private:
 			std::unique_ptr<RenderApi> m_RenderApi;
@@ -34,4 +34,14 @@ namespace VRE {
 	{
 		m_RenderApi->CleanUp();
 	}
+
+	const RenderStats& Renderer::GetStats()
+	{
+		return m_RenderApi->GetStats();
+	}
+
+	void Renderer::LoadScene(const std::string& path)
+	{
+		m_RenderApi->LoadScene(path);
+	}
 }
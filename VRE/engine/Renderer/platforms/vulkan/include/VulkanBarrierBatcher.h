@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <vector>
+#include <VulkanCommon.h>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	// Collects barriers and records them as one DependencyInfo right before the commands that consume them, global
+	// memory barriers merged into one. Barriers whose producer finished well before the consumer can be split
+	// instead: Signal() sets an event once the work recorded so far reaches their source stages and Wait() waits on it
+	// before the consumer, so whatever is recorded in between overlaps with the producer's tail instead of draining.
+	class VulkanBarrierBatcher
+	{
+		public:
+			VulkanBarrierBatcher(const vk::raii::Device& device);
+
+			VulkanBarrierBatcher(const VulkanBarrierBatcher&) = delete;
+			VulkanBarrierBatcher& operator=(const VulkanBarrierBatcher&) = delete;
+
+			//Events of the frame slot's previous command buffer are free again once the GPU finished it
+			void BeginFrame(uint32_t frameIndex);
+
+			void AddMemoryBarrier(const vk::MemoryBarrier2& barrier);
+			void AddBufferBarrier(const vk::BufferMemoryBarrier2& barrier);
+			void AddImageBarrier(const vk::ImageMemoryBarrier2& barrier);
+			bool IsEmpty() const { return !m_Pending.HasMemory() && m_Pending.Buffers.empty() && m_Pending.Images.empty(); }
+
+			//Records everything added since the last Flush or Signal as one pipelineBarrier2
+			void Flush(const vk::raii::CommandBuffer& commandBuffer);
+			//Records everything added since the last Flush or Signal as the first half of a split barrier, Wait with the result
+			uint32_t Signal(const vk::raii::CommandBuffer& commandBuffer);
+			//Completes split barriers of this frame, each waited on exactly once
+			void Wait(const vk::raii::CommandBuffer& commandBuffer, std::span<const uint32_t> splits);
+
+			//Pipeline barriers and split barriers recorded since BeginFrame
+			uint32_t GetBarrierCount() const { return m_BarrierCount; }
+			uint32_t GetSplitBarrierCount() const { return m_SplitBarrierCount; }
+
+		private:
+			struct Batch
+			{
+				vk::MemoryBarrier2 Memory;
+				std::vector<vk::BufferMemoryBarrier2> Buffers;
+				std::vector<vk::ImageMemoryBarrier2> Images;
+
+				bool HasMemory() const { return Memory.srcStageMask || Memory.dstStageMask; }
+				//Points into the batch, which must stay put while the result is in use
+				vk::DependencyInfo GetDependencyInfo() const;
+			};
+
+			struct SplitBarrier
+			{
+				vk::Event Event;
+				Batch Barriers;
+			};
+
+		private:
+			const vk::raii::Device& m_Device;
+			Batch m_Pending;
+			//Created on demand, each frame slot uses its events from the front
+			std::array<std::vector<vk::raii::Event>, k_MaxFramesInFlight> m_Events;
+			std::vector<SplitBarrier> m_Splits;
+			uint32_t m_FrameIndex = 0;
+			uint32_t m_BarrierCount = 0;
+			uint32_t m_SplitBarrierCount = 0;
+	};
+}
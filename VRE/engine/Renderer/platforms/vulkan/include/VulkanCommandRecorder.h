@@ -0,0 +1,44 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <ThreadPool.h>
+#include <VulkanFrameCommandPool.h>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	// Records secondary command buffers in parallel on a thread pool of its own, so recording never queues behind
+	// file loading. Every worker, the calling thread included, has a VulkanFrameCommandPool of its own: no two
+	// threads ever share a pool, and a slot's pools are only reset once the GPU finished the frame that last used them.
+	class VulkanCommandRecorder
+	{
+		public:
+			//Gets the secondary command buffer to record into, already begun, and the chunk to record; runs on any thread
+			using RecordCallback = std::function<void(const vk::raii::CommandBuffer&, uint32_t)>;
+
+		public:
+			VulkanCommandRecorder(const vk::raii::Device& device, uint32_t queueFamilyIndex, uint32_t threadCount = ThreadPool::GetDefaultThreadCount());
+
+			VulkanCommandRecorder(const VulkanCommandRecorder&) = delete;
+			VulkanCommandRecorder& operator=(const VulkanCommandRecorder&) = delete;
+
+			void BeginFrame(uint32_t frameIndex);
+
+			//Workers including the calling thread, more chunks than that are recorded back to back
+			uint32_t GetWorkerCount() const { return m_ThreadPool.GetThreadCount() + 1; }
+			// Records chunkCount secondaries and returns them in chunk order, ready for executeCommands. Blocks until
+			// all are done; the calling thread records its share meanwhile. Rethrows the first exception of a chunk.
+			std::vector<vk::CommandBuffer> Record(uint32_t chunkCount, const vk::CommandBufferInheritanceInfo& inheritance, const RecordCallback& record);
+
+		private:
+			vk::CommandBuffer RecordChunk(VulkanFrameCommandPool& pool, const vk::CommandBufferInheritanceInfo& inheritance, const RecordCallback& record,
+				uint32_t chunk);
+
+		private:
+			ThreadPool m_ThreadPool;
+			//One per worker
+			std::vector<std::unique_ptr<VulkanFrameCommandPool>> m_Pools;
+	};
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+namespace VRE
+{
+	// Number of frames the CPU may record ahead of the GPU. Per-frame resources (uniform buffers,
+	// descriptor ring regions, ...) are allocated once per frame slot.
+	constexpr uint32_t k_MaxFramesInFlight = 2;
+}
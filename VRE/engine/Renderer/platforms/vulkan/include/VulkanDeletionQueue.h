@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	// Defers destruction of Vulkan objects until the GPU is done with them. Every object is tagged with the frame
+	// timeline value current at the time it was released; Collect() then destroys everything the GPU has passed in one
+	// sweep per frame, so resources can be freed at runtime without idling the device.
+	class VulkanDeletionQueue
+	{
+		public:
+			VulkanDeletionQueue(const vk::raii::Device& device);
+			~VulkanDeletionQueue();
+
+			VulkanDeletionQueue(const VulkanDeletionQueue&) = delete;
+			VulkanDeletionQueue& operator=(const VulkanDeletionQueue&) = delete;
+
+			//Timeline value the frame currently being recorded will signal, objects released from now on retire with it
+			void SetRetireValue(uint64_t retireValue) { assert(retireValue >= m_RetireValue); m_RetireValue = retireValue; }
+			uint64_t GetRetireValue() const { return m_RetireValue; }
+
+			template<typename HandleType> void Enqueue(HandleType handle)
+			{
+				if (handle)
+				{
+					m_Entries.push_back({ m_RetireValue, HandleType::objectType, (uint64_t)(static_cast<typename HandleType::CType>(handle)) });
+				}
+			}
+
+			//Destroys every object whose retire value the GPU has reached
+			void Collect(uint64_t completedValue);
+			//Destroys everything, only valid once the device is idle
+			void Flush();
+
+			size_t GetPendingCount() const { return m_Entries.size(); }
+
+		private:
+			struct Entry
+			{
+				uint64_t RetireValue;
+				vk::ObjectType Type;
+				uint64_t Handle;
+			};
+
+			void Destroy(const Entry& entry);
+
+		private:
+			const vk::raii::Device& m_Device;
+			//Retire values only grow, so entries stay sorted and Collect only ever trims the front
+			std::vector<Entry> m_Entries;
+			uint64_t m_RetireValue = 0;
+	};
+}
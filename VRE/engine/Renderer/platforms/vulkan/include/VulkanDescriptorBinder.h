@@ -0,0 +1,69 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <Handle.h>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	inline vk::ImageLayout GetDescriptorImageLayout(vk::DescriptorType type)
+	{
+		return type == vk::DescriptorType::eStorageImage ? vk::ImageLayout::eGeneral : vk::ImageLayout::eShaderReadOnlyOptimal;
+	}
+
+	// Transient descriptor set. Only valid until the frame slot it was allocated in is reused.
+	struct VulkanDescriptorSet
+	{
+		vk::DescriptorSetLayout Layout = nullptr;
+		vk::DescriptorSet Set = nullptr;	// descriptor pool backend
+		vk::DeviceSize Offset = 0;			// descriptor buffer backend, offset into the descriptor buffer
+	};
+
+	// Hides how descriptors are stored so RecordCommandBuffer stays the same whichever backend is active.
+	class VulkanDescriptorBinder
+	{
+		public:
+			enum class Backend
+			{
+				DescriptorPool = 0,
+				DescriptorBuffer = 1
+			};
+
+		public:
+			virtual ~VulkanDescriptorBinder() = default;
+
+			virtual vk::raii::DescriptorSetLayout CreateSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings) = 0;
+			virtual vk::PipelineCreateFlags GetPipelineCreateFlags() const = 0;
+
+			//Recycle every transient set allocated the last time this frame slot was used
+			virtual void BeginFrame(uint32_t frameIndex) = 0;
+			// Sets allocated between BeginRetained and EndRetained stay valid across BeginFrame, for command buffers
+			// recorded once and submitted again. They live until the next BeginRetained in the same frame slot, which
+			// recycles them; only call it once the GPU finished every submit using them.
+			virtual void BeginRetained() = 0;
+			virtual void EndRetained() = 0;
+			// Makes room for setCount more sets of layout in every frame slot, on top of a fixed budget for everything else.
+			// Call between BeginFrame and the frame's first allocation. True when the storage had to move: retained sets
+			// are gone then, and command buffers recorded with them have to be recorded again.
+			virtual bool Reserve(vk::DescriptorSetLayout layout, uint32_t setCount) = 0;
+			virtual void BeginCommandBuffer(const vk::raii::CommandBuffer& commandBuffer) = 0;
+
+			virtual VulkanDescriptorSet Allocate(vk::DescriptorSetLayout layout) = 0;
+			virtual void WriteBuffer(const VulkanDescriptorSet& set, uint32_t binding, vk::DescriptorType type,
+				BufferHandle buffer, vk::DeviceSize offset, vk::DeviceSize range) = 0;
+			//Sampled images are expected in eShaderReadOnlyOptimal, storage images in eGeneral
+			virtual void WriteImage(const VulkanDescriptorSet& set, uint32_t binding, vk::DescriptorType type,
+				TextureHandle texture, vk::Sampler sampler) = 0;
+			//For views the resource pool doesn't own, e.g. single mips, and for array bindings
+			virtual void WriteImageView(const VulkanDescriptorSet& set, uint32_t binding, uint32_t arrayElement, vk::DescriptorType type,
+				vk::ImageView view, vk::Sampler sampler) = 0;
+			virtual void BindSets(const vk::raii::CommandBuffer& commandBuffer, vk::PipelineBindPoint bindPoint,
+				vk::PipelineLayout pipelineLayout, uint32_t firstSet, std::span<const VulkanDescriptorSet> sets) = 0;
+
+			Backend GetBackend() const { return m_Backend; }
+
+		protected:
+			Backend m_Backend;
+	};
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <unordered_map>
+#include <VulkanDescriptorBinder.h>
+#include <VulkanResourcePool.h>
+
+namespace VRE
+{
+	// VK_EXT_descriptor_buffer backend. Descriptors live in a persistently mapped buffer that is split into one
+	// ring region per frame slot; sets are plain offsets into it and writes are memcpy of cached descriptor blobs.
+	// Retained sets come from a second region per frame slot behind them. Reserve grows every region at once by
+	// moving to a bigger buffer, the old one lives on until the frames recorded with it retire.
+	class VulkanDescriptorBufferBinder : public VulkanDescriptorBinder
+	{
+		public:
+			VulkanDescriptorBufferBinder(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, VulkanResourcePool& resourcePool);
+			virtual ~VulkanDescriptorBufferBinder() override;
+
+			virtual vk::raii::DescriptorSetLayout CreateSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings) override;
+			virtual vk::PipelineCreateFlags GetPipelineCreateFlags() const override { return vk::PipelineCreateFlagBits::eDescriptorBufferEXT; }
+
+			virtual void BeginFrame(uint32_t frameIndex) override;
+			virtual void BeginRetained() override;
+			virtual void EndRetained() override;
+			virtual bool Reserve(vk::DescriptorSetLayout layout, uint32_t setCount) override;
+			virtual void BeginCommandBuffer(const vk::raii::CommandBuffer& commandBuffer) override;
+
+			virtual VulkanDescriptorSet Allocate(vk::DescriptorSetLayout layout) override;
+			virtual void WriteBuffer(const VulkanDescriptorSet& set, uint32_t binding, vk::DescriptorType type,
+				BufferHandle buffer, vk::DeviceSize offset, vk::DeviceSize range) override;
+			virtual void WriteImage(const VulkanDescriptorSet& set, uint32_t binding, vk::DescriptorType type,
+				TextureHandle texture, vk::Sampler sampler) override;
+			virtual void WriteImageView(const VulkanDescriptorSet& set, uint32_t binding, uint32_t arrayElement, vk::DescriptorType type,
+				vk::ImageView view, vk::Sampler sampler) override;
+			virtual void BindSets(const vk::raii::CommandBuffer& commandBuffer, vk::PipelineBindPoint bindPoint,
+				vk::PipelineLayout pipelineLayout, uint32_t firstSet, std::span<const VulkanDescriptorSet> sets) override;
+
+		private:
+			struct LayoutInfo
+			{
+				vk::DeviceSize Size = 0;
+				std::vector<vk::DeviceSize> BindingOffsets;
+			};
+
+			struct DescriptorKey
+			{
+				vk::DescriptorType Type;
+				vk::DeviceAddress Address;
+				vk::DeviceSize Range;
+
+				bool operator==(const DescriptorKey&) const = default;
+			};
+
+			struct DescriptorKeyHash
+			{
+				size_t operator()(const DescriptorKey& key) const;
+			};
+
+			vk::DeviceSize GetMaxFrameRegionSize() const;
+			void CreateDescriptorBuffer(vk::DeviceSize frameRegionSize);
+			const std::byte* GetDescriptor(const DescriptorKey& key);
+			size_t GetDescriptorSize(vk::DescriptorType type) const;
+
+		private:
+			const vk::raii::Device& m_Device;
+			VulkanResourcePool& m_ResourcePool;
+			vk::PhysicalDeviceDescriptorBufferPropertiesEXT m_Properties;
+			BufferHandle m_DescriptorBuffer;
+			std::byte* m_DescriptorBufferData = nullptr;
+			vk::DeviceSize m_FrameRegionSize = 0;
+			vk::DeviceSize m_FrameRegionBegin = 0;
+			vk::DeviceSize m_FrameRegionHead = 0;
+			//Asked for by Reserve since BeginFrame, on top of k_DescriptorBufferFrameRegionSize
+			vk::DeviceSize m_ReservedSize = 0;
+			uint32_t m_FrameIndex = 0;
+			//Where the transient region was at when BeginRetained switched to the retained one
+			vk::DeviceSize m_TransientRegionHead = 0;
+
+			std::unordered_map<VkDescriptorSetLayout, LayoutInfo> m_Layouts;
+
+			//Descriptor blobs are fetched from the driver once per resource and memcpy'd on every later write
+			std::unordered_map<DescriptorKey, size_t, DescriptorKeyHash> m_DescriptorCacheIndex;
+			std::vector<std::byte> m_DescriptorCache;
+			size_t m_DescriptorStride = 0;
+	};
+}
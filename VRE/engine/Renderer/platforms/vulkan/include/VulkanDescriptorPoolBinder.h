@@ -0,0 +1,55 @@
+#pragma once
+
+#include <VulkanCommon.h>
+#include <VulkanDescriptorBinder.h>
+#include <VulkanResourcePool.h>
+
+namespace VRE
+{
+	// Classic backend: descriptor pools per frame slot, reset wholesale at the start of the frame. A slot starts with one
+	// pool and gets another whenever the ones it has run out, so a frame never fails for allocating too many sets.
+	// Retained sets come from a second list of pools per frame slot.
+	class VulkanDescriptorPoolBinder : public VulkanDescriptorBinder
+	{
+		public:
+			VulkanDescriptorPoolBinder(const vk::raii::Device& device, const VulkanResourcePool& resourcePool);
+
+			virtual vk::raii::DescriptorSetLayout CreateSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings) override;
+			virtual vk::PipelineCreateFlags GetPipelineCreateFlags() const override { return {}; }
+
+			virtual void BeginFrame(uint32_t frameIndex) override;
+			virtual void BeginRetained() override;
+			virtual void EndRetained() override;
+			//Pools are added on demand instead
+			virtual bool Reserve(vk::DescriptorSetLayout layout, uint32_t setCount) override { return false; }
+			virtual void BeginCommandBuffer(const vk::raii::CommandBuffer& commandBuffer) override {}
+
+			virtual VulkanDescriptorSet Allocate(vk::DescriptorSetLayout layout) override;
+			virtual void WriteBuffer(const VulkanDescriptorSet& set, uint32_t binding, vk::DescriptorType type,
+				BufferHandle buffer, vk::DeviceSize offset, vk::DeviceSize range) override;
+			virtual void WriteImage(const VulkanDescriptorSet& set, uint32_t binding, vk::DescriptorType type,
+				TextureHandle texture, vk::Sampler sampler) override;
+			virtual void WriteImageView(const VulkanDescriptorSet& set, uint32_t binding, uint32_t arrayElement, vk::DescriptorType type,
+				vk::ImageView view, vk::Sampler sampler) override;
+			virtual void BindSets(const vk::raii::CommandBuffer& commandBuffer, vk::PipelineBindPoint bindPoint,
+				vk::PipelineLayout pipelineLayout, uint32_t firstSet, std::span<const VulkanDescriptorSet> sets) override;
+
+		private:
+			struct SlotPools
+			{
+				std::vector<vk::raii::DescriptorPool> Pools;
+				//Of Pools, allocated from since the slot was last reset; the ones before it are full
+				uint32_t Current = 0;
+			};
+
+			void ResetSlot(SlotPools& slot);
+
+		private:
+			const vk::raii::Device& m_Device;
+			const VulkanResourcePool& m_ResourcePool;
+			//Transient slots first, then the retained ones
+			std::vector<SlotPools> m_Slots;
+			uint32_t m_FrameIndex = 0;
+			bool m_bRetained = false;
+	};
+}
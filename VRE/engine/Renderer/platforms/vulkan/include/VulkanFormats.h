@@ -0,0 +1,22 @@
+#pragma once
+
+#include <span>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	struct FormatBlockInfo
+	{
+		uint32_t BlockWidth = 1;
+		uint32_t BlockHeight = 1;
+		uint32_t BytesPerBlock = 4;
+	};
+
+	FormatBlockInfo GetFormatBlockInfo(vk::Format format);
+	vk::Extent3D GetMipExtent(const vk::Extent3D& extent, uint32_t mipLevel);
+	//Tightly packed size of one mip level, block compressed formats round up to whole blocks
+	vk::DeviceSize GetMipSize(vk::Format format, const vk::Extent3D& extent, uint32_t mipLevel);
+
+	//First candidate the device supports with every requested optimal tiling feature, eUndefined if none does
+	vk::Format SelectSupportedFormat(const vk::raii::PhysicalDevice& physicalDevice, std::span<const vk::Format> candidates, vk::FormatFeatureFlags features);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <VulkanCommon.h>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	// Command buffers for one recording thread, from a transient pool per frame slot. Buffers are never reset one
+	// by one: BeginFrame resets the slot's whole pool, which lets the driver recycle its command memory in one go,
+	// and puts all of the slot's buffers back on the free list. Only call it once the GPU finished the frame that
+	// last used the slot.
+	class VulkanFrameCommandPool
+	{
+		public:
+			VulkanFrameCommandPool(const vk::raii::Device& device, uint32_t queueFamilyIndex);
+
+			VulkanFrameCommandPool(const VulkanFrameCommandPool&) = delete;
+			VulkanFrameCommandPool& operator=(const VulkanFrameCommandPool&) = delete;
+
+			void BeginFrame(uint32_t frameIndex);
+
+			//In the initial state and allocated only when the free list is empty. The reference stays valid across later
+			//Allocate calls, the buffer may be recorded until the frame slot comes around again
+			vk::raii::CommandBuffer& Allocate(vk::CommandBufferLevel level);
+
+		private:
+			struct FreeList
+			{
+				//A deque so growing it never moves the buffers already handed out
+				std::deque<vk::raii::CommandBuffer> CommandBuffers;
+				//Of CommandBuffers, handed out since the pool's last reset; the rest are free
+				uint32_t UsedCount = 0;
+			};
+
+			struct FramePool
+			{
+				vk::raii::CommandPool Pool = nullptr;
+				//Primary and secondary
+				std::array<FreeList, 2> Levels;
+			};
+
+		private:
+			const vk::raii::Device& m_Device;
+			std::array<FramePool, k_MaxFramesInFlight> m_Pools;
+			uint32_t m_FrameIndex = 0;
+	};
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <map>
+#include <vector>
+#include <Handle.h>
+#include <MeshFile.h>
+#include <RangeAllocator.h>
+#include <VulkanDeletionQueue.h>
+#include <VulkanResourcePool.h>
+#include <VulkanVertexInput.h>
+
+namespace VRE
+{
+	// Where one mesh lives in the shared buffers, in vertices and indices: exactly what a draw passes as
+	// vertexOffset and firstIndex
+	struct VulkanGeometry
+	{
+		MeshVertexLayout VertexLayout = MeshVertexLayout::Interleaved;
+		MeshVertexFormat VertexFormat = MeshVertexFormat::Float;
+		vk::IndexType IndexType = vk::IndexType::eUint32;
+		uint32_t FirstVertex = 0;
+		uint32_t VertexCount = 0;
+		uint32_t FirstIndex = 0;
+		uint32_t IndexCount = 0;
+		bool bUploaded = false;
+	};
+
+	struct VulkanGeometryRegion
+	{
+		BufferHandle Buffer;
+		vk::DeviceSize Offset = 0;
+		vk::DeviceSize Size = 0;
+	};
+
+	// Holds the vertices and indices of every mesh in a few large device local buffers: one per vertex layout and
+	// format, one per index type. Meshes get ranges from a RangeAllocator, so meshes sharing a buffer draw with one
+	// vertex and index buffer bind. A full buffer doubles and copies its contents over; ranges of unloaded meshes are
+	// reused once the GPU is past the frames that drew them, and Record() closes holes by moving the highest meshes
+	// down a few megabytes per frame. Offsets change when that happens, so look them up at record time.
+	class VulkanGeometryPool
+	{
+		public:
+			VulkanGeometryPool(VulkanResourcePool& resourcePool, VulkanDeletionQueue& deletionQueue);
+			~VulkanGeometryPool();
+
+			VulkanGeometryPool(const VulkanGeometryPool&) = delete;
+			VulkanGeometryPool& operator=(const VulkanGeometryPool&) = delete;
+
+			GeometryHandle Allocate(MeshVertexLayout layout, MeshVertexFormat format, uint32_t vertexCount, vk::IndexType indexType, uint32_t indexCount);
+			void Free(GeometryHandle handle);
+			bool IsValid(GeometryHandle handle) const { return m_Handles.IsAlive(handle); }
+			const VulkanGeometry& Get(GeometryHandle handle) const { assert(IsValid(handle)); return m_Geometries[handle.GetIndex()]; }
+			//Call once every byte of the geometry is recorded, only uploaded geometry gets moved
+			void MarkUploaded(GeometryHandle handle) { assert(IsValid(handle)); m_Geometries[handle.GetIndex()].bUploaded = true; }
+
+			//Interleaved vertices or the position stream, the attribute stream (no buffer for interleaved), the indices
+			VulkanGeometryRegion GetPositionRegion(GeometryHandle handle) const;
+			VulkanGeometryRegion GetAttributeRegion(GeometryHandle handle) const;
+			VulkanGeometryRegion GetIndexRegion(GeometryHandle handle) const;
+
+			//Invalid until the first geometry of that kind is allocated
+			BufferHandle GetVertexBuffer(MeshVertexLayout layout, MeshVertexFormat format) const { return m_Arenas[GetVertexArena(layout, format)].Buffer; }
+			//Where the attribute stream of a streamed buffer starts
+			vk::DeviceSize GetAttributeOffset(MeshVertexLayout layout, MeshVertexFormat format) const;
+			BufferHandle GetIndexBuffer(vk::IndexType indexType) const { return m_Arenas[GetIndexArena(indexType)].Buffer; }
+
+			//Gives back the ranges of frames the GPU has finished
+			void Collect(uint64_t completedValue);
+			//Copies grown buffers and compacts, before anything else reads or writes the pool this frame
+			void Record(const vk::raii::CommandBuffer& commandBuffer);
+			//Changes whenever Record moves geometry or retires a buffer, so anything recorded with older offsets is stale
+			uint64_t GetVersion() const { return m_Version; }
+
+			vk::DeviceSize GetCapacity() const;
+			vk::DeviceSize GetFreeSize() const;
+
+		private:
+			//Elements are vertices or indices; a streamed buffer keeps Capacity positions, then Capacity attributes
+			struct Arena
+			{
+				VulkanVertexStrides Strides;
+				vk::BufferUsageFlags Usage;
+				BufferHandle Buffer;
+				RangeAllocator Allocator;
+				//Live ranges by first element, compaction moves the last ones
+				std::map<uint64_t, GeometryHandle> Ranges;
+				//Buffer the contents still have to be copied from after growing, with its capacity
+				BufferHandle GrowSource;
+				uint64_t GrowSourceCapacity = 0;
+			};
+
+			struct PendingFree
+			{
+				uint64_t RetireValue;
+				uint32_t Arena;
+				uint64_t First;
+				uint64_t Count;
+			};
+
+			static uint32_t GetVertexArena(MeshVertexLayout layout, MeshVertexFormat format);
+			static uint32_t GetIndexArena(vk::IndexType indexType) { return indexType == vk::IndexType::eUint16 ? 4 : 5; }
+			uint64_t AllocateRange(uint32_t arenaIndex, uint64_t count);
+			void Grow(Arena& arena, uint64_t minCapacity);
+			void RecordGrowCopy(const vk::raii::CommandBuffer& commandBuffer, Arena& arena);
+			//Moves the highest ranges into lower holes and appends the copies, returns the bytes moved
+			vk::DeviceSize Compact(uint32_t arenaIndex, vk::DeviceSize budget, std::vector<vk::BufferCopy>& moves);
+
+		private:
+			VulkanResourcePool& m_ResourcePool;
+			VulkanDeletionQueue& m_DeletionQueue;
+			HandlePool<GeometryTag> m_Handles;
+			std::vector<VulkanGeometry> m_Geometries;
+			//Four vertex buffers by layout and format, then 16 and 32-bit indices
+			std::array<Arena, 6> m_Arenas;
+			std::vector<PendingFree> m_PendingFrees;
+			uint64_t m_Version = 0;
+	};
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <Compression.h>
+#include <PakArchive.h>
+#include <VulkanDescriptorBinder.h>
+#include <VulkanResourcePool.h>
+#include <VulkanUploadContext.h>
+
+namespace VRE
+{
+	struct CompressedChunk
+	{
+		CompressionCodec Codec = CompressionCodec::None;
+		std::span<const std::byte> Data;
+		//Decompressed size
+		uint32_t Size = 0;
+	};
+
+	// Decompresses streamed data on the GPU with decompressShader.slang, one workgroup per LZ4 chunk. Chunks are
+	// staged exactly as stored, so staging memory and upload bandwidth shrink by the compression ratio and the CPU
+	// never touches the decompressed bytes. Raw chunks become plain copies and codecs the shader can't decode (zstd)
+	// fall back to the CPU decoder writing straight into staging memory.
+	class VulkanGpuDecompressor
+	{
+		public:
+			//Compressed bytes and LZ4 chunks one frame can decompress on the GPU
+			static constexpr vk::DeviceSize k_InputBufferSize = 16 * 1024 * 1024;
+			static constexpr uint32_t k_MaxChunksPerFrame = 1024;
+
+			VulkanGpuDecompressor(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, VulkanResourcePool& resourcePool,
+				VulkanUploadContext& uploadContext, VulkanDescriptorBinder& descriptorBinder, const std::string& shaderPath);
+			~VulkanGpuDecompressor();
+
+			VulkanGpuDecompressor(const VulkanGpuDecompressor&) = delete;
+			VulkanGpuDecompressor& operator=(const VulkanGpuDecompressor&) = delete;
+
+			//Chunks are written back to back from destinationOffset, the destination needs storage, transfer dst and
+			//device address usage (the descriptor buffer backend binds by address).
+			//False when this frame's staging or input budget is used up, try again next frame.
+			bool Decompress(std::span<const CompressedChunk> chunks, BufferHandle destination, vk::DeviceSize destinationOffset);
+			bool Decompress(const PakArchive& pak, const PakFileEntry& entry, BufferHandle destination, vk::DeviceSize destinationOffset);
+			//Larger destinations can't be bound whole or addressed by the shader, their chunks decode on the CPU
+			vk::DeviceSize GetMaxDestinationSize() const { return m_MaxDestinationSize; }
+			//Everything queued this frame, destinations are readable by any later command
+			void Record(const vk::raii::CommandBuffer& commandBuffer);
+
+			//Decodes LZ4 on the CPU as well, to compare the shader against the reference decoder or work around it
+			void SetCpuFallback(bool bEnabled) { m_bCpuFallback = bEnabled; }
+
+		private:
+			//Matches ChunkDesc in decompressShader.slang
+			struct ChunkDesc
+			{
+				uint32_t InputOffset;
+				uint32_t InputSize;
+				uint32_t OutputOffset;
+				uint32_t OutputSize;
+			};
+
+			struct Copy
+			{
+				vk::Buffer Source;
+				BufferHandle Destination;
+				vk::BufferCopy Region;
+			};
+
+			struct Dispatch
+			{
+				BufferHandle Destination;
+				uint32_t FirstChunk = 0;
+				uint32_t ChunkCount = 0;
+			};
+
+		private:
+			const vk::raii::Device& m_Device;
+			VulkanResourcePool& m_ResourcePool;
+			VulkanUploadContext& m_UploadContext;
+			VulkanDescriptorBinder& m_DescriptorBinder;
+
+			vk::raii::DescriptorSetLayout m_SetLayout = nullptr;
+			PipelineHandle m_Pipeline;
+			BufferHandle m_InputBuffer;
+			BufferHandle m_ChunkBuffer;
+			vk::DeviceSize m_MaxDestinationSize = 0;
+			bool m_bCpuFallback = false;
+
+			//Queued for the next Record
+			std::vector<Copy> m_Copies;
+			std::vector<ChunkDesc> m_Chunks;
+			std::vector<Dispatch> m_Dispatches;
+			vk::DeviceSize m_InputHead = 0;
+	};
+}
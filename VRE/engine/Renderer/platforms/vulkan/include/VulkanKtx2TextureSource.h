@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <VulkanTextureSource.h>
+
+namespace VRE
+{
+	// KTX2 texture for the streamer. Plain and zstd supercompressed files hold GPU formats that are uploaded as is;
+	// Basis Universal files (ETC1S/BasisLZ and UASTC) are transcoded to the best block format the device samples
+	// from: BC7, ASTC 4x4, ETC2, then BC3/BC1, with RGBA8 as the last resort. ReadMip does the decompression and
+	// transcoding, so it runs per mip on the streamer's worker threads, and so does the header parsing in Open.
+	// Only 2D textures with one layer and face. zstd needs VRE_ENABLE_ZSTD and Basis needs VRE_ENABLE_BASISU,
+	// unsupported files fail Open.
+	class VulkanKtx2TextureSource : public VulkanTextureSource
+	{
+		public:
+			//Nothing is read until Open, the physical device has to outlive the source
+			VulkanKtx2TextureSource(std::string path, const vk::raii::PhysicalDevice& physicalDevice);
+			virtual ~VulkanKtx2TextureSource() override;
+
+			virtual bool Open() override;
+			virtual const TextureSourceInfo& GetInfo() const override { return m_Info; }
+			virtual bool ReadMip(uint32_t mipLevel, std::vector<std::byte>& data) const override;
+
+		private:
+			enum class Encoding
+			{
+				Raw,
+				Zstd,
+				Basis
+			};
+
+			struct LevelIndex
+			{
+				uint64_t ByteOffset = 0;
+				uint64_t ByteLength = 0;
+				uint64_t UncompressedByteLength = 0;
+			};
+
+			//Defined only when Basis support is compiled in
+			struct BasisState;
+
+			bool InitBasis(bool bSrgb);
+
+		private:
+			std::string m_Path;
+			const vk::raii::PhysicalDevice& m_PhysicalDevice;
+			TextureSourceInfo m_Info;
+			Encoding m_Encoding = Encoding::Raw;
+			std::vector<LevelIndex> m_Levels;
+			std::unique_ptr<BasisState> m_Basis;
+	};
+}
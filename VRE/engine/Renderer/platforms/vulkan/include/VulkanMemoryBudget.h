@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <RenderStats.h>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	// Per-heap memory budget and usage. With VK_EXT_memory_budget both come from the driver and include other
+	// processes' pressure; without it the budget is a fixed fraction of the heap size and usage is whatever this
+	// process allocated through the resource pool. Allocations update the usage estimate until the next Poll().
+	class VulkanMemoryBudget
+	{
+		public:
+			VulkanMemoryBudget(const vk::raii::PhysicalDevice& physicalDevice, bool bMemoryBudgetSupported);
+
+			//Refreshes budget and usage, meant to be called once per frame
+			void Poll();
+
+			void OnAllocate(uint32_t memoryTypeIndex, vk::DeviceSize size);
+			void OnFree(uint32_t memoryTypeIndex, vk::DeviceSize size);
+
+			uint32_t GetHeapIndex(uint32_t memoryTypeIndex) const { return m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex; }
+			uint32_t GetHeapCount() const { return m_MemoryProperties.memoryHeapCount; }
+			vk::DeviceSize GetBudget(uint32_t heapIndex) const { return m_Heaps[heapIndex].Budget; }
+			vk::DeviceSize GetUsage(uint32_t heapIndex) const { return m_Heaps[heapIndex].Usage; }
+			const std::vector<MemoryHeapStats>& GetHeapStats() const { return m_Heaps; }
+			bool IsMemoryBudgetSupported() const { return m_bMemoryBudgetSupported; }
+
+		private:
+			const vk::raii::PhysicalDevice& m_PhysicalDevice;
+			vk::PhysicalDeviceMemoryProperties m_MemoryProperties;
+			bool m_bMemoryBudgetSupported;
+
+			std::vector<MemoryHeapStats> m_Heaps;
+			//Bytes allocated by this process per heap, the only usage figure available without the extension
+			std::vector<vk::DeviceSize> m_TrackedUsage;
+	};
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <MeshFile.h>
+#include <ThreadPool.h>
+#include <VulkanGeometryPool.h>
+#include <VulkanGpuDecompressor.h>
+#include <VulkanResourcePool.h>
+#include <VulkanUploadContext.h>
+#include <glm/glm.hpp>
+
+namespace VRE
+{
+	struct VulkanMesh
+	{
+		//Vertices and indices in the shared buffers of the geometry pool
+		GeometryHandle Geometry;
+		vk::IndexType IndexType = vk::IndexType::eUint32;
+		MeshVertexLayout VertexLayout = MeshVertexLayout::Interleaved;
+		MeshVertexFormat VertexFormat = MeshVertexFormat::Float;
+		uint32_t VertexCount = 0;
+		MeshBounds Bounds = {};
+		std::vector<MeshLod> Lods;
+		//Storage buffers of the meshlet sections, only created when the loader uploads meshlets
+		BufferHandle MeshletBuffer;
+		BufferHandle MeshletVertexBuffer;
+		BufferHandle MeshletTriangleBuffer;
+		//Of the largest meshlets, mesh shaders can only emit so much per group
+		uint32_t MaxMeshletVertices = 0;
+		uint32_t MaxMeshletTriangles = 0;
+		bool bReady = false;
+	};
+
+	// One mesh placed in the world, e.g. a glTF node's primitive
+	struct VulkanMeshInstance
+	{
+		MeshHandle Mesh;
+		glm::mat4 Transform = glm::mat4(1.0f);
+
+		bool operator==(const VulkanMeshInstance&) const = default;
+	};
+
+	// Loads cooked .vmesh files into ranges of the geometry pool's vertex and index buffers. Files are read through
+	// the VirtualFileSystem in the background and stay mapped while their sections are copied into staging memory as
+	// they are, spread over as many frames as the staging budget needs, and are released once the last copy is
+	// recorded. With bMeshlets the meshlet sections are uploaded as storage buffers of their own.
+	// Files stored compressed in a pak skip the CPU decoder when there is a GPU decompressor: a worker decodes just the
+	// header, LODs and meshlets the CPU needs, the chunks are staged as stored and decompress into a scratch buffer
+	// the sections are copied out of on the GPU.
+	class VulkanMeshLoader
+	{
+		public:
+			//Without gpuDecompressor every file decompresses on the CPU
+			VulkanMeshLoader(VulkanResourcePool& resourcePool, VulkanGeometryPool& geometryPool, VulkanUploadContext& uploadContext, ThreadPool& threadPool,
+				VulkanGpuDecompressor* gpuDecompressor, bool bMeshlets);
+			~VulkanMeshLoader();
+
+			VulkanMeshLoader(const VulkanMeshLoader&) = delete;
+			VulkanMeshLoader& operator=(const VulkanMeshLoader&) = delete;
+
+			//Returns right away and reads the file in the background, don't draw the mesh before IsReady. A missing file
+			//or one that is not a current .vmesh never becomes ready
+			MeshHandle LoadMesh(std::string_view path);
+			//For meshes cooked in memory, e.g. by the glTF import
+			MeshHandle LoadMesh(std::shared_ptr<MeshFile> file);
+			void UnloadMesh(MeshHandle mesh);
+			bool IsValid(MeshHandle mesh) const { return m_Handles.IsAlive(mesh); }
+			bool IsReady(MeshHandle mesh) const { return GetMesh(mesh).bReady; }
+			const VulkanMesh& GetMesh(MeshHandle mesh) const { assert(IsValid(mesh)); return m_Meshes[mesh.GetIndex()]; }
+
+			//Sets up the meshes whose reads completed, before the geometry pool's Record
+			void BeginFrame();
+			//Copies as much pending mesh data as this frame's staging budget allows, after the geometry pool's Record
+			void Record(const vk::raii::CommandBuffer& commandBuffer);
+
+		private:
+			//The streamed layout's vertex section goes to two places in the geometry pool
+			enum class UploadPart : uint32_t
+			{
+				Positions,
+				Attributes,
+				Indices,
+				Meshlets,
+				MeshletVertices,
+				MeshletTriangles,
+				Count
+			};
+
+			//Header and the sections the CPU reads of a pak file whose chunks decompress on the GPU
+			struct PakMesh
+			{
+				VirtualFileSystem::PakFileRef File;
+				MeshFileHeader Header;
+				std::vector<MeshLod> Lods;
+				std::vector<Meshlet> Meshlets;
+			};
+
+			struct PendingUpload
+			{
+				MeshHandle Mesh;
+				//Sections copied through staging
+				std::shared_ptr<MeshFile> File;
+				//Or pak chunks decompressed into FileBuffer, which holds the whole file once the decompressor recorded
+				//the last of them
+				VirtualFileSystem::PakFileRef PakFile = {};
+				MeshFileHeader Header = {};
+				BufferHandle FileBuffer = {};
+				uint32_t ChunksQueued = 0;
+				std::array<vk::DeviceSize, static_cast<size_t>(UploadPart::Count)> BytesDone = {};
+			};
+
+			struct CompletedRead
+			{
+				MeshHandle Mesh;
+				std::optional<FileData> Data;
+				std::optional<PakMesh> Pak;
+			};
+
+			//Shared with the read callbacks, which may still run after the loader is gone
+			struct ReadQueue
+			{
+				std::mutex Mutex;
+				std::vector<CompletedRead> Reads;
+			};
+
+			//Runs on a worker, nullopt if the file is not a current .vmesh
+			static std::optional<PakMesh> ReadPakMesh(const VirtualFileSystem::PakFileRef& file);
+
+			MeshHandle AllocateHandle();
+			//Allocates the mesh's geometry, the caller queues the upload
+			void CreateMesh(MeshHandle handle, const MeshFileHeader& header, std::span<const MeshLod> lods, std::span<const Meshlet> meshlets);
+			//Copies the rest of source from done onwards as far as staging allows, true once all of it is recorded
+			bool UploadSection(const vk::raii::CommandBuffer& commandBuffer, std::span<const std::byte> source, const VulkanGeometryRegion& destination,
+				vk::DeviceSize& done);
+			//Queues the file's chunks with the decompressor, then copies the sections out a frame later; true once done
+			bool UploadDecompressed(const vk::raii::CommandBuffer& commandBuffer, PendingUpload& upload,
+				std::span<const VulkanGeometryRegion> destinations);
+
+		private:
+			VulkanResourcePool& m_ResourcePool;
+			VulkanGeometryPool& m_GeometryPool;
+			VulkanUploadContext& m_UploadContext;
+			ThreadPool& m_ThreadPool;
+			VulkanGpuDecompressor* m_GpuDecompressor = nullptr;
+			HandlePool<MeshTag> m_Handles;
+			std::vector<VulkanMesh> m_Meshes;
+			std::deque<PendingUpload> m_Uploads;
+			std::shared_ptr<ReadQueue> m_CompletedReads = std::make_shared<ReadQueue>();
+			bool m_bMeshlets = false;
+	};
+}
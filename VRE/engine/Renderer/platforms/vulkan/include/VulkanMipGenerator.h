@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <VulkanDeletionQueue.h>
+#include <VulkanDescriptorBinder.h>
+#include <VulkanResourcePool.h>
+
+namespace VRE
+{
+	enum class MipFilter : uint32_t
+	{
+		Box = 0,
+		//Kaiser windowed sinc, sharper than box; the levels the shader reduces in registers always use box
+		Kaiser = 1
+	};
+
+	// Builds mip chains on the GPU with a single pass downsampler (downsampleShader.slang). One dispatch writes up
+	// to 12 levels: workgroups reduce 64x64 tiles down to the sixth level and the last one to finish, found with a
+	// global atomic counter, reduces that to the remaining six, so there is no barrier between levels. Textures need
+	// sampled and storage usage and a format that supports storage images, which rules out sRGB on most devices.
+	class VulkanMipGenerator
+	{
+		public:
+			static constexpr uint32_t k_MaxMipsPerDispatch = 12;
+
+			//Needs quad subgroup operations in compute shaders
+			static bool IsSupported(const vk::raii::PhysicalDevice& physicalDevice);
+
+			VulkanMipGenerator(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, VulkanResourcePool& resourcePool,
+				VulkanDescriptorBinder& descriptorBinder, VulkanDeletionQueue& deletionQueue, const std::string& shaderPath);
+			~VulkanMipGenerator();
+
+			VulkanMipGenerator(const VulkanMipGenerator&) = delete;
+			VulkanMipGenerator& operator=(const VulkanMipGenerator&) = delete;
+
+			//Rebuilds every level below mip 0 at the next Record, the texture ends up in eShaderReadOnlyOptimal
+			void GenerateMips(TextureHandle texture, MipFilter filter = MipFilter::Box, vk::ImageLayout currentLayout = vk::ImageLayout::eShaderReadOnlyOptimal);
+			void Record(const vk::raii::CommandBuffer& commandBuffer);
+			//Records right away, for render targets that need their chain in the middle of a frame
+			void RecordMips(const vk::raii::CommandBuffer& commandBuffer, TextureHandle texture, MipFilter filter, vk::ImageLayout currentLayout);
+
+		private:
+			struct Request
+			{
+				TextureHandle Texture;
+				MipFilter Filter = MipFilter::Box;
+				vk::ImageLayout CurrentLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+			};
+
+			//Levels one dispatch may write starting from a mip of this format, 0 if it can't be a storage image
+			uint32_t GetMaxMipsPerDispatch(vk::Format format) const;
+
+		private:
+			const vk::raii::Device& m_Device;
+			const vk::raii::PhysicalDevice& m_PhysicalDevice;
+			VulkanResourcePool& m_ResourcePool;
+			VulkanDescriptorBinder& m_DescriptorBinder;
+			VulkanDeletionQueue& m_DeletionQueue;
+
+			vk::raii::DescriptorSetLayout m_SetLayout = nullptr;
+			PipelineHandle m_Pipeline;
+			BufferHandle m_WorkGroupCounter;
+			bool m_bCounterCleared = false;
+
+			std::vector<Request> m_Requests;
+	};
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <VulkanDescriptorBinder.h>
+#include <VulkanResourcePool.h>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	struct VulkanPerDrawBinding
+	{
+		uint32_t Binding = 0;
+		vk::DescriptorType Type = vk::DescriptorType::eUniformBuffer;
+		BufferHandle Buffer;
+		vk::DeviceSize Offset = 0;
+		vk::DeviceSize Range = vk::WholeSize;
+
+		bool operator==(const VulkanPerDrawBinding&) const = default;
+	};
+
+	// Cheapest available path for data that changes on every draw.
+	//  - Payloads that fit in maxPushConstantsSize are pushed inline as push constants.
+	//  - Bigger payloads are copied into a per-frame mapped ring buffer and only its 8 byte device address is pushed,
+	//    shaders compiled for such a payload read it through the address instead.
+	//  - A few per-draw buffer bindings go through VK_KHR_push_descriptor, or a transient set from the descriptor
+	//    binder when push descriptors are unavailable or the descriptor buffer backend is active. Those sets are shared
+	//    by every call of the frame with the same layout and bindings, so repeated draws of a mesh allocate one.
+	// PushData and PushBindings may be called from several recording threads at once. Between BeginRetained and
+	// EndRetained the ring and descriptor sets come from storage of the frame slot that outlives the frame, see
+	// VulkanDescriptorBinder::BeginRetained; the binder has to be switched along with it.
+	class VulkanPerDrawData
+	{
+		public:
+			VulkanPerDrawData(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, VulkanResourcePool& resourcePool,
+				VulkanDescriptorBinder& descriptorBinder, bool bPushDescriptorSupported);
+			~VulkanPerDrawData();
+
+			//Push constant range a pipeline layout has to declare for a per-draw payload of payloadSize bytes
+			vk::PushConstantRange GetPushConstantRange(uint32_t payloadSize, vk::ShaderStageFlags stages) const;
+			bool FitsInPushConstants(uint32_t payloadSize) const { return payloadSize <= m_MaxPushConstantsSize; }
+			bool UsesPushDescriptors() const { return m_bUsePushDescriptors; }
+
+			vk::raii::DescriptorSetLayout CreatePerDrawSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings);
+
+			void BeginFrame(uint32_t frameIndex);
+			void BeginRetained();
+			void EndRetained();
+			void PushData(const vk::raii::CommandBuffer& commandBuffer, vk::PipelineLayout pipelineLayout, vk::ShaderStageFlags stages,
+				const void* data, uint32_t size);
+			void PushBindings(const vk::raii::CommandBuffer& commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout,
+				vk::DescriptorSetLayout setLayout, uint32_t set, std::span<const VulkanPerDrawBinding> bindings);
+
+		private:
+			struct BindingsKey
+			{
+				vk::DescriptorSetLayout Layout;
+				std::vector<VulkanPerDrawBinding> Bindings;
+
+				bool operator==(const BindingsKey&) const = default;
+			};
+
+			struct BindingsKeyHash
+			{
+				size_t operator()(const BindingsKey& key) const;
+			};
+
+			vk::DeviceAddress AllocateRing(const void* data, uint32_t size);
+
+		private:
+			const vk::raii::Device& m_Device;
+			VulkanResourcePool& m_ResourcePool;
+			VulkanDescriptorBinder& m_DescriptorBinder;
+			bool m_bUsePushDescriptors = false;
+			uint32_t m_MaxPushConstantsSize = 0;
+
+			//Transient rings first, then the retained ones
+			std::vector<BufferHandle> m_RingBuffers;
+			vk::DeviceSize m_RingHead = 0;
+			vk::DeviceSize m_RetainedRingHead = 0;
+			bool m_bRetained = false;
+			uint32_t m_FrameIndex = 0;
+			//Descriptor binder fallback sets of this frame and of the retained recording
+			std::unordered_map<BindingsKey, VulkanDescriptorSet, BindingsKeyHash> m_Sets;
+			std::unordered_map<BindingsKey, VulkanDescriptorSet, BindingsKeyHash> m_RetainedSets;
+			//Guards the ring and the descriptor binder fallback, pushing straight into the command buffer needs no lock
+			std::mutex m_Mutex;
+	};
+}
@@ -1,6 +1,29 @@
 #pragma once
 
+#include <array>
+#include <memory>
+#include <span>
 #include <RenderApi.h>
+#include <VulkanBarrierBatcher.h>
+#include <VulkanCommandRecorder.h>
+#include <VulkanCommon.h>
+#include <VulkanDeletionQueue.h>
+#include <VulkanDescriptorBinder.h>
+#include <VulkanFrameCommandPool.h>
+#include <VulkanGeometryPool.h>
+#include <VulkanGpuDecompressor.h>
+#include <VulkanMemoryBudget.h>
+#include <VulkanMeshLoader.h>
+#include <VulkanMipGenerator.h>
+#include <VulkanPerDrawData.h>
+#include <VulkanRenderGraph.h>
+#include <VulkanResidencyManager.h>
+#include <VulkanTextureStreamer.h>
+#include <VulkanTransientPool.h>
+#include <VulkanUploadContext.h>
+#include <VulkanVertexInput.h>
+#include <VulkanVirtualTexture.h>
+#include <VulkanResourcePool.h>
 #include <vulkan/vulkan_raii.hpp>
 
 namespace VRE
@@ -10,7 +33,69 @@ namespace VRE
 		virtual void Init() override;
 		virtual void CleanUp() override;
 		virtual void DrawFrame() override;
+		virtual const RenderStats& GetStats() override;
+		virtual void LoadScene(const std::string& path) override;
 		vk::raii::Device& GetDevice() { return m_Device; }
+		VulkanResourcePool& GetResourcePool() { return *m_ResourcePool; }
+		VulkanResidencyManager& GetResidencyManager() { return *m_ResidencyManager; }
+		VulkanTextureStreamer& GetTextureStreamer() { return *m_TextureStreamer; }
+		//Uploads compressed chunks, e.g. straight out of a pak, and decompresses them in this frame's command buffer
+		VulkanGpuDecompressor& GetGpuDecompressor() { return *m_GpuDecompressor; }
+		//Streams a .ktx2 file, Basis Universal textures get transcoded to a block format the device supports
+		TextureHandle LoadKtx2Texture(const std::string& path);
+		//Loads a .vmesh written by vre_cook, its buffers fill over the next frames
+		MeshHandle LoadMesh(const std::string& path);
+		//Decodes and cooks every primitive on the worker threads, then queues them all for upload; one instance per
+		//node and primitive of the default scene
+		std::vector<VulkanMeshInstance> LoadGltfScene(const std::string& path);
+		VulkanMeshLoader& GetMeshLoader() { return *m_MeshLoader; }
+		//Vertices and indices of every loaded mesh
+		VulkanGeometryPool& GetGeometryPool() { return *m_GeometryPool; }
+		// Queues a draw of LOD 0 for the next frame, skipped while the mesh is still uploading. Vertex path draws of
+		// meshes sharing a geometry pool buffer go out as one multi draw indirect.
+		void DrawMesh(MeshHandle mesh, const glm::mat4& transform);
+		//Camera of the next frames, Vulkan clip space: y points down and depth goes from 0 to 1
+		void SetViewProjection(const glm::mat4& viewProjection) { m_ViewProjection = viewProjection; }
+		// Meshes draw through task and mesh shaders that cull meshlets on the GPU when the device has
+		// VK_EXT_mesh_shader, otherwise through the vertex pipeline; switching back and forth is allowed every frame
+		bool IsMeshShadingSupported() const { return m_bMeshShadingSupported; }
+		bool IsMeshShadingEnabled() const { return m_bMeshShadingEnabled; }
+		void SetMeshShadingEnabled(bool bEnabled) { m_bMeshShadingEnabled = bEnabled && m_bMeshShadingSupported; }
+		// Vertex path meshes fetch their vertices from the vertex buffer as a storage buffer instead of through
+		// vertex input state, so every layout and format draws with the same pipeline
+		bool IsVertexPullingEnabled() const { return m_bVertexPullingEnabled; }
+		void SetVertexPullingEnabled(bool bEnabled) { m_bVertexPullingEnabled = bEnabled; }
+		// Keeps the main pass's recording per frame slot and replays it while the queued draws, the camera, the geometry
+		// pool and the swapchain stay the same as the frame before; anything else re-records. For static views, where
+		// recording would otherwise be all of the frame's CPU time
+		bool IsStaticFrameCachingEnabled() const { return m_bStaticFrameCaching; }
+		void SetStaticFrameCaching(bool bEnabled);
+		//Rebuilds the chain below mip 0 in this frame's command buffer, see VulkanMipGenerator for texture requirements
+		void GenerateMips(TextureHandle texture, MipFilter filter = MipFilter::Box);
+		//Its feedback pass runs every frame once SetFeedbackCallback gave it something to draw
+		VulkanVirtualTexture& CreateVirtualTexture(const VirtualTextureDesc& desc, std::shared_ptr<VulkanVirtualTextureSource> source);
+
+	private:
+		//Everything the main pass's recording depends on besides buffer contents it only references
+		struct MainPassKey
+		{
+			std::vector<VulkanMeshInstance> Draws;
+			uint64_t GeometryVersion = 0;
+			glm::mat4 ViewProjection = glm::mat4(1.0f);
+			vk::Extent2D Extent;
+			vk::Format Format = vk::Format::eUndefined;
+			bool bMeshShading = false;
+			bool bVertexPulling = false;
+
+			bool operator==(const MainPassKey&) const = default;
+		};
+		struct CachedMainPass
+		{
+			vk::raii::CommandBuffer CommandBuffer = nullptr;
+			bool bValid = false;
+			uint32_t MeshDraws = 0;
+			uint32_t MeshDrawCalls = 0;
+		};
 
 	private:
 		void CreateInstance();
@@ -18,22 +103,59 @@ namespace VRE
 		void PickPhysicalDevice();
 		std::vector<const char*> GetRequiredExtensions();
 		void CreateLogicalDevice();
+		bool IsDeviceExtensionEnabled(const char* extensionName) const;
+		void CreateDescriptorBinder();
+		void CreatePerDrawData();
+		void CreateTextureStreamer();
+		void CreateMipGenerator();
+		void CreateGpuDecompressor();
+		void CreateMeshLoader();
+		void CreateDescriptorSetLayouts();
+		void CreateUniformBuffers();
+		void UpdateUniformBuffer(uint32_t currentFrame);
 		void CreateSwapChain();
 		void CreateImageViews();
 		void CreateShaderModule();
 		void CreateGraphicsPipeline();
+		//One per vertex layout and format, indexed by GetMeshPipelineIndex
+		void CreateMeshPipelines();
+		//Without vertexInput the stages are task and mesh shaders, drawSetLayout goes to set 1 when given
+		PipelineHandle BuildGraphicsPipeline(std::span<const vk::PipelineShaderStageCreateInfo> stages,
+			const vk::PipelineVertexInputStateCreateInfo* vertexInput, vk::DescriptorSetLayout drawSetLayout,
+			vk::ShaderStageFlags drawConstantStages, uint32_t drawConstantsSize);
+		//Sizes the descriptor binder for the per-draw sets of the queued draws, before the frame allocates any
+		void ReservePerDrawSets();
+		//Sorts the queued mesh draws into batches and splits them into items, on the recording thread
+		void PrepareMeshDraws();
+		//Records items [begin, end) and returns the draw calls; safe to call for disjoint ranges from several threads
+		uint32_t RecordMeshDrawItems(const vk::raii::CommandBuffer& commandBuffer, const VulkanDescriptorSet& frameSet, size_t begin, size_t end);
+		//Splits the items into chunks of about equal draws, bounds gets chunk count + 1 entries; 0 when not worth recording in parallel
+		uint32_t GetMeshDrawChunks(std::vector<size_t>& bounds) const;
+		//Grows this frame slot's per-draw data and indirect commands to hold drawCount draws
+		void ReserveMeshDrawBuffers(uint32_t drawCount);
+		void RecordMeshletDraw(const vk::raii::CommandBuffer& commandBuffer, const VulkanMesh& mesh, const glm::mat4& transform);
 		void CreateCommandPool();
-		void CreateCommandBuffer();
-		void RecordCommandBuffer(uint32_t imageIndex);
+		//Returns the frame's primary command buffer, ready to submit
+		vk::CommandBuffer RecordCommandBuffer(uint32_t imageIndex);
+		//Clears the back buffer and draws everything queued for the frame
+		void RecordMainPass(const vk::raii::CommandBuffer& commandBuffer, uint32_t imageIndex);
+		//Everything inside the main pass's rendering: dynamic state, the triangle when asked for and mesh draw items [begin, end)
+		uint32_t RecordMainPassCommands(const vk::raii::CommandBuffer& commandBuffer, const VulkanDescriptorSet& frameSet, size_t begin, size_t end,
+			bool bTriangle);
+		//Set 0 of every main pass pipeline, the frame slot's uniforms
+		VulkanDescriptorSet AllocateFrameSet();
+		//What secondaries recorded inside the main pass inherit
+		vk::CommandBufferInheritanceRenderingInfo GetMainPassInheritance() const;
+		//This frame slot's cached main pass, null when its inputs changed since the last frame, which drops every cached recording
+		CachedMainPass* GetCachedMainPass();
+		//Records the prepared mesh draws into the cached main pass, with everything it allocates retained
+		void RecordCachedMainPass(CachedMainPass& cachedPass);
 		void CreateSyncObjects();
 
 		vk::SurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& availableFormats);
 		vk::PresentModeKHR ChooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes);
 		vk::Extent2D ChooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities);
 
-		void transition_image_layout(uint32_t currentFrame, vk::ImageLayout old_layout, vk::ImageLayout new_layout, vk::AccessFlags2 src_access_mask,
-			vk::AccessFlags2 dst_access_mask, vk::PipelineStageFlags2 src_stage_mask, vk::PipelineStageFlags2 dst_stage_mask);
-
 	private:
 		vk::raii::Context m_Context;
 		vk::raii::Instance m_Instance = nullptr;
@@ -41,16 +163,25 @@ namespace VRE
 		vk::raii::PhysicalDevice m_PhysicalDevice = nullptr;
 		vk::raii::Device m_Device = nullptr;
 		vk::raii::Device m_LogicalDevice = nullptr;
-		vk::raii::PipelineLayout m_PipelineLayout = nullptr;
-		vk::raii::Pipeline m_GraphicsPipeline = nullptr;
-		vk::raii::CommandPool m_CommandPool = nullptr;
-		vk::raii::CommandBuffer m_CommandBuffer = nullptr;
-		vk::raii::Semaphore m_PresentCompleteSemaphore = nullptr;
-		vk::raii::Semaphore m_RenderFinishedSemaphore = nullptr;
-		vk::raii::Fence m_DrawFence = nullptr;
+		//The primary command buffers, reset a frame slot at a time
+		std::unique_ptr<VulkanFrameCommandPool> m_CommandPool;
+		//Records the main pass's mesh draws into secondaries when there are enough of them
+		std::unique_ptr<VulkanCommandRecorder> m_CommandRecorder;
+		bool m_bStaticFrameCaching = false;
+		//Of the last frame
+		MainPassKey m_MainPassKey;
+		//Resettable buffers: a slot's recording is replaced while the other slots' are still in flight
+		vk::raii::CommandPool m_CachedCommandPool = nullptr;
+		std::array<CachedMainPass, k_MaxFramesInFlight> m_CachedMainPasses;
+		std::vector<vk::raii::Semaphore> m_PresentCompleteSemaphores;
+		std::vector<vk::raii::Semaphore> m_RenderFinishedSemaphores;
+		//Signaled with m_FrameNumber by each frame's submit, tells which frames the GPU has finished
+		vk::raii::Semaphore m_FrameTimeline = nullptr;
+		uint64_t m_FrameNumber = 0;
 		vk::raii::Queue m_Queue = nullptr;
 		uint32_t m_QueueIndex = 0;
 		uint32_t m_ImageCount = 0;
+		uint32_t m_CurrentFrame = 0;
 
 		vk::raii::SwapchainKHR m_SwapChain = nullptr;
 		std::vector<vk::Image> m_SwapChainImages;
@@ -64,6 +195,79 @@ namespace VRE
 			vk::KHRSynchronization2ExtensionName,
 			vk::KHRCreateRenderpass2ExtensionName
 		};
+		//Enabled only when the device supports them, query with IsDeviceExtensionEnabled
+		std::vector<const char*> m_OptionalDeviceExtensions;
+		std::vector<const char*> m_EnabledDeviceExtensions;
+
+		//Declared before everything that creates resources through them so they are destroyed last
+		std::unique_ptr<VulkanDeletionQueue> m_DeletionQueue;
+		std::unique_ptr<VulkanMemoryBudget> m_MemoryBudget;
+		std::unique_ptr<VulkanResidencyManager> m_ResidencyManager;
+		std::unique_ptr<VulkanResourcePool> m_ResourcePool;
+		std::unique_ptr<VulkanTransientPool> m_TransientPool;
+		std::unique_ptr<VulkanDescriptorBinder> m_DescriptorBinder;
+		std::unique_ptr<VulkanPerDrawData> m_PerDrawData;
+		std::unique_ptr<ThreadPool> m_ThreadPool;
+		std::unique_ptr<VulkanUploadContext> m_UploadContext;
+		std::unique_ptr<VulkanGpuDecompressor> m_GpuDecompressor;
+		std::unique_ptr<VulkanGeometryPool> m_GeometryPool;
+		std::unique_ptr<VulkanMeshLoader> m_MeshLoader;
+		std::unique_ptr<VulkanTextureStreamer> m_TextureStreamer;
+		std::vector<std::unique_ptr<VulkanVirtualTexture>> m_VirtualTextures;
+		//Null when the device lacks quad subgroup operations
+		std::unique_ptr<VulkanMipGenerator> m_MipGenerator;
+		vk::raii::DescriptorSetLayout m_FrameSetLayout = nullptr;
+		std::vector<BufferHandle> m_UniformBuffers;
+		PipelineHandle m_GraphicsPipeline;
+		std::array<PipelineHandle, 4> m_MeshPipelines;
+		std::vector<VulkanMeshInstance> m_MeshDraws;
+		//Queued again every frame, on top of the caller's DrawMesh calls
+		std::vector<VulkanMeshInstance> m_SceneInstances;
+		//Vertex path draws sorted by batch, index i owns slot i of the per-draw data and indirect commands
+		struct MeshBatchDraw
+		{
+			uint32_t Batch;
+			const VulkanMesh* Mesh;
+			const glm::mat4* Transform;
+		};
+		std::vector<MeshBatchDraw> m_MeshBatchDraws;
+		//The unit of recording: one meshlet draw, or one indirect call over m_MeshBatchDraws [First, First + Count) of a batch
+		struct MeshDrawItem
+		{
+			const VulkanMesh* Mesh = nullptr;
+			const glm::mat4* Transform = nullptr;
+			uint32_t Batch = 0;
+			uint32_t First = 0;
+			uint32_t Count = 0;
+			bool bMeshlets = false;
+		};
+		std::vector<MeshDrawItem> m_MeshDrawItems;
+		//Host visible, written while recording; per frame slot since the GPU may still read the previous frame's
+		struct MeshDrawBuffers
+		{
+			BufferHandle DrawData;
+			BufferHandle Commands;
+			uint32_t Capacity = 0;
+		};
+		std::array<MeshDrawBuffers, k_MaxFramesInFlight> m_MeshDrawBuffers;
+		//1 without the multiDrawIndirect feature
+		uint32_t m_MaxDrawIndirectCount = 1;
+		//Set 1 of every vertex path pipeline: the vertex buffer to pull from and the per-draw data
+		vk::raii::DescriptorSetLayout m_MeshDrawSetLayout = nullptr;
+		bool m_bMeshShadingSupported = false;
+		bool m_bMeshShadingEnabled = false;
+		//Task and mesh shader pipeline, its set 1 holds the drawn mesh's vertex and meshlet buffers
+		PipelineHandle m_MeshletPipeline;
+		vk::raii::DescriptorSetLayout m_MeshletSetLayout = nullptr;
+		bool m_bVertexPullingEnabled = false;
+		//Reads the vertex buffer bound at set 1
+		PipelineHandle m_PulledMeshPipeline;
+		glm::mat4 m_ViewProjection = glm::mat4(1.0f);
+		std::unique_ptr<VulkanBarrierBatcher> m_BarrierBatcher;
+		//Rebuilt by every RecordCommandBuffer
+		std::unique_ptr<VulkanRenderGraph> m_RenderGraph;
+
+		RenderStats m_Stats;
 
 		std::vector<char> m_ShaderCode;
 		vk::raii::ShaderModule m_ShaderModule = nullptr;
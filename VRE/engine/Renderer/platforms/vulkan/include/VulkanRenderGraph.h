@@ -0,0 +1,167 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <VulkanBarrierBatcher.h>
+#include <VulkanTransientPool.h>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	// How a pass touches a resource; the graph derives stages, access and image layout from it
+	enum class VulkanResourceUsage : uint32_t
+	{
+		ColorAttachment,
+		DepthAttachment,
+		DepthRead,
+		Sampled,
+		StorageRead,
+		StorageWrite,
+		TransferSrc,
+		TransferDst,
+		VertexInput,
+		IndirectRead,
+		UniformRead
+	};
+
+	struct VulkanResourceState
+	{
+		vk::ImageLayout Layout = vk::ImageLayout::eUndefined;
+		vk::PipelineStageFlags2 Stages;
+		vk::AccessFlags2 Access;
+	};
+
+	struct VulkanRenderGraphResource
+	{
+		uint32_t Index = UINT32_MAX;
+		bool IsValid() const { return Index != UINT32_MAX; }
+	};
+
+	class VulkanRenderGraphPass
+	{
+		public:
+			//A write that depends on the previous contents, e.g. an attachment loaded instead of cleared, needs a Read too
+			VulkanRenderGraphPass& Read(VulkanRenderGraphResource resource, VulkanResourceUsage usage, vk::PipelineStageFlags2 stages = {});
+			VulkanRenderGraphPass& Write(VulkanRenderGraphResource resource, VulkanResourceUsage usage, vk::PipelineStageFlags2 stages = {});
+			// Never culled, and keeps its place relative to every other pass: for work whose results the graph can't
+			// see, like the upload recorders that place their own barriers
+			VulkanRenderGraphPass& SetSideEffects() { m_bSideEffects = true; return *this; }
+
+		private:
+			friend class VulkanRenderGraph;
+
+			struct Access
+			{
+				uint32_t Resource;
+				VulkanResourceState State;
+				//What a transient image has to be created with
+				vk::ImageUsageFlags ImageUsage;
+				bool bWrite;
+				bool bRead;
+			};
+
+			VulkanRenderGraphPass& Use(VulkanRenderGraphResource resource, VulkanResourceUsage usage, vk::PipelineStageFlags2 stages, bool bWrite);
+
+		private:
+			std::string_view m_Name;
+			std::function<void(const vk::raii::CommandBuffer&)> m_Execute;
+			std::vector<Access> m_Accesses;
+			bool m_bSideEffects = false;
+	};
+
+	// Frame graph rebuilt every frame. Passes declare what they read and write, Execute() then
+	//  - culls passes none of whose writes reach a later reader, an exported resource or a side effect,
+	//  - orders the rest by their dependencies, preferring a pass that doesn't wait on the one just before it,
+	//  - records them with every layout transition and hazard between them resolved, each pass's barriers merged
+	//    into one pipelineBarrier2 and reads in stages that already saw the last write left alone; a barrier whose
+	//    producer ran more than one pass earlier is split into an event set after the producer and waited on before
+	//    the consumer, so the passes in between overlap with the producer's tail.
+	// Resources are imported with the state they are in and, for exported ones, the state they have to end up in.
+	// Images created in the graph are transient: they only exist from the first to the last pass using them and
+	// share memory with transient images alive at other times, see VulkanTransientPool.
+	class VulkanRenderGraph
+	{
+		public:
+			VulkanRenderGraph(VulkanTransientPool& transientPool, VulkanBarrierBatcher& barrierBatcher);
+
+			VulkanRenderGraph(const VulkanRenderGraph&) = delete;
+			VulkanRenderGraph& operator=(const VulkanRenderGraph&) = delete;
+
+			//Names are only kept as views, pass literals
+			VulkanRenderGraphResource ImportImage(std::string_view name, vk::Image image, vk::ImageAspectFlags aspect, const VulkanResourceState& initialState,
+				std::optional<VulkanResourceState> finalState = std::nullopt);
+			VulkanRenderGraphResource ImportBuffer(std::string_view name, vk::Buffer buffer, const VulkanResourceState& initialState,
+				std::optional<VulkanResourceState> finalState = std::nullopt);
+			//Usage is filled in from the passes, set only what they can't declare
+			VulkanRenderGraphResource CreateImage(std::string_view name, const VulkanTransientImageDesc& desc);
+			//Only valid inside pass callbacks, transient images don't exist before
+			vk::Image GetImage(VulkanRenderGraphResource resource) const { return m_Resources[resource.Index].Image; }
+			vk::ImageView GetImageView(VulkanRenderGraphResource resource) const { return m_Resources[resource.Index].View; }
+			//The returned pass stays valid until Execute
+			VulkanRenderGraphPass& AddPass(std::string_view name, std::function<void(const vk::raii::CommandBuffer&)> execute);
+
+			//Records the frame's passes and clears the graph for the next one
+			void Execute(const vk::raii::CommandBuffer& commandBuffer);
+
+			//Of the last Execute
+			uint32_t GetPassCount() const { return m_PassCount; }
+			uint32_t GetCulledPassCount() const { return m_CulledPassCount; }
+
+		private:
+			struct Resource
+			{
+				std::string_view Name;
+				vk::Image Image;
+				vk::ImageAspectFlags Aspect;
+				vk::ImageView View;
+				vk::Buffer Buffer;
+				std::optional<VulkanResourceState> FinalState;
+				std::optional<VulkanTransientImageDesc> TransientDesc;
+				//Request backing a transient image this frame and the position of the first pass using it
+				uint32_t TransientRequest = UINT32_MAX;
+				uint32_t FirstPass = UINT32_MAX;
+				//Tracked while recording: the last write, and the stages that read since and already waited for it
+				vk::ImageLayout Layout = vk::ImageLayout::eUndefined;
+				vk::PipelineStageFlags2 WriteStages;
+				vk::AccessFlags2 WriteAccess;
+				vk::PipelineStageFlags2 ReadStages;
+				vk::AccessFlags2 ReadAccess;
+				//Positions of the passes that did them
+				uint32_t WritePass = UINT32_MAX;
+				uint32_t ReadPass = UINT32_MAX;
+			};
+
+			//Ahead of a pass, waiting for the work of the pass at position Producer, or of earlier frames without one
+			struct PlannedBarrier
+			{
+				uint32_t Producer;
+				bool bImage;
+				vk::ImageMemoryBarrier2 Image;
+				vk::MemoryBarrier2 Memory;
+			};
+
+			std::vector<bool> CullPasses() const;
+			std::vector<uint32_t> OrderPasses(const std::vector<bool>& live) const;
+			//Requests the transient images the live passes use and sets them up to wait for the memory's previous users
+			void AllocateTransients(const std::vector<uint32_t>& order);
+			//First use of a transient image, waits for what used its memory before it this frame
+			void WaitForAliases(Resource& resource) const;
+			//Brings a resource into state for the pass at position, planning whatever barrier that takes
+			void Transition(Resource& resource, const VulkanResourceState& state, bool bWrite, uint32_t position,
+				std::vector<PlannedBarrier>& barriers) const;
+			void AddBarrier(const PlannedBarrier& barrier);
+
+		private:
+			VulkanTransientPool& m_TransientPool;
+			VulkanBarrierBatcher& m_BarrierBatcher;
+			std::vector<Resource> m_Resources;
+			//Resource behind each transient request of the current Execute
+			std::vector<uint32_t> m_TransientResources;
+			std::deque<VulkanRenderGraphPass> m_Passes;
+			uint32_t m_PassCount = 0;
+			uint32_t m_CulledPassCount = 0;
+	};
+}
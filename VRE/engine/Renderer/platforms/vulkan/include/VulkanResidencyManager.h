@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <Handle.h>
+#include <VulkanMemoryBudget.h>
+
+namespace VRE
+{
+	// Keeps streamable resources (mip chains, virtual texture pages, cached geometry) inside the memory budget.
+	// Resources register with their resident size and an eviction callback and are touched every frame they are
+	// used; once a heap crosses its high water mark the least recently used ones are asked to shrink until usage
+	// drops back below the low water mark. Optional allocations are declined outright while a heap is near budget.
+	class VulkanResidencyManager
+	{
+		public:
+			//Asked to give memory back, returns the bytes the resource still keeps resident (0 when fully evicted).
+			//Runs inside eviction and must not call back into the residency manager.
+			using EvictCallback = std::function<vk::DeviceSize(ResidencyHandle)>;
+
+		public:
+			VulkanResidencyManager(VulkanMemoryBudget& memoryBudget);
+
+			VulkanResidencyManager(const VulkanResidencyManager&) = delete;
+			VulkanResidencyManager& operator=(const VulkanResidencyManager&) = delete;
+
+			ResidencyHandle Register(uint32_t heapIndex, vk::DeviceSize residentBytes, EvictCallback onEvict);
+			void Unregister(ResidencyHandle handle);
+			bool IsValid(ResidencyHandle handle) const { return m_Handles.IsAlive(handle); }
+
+			//Marks the resource as used by the frame being recorded, which keeps it from being evicted this frame
+			void Touch(ResidencyHandle handle);
+			//Streaming in or dropping mips changes the resident size
+			void SetResidentBytes(ResidencyHandle handle, vk::DeviceSize residentBytes);
+
+			//Returns false if an optional allocation of this size would push the heap too close to its budget
+			bool ReserveOptional(uint32_t heapIndex, vk::DeviceSize size);
+			//Evicts least recently used resources so a required allocation of this size fits in the budget
+			void MakeRoom(uint32_t heapIndex, vk::DeviceSize size);
+
+			//Once per frame after the budget was polled, evicts from heaps that crossed their high water mark
+			void Update(uint64_t frameNumber);
+
+			uint32_t GetResourceCount() const { return m_Handles.GetAliveCount(); }
+			vk::DeviceSize GetResidentBytes() const { return m_TotalResidentBytes; }
+			vk::DeviceSize GetEvictedBytes() const { return m_EvictedBytes; }
+			uint32_t GetDeclinedAllocations() const { return m_DeclinedAllocations; }
+
+		private:
+			void EvictUntil(uint32_t heapIndex, vk::DeviceSize targetUsage);
+			void LinkBack(uint32_t index);
+			void Unlink(uint32_t index);
+
+		private:
+			static constexpr uint32_t k_InvalidIndex = ~0u;
+
+			VulkanMemoryBudget& m_MemoryBudget;
+			uint64_t m_FrameNumber = 0;
+
+			HandlePool<ResidencyTag> m_Handles;
+			std::vector<uint32_t> m_HeapIndices;
+			std::vector<vk::DeviceSize> m_ResidentBytes;
+			std::vector<uint64_t> m_LastUsedFrames;
+			std::vector<EvictCallback> m_EvictCallbacks;
+
+			//Intrusive LRU list over handle slots, the head is the least recently used resource
+			std::vector<uint32_t> m_Prev;
+			std::vector<uint32_t> m_Next;
+			uint32_t m_Head = k_InvalidIndex;
+			uint32_t m_Tail = k_InvalidIndex;
+
+			vk::DeviceSize m_TotalResidentBytes = 0;
+			vk::DeviceSize m_EvictedBytes = 0;
+			uint32_t m_DeclinedAllocations = 0;
+	};
+}
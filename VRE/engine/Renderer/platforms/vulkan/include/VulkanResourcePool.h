@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+#include <Handle.h>
+#include <VulkanDeletionQueue.h>
+#include <VulkanResidencyManager.h>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	struct BufferDesc
+	{
+		vk::DeviceSize Size = 0;
+		vk::BufferUsageFlags Usage;
+		vk::MemoryPropertyFlags MemoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+		//Optional resources (caches, extra mips) fail with an invalid handle instead of evicting when the heap is near budget
+		bool bOptional = false;
+	};
+
+	struct TextureDesc
+	{
+		vk::Extent3D Extent = { 1, 1, 1 };
+		vk::Format Format = vk::Format::eR8G8B8A8Unorm;
+		uint32_t MipLevels = 1;
+		uint32_t ArrayLayers = 1;
+		vk::ImageUsageFlags Usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+		vk::ImageAspectFlags Aspect = vk::ImageAspectFlagBits::eColor;
+		vk::ImageViewType ViewType = vk::ImageViewType::e2D;
+		vk::MemoryPropertyFlags MemoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+		bool bOptional = false;
+	};
+
+	// Owns every buffer, texture and pipeline behind 32-bit generational handles. Each resource type is stored as
+	// structure-of-arrays indexed by the handle's slot, so hot paths pass 4 byte handles around and only touch the
+	// arrays they actually need. Objects are held as plain vk handles; destroying a resource invalidates its handle
+	// right away but hands the vk objects to the deletion queue, which frees them once the GPU is done with them.
+	class VulkanResourcePool
+	{
+		public:
+			VulkanResourcePool(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, VulkanDeletionQueue& deletionQueue,
+				VulkanMemoryBudget& memoryBudget, VulkanResidencyManager& residencyManager);
+			~VulkanResourcePool();
+
+			VulkanResourcePool(const VulkanResourcePool&) = delete;
+			VulkanResourcePool& operator=(const VulkanResourcePool&) = delete;
+
+			//Returns an invalid handle if an optional buffer was declined
+			BufferHandle CreateBuffer(const BufferDesc& desc);
+			void DestroyBuffer(BufferHandle handle);
+			bool IsValid(BufferHandle handle) const { return m_Buffers.Handles.IsAlive(handle); }
+			vk::Buffer GetBuffer(BufferHandle handle) const { assert(IsValid(handle)); return m_Buffers.Buffers[handle.GetIndex()]; }
+			vk::DeviceSize GetSize(BufferHandle handle) const { assert(IsValid(handle)); return m_Buffers.Sizes[handle.GetIndex()]; }
+			vk::DeviceAddress GetDeviceAddress(BufferHandle handle) const { assert(IsValid(handle)); return m_Buffers.Addresses[handle.GetIndex()]; }
+			//Host visible buffers stay persistently mapped, nullptr otherwise
+			void* GetMappedData(BufferHandle handle) const { assert(IsValid(handle)); return m_Buffers.MappedData[handle.GetIndex()]; }
+
+			TextureHandle CreateTexture(const TextureDesc& desc);
+			void DestroyTexture(TextureHandle handle);
+			bool IsValid(TextureHandle handle) const { return m_Textures.Handles.IsAlive(handle); }
+			vk::Image GetImage(TextureHandle handle) const { assert(IsValid(handle)); return m_Textures.Images[handle.GetIndex()]; }
+			vk::ImageView GetImageView(TextureHandle handle) const { assert(IsValid(handle)); return m_Textures.Views[handle.GetIndex()]; }
+			const TextureDesc& GetDesc(TextureHandle handle) const { assert(IsValid(handle)); return m_Textures.Descs[handle.GetIndex()]; }
+			vk::DeviceSize GetMemorySize(TextureHandle handle) const { assert(IsValid(handle)); return m_Textures.Memory[handle.GetIndex()].Size; }
+			uint32_t GetMemoryHeap(TextureHandle handle) const;
+			//Exchanges the images behind two handles, lets a resized texture keep the handle everything else refers to
+			void SwapTextures(TextureHandle first, TextureHandle second);
+
+			//Takes ownership of an already created pipeline and its layout
+			PipelineHandle AddPipeline(vk::raii::Pipeline&& pipeline, vk::raii::PipelineLayout&& layout, vk::PipelineBindPoint bindPoint);
+			void DestroyPipeline(PipelineHandle handle);
+			bool IsValid(PipelineHandle handle) const { return m_Pipelines.Handles.IsAlive(handle); }
+			vk::Pipeline GetPipeline(PipelineHandle handle) const { assert(IsValid(handle)); return m_Pipelines.Pipelines[handle.GetIndex()]; }
+			vk::PipelineLayout GetPipelineLayout(PipelineHandle handle) const { assert(IsValid(handle)); return m_Pipelines.Layouts[handle.GetIndex()]; }
+			vk::PipelineBindPoint GetBindPoint(PipelineHandle handle) const { assert(IsValid(handle)); return m_Pipelines.BindPoints[handle.GetIndex()]; }
+
+			uint32_t FindMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
+
+		private:
+			struct Allocation
+			{
+				vk::DeviceMemory Memory;
+				uint32_t MemoryType = 0;
+				vk::DeviceSize Size = 0;
+			};
+
+			//Null memory if an optional allocation was declined
+			Allocation AllocateMemory(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool bDeviceAddress, bool bOptional);
+			void FreeMemory(const Allocation& allocation);
+			void ReleaseBuffer(uint32_t index);
+			void ReleaseTexture(uint32_t index);
+			void ReleasePipeline(uint32_t index);
+
+		private:
+			struct BufferStorage
+			{
+				HandlePool<BufferTag> Handles;
+				std::vector<vk::Buffer> Buffers;
+				std::vector<Allocation> Memory;
+				std::vector<vk::DeviceAddress> Addresses;
+				std::vector<void*> MappedData;
+				std::vector<vk::DeviceSize> Sizes;
+			};
+
+			struct TextureStorage
+			{
+				HandlePool<TextureTag> Handles;
+				std::vector<vk::Image> Images;
+				std::vector<vk::ImageView> Views;
+				std::vector<Allocation> Memory;
+				std::vector<TextureDesc> Descs;
+			};
+
+			struct PipelineStorage
+			{
+				HandlePool<PipelineTag> Handles;
+				std::vector<vk::Pipeline> Pipelines;
+				std::vector<vk::PipelineLayout> Layouts;
+				std::vector<vk::PipelineBindPoint> BindPoints;
+			};
+
+			const vk::raii::Device& m_Device;
+			VulkanDeletionQueue& m_DeletionQueue;
+			VulkanMemoryBudget& m_MemoryBudget;
+			VulkanResidencyManager& m_ResidencyManager;
+			vk::PhysicalDeviceMemoryProperties m_MemoryProperties;
+
+			BufferStorage m_Buffers;
+			TextureStorage m_Textures;
+			PipelineStorage m_Pipelines;
+	};
+}
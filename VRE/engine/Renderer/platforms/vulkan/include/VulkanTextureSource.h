@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	struct TextureSourceInfo
+	{
+		vk::Extent3D Extent = { 1, 1, 1 };
+		vk::Format Format = vk::Format::eR8G8B8A8Unorm;
+		uint32_t MipLevels = 1;
+	};
+
+	// Where the texture streamer pulls mip data from. Open runs once on a streaming worker before anything else is
+	// called, for sources that have to read a header to know their info. ReadMip runs on streaming worker threads,
+	// possibly for several mips of the same texture at once, and fills data with the tightly packed level.
+	class VulkanTextureSource
+	{
+		public:
+			virtual ~VulkanTextureSource() = default;
+
+			//False if the source turned out unusable, its texture never becomes ready then
+			virtual bool Open() { return true; }
+			virtual const TextureSourceInfo& GetInfo() const = 0;
+			virtual bool ReadMip(uint32_t mipLevel, std::vector<std::byte>& data) const = 0;
+	};
+
+	// Headerless file holding every mip level tightly packed, largest first.
+	class VulkanRawTextureFileSource : public VulkanTextureSource
+	{
+		public:
+			VulkanRawTextureFileSource(std::string path, const TextureSourceInfo& info);
+
+			virtual const TextureSourceInfo& GetInfo() const override { return m_Info; }
+			virtual bool ReadMip(uint32_t mipLevel, std::vector<std::byte>& data) const override;
+
+		private:
+			std::string m_Path;
+			TextureSourceInfo m_Info;
+			std::vector<uint64_t> m_MipOffsets;
+	};
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <ThreadPool.h>
+#include <VulkanResidencyManager.h>
+#include <VulkanResourcePool.h>
+#include <VulkanTextureSource.h>
+#include <VulkanUploadContext.h>
+
+namespace VRE
+{
+	// Streams texture mips in and out at runtime. Textures load with only their mip tail resident; the renderer
+	// requests the mips it needs every frame from CPU screen-size estimates (EstimateMip, RequestMip) and the missing
+	// levels are read on worker threads. There is no GPU sampler feedback, no pass samples streamed textures yet.
+	// Once a read completes the texture is reallocated at the larger size, resident levels are copied over on the GPU
+	// and the new image is swapped in under the same handle, all inside the frame's command buffer, so nothing ever
+	// waits. Growing is an optional allocation and backs off near the memory budget; the residency manager shrinks
+	// least recently used textures back to their tail.
+	class VulkanTextureStreamer
+	{
+		public:
+			static constexpr uint32_t k_NoRequest = ~0u;
+
+		public:
+			VulkanTextureStreamer(VulkanResourcePool& resourcePool, VulkanResidencyManager& residencyManager, VulkanUploadContext& uploadContext,
+				ThreadPool& threadPool);
+			~VulkanTextureStreamer();
+
+			VulkanTextureStreamer(const VulkanTextureStreamer&) = delete;
+			VulkanTextureStreamer& operator=(const VulkanTextureStreamer&) = delete;
+
+			//Returns a placeholder handle right away and opens the source on a worker; the real texture takes over the
+			//handle once it is open and the mip tail read follows. Don't sample it before IsReady
+			TextureHandle LoadTexture(std::shared_ptr<VulkanTextureSource> source);
+			void UnloadTexture(TextureHandle texture);
+
+			//Mip level of the full chain needed this frame, lower is sharper
+			void RequestMip(TextureHandle texture, uint32_t mipLevel);
+			//Mip that maps roughly one texel to one pixel for a texture covering screenSize pixels along its largest axis
+			static uint32_t EstimateMip(uint32_t textureSize, float screenSize);
+
+			//True once the tail upload is recorded, from then on some mip is always resident
+			bool IsReady(TextureHandle texture) const { return m_Textures[GetSlot(texture)].bReady; }
+			uint32_t GetResidentMip(TextureHandle texture) const { return m_Textures[GetSlot(texture)].ResidentMip; }
+
+			//Schedules reads for the missing mips requested since the last frame
+			void BeginFrame();
+			//Records uploads and resizes, must come before anything in the command buffer samples streamed textures
+			void Record(const vk::raii::CommandBuffer& commandBuffer);
+
+		private:
+			struct StreamedTexture
+			{
+				std::shared_ptr<VulkanTextureSource> Source;
+				TextureHandle Texture;
+				ResidencyHandle Residency;
+				uint32_t ResidentMip = 0;
+				uint32_t TailMip = 0;
+				uint32_t RequestedMip = k_NoRequest;
+				//Set by eviction, applied on the next Record
+				uint32_t ShrinkMip = k_NoRequest;
+				//Bumped whenever an in-flight read becomes stale
+				uint32_t LoadSerial = 0;
+				uint64_t RetryFrame = 0;
+				//Set once the source is open and the real texture replaced the placeholder
+				bool bOpen = false;
+				bool bLoading = false;
+				bool bReady = false;
+			};
+
+			struct SourceOpen
+			{
+				uint32_t Slot = 0;
+				uint32_t Serial = 0;
+			};
+
+			struct MipLoad
+			{
+				uint32_t Slot = 0;
+				uint32_t Serial = 0;
+				uint32_t FirstMip = 0;
+				std::vector<std::vector<std::byte>> Mips;
+				bool bInitial = false;
+			};
+
+			enum class ResizeResult
+			{
+				Done,
+				OutOfStaging,
+				Declined
+			};
+
+			uint32_t GetSlot(TextureHandle texture) const;
+			//Swaps the texture sized for the opened source in for the placeholder and queues the tail read
+			void CreateStreamedTexture(uint32_t slot);
+			//Reads from firstMip up to the resident mips, or fewer when they would not fit one frame of staging
+			void ScheduleLoad(uint32_t slot, uint32_t firstMip);
+			vk::DeviceSize Evict(uint32_t slot);
+
+			ResizeResult UploadInitial(const vk::raii::CommandBuffer& commandBuffer, const MipLoad& load);
+			ResizeResult Resize(const vk::raii::CommandBuffer& commandBuffer, uint32_t slot, uint32_t newFirstMip, const MipLoad* load);
+			//Copies load into staging and appends the matching buffer to image copies for an image starting at imageFirstMip
+			bool StageLoad(const MipLoad& load, uint32_t imageFirstMip, vk::Buffer& stagingBuffer, std::vector<vk::BufferImageCopy>& regions);
+
+		private:
+			VulkanResourcePool& m_ResourcePool;
+			VulkanResidencyManager& m_ResidencyManager;
+			VulkanUploadContext& m_UploadContext;
+			ThreadPool& m_ThreadPool;
+
+			std::vector<StreamedTexture> m_Textures;
+			std::vector<uint32_t> m_FreeSlots;
+			std::unordered_map<TextureHandle, uint32_t> m_SlotLookup;
+			uint64_t m_FrameCounter = 0;
+
+			//Reads finished by the workers, handed over to Record
+			std::mutex m_CompletedMutex;
+			std::vector<MipLoad> m_CompletedLoads;
+			//Sources opened by the workers, only successful opens are listed
+			std::vector<SourceOpen> m_CompletedOpens;
+			//Loads waiting for staging space, owned by the render thread
+			std::vector<MipLoad> m_ReadyLoads;
+			uint32_t m_PendingLoads = 0;
+	};
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <VulkanDeletionQueue.h>
+#include <VulkanMemoryBudget.h>
+#include <VulkanResidencyManager.h>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	struct VulkanTransientImageDesc
+	{
+		vk::Extent2D Extent;
+		vk::Format Format = vk::Format::eR8G8B8A8Unorm;
+		vk::ImageUsageFlags Usage;
+		vk::ImageAspectFlags Aspect = vk::ImageAspectFlagBits::eColor;
+		uint32_t MipLevels = 1;
+		uint32_t ArrayLayers = 1;
+
+		bool operator==(const VulkanTransientImageDesc&) const = default;
+	};
+
+	struct VulkanTransientImage
+	{
+		vk::Image Image;
+		vk::ImageView View;
+		//Earlier requests of this frame whose memory it reuses, its first use has to wait for theirs
+		std::vector<uint32_t> Aliases;
+		//Stages that used its memory last frame, for the first request on that memory
+		vk::PipelineStageFlags2 PreviousStages;
+	};
+
+	// Backs images that live for part of a frame, like depth, G-buffer and post-processing targets. Every frame the
+	// render graph requests them with the range of passes they are alive for; requests whose lifetimes don't overlap
+	// are packed onto the same memory, largest first, into a few blocks that are kept from frame to frame. Images are
+	// cached by description and placement, so an unchanged frame creates nothing. Attachment only images go to
+	// lazily allocated memory where the device has it, tilers then never back them with real memory.
+	class VulkanTransientPool
+	{
+		public:
+			VulkanTransientPool(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, VulkanDeletionQueue& deletionQueue,
+				VulkanMemoryBudget& memoryBudget, VulkanResidencyManager& residencyManager);
+			~VulkanTransientPool();
+
+			VulkanTransientPool(const VulkanTransientPool&) = delete;
+			VulkanTransientPool& operator=(const VulkanTransientPool&) = delete;
+
+			//Passes are positions in the frame's execution order, both inclusive
+			uint32_t Request(const VulkanTransientImageDesc& desc, uint32_t firstPass, uint32_t lastPass);
+			//Places this frame's requests and creates whatever images are missing
+			void Allocate();
+			const VulkanTransientImage& Get(uint32_t request) const { return m_Requests[request].Image; }
+			//Stages the request's image was used in, its memory's next user waits for them
+			void SetUsedStages(uint32_t request, vk::PipelineStageFlags2 stages);
+			//Drops the requests, and images and blocks that went unused for a while
+			void EndFrame();
+
+			bool IsLazilyAllocatedSupported() const { return m_LazyMemoryTypeBits != 0; }
+			//Bytes of the blocks, and what this frame's requests would have taken without aliasing; lazily allocated ones not counted
+			vk::DeviceSize GetMemorySize() const { return m_MemorySize; }
+			vk::DeviceSize GetRequestedSize() const { return m_RequestedSize; }
+
+		private:
+			struct ImageRequest
+			{
+				VulkanTransientImageDesc Desc;
+				uint32_t FirstPass;
+				uint32_t LastPass;
+				vk::MemoryRequirements Requirements;
+				bool bLazy;
+				uint32_t Block = UINT32_MAX;
+				vk::DeviceSize Offset = 0;
+				VulkanTransientImage Image;
+			};
+
+			struct Block
+			{
+				vk::DeviceMemory Memory;
+				uint32_t MemoryType;
+				vk::DeviceSize Size;
+				bool bLazy;
+				vk::PipelineStageFlags2 Stages;
+				vk::PipelineStageFlags2 NextStages;
+				uint32_t UnusedFrames = 0;
+				//Requests placed this frame
+				std::vector<uint32_t> Requests;
+			};
+
+			struct DescHash
+			{
+				size_t operator()(const VulkanTransientImageDesc& desc) const;
+			};
+
+			struct ImageKey
+			{
+				VulkanTransientImageDesc Desc;
+				uint32_t Block;
+				vk::DeviceSize Offset;
+
+				bool operator==(const ImageKey&) const = default;
+			};
+
+			struct ImageKeyHash
+			{
+				size_t operator()(const ImageKey& key) const;
+			};
+
+			struct CachedImage
+			{
+				vk::Image Image;
+				vk::ImageView View;
+				uint32_t UnusedFrames = 0;
+			};
+
+			vk::MemoryRequirements GetRequirements(const VulkanTransientImageDesc& desc);
+			//Lowest offset in the block free for the request's whole lifetime
+			bool Place(uint32_t blockIndex, uint32_t requestIndex);
+			uint32_t AllocateBlock(const ImageRequest& request);
+			void ReleaseBlock(Block& block);
+			const CachedImage& GetImage(const ImageKey& key);
+
+		private:
+			const vk::raii::Device& m_Device;
+			VulkanDeletionQueue& m_DeletionQueue;
+			VulkanMemoryBudget& m_MemoryBudget;
+			VulkanResidencyManager& m_ResidencyManager;
+			vk::PhysicalDeviceMemoryProperties m_MemoryProperties;
+			uint32_t m_LazyMemoryTypeBits = 0;
+
+			std::vector<ImageRequest> m_Requests;
+			//Released blocks stay as empty slots, cached images refer to blocks by index
+			std::vector<Block> m_Blocks;
+			std::unordered_map<ImageKey, CachedImage, ImageKeyHash> m_Images;
+			std::unordered_map<VulkanTransientImageDesc, vk::MemoryRequirements, DescHash> m_Requirements;
+			vk::DeviceSize m_MemorySize = 0;
+			vk::DeviceSize m_RequestedSize = 0;
+	};
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+#include <VulkanResourcePool.h>
+
+namespace VRE
+{
+	struct VulkanStagingAllocation
+	{
+		vk::Buffer Buffer = nullptr;
+		vk::DeviceSize Offset = 0;
+		std::byte* Data = nullptr;
+	};
+
+	// Per-frame staging memory for copies recorded into the frame's command buffer. Each frame slot owns one
+	// persistently mapped ring that is recycled once the slot comes around again, so uploads never wait on the GPU;
+	// the ring size doubles as the per-frame upload budget and callers retry next frame when it runs out.
+	class VulkanUploadContext
+	{
+		public:
+			VulkanUploadContext(VulkanResourcePool& resourcePool);
+			~VulkanUploadContext();
+
+			VulkanUploadContext(const VulkanUploadContext&) = delete;
+			VulkanUploadContext& operator=(const VulkanUploadContext&) = delete;
+
+			void BeginFrame(uint32_t frameIndex);
+
+			//Empty when this frame's staging budget is used up
+			std::optional<VulkanStagingAllocation> Allocate(vk::DeviceSize size, vk::DeviceSize alignment = 16);
+			vk::DeviceSize GetRemaining() const;
+			//The most a single frame can stage, anything larger never fits
+			vk::DeviceSize GetCapacity() const;
+
+		private:
+			VulkanResourcePool& m_ResourcePool;
+			std::vector<BufferHandle> m_StagingBuffers;
+			uint32_t m_FrameIndex = 0;
+			vk::DeviceSize m_Head = 0;
+	};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <MeshFile.h>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace VRE
+{
+	//Vertex shader input locations shared by every mesh pipeline
+	constexpr uint32_t k_PositionLocation = 0;
+	constexpr uint32_t k_NormalLocation = 1;
+	constexpr uint32_t k_TexCoordLocation = 2;
+
+	// Bytes per vertex of a cooked vertex section. The streamed layout stores PositionStride bytes per vertex for
+	// the whole mesh, then AttributeStride bytes per vertex; the interleaved layout has no attribute stream.
+	struct VulkanVertexStrides
+	{
+		uint32_t PositionStride = 0;
+		uint32_t AttributeStride = 0;
+	};
+
+	VulkanVertexStrides GetMeshVertexStrides(MeshVertexLayout layout, MeshVertexFormat format);
+
+	struct VulkanVertexInputState
+	{
+		std::vector<vk::VertexInputBindingDescription> Bindings;
+		std::vector<vk::VertexInputAttributeDescription> Attributes;
+
+		//Points into this object, keep it alive until the pipeline is created
+		vk::PipelineVertexInputStateCreateInfo GetCreateInfo() const;
+	};
+
+	// Bindings and attributes matching a cooked mesh's vertex section. The streamed layout reads positions from
+	// binding 0 and the other attributes from binding 1, both bound to the same buffer at different offsets.
+	// Quantized formats are fetched as UNORM, SNORM and half floats so the fixed function unit does the conversion,
+	// only the bounds remap of positions and the octahedral normal decode are left to the shader.
+	VulkanVertexInputState GetMeshVertexInputState(MeshVertexLayout layout, MeshVertexFormat format);
+
+	constexpr uint32_t k_VertexFetchQuantized = 1;
+	constexpr uint32_t k_VertexFetchStreamed = 2;
+
+	// For shaders that read vertices straight from the vertex buffer, matches MeshVertexFetch in StaticMesh.slang.
+	// Strides follow from the flags, only where the normal of the first vertex lives has to be passed along.
+	struct VulkanVertexFetch
+	{
+		uint32_t Flags = 0;
+		uint32_t AttributeOffset = 0;
+	};
+
+	VulkanVertexFetch GetMeshVertexFetch(MeshVertexLayout layout, MeshVertexFormat format, vk::DeviceSize attributeStreamOffset);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <ThreadPool.h>
+#include <VulkanResourcePool.h>
+#include <VulkanUploadContext.h>
+
+namespace VRE
+{
+	struct VirtualTextureDesc
+	{
+		//Mip 0 size of the whole virtual texture, a power of two multiple of PageSize
+		vk::Extent2D VirtualExtent = { 16384, 16384 };
+		vk::Format Format = vk::Format::eR8G8B8A8Unorm;
+		//Texels per page side, not counting the border that keeps bilinear filtering inside the page
+		uint32_t PageSize = 128;
+		uint32_t PageBorder = 4;
+		//Physical page cache is AtlasPagesPerSide^2 pages, which is all the memory the texture ever uses
+		uint32_t AtlasPagesPerSide = 32;
+		//Resolution of the feedback pass, usually a fraction of the swapchain
+		vk::Extent2D FeedbackExtent = { 160, 90 };
+	};
+
+	// Supplies pages of a virtual texture. ReadPage runs on worker threads and fills data with one page including its
+	// border, (PageSize + 2 * PageBorder)^2 texels tightly packed.
+	class VulkanVirtualTextureSource
+	{
+		public:
+			virtual ~VulkanVirtualTextureSource() = default;
+
+			virtual bool ReadPage(uint32_t mipLevel, uint32_t pageX, uint32_t pageY, std::vector<std::byte>& data) const = 0;
+	};
+
+	// Sparse virtual texture backed by a fixed physical page cache. A low resolution feedback pass writes the page
+	// every pixel wants into an R32Uint target; the CPU reads it back once the frame retires, loads missing pages on
+	// worker threads and uploads them into free atlas slots, evicting the least recently used page when full. The page
+	// table holds one texel per virtual page per mip pointing at the physical page, or at the nearest resident ancestor
+	// while a page is missing. The coarsest mip is one page that stays resident, so every lookup resolves.
+	// VulkanRenderApi records the feedback pass every frame, before the main pass, once the caller set what it draws.
+	class VulkanVirtualTexture
+	{
+		public:
+			static constexpr uint32_t k_InvalidPage = ~0u;
+
+		public:
+			VulkanVirtualTexture(VulkanResourcePool& resourcePool, VulkanUploadContext& uploadContext,
+				ThreadPool& threadPool, const VirtualTextureDesc& desc, std::shared_ptr<VulkanVirtualTextureSource> source);
+			~VulkanVirtualTexture();
+
+			VulkanVirtualTexture(const VulkanVirtualTexture&) = delete;
+			VulkanVirtualTexture& operator=(const VulkanVirtualTexture&) = delete;
+
+			//Reads the feedback this frame slot recorded last time and queues loads for missing pages
+			void BeginFrame(uint32_t frameIndex);
+			//Uploads finished pages and the page table, must come before anything samples the virtual texture
+			void Record(const vk::raii::CommandBuffer& commandBuffer);
+
+			//Binds the caller's feedback pipeline, one importing the VirtualTexturing shader module, and draws the scene
+			using FeedbackCallback = std::function<void(const vk::raii::CommandBuffer&)>;
+			void SetFeedbackCallback(FeedbackCallback callback) { m_FeedbackCallback = std::move(callback); }
+			//Nothing without a callback, the page table then keeps what is resident
+			void RecordFeedbackPass(const vk::raii::CommandBuffer& commandBuffer);
+			//Feedback pass: the caller binds its feedback pipeline and draws the scene in between
+			void BeginFeedbackPass(const vk::raii::CommandBuffer& commandBuffer);
+			void EndFeedbackPass(const vk::raii::CommandBuffer& commandBuffer);
+			vk::Format GetFeedbackFormat() const { return vk::Format::eR32Uint; }
+			vk::Extent2D GetFeedbackExtent() const { return m_Desc.FeedbackExtent; }
+
+			TextureHandle GetPageTable() const { return m_PageTable; }
+			TextureHandle GetAtlas() const { return m_Atlas; }
+			const VirtualTextureDesc& GetDesc() const { return m_Desc; }
+			uint32_t GetMipCount() const { return m_MipCount; }
+			uint32_t GetResidentPageCount() const { return static_cast<uint32_t>(m_PageToSlot.size()); }
+
+			static uint32_t PackPage(uint32_t mipLevel, uint32_t pageX, uint32_t pageY) { return (mipLevel << 28) | (pageY << 14) | pageX; }
+			static uint32_t GetPageMip(uint32_t page) { return page >> 28; }
+			static uint32_t GetPageX(uint32_t page) { return page & 0x3FFF; }
+			static uint32_t GetPageY(uint32_t page) { return (page >> 14) & 0x3FFF; }
+
+		private:
+			struct PageLoad
+			{
+				uint32_t Page = k_InvalidPage;
+				std::vector<std::byte> Data;
+			};
+
+			void RequestPage(uint32_t page);
+			//Free atlas slot, or the least recently used one not needed by this frame; k_InvalidPage if all are in use
+			uint32_t AcquireSlot();
+			void RebuildPageTable();
+			vk::Extent2D GetPageCount(uint32_t mipLevel) const;
+
+		private:
+			VulkanResourcePool& m_ResourcePool;
+			VulkanUploadContext& m_UploadContext;
+			ThreadPool& m_ThreadPool;
+			VirtualTextureDesc m_Desc;
+			std::shared_ptr<VulkanVirtualTextureSource> m_Source;
+			FeedbackCallback m_FeedbackCallback;
+			uint32_t m_MipCount = 1;
+			uint32_t m_TileSize = 0;
+			vk::DeviceSize m_TileBytes = 0;
+
+			TextureHandle m_Atlas;
+			TextureHandle m_PageTable;
+			TextureHandle m_FeedbackTarget;
+			std::vector<BufferHandle> m_FeedbackReadback;
+			std::vector<bool> m_FeedbackWritten;
+			uint32_t m_FrameIndex = 0;
+			uint64_t m_FrameCounter = 0;
+			bool m_bAtlasInitialized = false;
+			bool m_bPageTableInitialized = false;
+
+			//Physical slots, the slot index is y * AtlasPagesPerSide + x
+			std::vector<uint32_t> m_SlotPages;
+			std::vector<uint64_t> m_SlotLastUsed;
+			std::vector<uint32_t> m_FreeSlots;
+			std::unordered_map<uint32_t, uint32_t> m_PageToSlot;
+			uint32_t m_LockedSlot = 0;
+
+			//Packed RGBA8 entries (physical x, physical y, mip the page was found at, resident), all mips back to back
+			std::vector<uint32_t> m_PageTableData;
+			std::vector<vk::DeviceSize> m_PageTableMipOffsets;
+			bool m_bPageTableDirty = true;
+
+			std::unordered_set<uint32_t> m_InFlight;
+			std::mutex m_CompletedMutex;
+			std::vector<PageLoad> m_CompletedLoads;
+			std::vector<PageLoad> m_ReadyLoads;
+	};
+}
@@ -0,0 +1,96 @@
+#include <VulkanBarrierBatcher.h>
+#include <cassert>
+
+namespace VRE
+{
+	VulkanBarrierBatcher::VulkanBarrierBatcher(const vk::raii::Device& device)
+		: m_Device(device)
+	{
+	}
+
+	void VulkanBarrierBatcher::BeginFrame(uint32_t frameIndex)
+	{
+		assert(IsEmpty());
+		m_FrameIndex = frameIndex;
+		for (vk::raii::Event& event : m_Events[m_FrameIndex])
+		{
+			event.reset();
+		}
+		m_Splits.clear();
+		m_BarrierCount = 0;
+		m_SplitBarrierCount = 0;
+	}
+
+	void VulkanBarrierBatcher::AddMemoryBarrier(const vk::MemoryBarrier2& barrier)
+	{
+		m_Pending.Memory.srcStageMask |= barrier.srcStageMask;
+		m_Pending.Memory.srcAccessMask |= barrier.srcAccessMask;
+		m_Pending.Memory.dstStageMask |= barrier.dstStageMask;
+		m_Pending.Memory.dstAccessMask |= barrier.dstAccessMask;
+	}
+
+	void VulkanBarrierBatcher::AddBufferBarrier(const vk::BufferMemoryBarrier2& barrier)
+	{
+		m_Pending.Buffers.push_back(barrier);
+	}
+
+	void VulkanBarrierBatcher::AddImageBarrier(const vk::ImageMemoryBarrier2& barrier)
+	{
+		m_Pending.Images.push_back(barrier);
+	}
+
+	void VulkanBarrierBatcher::Flush(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		if (IsEmpty())
+		{
+			return;
+		}
+		commandBuffer.pipelineBarrier2(m_Pending.GetDependencyInfo());
+		m_BarrierCount++;
+		m_Pending = Batch{};
+	}
+
+	uint32_t VulkanBarrierBatcher::Signal(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		assert(!IsEmpty());
+		std::vector<vk::raii::Event>& events = m_Events[m_FrameIndex];
+		if (events.size() == m_Splits.size())
+		{
+			events.emplace_back(m_Device, vk::EventCreateInfo{});
+		}
+		SplitBarrier& split = m_Splits.emplace_back(SplitBarrier{ .Event = *events[m_Splits.size()], .Barriers = std::move(m_Pending) });
+		m_Pending = Batch{};
+		//Set and wait have to be given identical dependency infos
+		commandBuffer.setEvent2(split.Event, split.Barriers.GetDependencyInfo());
+		m_SplitBarrierCount++;
+		return static_cast<uint32_t>(m_Splits.size() - 1);
+	}
+
+	void VulkanBarrierBatcher::Wait(const vk::raii::CommandBuffer& commandBuffer, std::span<const uint32_t> splits)
+	{
+		if (splits.empty())
+		{
+			return;
+		}
+		std::vector<vk::Event> events;
+		std::vector<vk::DependencyInfo> dependencyInfos;
+		for (uint32_t index : splits)
+		{
+			events.push_back(m_Splits[index].Event);
+			dependencyInfos.push_back(m_Splits[index].Barriers.GetDependencyInfo());
+		}
+		commandBuffer.waitEvents2(events, dependencyInfos);
+	}
+
+	vk::DependencyInfo VulkanBarrierBatcher::Batch::GetDependencyInfo() const
+	{
+		return {
+			.memoryBarrierCount = HasMemory() ? 1u : 0u,
+			.pMemoryBarriers = &Memory,
+			.bufferMemoryBarrierCount = static_cast<uint32_t>(Buffers.size()),
+			.pBufferMemoryBarriers = Buffers.data(),
+			.imageMemoryBarrierCount = static_cast<uint32_t>(Images.size()),
+			.pImageMemoryBarriers = Images.data()
+		};
+	}
+}
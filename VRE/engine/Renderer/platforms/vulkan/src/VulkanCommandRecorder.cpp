@@ -0,0 +1,90 @@
+#include <VulkanCommandRecorder.h>
+#include <algorithm>
+#include <exception>
+#include <latch>
+
+namespace VRE
+{
+	VulkanCommandRecorder::VulkanCommandRecorder(const vk::raii::Device& device, uint32_t queueFamilyIndex, uint32_t threadCount)
+		: m_ThreadPool(threadCount)
+	{
+		for (uint32_t worker = 0; worker < GetWorkerCount(); worker++)
+		{
+			m_Pools.push_back(std::make_unique<VulkanFrameCommandPool>(device, queueFamilyIndex));
+		}
+	}
+
+	void VulkanCommandRecorder::BeginFrame(uint32_t frameIndex)
+	{
+		for (auto& pool : m_Pools)
+		{
+			pool->BeginFrame(frameIndex);
+		}
+	}
+
+	std::vector<vk::CommandBuffer> VulkanCommandRecorder::Record(uint32_t chunkCount, const vk::CommandBufferInheritanceInfo& inheritance,
+		const RecordCallback& record)
+	{
+		std::vector<vk::CommandBuffer> commandBuffers(chunkCount);
+		if (chunkCount == 0)
+		{
+			return commandBuffers;
+		}
+
+		//Worker w records chunks w, w + workerCount, ... into its own pool
+		const uint32_t workerCount = std::min(chunkCount, GetWorkerCount());
+		std::vector<std::exception_ptr> errors(workerCount);
+		const auto recordWorker = [&](uint32_t worker)
+		{
+			try
+			{
+				for (uint32_t chunk = worker; chunk < chunkCount; chunk += workerCount)
+				{
+					commandBuffers[chunk] = RecordChunk(*m_Pools[worker], inheritance, record, chunk);
+				}
+			}
+			catch (...)
+			{
+				errors[worker] = std::current_exception();
+			}
+		};
+
+		std::latch done(workerCount - 1);
+		for (uint32_t worker = 1; worker < workerCount; worker++)
+		{
+			m_ThreadPool.Submit([&recordWorker, &done, worker]
+			{
+				recordWorker(worker);
+				done.count_down();
+			});
+		}
+		recordWorker(0);
+		done.wait();
+
+		for (const std::exception_ptr& error : errors)
+		{
+			if (error)
+			{
+				std::rethrow_exception(error);
+			}
+		}
+		return commandBuffers;
+	}
+
+	vk::CommandBuffer VulkanCommandRecorder::RecordChunk(VulkanFrameCommandPool& pool, const vk::CommandBufferInheritanceInfo& inheritance,
+		const RecordCallback& record, uint32_t chunk)
+	{
+		vk::raii::CommandBuffer& commandBuffer = pool.Allocate(vk::CommandBufferLevel::eSecondary);
+
+		//Inheriting a render pass or dynamic rendering state means the chunk continues that render pass instance
+		const bool bRenderPassContinue = inheritance.renderPass || inheritance.pNext;
+		commandBuffer.begin({
+			.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit
+				| (bRenderPassContinue ? vk::CommandBufferUsageFlagBits::eRenderPassContinue : vk::CommandBufferUsageFlags{}),
+			.pInheritanceInfo = &inheritance
+		});
+		record(commandBuffer, chunk);
+		commandBuffer.end();
+		return *commandBuffer;
+	}
+}
@@ -0,0 +1,66 @@
+#include <VulkanDeletionQueue.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace VRE
+{
+	template<typename HandleType> static HandleType FromRaw(uint64_t handle)
+	{
+		return HandleType((typename HandleType::CType)(handle));
+	}
+
+	VulkanDeletionQueue::VulkanDeletionQueue(const vk::raii::Device& device)
+		: m_Device(device)
+	{
+	}
+
+	VulkanDeletionQueue::~VulkanDeletionQueue()
+	{
+		Flush();
+	}
+
+	void VulkanDeletionQueue::Collect(uint64_t completedValue)
+	{
+		const auto retiredEnd = std::ranges::upper_bound(m_Entries, completedValue, {}, &Entry::RetireValue);
+		for (auto it = m_Entries.begin(); it != retiredEnd; ++it)
+		{
+			Destroy(*it);
+		}
+		m_Entries.erase(m_Entries.begin(), retiredEnd);
+	}
+
+	void VulkanDeletionQueue::Flush()
+	{
+		for (const Entry& entry : m_Entries)
+		{
+			Destroy(entry);
+		}
+		m_Entries.clear();
+	}
+
+	void VulkanDeletionQueue::Destroy(const Entry& entry)
+	{
+		const auto& dispatcher = *m_Device.getDispatcher();
+		vk::Device device = *m_Device;
+		switch (entry.Type)
+		{
+			case vk::ObjectType::eBuffer: device.destroyBuffer(FromRaw<vk::Buffer>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eBufferView: device.destroyBufferView(FromRaw<vk::BufferView>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eImage: device.destroyImage(FromRaw<vk::Image>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eImageView: device.destroyImageView(FromRaw<vk::ImageView>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eDeviceMemory: device.freeMemory(FromRaw<vk::DeviceMemory>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eSampler: device.destroySampler(FromRaw<vk::Sampler>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::ePipeline: device.destroyPipeline(FromRaw<vk::Pipeline>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::ePipelineLayout: device.destroyPipelineLayout(FromRaw<vk::PipelineLayout>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eDescriptorSetLayout: device.destroyDescriptorSetLayout(FromRaw<vk::DescriptorSetLayout>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eDescriptorPool: device.destroyDescriptorPool(FromRaw<vk::DescriptorPool>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eShaderModule: device.destroyShaderModule(FromRaw<vk::ShaderModule>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eCommandPool: device.destroyCommandPool(FromRaw<vk::CommandPool>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eQueryPool: device.destroyQueryPool(FromRaw<vk::QueryPool>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eSemaphore: device.destroySemaphore(FromRaw<vk::Semaphore>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eFence: device.destroyFence(FromRaw<vk::Fence>(entry.Handle), nullptr, dispatcher); break;
+			case vk::ObjectType::eEvent: device.destroyEvent(FromRaw<vk::Event>(entry.Handle), nullptr, dispatcher); break;
+			default: throw std::runtime_error("Unsupported object type in deletion queue!");
+		}
+	}
+}
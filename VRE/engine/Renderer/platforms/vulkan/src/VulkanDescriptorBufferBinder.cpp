@@ -0,0 +1,247 @@
+#include <VulkanDescriptorBufferBinder.h>
+#include <VulkanCommon.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace VRE
+{
+	constexpr vk::DeviceSize k_DescriptorBufferFrameRegionSize = 256 * 1024;
+	//A transient and a retained region per frame slot
+	constexpr uint32_t k_DescriptorBufferRegionCount = 2 * k_MaxFramesInFlight;
+	//Combined image samplers embed a sampler, so the one buffer has to be bindable as a sampler descriptor buffer too
+	constexpr vk::BufferUsageFlags k_DescriptorBufferUsage = vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT;
+
+	static vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	vk::DeviceSize VulkanDescriptorBufferBinder::GetMaxFrameRegionSize() const
+	{
+		return (m_Properties.maxResourceDescriptorBufferRange / k_DescriptorBufferRegionCount) & ~(m_Properties.descriptorBufferOffsetAlignment - 1);
+	}
+
+	void VulkanDescriptorBufferBinder::CreateDescriptorBuffer(vk::DeviceSize frameRegionSize)
+	{
+		m_FrameRegionSize = frameRegionSize;
+		m_DescriptorBuffer = m_ResourcePool.CreateBuffer({
+			.Size = m_FrameRegionSize * k_DescriptorBufferRegionCount,
+			.Usage = k_DescriptorBufferUsage | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+			.MemoryProperties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+		});
+		m_DescriptorBufferData = static_cast<std::byte*>(m_ResourcePool.GetMappedData(m_DescriptorBuffer));
+	}
+
+	size_t VulkanDescriptorBufferBinder::DescriptorKeyHash::operator()(const DescriptorKey& key) const
+	{
+		size_t hash = std::hash<uint64_t>{}(key.Address);
+		hash ^= std::hash<uint64_t>{}(key.Range) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+		hash ^= std::hash<uint32_t>{}(static_cast<uint32_t>(key.Type)) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+
+	VulkanDescriptorBufferBinder::VulkanDescriptorBufferBinder(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+		VulkanResourcePool& resourcePool)
+		: m_Device(device), m_ResourcePool(resourcePool)
+	{
+		m_Backend = Backend::DescriptorBuffer;
+
+		auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorBufferPropertiesEXT>();
+		m_Properties = properties.get<vk::PhysicalDeviceDescriptorBufferPropertiesEXT>();
+		m_DescriptorStride = std::max(m_Properties.uniformBufferDescriptorSize, m_Properties.storageBufferDescriptorSize);
+
+		CreateDescriptorBuffer(std::min(AlignUp(k_DescriptorBufferFrameRegionSize, m_Properties.descriptorBufferOffsetAlignment), GetMaxFrameRegionSize()));
+	}
+
+	VulkanDescriptorBufferBinder::~VulkanDescriptorBufferBinder()
+	{
+		m_ResourcePool.DestroyBuffer(m_DescriptorBuffer);
+	}
+
+	vk::raii::DescriptorSetLayout VulkanDescriptorBufferBinder::CreateSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings)
+	{
+		vk::DescriptorSetLayoutCreateInfo layoutInfo{
+			.flags = vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT,
+			.bindingCount = static_cast<uint32_t>(bindings.size()),
+			.pBindings = bindings.data()
+		};
+		vk::raii::DescriptorSetLayout layout(m_Device, layoutInfo);
+
+		//Layout size and binding offsets never change, query them once instead of on every write
+		LayoutInfo info{ .Size = layout.getSizeEXT() };
+		for (const auto& binding : bindings)
+		{
+			if (info.BindingOffsets.size() <= binding.binding)
+			{
+				info.BindingOffsets.resize(binding.binding + 1, 0);
+			}
+			info.BindingOffsets[binding.binding] = layout.getBindingOffsetEXT(binding.binding);
+		}
+		m_Layouts[*layout] = std::move(info);
+		return layout;
+	}
+
+	void VulkanDescriptorBufferBinder::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		m_FrameRegionBegin = frameIndex * m_FrameRegionSize;
+		m_FrameRegionHead = 0;
+		m_ReservedSize = 0;
+	}
+
+	void VulkanDescriptorBufferBinder::BeginRetained()
+	{
+		m_TransientRegionHead = m_FrameRegionHead;
+		m_FrameRegionBegin = (k_MaxFramesInFlight + m_FrameIndex) * m_FrameRegionSize;
+		m_FrameRegionHead = 0;
+	}
+
+	void VulkanDescriptorBufferBinder::EndRetained()
+	{
+		m_FrameRegionBegin = m_FrameIndex * m_FrameRegionSize;
+		m_FrameRegionHead = m_TransientRegionHead;
+	}
+
+	bool VulkanDescriptorBufferBinder::Reserve(vk::DescriptorSetLayout layout, uint32_t setCount)
+	{
+		const auto layoutIt = m_Layouts.find(layout);
+		if (layoutIt == m_Layouts.end())
+		{
+			throw std::runtime_error("Descriptor set layout was not created by this descriptor binder!");
+		}
+		m_ReservedSize += setCount * AlignUp(layoutIt->second.Size, m_Properties.descriptorBufferOffsetAlignment);
+		const vk::DeviceSize requiredSize = AlignUp(k_DescriptorBufferFrameRegionSize + m_ReservedSize, m_Properties.descriptorBufferOffsetAlignment);
+		if (requiredSize <= m_FrameRegionSize)
+		{
+			return false;
+		}
+		const vk::DeviceSize maxSize = GetMaxFrameRegionSize();
+		if (requiredSize > maxSize)
+		{
+			throw std::runtime_error("Descriptor buffer can't hold a frame's descriptor sets!");
+		}
+
+		//Doubles so a scene growing a little every frame doesn't move the buffer every time. Nothing was allocated this
+		//frame yet and the sets of earlier frames stay in the old buffer, so there's nothing to copy over.
+		m_ResourcePool.DestroyBuffer(m_DescriptorBuffer);
+		CreateDescriptorBuffer(std::min(std::max(requiredSize, 2 * m_FrameRegionSize), maxSize));
+		m_FrameRegionBegin = m_FrameIndex * m_FrameRegionSize;
+		m_FrameRegionHead = 0;
+		return true;
+	}
+
+	void VulkanDescriptorBufferBinder::BeginCommandBuffer(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		vk::DescriptorBufferBindingInfoEXT bindingInfo{
+			.address = m_ResourcePool.GetDeviceAddress(m_DescriptorBuffer),
+			.usage = k_DescriptorBufferUsage
+		};
+		commandBuffer.bindDescriptorBuffersEXT(bindingInfo);
+	}
+
+	VulkanDescriptorSet VulkanDescriptorBufferBinder::Allocate(vk::DescriptorSetLayout layout)
+	{
+		const auto layoutIt = m_Layouts.find(layout);
+		if (layoutIt == m_Layouts.end())
+		{
+			throw std::runtime_error("Descriptor set layout was not created by this descriptor binder!");
+		}
+
+		const vk::DeviceSize offset = AlignUp(m_FrameRegionHead, m_Properties.descriptorBufferOffsetAlignment);
+		if (offset + layoutIt->second.Size > m_FrameRegionSize)
+		{
+			throw std::runtime_error("Descriptor buffer frame region exhausted!");
+		}
+		m_FrameRegionHead = offset + layoutIt->second.Size;
+		return { .Layout = layout, .Offset = m_FrameRegionBegin + offset };
+	}
+
+	void VulkanDescriptorBufferBinder::WriteBuffer(const VulkanDescriptorSet& set, uint32_t binding, vk::DescriptorType type,
+		BufferHandle buffer, vk::DeviceSize offset, vk::DeviceSize range)
+	{
+		const LayoutInfo& layoutInfo = m_Layouts.at(set.Layout);
+		const std::byte* descriptor = GetDescriptor({ .Type = type, .Address = m_ResourcePool.GetDeviceAddress(buffer) + offset, .Range = range });
+
+		std::byte* dst = m_DescriptorBufferData + set.Offset + layoutInfo.BindingOffsets[binding];
+		std::memcpy(dst, descriptor, GetDescriptorSize(type));
+	}
+
+	void VulkanDescriptorBufferBinder::WriteImage(const VulkanDescriptorSet& set, uint32_t binding, vk::DescriptorType type,
+		TextureHandle texture, vk::Sampler sampler)
+	{
+		WriteImageView(set, binding, 0, type, m_ResourcePool.GetImageView(texture), sampler);
+	}
+
+	void VulkanDescriptorBufferBinder::WriteImageView(const VulkanDescriptorSet& set, uint32_t binding, uint32_t arrayElement, vk::DescriptorType type,
+		vk::ImageView view, vk::Sampler sampler)
+	{
+		const LayoutInfo& layoutInfo = m_Layouts.at(set.Layout);
+		vk::DescriptorImageInfo imageInfo{ .sampler = sampler, .imageView = view, .imageLayout = GetDescriptorImageLayout(type) };
+		vk::DescriptorGetInfoEXT getInfo{ .type = type };
+		switch (type)
+		{
+			case vk::DescriptorType::eCombinedImageSampler: getInfo.data.pCombinedImageSampler = &imageInfo; break;
+			case vk::DescriptorType::eSampledImage: getInfo.data.pSampledImage = &imageInfo; break;
+			case vk::DescriptorType::eStorageImage: getInfo.data.pStorageImage = &imageInfo; break;
+			default: throw std::runtime_error("Unsupported image descriptor type for descriptor buffer backend!");
+		}
+
+		//Not cached: views of streamed textures are recreated constantly and the driver may hand out recycled handles.
+		//Array elements are packed tightly inside the binding.
+		const size_t descriptorSize = GetDescriptorSize(type);
+		std::byte* dst = m_DescriptorBufferData + set.Offset + layoutInfo.BindingOffsets[binding] + arrayElement * descriptorSize;
+		m_Device.getDescriptorEXT(getInfo, descriptorSize, dst);
+	}
+
+	void VulkanDescriptorBufferBinder::BindSets(const vk::raii::CommandBuffer& commandBuffer, vk::PipelineBindPoint bindPoint,
+		vk::PipelineLayout pipelineLayout, uint32_t firstSet, std::span<const VulkanDescriptorSet> sets)
+	{
+		std::vector<uint32_t> bufferIndices(sets.size(), 0);
+		std::vector<vk::DeviceSize> offsets;
+		offsets.reserve(sets.size());
+		for (const auto& set : sets)
+		{
+			offsets.push_back(set.Offset);
+		}
+		commandBuffer.setDescriptorBufferOffsetsEXT(bindPoint, pipelineLayout, firstSet, bufferIndices, offsets);
+	}
+
+	const std::byte* VulkanDescriptorBufferBinder::GetDescriptor(const DescriptorKey& key)
+	{
+		const auto cacheIt = m_DescriptorCacheIndex.find(key);
+		if (cacheIt != m_DescriptorCacheIndex.end())
+		{
+			return m_DescriptorCache.data() + cacheIt->second;
+		}
+
+		vk::DescriptorAddressInfoEXT addressInfo{ .address = key.Address, .range = key.Range, .format = vk::Format::eUndefined };
+		vk::DescriptorGetInfoEXT getInfo{ .type = key.Type };
+		switch (key.Type)
+		{
+			case vk::DescriptorType::eUniformBuffer: getInfo.data.pUniformBuffer = &addressInfo; break;
+			case vk::DescriptorType::eStorageBuffer: getInfo.data.pStorageBuffer = &addressInfo; break;
+			default: throw std::runtime_error("Unsupported descriptor type for descriptor buffer backend!");
+		}
+
+		const size_t cacheOffset = m_DescriptorCache.size();
+		m_DescriptorCache.resize(cacheOffset + m_DescriptorStride);
+		m_Device.getDescriptorEXT(getInfo, GetDescriptorSize(key.Type), m_DescriptorCache.data() + cacheOffset);
+
+		m_DescriptorCacheIndex.emplace(key, cacheOffset);
+		return m_DescriptorCache.data() + cacheOffset;
+	}
+
+	size_t VulkanDescriptorBufferBinder::GetDescriptorSize(vk::DescriptorType type) const
+	{
+		switch (type)
+		{
+			case vk::DescriptorType::eUniformBuffer: return m_Properties.uniformBufferDescriptorSize;
+			case vk::DescriptorType::eStorageBuffer: return m_Properties.storageBufferDescriptorSize;
+			case vk::DescriptorType::eCombinedImageSampler: return m_Properties.combinedImageSamplerDescriptorSize;
+			case vk::DescriptorType::eSampledImage: return m_Properties.sampledImageDescriptorSize;
+			case vk::DescriptorType::eStorageImage: return m_Properties.storageImageDescriptorSize;
+			default: throw std::runtime_error("Unsupported descriptor type for descriptor buffer backend!");
+		}
+	}
+}
@@ -0,0 +1,146 @@
+#include <VulkanDescriptorPoolBinder.h>
+#include <array>
+#include <stdexcept>
+
+namespace VRE
+{
+	//Per pool, a frame slot that needs more gets more pools
+	constexpr uint32_t k_MaxSetsPerPool = 1024;
+	constexpr uint32_t k_MaxDescriptorsPerType = 4096;
+
+	static vk::raii::DescriptorPool CreatePool(const vk::raii::Device& device)
+	{
+		const std::array poolSizes = {
+			vk::DescriptorPoolSize{ .type = vk::DescriptorType::eUniformBuffer, .descriptorCount = k_MaxDescriptorsPerType },
+			vk::DescriptorPoolSize{ .type = vk::DescriptorType::eStorageBuffer, .descriptorCount = k_MaxDescriptorsPerType },
+			vk::DescriptorPoolSize{ .type = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = k_MaxDescriptorsPerType },
+			vk::DescriptorPoolSize{ .type = vk::DescriptorType::eSampledImage, .descriptorCount = k_MaxDescriptorsPerType },
+			vk::DescriptorPoolSize{ .type = vk::DescriptorType::eStorageImage, .descriptorCount = k_MaxDescriptorsPerType }
+		};
+		//No eFreeDescriptorSet: sets are never freed individually, the whole pool is reset once per frame
+		const vk::DescriptorPoolCreateInfo poolInfo{
+			.maxSets = k_MaxSetsPerPool,
+			.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+			.pPoolSizes = poolSizes.data()
+		};
+		return vk::raii::DescriptorPool(device, poolInfo);
+	}
+
+	VulkanDescriptorPoolBinder::VulkanDescriptorPoolBinder(const vk::raii::Device& device, const VulkanResourcePool& resourcePool)
+		: m_Device(device), m_ResourcePool(resourcePool)
+	{
+		m_Backend = Backend::DescriptorPool;
+
+		m_Slots.resize(2 * k_MaxFramesInFlight);
+		for (SlotPools& slot : m_Slots)
+		{
+			slot.Pools.push_back(CreatePool(m_Device));
+		}
+	}
+
+	vk::raii::DescriptorSetLayout VulkanDescriptorPoolBinder::CreateSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings)
+	{
+		vk::DescriptorSetLayoutCreateInfo layoutInfo{ .bindingCount = static_cast<uint32_t>(bindings.size()), .pBindings = bindings.data() };
+		return vk::raii::DescriptorSetLayout(m_Device, layoutInfo);
+	}
+
+	void VulkanDescriptorPoolBinder::ResetSlot(SlotPools& slot)
+	{
+		for (uint32_t i = 0; i <= slot.Current; i++)
+		{
+			slot.Pools[i].reset();
+		}
+		slot.Current = 0;
+	}
+
+	void VulkanDescriptorPoolBinder::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		ResetSlot(m_Slots[m_FrameIndex]);
+	}
+
+	void VulkanDescriptorPoolBinder::BeginRetained()
+	{
+		m_bRetained = true;
+		ResetSlot(m_Slots[k_MaxFramesInFlight + m_FrameIndex]);
+	}
+
+	void VulkanDescriptorPoolBinder::EndRetained()
+	{
+		m_bRetained = false;
+	}
+
+	VulkanDescriptorSet VulkanDescriptorPoolBinder::Allocate(vk::DescriptorSetLayout layout)
+	{
+		SlotPools& slot = m_Slots[(m_bRetained ? k_MaxFramesInFlight : 0) + m_FrameIndex];
+		vk::DescriptorSetAllocateInfo allocInfo{ .descriptorPool = *slot.Pools[slot.Current], .descriptorSetCount = 1, .pSetLayouts = &layout };
+
+		//Allocate through the raw handle, raii sets would try to free themselves back into a pool we reset wholesale
+		VulkanDescriptorSet set{ .Layout = layout };
+		vk::Device device = *m_Device;
+		vk::Result result = device.allocateDescriptorSets(&allocInfo, &set.Set, *m_Device.getDispatcher());
+		if (result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool)
+		{
+			//Kept across frames, a slot that needed it once likely needs it again
+			if (++slot.Current == slot.Pools.size())
+			{
+				slot.Pools.push_back(CreatePool(m_Device));
+			}
+			allocInfo.descriptorPool = *slot.Pools[slot.Current];
+			result = device.allocateDescriptorSets(&allocInfo, &set.Set, *m_Device.getDispatcher());
+		}
+		if (result != vk::Result::eSuccess)
+		{
+			throw std::runtime_error("failed to allocate descriptor set!");
+		}
+		return set;
+	}
+
+	void VulkanDescriptorPoolBinder::WriteBuffer(const VulkanDescriptorSet& set, uint32_t binding, vk::DescriptorType type,
+		BufferHandle buffer, vk::DeviceSize offset, vk::DeviceSize range)
+	{
+		vk::DescriptorBufferInfo bufferInfo{ .buffer = m_ResourcePool.GetBuffer(buffer), .offset = offset, .range = range };
+		vk::WriteDescriptorSet write{
+			.dstSet = set.Set,
+			.dstBinding = binding,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = type,
+			.pBufferInfo = &bufferInfo
+		};
+		m_Device.updateDescriptorSets(write, nullptr);
+	}
+
+	void VulkanDescriptorPoolBinder::WriteImage(const VulkanDescriptorSet& set, uint32_t binding, vk::DescriptorType type,
+		TextureHandle texture, vk::Sampler sampler)
+	{
+		WriteImageView(set, binding, 0, type, m_ResourcePool.GetImageView(texture), sampler);
+	}
+
+	void VulkanDescriptorPoolBinder::WriteImageView(const VulkanDescriptorSet& set, uint32_t binding, uint32_t arrayElement, vk::DescriptorType type,
+		vk::ImageView view, vk::Sampler sampler)
+	{
+		vk::DescriptorImageInfo imageInfo{ .sampler = sampler, .imageView = view, .imageLayout = GetDescriptorImageLayout(type) };
+		vk::WriteDescriptorSet write{
+			.dstSet = set.Set,
+			.dstBinding = binding,
+			.dstArrayElement = arrayElement,
+			.descriptorCount = 1,
+			.descriptorType = type,
+			.pImageInfo = &imageInfo
+		};
+		m_Device.updateDescriptorSets(write, nullptr);
+	}
+
+	void VulkanDescriptorPoolBinder::BindSets(const vk::raii::CommandBuffer& commandBuffer, vk::PipelineBindPoint bindPoint,
+		vk::PipelineLayout pipelineLayout, uint32_t firstSet, std::span<const VulkanDescriptorSet> sets)
+	{
+		std::vector<vk::DescriptorSet> descriptorSets;
+		descriptorSets.reserve(sets.size());
+		for (const auto& set : sets)
+		{
+			descriptorSets.push_back(set.Set);
+		}
+		commandBuffer.bindDescriptorSets(bindPoint, pipelineLayout, firstSet, descriptorSets, nullptr);
+	}
+}
@@ -0,0 +1,89 @@
+#include <VulkanFormats.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace VRE
+{
+	FormatBlockInfo GetFormatBlockInfo(vk::Format format)
+	{
+		switch (format)
+		{
+			case vk::Format::eR8Unorm:
+			case vk::Format::eR8Srgb:
+				return { 1, 1, 1 };
+			case vk::Format::eR8G8Unorm:
+			case vk::Format::eR16Sfloat:
+				return { 1, 1, 2 };
+			case vk::Format::eR8G8B8A8Unorm:
+			case vk::Format::eR8G8B8A8Srgb:
+			case vk::Format::eB8G8R8A8Unorm:
+			case vk::Format::eB8G8R8A8Srgb:
+			case vk::Format::eA2B10G10R10UnormPack32:
+			case vk::Format::eB10G11R11UfloatPack32:
+			case vk::Format::eR16G16Sfloat:
+			case vk::Format::eR32Sfloat:
+				return { 1, 1, 4 };
+			case vk::Format::eR16G16B16A16Sfloat:
+			case vk::Format::eR32G32Sfloat:
+				return { 1, 1, 8 };
+			case vk::Format::eR32G32B32A32Sfloat:
+				return { 1, 1, 16 };
+			case vk::Format::eEtc2R8G8B8UnormBlock:
+			case vk::Format::eEtc2R8G8B8SrgbBlock:
+			case vk::Format::eEtc2R8G8B8A1UnormBlock:
+			case vk::Format::eEtc2R8G8B8A1SrgbBlock:
+			case vk::Format::eEacR11UnormBlock:
+			case vk::Format::eBc1RgbUnormBlock:
+			case vk::Format::eBc1RgbSrgbBlock:
+			case vk::Format::eBc1RgbaUnormBlock:
+			case vk::Format::eBc1RgbaSrgbBlock:
+			case vk::Format::eBc4UnormBlock:
+			case vk::Format::eBc4SnormBlock:
+				return { 4, 4, 8 };
+			case vk::Format::eBc2UnormBlock:
+			case vk::Format::eBc2SrgbBlock:
+			case vk::Format::eBc3UnormBlock:
+			case vk::Format::eBc3SrgbBlock:
+			case vk::Format::eBc5UnormBlock:
+			case vk::Format::eBc5SnormBlock:
+			case vk::Format::eBc6HUfloatBlock:
+			case vk::Format::eBc6HSfloatBlock:
+			case vk::Format::eBc7UnormBlock:
+			case vk::Format::eBc7SrgbBlock:
+			case vk::Format::eEtc2R8G8B8A8UnormBlock:
+			case vk::Format::eEtc2R8G8B8A8SrgbBlock:
+			case vk::Format::eEacR11G11UnormBlock:
+			case vk::Format::eAstc4x4UnormBlock:
+			case vk::Format::eAstc4x4SrgbBlock:
+				return { 4, 4, 16 };
+			default:
+				throw std::runtime_error("Unsupported texture format!");
+		}
+	}
+
+	vk::Extent3D GetMipExtent(const vk::Extent3D& extent, uint32_t mipLevel)
+	{
+		return { std::max(1u, extent.width >> mipLevel), std::max(1u, extent.height >> mipLevel), std::max(1u, extent.depth >> mipLevel) };
+	}
+
+	vk::DeviceSize GetMipSize(vk::Format format, const vk::Extent3D& extent, uint32_t mipLevel)
+	{
+		const FormatBlockInfo block = GetFormatBlockInfo(format);
+		const vk::Extent3D mipExtent = GetMipExtent(extent, mipLevel);
+		const vk::DeviceSize blocksX = (mipExtent.width + block.BlockWidth - 1) / block.BlockWidth;
+		const vk::DeviceSize blocksY = (mipExtent.height + block.BlockHeight - 1) / block.BlockHeight;
+		return blocksX * blocksY * mipExtent.depth * block.BytesPerBlock;
+	}
+
+	vk::Format SelectSupportedFormat(const vk::raii::PhysicalDevice& physicalDevice, std::span<const vk::Format> candidates, vk::FormatFeatureFlags features)
+	{
+		for (vk::Format candidate : candidates)
+		{
+			if ((physicalDevice.getFormatProperties(candidate).optimalTilingFeatures & features) == features)
+			{
+				return candidate;
+			}
+		}
+		return vk::Format::eUndefined;
+	}
+}
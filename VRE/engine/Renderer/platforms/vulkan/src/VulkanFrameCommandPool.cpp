@@ -0,0 +1,44 @@
+#include <VulkanFrameCommandPool.h>
+
+namespace VRE
+{
+	VulkanFrameCommandPool::VulkanFrameCommandPool(const vk::raii::Device& device, uint32_t queueFamilyIndex)
+		: m_Device(device)
+	{
+		//Transient: buffers are recorded once and recycled with the whole pool, never reset on their own
+		const vk::CommandPoolCreateInfo poolInfo{ .flags = vk::CommandPoolCreateFlagBits::eTransient, .queueFamilyIndex = queueFamilyIndex };
+		for (FramePool& pool : m_Pools)
+		{
+			pool.Pool = vk::raii::CommandPool(m_Device, poolInfo);
+		}
+	}
+
+	void VulkanFrameCommandPool::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		FramePool& pool = m_Pools[m_FrameIndex];
+		bool bUsed = false;
+		for (FreeList& level : pool.Levels)
+		{
+			bUsed |= level.UsedCount > 0;
+			level.UsedCount = 0;
+		}
+		//Keeps the pool's memory for next time, this frame records about as much as the last one did
+		if (bUsed)
+		{
+			pool.Pool.reset();
+		}
+	}
+
+	vk::raii::CommandBuffer& VulkanFrameCommandPool::Allocate(vk::CommandBufferLevel level)
+	{
+		FramePool& pool = m_Pools[m_FrameIndex];
+		FreeList& freeList = pool.Levels[level == vk::CommandBufferLevel::ePrimary ? 0 : 1];
+		if (freeList.UsedCount == freeList.CommandBuffers.size())
+		{
+			vk::raii::CommandBuffers allocated(m_Device, { .commandPool = pool.Pool, .level = level, .commandBufferCount = 1 });
+			freeList.CommandBuffers.push_back(std::move(allocated[0]));
+		}
+		return freeList.CommandBuffers[freeList.UsedCount++];
+	}
+}
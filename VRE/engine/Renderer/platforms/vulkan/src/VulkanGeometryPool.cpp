@@ -0,0 +1,327 @@
+#include <VulkanGeometryPool.h>
+#include <algorithm>
+
+namespace VRE
+{
+	//First size of each buffer, they double from there
+	constexpr vk::DeviceSize k_InitialArenaSize = 8 * 1024 * 1024;
+	//Compaction starts once holes add up to this fraction of a buffer and copies at most the budget per frame
+	constexpr uint64_t k_CompactionThreshold = 8;
+	constexpr vk::DeviceSize k_CompactionBudget = 4 * 1024 * 1024;
+
+	//Empty meshes still take one element so every geometry has a range of its own
+	static uint64_t GetRangeSize(uint32_t count)
+	{
+		return std::max<uint64_t>(count, 1);
+	}
+
+	VulkanGeometryPool::VulkanGeometryPool(VulkanResourcePool& resourcePool, VulkanDeletionQueue& deletionQueue)
+		: m_ResourcePool(resourcePool), m_DeletionQueue(deletionQueue)
+	{
+		for (MeshVertexLayout layout : { MeshVertexLayout::Interleaved, MeshVertexLayout::Streamed })
+		{
+			for (MeshVertexFormat format : { MeshVertexFormat::Float, MeshVertexFormat::Quantized })
+			{
+				Arena& arena = m_Arenas[GetVertexArena(layout, format)];
+				arena.Strides = GetMeshVertexStrides(layout, format);
+				//Also a storage buffer for shaders that pull vertices themselves
+				arena.Usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer
+					| vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+			}
+		}
+		for (vk::IndexType indexType : { vk::IndexType::eUint16, vk::IndexType::eUint32 })
+		{
+			Arena& arena = m_Arenas[GetIndexArena(indexType)];
+			arena.Strides = { .PositionStride = indexType == vk::IndexType::eUint16 ? 2u : 4u };
+			arena.Usage = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+		}
+	}
+
+	VulkanGeometryPool::~VulkanGeometryPool()
+	{
+		for (Arena& arena : m_Arenas)
+		{
+			for (BufferHandle buffer : { arena.Buffer, arena.GrowSource })
+			{
+				if (buffer.IsValid())
+				{
+					m_ResourcePool.DestroyBuffer(buffer);
+				}
+			}
+		}
+	}
+
+	uint32_t VulkanGeometryPool::GetVertexArena(MeshVertexLayout layout, MeshVertexFormat format)
+	{
+		return static_cast<uint32_t>(layout) * 2 + static_cast<uint32_t>(format);
+	}
+
+	GeometryHandle VulkanGeometryPool::Allocate(MeshVertexLayout layout, MeshVertexFormat format, uint32_t vertexCount, vk::IndexType indexType,
+		uint32_t indexCount)
+	{
+		const GeometryHandle handle = m_Handles.Allocate();
+		if (m_Geometries.size() < m_Handles.GetCapacity())
+		{
+			m_Geometries.resize(m_Handles.GetCapacity());
+		}
+		const uint32_t vertexArena = GetVertexArena(layout, format);
+		const uint32_t indexArena = GetIndexArena(indexType);
+		VulkanGeometry& geometry = m_Geometries[handle.GetIndex()];
+		geometry = {
+			.VertexLayout = layout,
+			.VertexFormat = format,
+			.IndexType = indexType,
+			.FirstVertex = static_cast<uint32_t>(AllocateRange(vertexArena, GetRangeSize(vertexCount))),
+			.VertexCount = vertexCount,
+			.FirstIndex = static_cast<uint32_t>(AllocateRange(indexArena, GetRangeSize(indexCount))),
+			.IndexCount = indexCount
+		};
+		m_Arenas[vertexArena].Ranges.emplace(geometry.FirstVertex, handle);
+		m_Arenas[indexArena].Ranges.emplace(geometry.FirstIndex, handle);
+		return handle;
+	}
+
+	void VulkanGeometryPool::Free(GeometryHandle handle)
+	{
+		VulkanGeometry& geometry = m_Geometries[handle.GetIndex()];
+		//Frames up to the one recorded last may still draw it
+		const uint64_t retireValue = m_DeletionQueue.GetRetireValue();
+		const uint32_t vertexArena = GetVertexArena(geometry.VertexLayout, geometry.VertexFormat);
+		const uint32_t indexArena = GetIndexArena(geometry.IndexType);
+		m_Arenas[vertexArena].Ranges.erase(geometry.FirstVertex);
+		m_Arenas[indexArena].Ranges.erase(geometry.FirstIndex);
+		m_PendingFrees.push_back({ retireValue, vertexArena, geometry.FirstVertex, GetRangeSize(geometry.VertexCount) });
+		m_PendingFrees.push_back({ retireValue, indexArena, geometry.FirstIndex, GetRangeSize(geometry.IndexCount) });
+		geometry = {};
+		m_Handles.Free(handle);
+	}
+
+	VulkanGeometryRegion VulkanGeometryPool::GetPositionRegion(GeometryHandle handle) const
+	{
+		const VulkanGeometry& geometry = Get(handle);
+		const Arena& arena = m_Arenas[GetVertexArena(geometry.VertexLayout, geometry.VertexFormat)];
+		return {
+			.Buffer = arena.Buffer,
+			.Offset = vk::DeviceSize(geometry.FirstVertex) * arena.Strides.PositionStride,
+			.Size = vk::DeviceSize(geometry.VertexCount) * arena.Strides.PositionStride
+		};
+	}
+
+	VulkanGeometryRegion VulkanGeometryPool::GetAttributeRegion(GeometryHandle handle) const
+	{
+		const VulkanGeometry& geometry = Get(handle);
+		const Arena& arena = m_Arenas[GetVertexArena(geometry.VertexLayout, geometry.VertexFormat)];
+		if (arena.Strides.AttributeStride == 0)
+		{
+			return {};
+		}
+		return {
+			.Buffer = arena.Buffer,
+			.Offset = GetAttributeOffset(geometry.VertexLayout, geometry.VertexFormat) + vk::DeviceSize(geometry.FirstVertex) * arena.Strides.AttributeStride,
+			.Size = vk::DeviceSize(geometry.VertexCount) * arena.Strides.AttributeStride
+		};
+	}
+
+	VulkanGeometryRegion VulkanGeometryPool::GetIndexRegion(GeometryHandle handle) const
+	{
+		const VulkanGeometry& geometry = Get(handle);
+		const Arena& arena = m_Arenas[GetIndexArena(geometry.IndexType)];
+		return {
+			.Buffer = arena.Buffer,
+			.Offset = vk::DeviceSize(geometry.FirstIndex) * arena.Strides.PositionStride,
+			.Size = vk::DeviceSize(geometry.IndexCount) * arena.Strides.PositionStride
+		};
+	}
+
+	vk::DeviceSize VulkanGeometryPool::GetAttributeOffset(MeshVertexLayout layout, MeshVertexFormat format) const
+	{
+		const Arena& arena = m_Arenas[GetVertexArena(layout, format)];
+		return arena.Strides.AttributeStride == 0 ? 0 : arena.Allocator.GetCapacity() * arena.Strides.PositionStride;
+	}
+
+	uint64_t VulkanGeometryPool::AllocateRange(uint32_t arenaIndex, uint64_t count)
+	{
+		Arena& arena = m_Arenas[arenaIndex];
+		std::optional<uint64_t> first = arena.Allocator.Allocate(count);
+		if (!first)
+		{
+			Grow(arena, arena.Allocator.GetCapacity() + count);
+			first = arena.Allocator.Allocate(count);
+		}
+		return *first;
+	}
+
+	void VulkanGeometryPool::Grow(Arena& arena, uint64_t minCapacity)
+	{
+		const uint64_t elementSize = arena.Strides.PositionStride + arena.Strides.AttributeStride;
+		const uint64_t capacity = std::max({ minCapacity, arena.Allocator.GetCapacity() * 2, k_InitialArenaSize / elementSize });
+		const BufferHandle buffer = m_ResourcePool.CreateBuffer({ .Size = capacity * elementSize, .Usage = arena.Usage });
+		if (arena.GrowSource.IsValid())
+		{
+			//Grown twice before Record, the GPU never saw the buffer in between
+			m_ResourcePool.DestroyBuffer(arena.Buffer);
+		}
+		else if (arena.Buffer.IsValid())
+		{
+			arena.GrowSource = arena.Buffer;
+			arena.GrowSourceCapacity = arena.Allocator.GetCapacity();
+		}
+		arena.Buffer = buffer;
+		arena.Allocator.Grow(capacity);
+	}
+
+	void VulkanGeometryPool::Collect(uint64_t completedValue)
+	{
+		//Retire values only grow, so the pending frees stay sorted
+		size_t count = 0;
+		while (count < m_PendingFrees.size() && m_PendingFrees[count].RetireValue <= completedValue)
+		{
+			const PendingFree& pending = m_PendingFrees[count];
+			m_Arenas[pending.Arena].Allocator.Free(pending.First, pending.Count);
+			count++;
+		}
+		m_PendingFrees.erase(m_PendingFrees.begin(), m_PendingFrees.begin() + count);
+	}
+
+	void VulkanGeometryPool::Record(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		std::array<std::vector<vk::BufferCopy>, 6> moves;
+		vk::DeviceSize budget = k_CompactionBudget;
+		bool bCopies = false;
+		for (uint32_t i = 0; i < m_Arenas.size(); i++)
+		{
+			budget -= std::min(budget, Compact(i, budget, moves[i]));
+			bCopies |= m_Arenas[i].GrowSource.IsValid() || !moves[i].empty();
+		}
+		if (!bCopies)
+		{
+			return;
+		}
+		m_Version++;
+
+		//Earlier frames' uploads have to land before they are copied around
+		const vk::MemoryBarrier2 transferBarrier{
+			.srcStageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &transferBarrier });
+		bool bGrown = false;
+		for (Arena& arena : m_Arenas)
+		{
+			if (arena.GrowSource.IsValid())
+			{
+				RecordGrowCopy(commandBuffer, arena);
+				bGrown = true;
+			}
+		}
+		if (bGrown && std::any_of(moves.begin(), moves.end(), [](const auto& arenaMoves) { return !arenaMoves.empty(); }))
+		{
+			commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &transferBarrier });
+		}
+		for (uint32_t i = 0; i < m_Arenas.size(); i++)
+		{
+			if (!moves[i].empty())
+			{
+				const vk::Buffer buffer = m_ResourcePool.GetBuffer(m_Arenas[i].Buffer);
+				commandBuffer.copyBuffer(buffer, buffer, moves[i]);
+			}
+		}
+
+		const vk::MemoryBarrier2 barrier{
+			.srcStageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eVertexAttributeInput | vk::PipelineStageFlagBits2::eIndexInput
+				| vk::PipelineStageFlagBits2::ePreRasterizationShaders | vk::PipelineStageFlagBits2::eAllTransfer,
+			.dstAccessMask = vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead | vk::AccessFlagBits2::eShaderStorageRead
+				| vk::AccessFlagBits2::eTransferWrite
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &barrier });
+	}
+
+	void VulkanGeometryPool::RecordGrowCopy(const vk::raii::CommandBuffer& commandBuffer, Arena& arena)
+	{
+		//The attribute stream starts after Capacity positions, so it moves along with the capacity
+		const VulkanVertexStrides& strides = arena.Strides;
+		const vk::DeviceSize oldCapacity = arena.GrowSourceCapacity;
+		const vk::BufferCopy regions[] = {
+			{ .srcOffset = 0, .dstOffset = 0, .size = oldCapacity * strides.PositionStride },
+			{ .srcOffset = oldCapacity * strides.PositionStride, .dstOffset = arena.Allocator.GetCapacity() * strides.PositionStride,
+				.size = oldCapacity * strides.AttributeStride }
+		};
+		commandBuffer.copyBuffer(m_ResourcePool.GetBuffer(arena.GrowSource), m_ResourcePool.GetBuffer(arena.Buffer),
+			vk::ArrayProxy<const vk::BufferCopy>(strides.AttributeStride != 0 ? 2 : 1, regions));
+		//Released while this frame is being recorded, so it outlives the copy
+		m_ResourcePool.DestroyBuffer(arena.GrowSource);
+		arena.GrowSource = {};
+		arena.GrowSourceCapacity = 0;
+	}
+
+	vk::DeviceSize VulkanGeometryPool::Compact(uint32_t arenaIndex, vk::DeviceSize budget, std::vector<vk::BufferCopy>& moves)
+	{
+		Arena& arena = m_Arenas[arenaIndex];
+		const VulkanVertexStrides& strides = arena.Strides;
+		const vk::DeviceSize attributeOffset = arena.Allocator.GetCapacity() * strides.PositionStride;
+		const bool bIndices = arenaIndex >= GetIndexArena(vk::IndexType::eUint16);
+		vk::DeviceSize moved = 0;
+		while (moved < budget && !arena.Ranges.empty())
+		{
+			//A single free tail is fine, only holes between meshes are worth copying for
+			const RangeAllocator& allocator = arena.Allocator;
+			if ((allocator.GetFreeSize() - allocator.GetLargestFreeRange()) * k_CompactionThreshold < allocator.GetCapacity())
+			{
+				break;
+			}
+			const auto last = std::prev(arena.Ranges.end());
+			const GeometryHandle handle = last->second;
+			VulkanGeometry& geometry = m_Geometries[handle.GetIndex()];
+			if (!geometry.bUploaded)
+			{
+				break;
+			}
+			const uint64_t first = last->first;
+			const uint64_t count = GetRangeSize(bIndices ? geometry.IndexCount : geometry.VertexCount);
+			const std::optional<uint64_t> target = arena.Allocator.AllocateBelow(count, first);
+			if (!target)
+			{
+				break;
+			}
+
+			//The target was free and the source stays allocated until this frame retires, so copies never overlap
+			moves.push_back({ .srcOffset = first * strides.PositionStride, .dstOffset = *target * strides.PositionStride,
+				.size = count * strides.PositionStride });
+			if (strides.AttributeStride != 0)
+			{
+				moves.push_back({ .srcOffset = attributeOffset + first * strides.AttributeStride,
+					.dstOffset = attributeOffset + *target * strides.AttributeStride, .size = count * strides.AttributeStride });
+			}
+			(bIndices ? geometry.FirstIndex : geometry.FirstVertex) = static_cast<uint32_t>(*target);
+			arena.Ranges.erase(last);
+			arena.Ranges.emplace(*target, handle);
+			m_PendingFrees.push_back({ m_DeletionQueue.GetRetireValue(), arenaIndex, first, count });
+			moved += count * (strides.PositionStride + strides.AttributeStride);
+		}
+		return moved;
+	}
+
+	vk::DeviceSize VulkanGeometryPool::GetCapacity() const
+	{
+		vk::DeviceSize capacity = 0;
+		for (const Arena& arena : m_Arenas)
+		{
+			capacity += arena.Allocator.GetCapacity() * (arena.Strides.PositionStride + arena.Strides.AttributeStride);
+		}
+		return capacity;
+	}
+
+	vk::DeviceSize VulkanGeometryPool::GetFreeSize() const
+	{
+		vk::DeviceSize size = 0;
+		for (const Arena& arena : m_Arenas)
+		{
+			size += arena.Allocator.GetFreeSize() * (arena.Strides.PositionStride + arena.Strides.AttributeStride);
+		}
+		return size;
+	}
+}
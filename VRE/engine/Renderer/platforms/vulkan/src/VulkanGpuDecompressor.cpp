@@ -0,0 +1,224 @@
+#include <VulkanGpuDecompressor.h>
+#include <FileReader.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace VRE
+{
+	struct DecompressConstants
+	{
+		uint32_t FirstChunk;
+	};
+
+	VulkanGpuDecompressor::VulkanGpuDecompressor(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+		VulkanResourcePool& resourcePool, VulkanUploadContext& uploadContext, VulkanDescriptorBinder& descriptorBinder, const std::string& shaderPath)
+		: m_Device(device), m_ResourcePool(resourcePool), m_UploadContext(uploadContext), m_DescriptorBinder(descriptorBinder)
+	{
+		m_MaxDestinationSize = std::min<vk::DeviceSize>(physicalDevice.getProperties().limits.maxStorageBufferRange, std::numeric_limits<uint32_t>::max());
+
+		std::vector<vk::DescriptorSetLayoutBinding> bindings = {
+			{ .binding = 0, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute },
+			{ .binding = 1, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute },
+			{ .binding = 2, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute }
+		};
+		m_SetLayout = m_DescriptorBinder.CreateSetLayout(bindings);
+
+		const std::vector<char> shaderCode = FileReader::ReadShaderFile(shaderPath);
+		vk::raii::ShaderModule shaderModule(m_Device, vk::ShaderModuleCreateInfo{
+			.codeSize = shaderCode.size(),
+			.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data())
+		});
+
+		vk::PushConstantRange pushConstantRange{ .stageFlags = vk::ShaderStageFlagBits::eCompute, .offset = 0, .size = sizeof(DecompressConstants) };
+		vk::raii::PipelineLayout pipelineLayout(m_Device, vk::PipelineLayoutCreateInfo{
+			.setLayoutCount = 1,
+			.pSetLayouts = &*m_SetLayout,
+			.pushConstantRangeCount = 1,
+			.pPushConstantRanges = &pushConstantRange
+		});
+		vk::ComputePipelineCreateInfo pipelineInfo{
+			.flags = m_DescriptorBinder.GetPipelineCreateFlags(),
+			.stage = { .stage = vk::ShaderStageFlagBits::eCompute, .module = shaderModule, .pName = "decompressMain" },
+			.layout = pipelineLayout
+		};
+		vk::raii::Pipeline pipeline(m_Device, nullptr, pipelineInfo);
+		m_Pipeline = m_ResourcePool.AddPipeline(std::move(pipeline), std::move(pipelineLayout), vk::PipelineBindPoint::eCompute);
+
+		m_InputBuffer = m_ResourcePool.CreateBuffer({
+			.Size = k_InputBufferSize,
+			.Usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress
+		});
+		m_ChunkBuffer = m_ResourcePool.CreateBuffer({
+			.Size = k_MaxChunksPerFrame * sizeof(ChunkDesc),
+			.Usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress
+		});
+	}
+
+	VulkanGpuDecompressor::~VulkanGpuDecompressor()
+	{
+		m_ResourcePool.DestroyBuffer(m_ChunkBuffer);
+		m_ResourcePool.DestroyBuffer(m_InputBuffer);
+		m_ResourcePool.DestroyPipeline(m_Pipeline);
+	}
+
+	bool VulkanGpuDecompressor::Decompress(const PakArchive& pak, const PakFileEntry& entry, BufferHandle destination, vk::DeviceSize destinationOffset)
+	{
+		std::vector<CompressedChunk> chunks;
+		for (const PakChunk& chunk : pak.GetChunks(entry))
+		{
+			chunks.push_back({ .Codec = chunk.Codec, .Data = pak.GetChunkData(chunk), .Size = chunk.Size });
+		}
+		return Decompress(chunks, destination, destinationOffset);
+	}
+
+	bool VulkanGpuDecompressor::Decompress(std::span<const CompressedChunk> chunks, BufferHandle destination, vk::DeviceSize destinationOffset)
+	{
+		vk::DeviceSize outputSize = 0;
+		vk::DeviceSize stagingSize = 0;
+		vk::DeviceSize inputSize = 0;
+		uint32_t gpuChunkCount = 0;
+		for (const CompressedChunk& chunk : chunks)
+		{
+			outputSize += chunk.Size;
+		}
+		const bool bGpuPath = !m_bCpuFallback && m_ResourcePool.GetSize(destination) <= m_MaxDestinationSize;
+		for (const CompressedChunk& chunk : chunks)
+		{
+			const bool bGpuChunk = bGpuPath && chunk.Codec == CompressionCodec::Lz4;
+			stagingSize += bGpuChunk ? chunk.Data.size() : chunk.Size;
+			inputSize += bGpuChunk ? chunk.Data.size() : 0;
+			gpuChunkCount += bGpuChunk ? 1 : 0;
+		}
+		if (destinationOffset + outputSize > m_ResourcePool.GetSize(destination))
+		{
+			throw std::runtime_error("Decompressed data doesn't fit the destination buffer!");
+		}
+		if (m_InputHead + inputSize > k_InputBufferSize || m_Chunks.size() + gpuChunkCount > k_MaxChunksPerFrame)
+		{
+			return false;
+		}
+		const std::optional<VulkanStagingAllocation> staging = m_UploadContext.Allocate(stagingSize);
+		if (!staging)
+		{
+			return false;
+		}
+
+		const Dispatch dispatch{ .Destination = destination, .FirstChunk = static_cast<uint32_t>(m_Chunks.size()), .ChunkCount = gpuChunkCount };
+		vk::DeviceSize stagingOffset = 0;
+		vk::DeviceSize outputOffset = destinationOffset;
+		for (const CompressedChunk& chunk : chunks)
+		{
+			std::byte* stagingData = staging->Data + stagingOffset;
+			if (bGpuPath && chunk.Codec == CompressionCodec::Lz4)
+			{
+#ifndef NDEBUG
+				//The shader just stops on malformed data, the reference decoder says why the destination holds garbage
+				std::vector<std::byte> reference(chunk.Size);
+				if (!VRE::Decompress(chunk.Codec, chunk.Data, reference))
+				{
+					throw std::runtime_error("Corrupt LZ4 chunk queued for GPU decompression!");
+				}
+#endif
+				std::memcpy(stagingData, chunk.Data.data(), chunk.Data.size());
+				m_Copies.push_back({ .Source = staging->Buffer, .Destination = m_InputBuffer, .Region = { staging->Offset + stagingOffset, m_InputHead, chunk.Data.size() } });
+				m_Chunks.push_back({
+					.InputOffset = static_cast<uint32_t>(m_InputHead),
+					.InputSize = static_cast<uint32_t>(chunk.Data.size()),
+					.OutputOffset = static_cast<uint32_t>(outputOffset),
+					.OutputSize = chunk.Size
+				});
+				m_InputHead += chunk.Data.size();
+				stagingOffset += chunk.Data.size();
+			}
+			else
+			{
+				if (!VRE::Decompress(chunk.Codec, chunk.Data, { stagingData, chunk.Size }))
+				{
+					throw std::runtime_error("Could not decompress chunk!");
+				}
+				m_Copies.push_back({ .Source = staging->Buffer, .Destination = destination, .Region = { staging->Offset + stagingOffset, outputOffset, chunk.Size } });
+				stagingOffset += chunk.Size;
+			}
+			outputOffset += chunk.Size;
+		}
+		if (gpuChunkCount > 0)
+		{
+			m_Dispatches.push_back(dispatch);
+		}
+		return true;
+	}
+
+	void VulkanGpuDecompressor::Record(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		if (m_Copies.empty())
+		{
+			return;
+		}
+
+		//The previous frame's dispatches may still read the input and chunk buffers, destinations may be in use
+		const vk::MemoryBarrier2 beforeBarrier{
+			.srcStageMask = vk::PipelineStageFlagBits2::eAllCommands,
+			.srcAccessMask = vk::AccessFlagBits2::eMemoryWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferWrite
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &beforeBarrier });
+
+		if (!m_Chunks.empty())
+		{
+			commandBuffer.updateBuffer<ChunkDesc>(m_ResourcePool.GetBuffer(m_ChunkBuffer), 0, m_Chunks);
+		}
+		for (const Copy& copy : m_Copies)
+		{
+			//Destroyed since it was queued
+			if (m_ResourcePool.IsValid(copy.Destination))
+			{
+				commandBuffer.copyBuffer(copy.Source, m_ResourcePool.GetBuffer(copy.Destination), copy.Region);
+			}
+		}
+
+		if (!m_Dispatches.empty())
+		{
+			const vk::MemoryBarrier2 inputBarrier{
+				.srcStageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+				.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+				.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+				.dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite
+			};
+			commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &inputBarrier });
+
+			const vk::PipelineLayout pipelineLayout = m_ResourcePool.GetPipelineLayout(m_Pipeline);
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_ResourcePool.GetPipeline(m_Pipeline));
+			for (const Dispatch& dispatch : m_Dispatches)
+			{
+				if (!m_ResourcePool.IsValid(dispatch.Destination))
+				{
+					continue;
+				}
+				VulkanDescriptorSet set = m_DescriptorBinder.Allocate(*m_SetLayout);
+				m_DescriptorBinder.WriteBuffer(set, 0, vk::DescriptorType::eStorageBuffer, m_ChunkBuffer, 0, m_Chunks.size() * sizeof(ChunkDesc));
+				m_DescriptorBinder.WriteBuffer(set, 1, vk::DescriptorType::eStorageBuffer, m_InputBuffer, 0, k_InputBufferSize);
+				m_DescriptorBinder.WriteBuffer(set, 2, vk::DescriptorType::eStorageBuffer, dispatch.Destination, 0, m_ResourcePool.GetSize(dispatch.Destination));
+				m_DescriptorBinder.BindSets(commandBuffer, vk::PipelineBindPoint::eCompute, pipelineLayout, 0, { &set, 1 });
+
+				commandBuffer.pushConstants<DecompressConstants>(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, DecompressConstants{ dispatch.FirstChunk });
+				commandBuffer.dispatch(dispatch.ChunkCount, 1, 1);
+			}
+		}
+
+		const vk::MemoryBarrier2 doneBarrier{
+			.srcStageMask = vk::PipelineStageFlagBits2::eAllTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderStorageWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eAllCommands,
+			.dstAccessMask = vk::AccessFlagBits2::eMemoryRead
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &doneBarrier });
+
+		m_Copies.clear();
+		m_Chunks.clear();
+		m_Dispatches.clear();
+		m_InputHead = 0;
+	}
+}
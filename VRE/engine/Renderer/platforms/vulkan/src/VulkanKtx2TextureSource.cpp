@@ -0,0 +1,242 @@
+#include <VulkanKtx2TextureSource.h>
+#include <VulkanFormats.h>
+#include <FileReader.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+
+#ifdef VRE_ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef VRE_ENABLE_BASISU
+#include <mutex>
+#include <basisu_transcoder.h>
+#endif
+
+namespace VRE
+{
+	constexpr std::array<uint8_t, 12> k_Ktx2Identifier = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	constexpr size_t k_Ktx2HeaderSize = 80;
+	constexpr size_t k_Ktx2LevelIndexEntrySize = 24;
+
+	constexpr uint32_t k_SupercompressionNone = 0;
+	constexpr uint32_t k_SupercompressionBasisLZ = 1;
+	constexpr uint32_t k_SupercompressionZstd = 2;
+	//Data format descriptor values, see the Khronos Data Format Specification
+	constexpr uint8_t k_DfdColorModelUASTC = 166;
+	constexpr uint8_t k_DfdTransferSrgb = 2;
+
+	template<typename T> static T ReadValue(const std::vector<std::byte>& data, size_t offset)
+	{
+		T value;
+		std::memcpy(&value, data.data() + offset, sizeof(T));
+		return value;
+	}
+
+#ifdef VRE_ENABLE_BASISU
+	struct VulkanKtx2TextureSource::BasisState
+	{
+		//The transcoder reads codebooks and level data straight out of the file, keep all of it around
+		std::vector<std::byte> FileData;
+		basist::ktx2_transcoder Transcoder;
+		basist::transcoder_texture_format TargetFormat = basist::transcoder_texture_format::cTFRGBA32;
+	};
+
+	static basist::transcoder_texture_format GetTranscodeFormat(vk::Format format)
+	{
+		switch (format)
+		{
+			case vk::Format::eBc7UnormBlock: case vk::Format::eBc7SrgbBlock: return basist::transcoder_texture_format::cTFBC7_RGBA;
+			case vk::Format::eAstc4x4UnormBlock: case vk::Format::eAstc4x4SrgbBlock: return basist::transcoder_texture_format::cTFASTC_4x4_RGBA;
+			case vk::Format::eEtc2R8G8B8A8UnormBlock: case vk::Format::eEtc2R8G8B8A8SrgbBlock: return basist::transcoder_texture_format::cTFETC2_RGBA;
+			//ETC1 is a subset of ETC2 RGB
+			case vk::Format::eEtc2R8G8B8UnormBlock: case vk::Format::eEtc2R8G8B8SrgbBlock: return basist::transcoder_texture_format::cTFETC1_RGB;
+			case vk::Format::eBc3UnormBlock: case vk::Format::eBc3SrgbBlock: return basist::transcoder_texture_format::cTFBC3_RGBA;
+			case vk::Format::eBc1RgbUnormBlock: case vk::Format::eBc1RgbSrgbBlock: return basist::transcoder_texture_format::cTFBC1_RGB;
+			default: return basist::transcoder_texture_format::cTFRGBA32;
+		}
+	}
+#else
+	struct VulkanKtx2TextureSource::BasisState
+	{
+	};
+#endif
+
+	VulkanKtx2TextureSource::VulkanKtx2TextureSource(std::string path, const vk::raii::PhysicalDevice& physicalDevice)
+		: m_Path(std::move(path)), m_PhysicalDevice(physicalDevice)
+	{
+	}
+
+	VulkanKtx2TextureSource::~VulkanKtx2TextureSource() = default;
+
+	bool VulkanKtx2TextureSource::Open()
+	{
+		std::vector<std::byte> header;
+		if (!FileReader::ReadFileRange(m_Path, 0, k_Ktx2HeaderSize, header) || std::memcmp(header.data(), k_Ktx2Identifier.data(), k_Ktx2Identifier.size()) != 0)
+		{
+			return false;
+		}
+
+		const uint32_t vkFormat = ReadValue<uint32_t>(header, 12);
+		const uint32_t pixelWidth = ReadValue<uint32_t>(header, 20);
+		const uint32_t pixelHeight = ReadValue<uint32_t>(header, 24);
+		const uint32_t pixelDepth = ReadValue<uint32_t>(header, 28);
+		const uint32_t layerCount = ReadValue<uint32_t>(header, 32);
+		const uint32_t faceCount = ReadValue<uint32_t>(header, 36);
+		//0 asks the loader to generate mips, there is only the base level in the file then
+		const uint32_t levelCount = std::max(1u, ReadValue<uint32_t>(header, 40));
+		const uint32_t supercompression = ReadValue<uint32_t>(header, 44);
+		const uint32_t dfdOffset = ReadValue<uint32_t>(header, 48);
+		//Only 2D textures
+		if (pixelDepth > 1 || layerCount > 1 || faceCount != 1 || pixelHeight == 0)
+		{
+			return false;
+		}
+
+		std::vector<std::byte> levelIndex;
+		if (!FileReader::ReadFileRange(m_Path, k_Ktx2HeaderSize, levelCount * k_Ktx2LevelIndexEntrySize, levelIndex))
+		{
+			return false;
+		}
+		m_Levels.resize(levelCount);
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			const size_t entry = level * k_Ktx2LevelIndexEntrySize;
+			m_Levels[level] = { ReadValue<uint64_t>(levelIndex, entry), ReadValue<uint64_t>(levelIndex, entry + 8), ReadValue<uint64_t>(levelIndex, entry + 16) };
+		}
+
+		//Color model and transfer function sit in the first descriptor block, right after the total size word
+		std::vector<std::byte> dfd;
+		if (!FileReader::ReadFileRange(m_Path, dfdOffset, 16, dfd))
+		{
+			return false;
+		}
+		const uint8_t colorModel = ReadValue<uint8_t>(dfd, 12);
+		const bool bSrgb = ReadValue<uint8_t>(dfd, 14) == k_DfdTransferSrgb;
+
+		m_Info.Extent = { pixelWidth, pixelHeight, 1 };
+		m_Info.MipLevels = levelCount;
+
+		if (supercompression == k_SupercompressionBasisLZ || (vkFormat == 0 && colorModel == k_DfdColorModelUASTC))
+		{
+			m_Encoding = Encoding::Basis;
+			return InitBasis(bSrgb);
+		}
+		if (vkFormat == 0)
+		{
+			return false;
+		}
+
+		if (supercompression == k_SupercompressionZstd)
+		{
+#ifdef VRE_ENABLE_ZSTD
+			m_Encoding = Encoding::Zstd;
+#else
+			return false;
+#endif
+		}
+		else if (supercompression != k_SupercompressionNone)
+		{
+			return false;
+		}
+
+		m_Info.Format = static_cast<vk::Format>(vkFormat);
+		const std::array candidates = { m_Info.Format };
+		return SelectSupportedFormat(m_PhysicalDevice, candidates, vk::FormatFeatureFlagBits::eSampledImage) != vk::Format::eUndefined;
+	}
+
+	bool VulkanKtx2TextureSource::InitBasis(bool bSrgb)
+	{
+#ifdef VRE_ENABLE_BASISU
+		static std::once_flag s_TranscoderInit;
+		std::call_once(s_TranscoderInit, [] { basist::basisu_transcoder_init(); });
+
+		m_Basis = std::make_unique<BasisState>();
+		std::error_code error;
+		const uintmax_t fileSize = std::filesystem::file_size(m_Path, error);
+		if (error || !FileReader::ReadFileRange(m_Path, 0, fileSize, m_Basis->FileData)
+			|| !m_Basis->Transcoder.init(m_Basis->FileData.data(), static_cast<uint32_t>(m_Basis->FileData.size())) || !m_Basis->Transcoder.start_transcoding())
+		{
+			return false;
+		}
+
+		//Filterable and sampleable, transcoding to a format the device can't filter is pointless
+		const vk::FormatFeatureFlags features = vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+		if (m_Basis->Transcoder.get_has_alpha())
+		{
+			const std::array unormCandidates = { vk::Format::eBc7UnormBlock, vk::Format::eAstc4x4UnormBlock, vk::Format::eEtc2R8G8B8A8UnormBlock,
+				vk::Format::eBc3UnormBlock, vk::Format::eR8G8B8A8Unorm };
+			const std::array srgbCandidates = { vk::Format::eBc7SrgbBlock, vk::Format::eAstc4x4SrgbBlock, vk::Format::eEtc2R8G8B8A8SrgbBlock,
+				vk::Format::eBc3SrgbBlock, vk::Format::eR8G8B8A8Srgb };
+			m_Info.Format = SelectSupportedFormat(m_PhysicalDevice, bSrgb ? srgbCandidates : unormCandidates, features);
+		}
+		else
+		{
+			const std::array unormCandidates = { vk::Format::eBc7UnormBlock, vk::Format::eAstc4x4UnormBlock, vk::Format::eEtc2R8G8B8UnormBlock,
+				vk::Format::eBc1RgbUnormBlock, vk::Format::eR8G8B8A8Unorm };
+			const std::array srgbCandidates = { vk::Format::eBc7SrgbBlock, vk::Format::eAstc4x4SrgbBlock, vk::Format::eEtc2R8G8B8SrgbBlock,
+				vk::Format::eBc1RgbSrgbBlock, vk::Format::eR8G8B8A8Srgb };
+			m_Info.Format = SelectSupportedFormat(m_PhysicalDevice, bSrgb ? srgbCandidates : unormCandidates, features);
+		}
+		//No transcode target
+		if (m_Info.Format == vk::Format::eUndefined)
+		{
+			return false;
+		}
+		m_Basis->TargetFormat = GetTranscodeFormat(m_Info.Format);
+		return true;
+#else
+		(void)bSrgb;
+		return false;
+#endif
+	}
+
+	bool VulkanKtx2TextureSource::ReadMip(uint32_t mipLevel, std::vector<std::byte>& data) const
+	{
+		if (mipLevel >= m_Levels.size())
+		{
+			return false;
+		}
+		const LevelIndex& level = m_Levels[mipLevel];
+		const vk::DeviceSize mipSize = GetMipSize(m_Info.Format, m_Info.Extent, mipLevel);
+
+		switch (m_Encoding)
+		{
+			case Encoding::Raw:
+			{
+				return FileReader::ReadFileRange(m_Path, level.ByteOffset, level.ByteLength, data) && data.size() == mipSize;
+			}
+			case Encoding::Zstd:
+			{
+#ifdef VRE_ENABLE_ZSTD
+				std::vector<std::byte> compressed;
+				if (!FileReader::ReadFileRange(m_Path, level.ByteOffset, level.ByteLength, compressed))
+				{
+					return false;
+				}
+				data.resize(level.UncompressedByteLength);
+				const size_t decompressedSize = ZSTD_decompress(data.data(), data.size(), compressed.data(), compressed.size());
+				return !ZSTD_isError(decompressedSize) && decompressedSize == mipSize;
+#else
+				return false;
+#endif
+			}
+			case Encoding::Basis:
+			{
+#ifdef VRE_ENABLE_BASISU
+				//Per call state lets several workers transcode levels of the same texture at once
+				basist::ktx2_transcoder_state state;
+				const FormatBlockInfo block = GetFormatBlockInfo(m_Info.Format);
+				data.resize(mipSize);
+				const uint32_t outputUnits = static_cast<uint32_t>(mipSize / block.BytesPerBlock);
+				return m_Basis->Transcoder.transcode_image_level(mipLevel, 0, 0, data.data(), outputUnits, m_Basis->TargetFormat, 0, 0, 0, -1, -1, &state);
+#else
+				return false;
+#endif
+			}
+		}
+		return false;
+	}
+}
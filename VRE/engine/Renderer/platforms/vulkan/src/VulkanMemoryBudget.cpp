@@ -0,0 +1,57 @@
+#include <VulkanMemoryBudget.h>
+#include <algorithm>
+
+namespace VRE
+{
+	//Without the extension leave headroom for the rest of the system and driver internal allocations
+	constexpr double k_FallbackBudgetFraction = 0.8;
+
+	VulkanMemoryBudget::VulkanMemoryBudget(const vk::raii::PhysicalDevice& physicalDevice, bool bMemoryBudgetSupported)
+		: m_PhysicalDevice(physicalDevice), m_MemoryProperties(physicalDevice.getMemoryProperties()), m_bMemoryBudgetSupported(bMemoryBudgetSupported)
+	{
+		m_Heaps.resize(m_MemoryProperties.memoryHeapCount);
+		m_TrackedUsage.resize(m_MemoryProperties.memoryHeapCount, 0);
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryHeapCount; i++)
+		{
+			m_Heaps[i].Size = m_MemoryProperties.memoryHeaps[i].size;
+			m_Heaps[i].bDeviceLocal = !!(m_MemoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+		}
+		Poll();
+	}
+
+	void VulkanMemoryBudget::Poll()
+	{
+		if (!m_bMemoryBudgetSupported)
+		{
+			for (uint32_t i = 0; i < m_Heaps.size(); i++)
+			{
+				m_Heaps[i].Budget = static_cast<uint64_t>(m_Heaps[i].Size * k_FallbackBudgetFraction);
+				m_Heaps[i].Usage = m_TrackedUsage[i];
+			}
+			return;
+		}
+
+		auto properties = m_PhysicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		const auto& budgetProperties = properties.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		for (uint32_t i = 0; i < m_Heaps.size(); i++)
+		{
+			//Some drivers report a budget above the heap size, clamp it so stats stay meaningful
+			m_Heaps[i].Budget = std::min(budgetProperties.heapBudget[i], m_Heaps[i].Size);
+			m_Heaps[i].Usage = budgetProperties.heapUsage[i];
+		}
+	}
+
+	void VulkanMemoryBudget::OnAllocate(uint32_t memoryTypeIndex, vk::DeviceSize size)
+	{
+		const uint32_t heapIndex = GetHeapIndex(memoryTypeIndex);
+		m_TrackedUsage[heapIndex] += size;
+		m_Heaps[heapIndex].Usage += size;
+	}
+
+	void VulkanMemoryBudget::OnFree(uint32_t memoryTypeIndex, vk::DeviceSize size)
+	{
+		const uint32_t heapIndex = GetHeapIndex(memoryTypeIndex);
+		m_TrackedUsage[heapIndex] -= std::min(m_TrackedUsage[heapIndex], size);
+		m_Heaps[heapIndex].Usage -= std::min(m_Heaps[heapIndex].Usage, size);
+	}
+}
@@ -0,0 +1,348 @@
+#include <VulkanMeshLoader.h>
+#include <FileReader.h>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace VRE
+{
+	//Smaller leftovers of the staging budget aren't worth a copy command, the upload continues next frame
+	constexpr vk::DeviceSize k_MinUploadPiece = 64 * 1024;
+	//Pak chunks per Decompress call, each call is a dispatch of its own
+	constexpr uint32_t k_DecompressBatchSize = 64;
+
+	VulkanMeshLoader::VulkanMeshLoader(VulkanResourcePool& resourcePool, VulkanGeometryPool& geometryPool, VulkanUploadContext& uploadContext,
+		ThreadPool& threadPool, VulkanGpuDecompressor* gpuDecompressor, bool bMeshlets)
+		: m_ResourcePool(resourcePool), m_GeometryPool(geometryPool), m_UploadContext(uploadContext), m_ThreadPool(threadPool),
+		m_GpuDecompressor(gpuDecompressor), m_bMeshlets(bMeshlets)
+	{
+	}
+
+	VulkanMeshLoader::~VulkanMeshLoader()
+	{
+		for (uint32_t index = 0; index < m_Handles.GetCapacity(); index++)
+		{
+			const MeshHandle mesh(index, m_Handles.GetGeneration(index));
+			if (m_Handles.IsAlive(mesh))
+			{
+				UnloadMesh(mesh);
+			}
+		}
+	}
+
+	MeshHandle VulkanMeshLoader::LoadMesh(std::string_view path)
+	{
+		const MeshHandle handle = AllocateHandle();
+		VirtualFileSystem& fileSystem = FileReader::GetFileSystem();
+		const std::optional<VirtualFileSystem::PakFileRef> pakFile = m_GpuDecompressor ? fileSystem.FindPakFile(path) : std::nullopt;
+		if (pakFile && !pakFile->Pak->IsStored(*pakFile->Entry) && pakFile->Entry->Size <= m_GpuDecompressor->GetMaxDestinationSize())
+		{
+			m_ThreadPool.Submit([queue = m_CompletedReads, handle, file = *pakFile]()
+			{
+				std::optional<PakMesh> mesh = ReadPakMesh(file);
+				std::lock_guard lock(queue->Mutex);
+				queue->Reads.push_back({ .Mesh = handle, .Data = std::nullopt, .Pak = std::move(mesh) });
+			});
+			return handle;
+		}
+
+		fileSystem.ReadFileAsync(path, [queue = m_CompletedReads, handle](std::optional<FileData> data)
+		{
+			std::lock_guard lock(queue->Mutex);
+			queue->Reads.push_back({ .Mesh = handle, .Data = std::move(data), .Pak = std::nullopt });
+		});
+		return handle;
+	}
+
+	MeshHandle VulkanMeshLoader::LoadMesh(std::shared_ptr<MeshFile> file)
+	{
+		const MeshHandle handle = AllocateHandle();
+		CreateMesh(handle, file->GetHeader(), file->GetLods(), file->GetMeshlets());
+		m_Uploads.push_back({ .Mesh = handle, .File = std::move(file) });
+		return handle;
+	}
+
+	std::optional<VulkanMeshLoader::PakMesh> VulkanMeshLoader::ReadPakMesh(const VirtualFileSystem::PakFileRef& file)
+	{
+		const PakArchive& pak = *file.Pak;
+		const PakFileEntry& entry = *file.Entry;
+		PakMesh mesh;
+		mesh.File = file;
+		if (!pak.ReadRange(entry, 0, std::as_writable_bytes(std::span(&mesh.Header, 1))) || !MeshFile::IsValidHeader(mesh.Header, entry.Size))
+		{
+			return std::nullopt;
+		}
+		//The decompressor writes chunk i from i * chunk size on, a shorter chunk before the last would leave a gap
+		const std::span<const PakChunk> chunks = pak.GetChunks(entry);
+		for (uint32_t i = 0; i < chunks.size(); i++)
+		{
+			if (uint64_t(i) * pak.GetChunkSize() + chunks[i].Size > entry.Size || (i + 1 < chunks.size() && chunks[i].Size != pak.GetChunkSize()))
+			{
+				return std::nullopt;
+			}
+		}
+
+		const MeshFileHeader& header = mesh.Header;
+		mesh.Lods.resize(header.LodCount);
+		mesh.Meshlets.resize(header.MeshletCount);
+		if (!pak.ReadRange(entry, header.Sections[static_cast<uint32_t>(MeshSection::Lods)].Offset, std::as_writable_bytes(std::span(mesh.Lods)))
+			|| !pak.ReadRange(entry, header.Sections[static_cast<uint32_t>(MeshSection::Meshlets)].Offset, std::as_writable_bytes(std::span(mesh.Meshlets))))
+		{
+			return std::nullopt;
+		}
+		return mesh;
+	}
+
+	MeshHandle VulkanMeshLoader::AllocateHandle()
+	{
+		const MeshHandle handle = m_Handles.Allocate();
+		if (m_Meshes.size() < m_Handles.GetCapacity())
+		{
+			m_Meshes.resize(m_Handles.GetCapacity());
+		}
+		m_Meshes[handle.GetIndex()] = {};
+		return handle;
+	}
+
+	void VulkanMeshLoader::CreateMesh(MeshHandle handle, const MeshFileHeader& header, std::span<const MeshLod> lods, std::span<const Meshlet> meshlets)
+	{
+		VulkanMesh& mesh = m_Meshes[handle.GetIndex()];
+		const vk::IndexType indexType = header.IndexSize == 2 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+		mesh = {
+			.Geometry = m_GeometryPool.Allocate(header.VertexLayout, header.VertexFormat, header.VertexCount, indexType, header.IndexCount),
+			.IndexType = indexType,
+			.VertexLayout = header.VertexLayout,
+			.VertexFormat = header.VertexFormat,
+			.VertexCount = header.VertexCount,
+			.Bounds = header.Bounds,
+			.Lods = { lods.begin(), lods.end() }
+		};
+		for (const Meshlet& meshlet : meshlets)
+		{
+			mesh.MaxMeshletVertices = std::max(mesh.MaxMeshletVertices, meshlet.VertexCount);
+			mesh.MaxMeshletTriangles = std::max(mesh.MaxMeshletTriangles, meshlet.TriangleCount);
+		}
+		if (m_bMeshlets)
+		{
+			const auto createStorageBuffer = [&](MeshSection section)
+			{
+				return m_ResourcePool.CreateBuffer({
+					.Size = std::max<vk::DeviceSize>(header.Sections[static_cast<uint32_t>(section)].Size, 4),
+					.Usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst
+				});
+			};
+			mesh.MeshletBuffer = createStorageBuffer(MeshSection::Meshlets);
+			mesh.MeshletVertexBuffer = createStorageBuffer(MeshSection::MeshletVertices);
+			mesh.MeshletTriangleBuffer = createStorageBuffer(MeshSection::MeshletTriangles);
+		}
+	}
+
+	void VulkanMeshLoader::UnloadMesh(MeshHandle handle)
+	{
+		VulkanMesh& mesh = m_Meshes[handle.GetIndex()];
+		//Meshes still being read have nothing allocated yet, their read is dropped once it completes
+		if (mesh.Geometry.IsValid())
+		{
+			m_GeometryPool.Free(mesh.Geometry);
+		}
+		if (mesh.MeshletBuffer.IsValid())
+		{
+			m_ResourcePool.DestroyBuffer(mesh.MeshletBuffer);
+			m_ResourcePool.DestroyBuffer(mesh.MeshletVertexBuffer);
+			m_ResourcePool.DestroyBuffer(mesh.MeshletTriangleBuffer);
+		}
+		mesh = {};
+		const auto upload = std::ranges::find(m_Uploads, handle, &PendingUpload::Mesh);
+		if (upload != m_Uploads.end())
+		{
+			//Chunks the decompressor still has queued for it are skipped once the buffer is gone
+			if (upload->FileBuffer.IsValid())
+			{
+				m_ResourcePool.DestroyBuffer(upload->FileBuffer);
+			}
+			m_Uploads.erase(upload);
+		}
+		m_Handles.Free(handle);
+	}
+
+	void VulkanMeshLoader::BeginFrame()
+	{
+		std::vector<CompletedRead> reads;
+		{
+			std::lock_guard lock(m_CompletedReads->Mutex);
+			reads.swap(m_CompletedReads->Reads);
+		}
+		for (CompletedRead& read : reads)
+		{
+			if (!m_Handles.IsAlive(read.Mesh))
+			{
+				continue;
+			}
+			if (read.Pak)
+			{
+				CreateMesh(read.Mesh, read.Pak->Header, read.Pak->Lods, read.Pak->Meshlets);
+				PendingUpload& upload = m_Uploads.emplace_back();
+				upload.Mesh = read.Mesh;
+				upload.PakFile = std::move(read.Pak->File);
+				upload.Header = read.Pak->Header;
+				upload.FileBuffer = m_ResourcePool.CreateBuffer({
+					.Size = upload.PakFile.Entry->Size,
+					.Usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst
+						| vk::BufferUsageFlagBits::eShaderDeviceAddress
+				});
+				continue;
+			}
+			std::shared_ptr<MeshFile> file = read.Data ? MeshFile::Load(std::move(*read.Data)) : nullptr;
+			if (file)
+			{
+				CreateMesh(read.Mesh, file->GetHeader(), file->GetLods(), file->GetMeshlets());
+				m_Uploads.push_back({ .Mesh = read.Mesh, .File = std::move(file) });
+			}
+		}
+	}
+
+	bool VulkanMeshLoader::UploadSection(const vk::raii::CommandBuffer& commandBuffer, std::span<const std::byte> source,
+		const VulkanGeometryRegion& destination, vk::DeviceSize& done)
+	{
+		while (done < source.size())
+		{
+			const vk::DeviceSize size = std::min<vk::DeviceSize>(source.size() - done, m_UploadContext.GetRemaining());
+			if (size < std::min<vk::DeviceSize>(source.size() - done, k_MinUploadPiece))
+			{
+				return false;
+			}
+			const std::optional<VulkanStagingAllocation> staging = m_UploadContext.Allocate(size);
+			if (!staging)
+			{
+				return false;
+			}
+			//The section already is in GPU layout, straight from the mapping into staging
+			std::memcpy(staging->Data, source.data() + done, size);
+			commandBuffer.copyBuffer(staging->Buffer, m_ResourcePool.GetBuffer(destination.Buffer),
+				vk::BufferCopy{ staging->Offset, destination.Offset + done, size });
+			done += size;
+		}
+		return true;
+	}
+
+	bool VulkanMeshLoader::UploadDecompressed(const vk::raii::CommandBuffer& commandBuffer, PendingUpload& upload,
+		std::span<const VulkanGeometryRegion> destinations)
+	{
+		const PakArchive& pak = *upload.PakFile.Pak;
+		const std::span<const PakChunk> chunks = pak.GetChunks(*upload.PakFile.Entry);
+		if (upload.ChunksQueued < chunks.size())
+		{
+			while (upload.ChunksQueued < chunks.size())
+			{
+				std::vector<CompressedChunk> batch;
+				for (const PakChunk& chunk : chunks.subspan(upload.ChunksQueued, std::min<size_t>(chunks.size() - upload.ChunksQueued, k_DecompressBatchSize)))
+				{
+					batch.push_back({ .Codec = chunk.Codec, .Data = pak.GetChunkData(chunk), .Size = chunk.Size });
+				}
+				if (!m_GpuDecompressor->Decompress(batch, upload.FileBuffer, vk::DeviceSize(upload.ChunksQueued) * pak.GetChunkSize()))
+				{
+					return false;
+				}
+				upload.ChunksQueued += static_cast<uint32_t>(batch.size());
+			}
+			//The decompressor records ahead of the loader, so the file is only complete in the next frame's uploads
+			return false;
+		}
+
+		const MeshFileHeader& header = upload.Header;
+		const auto sectionOffset = [&header](MeshSection section) { return header.Sections[static_cast<uint32_t>(section)].Offset; };
+		const auto sectionSize = [&header](MeshSection section) { return header.Sections[static_cast<uint32_t>(section)].Size; };
+		const std::pair<vk::DeviceSize, vk::DeviceSize> sources[] = {
+			{ sectionOffset(MeshSection::Vertices), destinations[0].Size },
+			{ sectionOffset(MeshSection::Vertices) + header.AttributeStreamOffset, destinations[1].Size },
+			{ sectionOffset(MeshSection::Indices), destinations[2].Size },
+			{ sectionOffset(MeshSection::Meshlets), sectionSize(MeshSection::Meshlets) },
+			{ sectionOffset(MeshSection::MeshletVertices), sectionSize(MeshSection::MeshletVertices) },
+			{ sectionOffset(MeshSection::MeshletTriangles), sectionSize(MeshSection::MeshletTriangles) }
+		};
+		//Decompressed in this command buffer already, the decompressor's barrier makes it readable to the copies
+		const vk::Buffer fileBuffer = m_ResourcePool.GetBuffer(upload.FileBuffer);
+		for (size_t part = 0; part < destinations.size(); part++)
+		{
+			const auto [offset, size] = sources[part];
+			if (destinations[part].Buffer.IsValid() && size > 0)
+			{
+				commandBuffer.copyBuffer(fileBuffer, m_ResourcePool.GetBuffer(destinations[part].Buffer),
+					vk::BufferCopy{ offset, destinations[part].Offset, size });
+				upload.BytesDone[part] = size;
+			}
+		}
+		m_ResourcePool.DestroyBuffer(upload.FileBuffer);
+		return true;
+	}
+
+	void VulkanMeshLoader::Record(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		bool bCopied = false;
+		while (!m_Uploads.empty())
+		{
+			PendingUpload& upload = m_Uploads.front();
+			VulkanMesh& mesh = m_Meshes[upload.Mesh.GetIndex()];
+			//Resolved every frame, the pool's buffers may have grown since the upload started
+			const std::array<VulkanGeometryRegion, static_cast<size_t>(UploadPart::Count)> destinations = {
+				m_GeometryPool.GetPositionRegion(mesh.Geometry),
+				m_GeometryPool.GetAttributeRegion(mesh.Geometry),
+				m_GeometryPool.GetIndexRegion(mesh.Geometry),
+				VulkanGeometryRegion{ .Buffer = mesh.MeshletBuffer },
+				VulkanGeometryRegion{ .Buffer = mesh.MeshletVertexBuffer },
+				VulkanGeometryRegion{ .Buffer = mesh.MeshletTriangleBuffer }
+			};
+			const auto bytesDone = upload.BytesDone;
+			bool bDone = true;
+			if (upload.File)
+			{
+				const MeshFile& file = *upload.File;
+				const std::span<const std::byte> vertices = file.GetSection(MeshSection::Vertices);
+				const std::span<const std::byte> sources[] = {
+					vertices.first(destinations[0].Size),
+					vertices.subspan(file.GetHeader().AttributeStreamOffset, destinations[1].Size),
+					file.GetSection(MeshSection::Indices).first(destinations[2].Size),
+					file.GetSection(MeshSection::Meshlets),
+					file.GetSection(MeshSection::MeshletVertices),
+					file.GetSection(MeshSection::MeshletTriangles)
+				};
+				for (size_t part = 0; part < destinations.size(); part++)
+				{
+					if (destinations[part].Buffer.IsValid() && !UploadSection(commandBuffer, sources[part], destinations[part], upload.BytesDone[part]))
+					{
+						bDone = false;
+						break;
+					}
+				}
+			}
+			else
+			{
+				bDone = UploadDecompressed(commandBuffer, upload, destinations);
+			}
+			bCopied |= upload.BytesDone != bytesDone;
+			if (!bDone)
+			{
+				break;
+			}
+			mesh.bReady = true;
+			m_GeometryPool.MarkUploaded(mesh.Geometry);
+			m_Uploads.pop_front();
+		}
+
+		if (bCopied)
+		{
+			vk::MemoryBarrier2 barrier{
+				.srcStageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+				.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+				.dstStageMask = vk::PipelineStageFlagBits2::eVertexAttributeInput | vk::PipelineStageFlagBits2::eIndexInput
+					| vk::PipelineStageFlagBits2::eVertexShader,
+				.dstAccessMask = vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead | vk::AccessFlagBits2::eShaderStorageRead
+			};
+			if (m_bMeshlets)
+			{
+				barrier.dstStageMask |= vk::PipelineStageFlagBits2::eTaskShaderEXT | vk::PipelineStageFlagBits2::eMeshShaderEXT;
+			}
+			commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &barrier });
+		}
+	}
+}
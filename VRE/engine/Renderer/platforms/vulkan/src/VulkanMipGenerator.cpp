@@ -0,0 +1,225 @@
+#include <VulkanMipGenerator.h>
+#include <VulkanFormats.h>
+#include <FileReader.h>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace VRE
+{
+	constexpr uint32_t k_TileSize = 64;
+	//The last workgroup reduces the sixth level as a single 64x64 tile, which caps the source of a 12 level dispatch
+	constexpr uint32_t k_MaxSingleDispatchExtent = 4096;
+	constexpr uint32_t k_MipsPerTile = 6;
+
+	struct DownsampleConstants
+	{
+		uint32_t MipCount;
+		uint32_t WorkGroupCount;
+		uint32_t Filter;
+	};
+
+	static vk::ImageMemoryBarrier2 MipBarrier(vk::Image image, uint32_t baseMip, uint32_t mipCount, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+		vk::PipelineStageFlags2 srcStage, vk::AccessFlags2 srcAccess, vk::PipelineStageFlags2 dstStage, vk::AccessFlags2 dstAccess)
+	{
+		return {
+			.srcStageMask = srcStage,
+			.srcAccessMask = srcAccess,
+			.dstStageMask = dstStage,
+			.dstAccessMask = dstAccess,
+			.oldLayout = oldLayout,
+			.newLayout = newLayout,
+			.srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+			.dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+			.image = image,
+			.subresourceRange = { vk::ImageAspectFlagBits::eColor, baseMip, mipCount, 0, 1 }
+		};
+	}
+
+	bool VulkanMipGenerator::IsSupported(const vk::raii::PhysicalDevice& physicalDevice)
+	{
+		auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>();
+		const auto& subgroup = properties.get<vk::PhysicalDeviceSubgroupProperties>();
+		return (subgroup.supportedOperations & vk::SubgroupFeatureFlagBits::eQuad) && (subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute);
+	}
+
+	VulkanMipGenerator::VulkanMipGenerator(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+		VulkanResourcePool& resourcePool, VulkanDescriptorBinder& descriptorBinder, VulkanDeletionQueue& deletionQueue, const std::string& shaderPath)
+		: m_Device(device), m_PhysicalDevice(physicalDevice), m_ResourcePool(resourcePool), m_DescriptorBinder(descriptorBinder),
+		m_DeletionQueue(deletionQueue)
+	{
+		if (!IsSupported(physicalDevice))
+		{
+			throw std::runtime_error("Mip generation needs quad subgroup operations in compute shaders!");
+		}
+
+		std::vector<vk::DescriptorSetLayoutBinding> bindings = {
+			{ .binding = 0, .descriptorType = vk::DescriptorType::eSampledImage, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute },
+			{ .binding = 1, .descriptorType = vk::DescriptorType::eStorageImage, .descriptorCount = k_MaxMipsPerDispatch, .stageFlags = vk::ShaderStageFlagBits::eCompute },
+			{ .binding = 2, .descriptorType = vk::DescriptorType::eStorageImage, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute },
+			{ .binding = 3, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute }
+		};
+		m_SetLayout = m_DescriptorBinder.CreateSetLayout(bindings);
+
+		const std::vector<char> shaderCode = FileReader::ReadShaderFile(shaderPath);
+		vk::raii::ShaderModule shaderModule(m_Device, vk::ShaderModuleCreateInfo{
+			.codeSize = shaderCode.size(),
+			.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data())
+		});
+
+		vk::PushConstantRange pushConstantRange{ .stageFlags = vk::ShaderStageFlagBits::eCompute, .offset = 0, .size = sizeof(DownsampleConstants) };
+		vk::raii::PipelineLayout pipelineLayout(m_Device, vk::PipelineLayoutCreateInfo{
+			.setLayoutCount = 1,
+			.pSetLayouts = &*m_SetLayout,
+			.pushConstantRangeCount = 1,
+			.pPushConstantRanges = &pushConstantRange
+		});
+		vk::ComputePipelineCreateInfo pipelineInfo{
+			.flags = m_DescriptorBinder.GetPipelineCreateFlags(),
+			.stage = { .stage = vk::ShaderStageFlagBits::eCompute, .module = shaderModule, .pName = "downsampleMain" },
+			.layout = pipelineLayout
+		};
+		vk::raii::Pipeline pipeline(m_Device, nullptr, pipelineInfo);
+		m_Pipeline = m_ResourcePool.AddPipeline(std::move(pipeline), std::move(pipelineLayout), vk::PipelineBindPoint::eCompute);
+
+		m_WorkGroupCounter = m_ResourcePool.CreateBuffer({
+			.Size = sizeof(uint32_t),
+			.Usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress
+		});
+	}
+
+	VulkanMipGenerator::~VulkanMipGenerator()
+	{
+		m_ResourcePool.DestroyBuffer(m_WorkGroupCounter);
+		m_ResourcePool.DestroyPipeline(m_Pipeline);
+	}
+
+	void VulkanMipGenerator::GenerateMips(TextureHandle texture, MipFilter filter, vk::ImageLayout currentLayout)
+	{
+		m_Requests.push_back({ .Texture = texture, .Filter = filter, .CurrentLayout = currentLayout });
+	}
+
+	void VulkanMipGenerator::Record(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		for (const Request& request : m_Requests)
+		{
+			//Destroyed since it was queued
+			if (m_ResourcePool.IsValid(request.Texture))
+			{
+				RecordMips(commandBuffer, request.Texture, request.Filter, request.CurrentLayout);
+			}
+		}
+		m_Requests.clear();
+	}
+
+	uint32_t VulkanMipGenerator::GetMaxMipsPerDispatch(vk::Format format) const
+	{
+		auto properties = m_PhysicalDevice.getFormatProperties2<vk::FormatProperties2, vk::FormatProperties3>(format);
+		const vk::FormatFeatureFlags2 features = properties.get<vk::FormatProperties3>().optimalTilingFeatures;
+		if (!(features & vk::FormatFeatureFlagBits2::eStorageImage) || !(features & vk::FormatFeatureFlagBits2::eStorageWriteWithoutFormat))
+		{
+			return 0;
+		}
+		//The last workgroup reads the sixth level back through a storage image
+		return (features & vk::FormatFeatureFlagBits2::eStorageReadWithoutFormat) ? k_MaxMipsPerDispatch : k_MipsPerTile;
+	}
+
+	void VulkanMipGenerator::RecordMips(const vk::raii::CommandBuffer& commandBuffer, TextureHandle texture, MipFilter filter, vk::ImageLayout currentLayout)
+	{
+		const TextureDesc& desc = m_ResourcePool.GetDesc(texture);
+		if (desc.MipLevels < 2)
+		{
+			return;
+		}
+		const vk::ImageUsageFlags requiredUsage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage;
+		const uint32_t maxMipsPerDispatch = GetMaxMipsPerDispatch(desc.Format);
+		if ((desc.Usage & requiredUsage) != requiredUsage || maxMipsPerDispatch == 0 || desc.Extent.depth > 1 || desc.ArrayLayers > 1)
+		{
+			throw std::runtime_error("Mip generation needs a single layer 2D texture with sampled and storage usage!");
+		}
+
+		const vk::Device device = *m_Device;
+		const auto& dispatcher = *m_Device.getDispatcher();
+		const vk::Image image = m_ResourcePool.GetImage(texture);
+
+		//One view per level, the shader binds levels individually
+		std::vector<vk::ImageView> views(desc.MipLevels);
+		for (uint32_t mip = 0; mip < desc.MipLevels; mip++)
+		{
+			vk::ImageViewCreateInfo viewInfo{
+				.image = image,
+				.viewType = vk::ImageViewType::e2D,
+				.format = desc.Format,
+				.subresourceRange = { vk::ImageAspectFlagBits::eColor, mip, 1, 0, 1 }
+			};
+			views[mip] = device.createImageView(viewInfo, nullptr, dispatcher);
+			m_DeletionQueue.Enqueue(views[mip]);
+		}
+
+		if (!m_bCounterCleared)
+		{
+			commandBuffer.fillBuffer(m_ResourcePool.GetBuffer(m_WorkGroupCounter), 0, vk::WholeSize, 0);
+			m_bCounterCleared = true;
+		}
+
+		//Mip 0 may have just been rendered or copied to, the other levels are overwritten entirely
+		const std::array imageBarriers = {
+			MipBarrier(image, 0, 1, currentLayout, vk::ImageLayout::eShaderReadOnlyOptimal,
+				vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryWrite,
+				vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead),
+			MipBarrier(image, 1, desc.MipLevels - 1, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+				vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eNone,
+				vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite)
+		};
+		//Orders the counter against its clear and the previous dispatch
+		const vk::MemoryBarrier2 counterBarrier{
+			.srcStageMask = vk::PipelineStageFlagBits2::eAllTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderStorageWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{
+			.memoryBarrierCount = 1,
+			.pMemoryBarriers = &counterBarrier,
+			.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size()),
+			.pImageMemoryBarriers = imageBarriers.data()
+		});
+
+		const vk::PipelineLayout pipelineLayout = m_ResourcePool.GetPipelineLayout(m_Pipeline);
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_ResourcePool.GetPipeline(m_Pipeline));
+
+		//Sources past the single dispatch limit take a few dispatches of six levels until they fit
+		uint32_t baseMip = 0;
+		while (baseMip + 1 < desc.MipLevels)
+		{
+			const vk::Extent3D extent = GetMipExtent(desc.Extent, baseMip);
+			const bool bFitsOneTile = std::max(extent.width, extent.height) <= k_MaxSingleDispatchExtent;
+			const uint32_t mipCount = std::min(desc.MipLevels - 1 - baseMip, bFitsOneTile ? maxMipsPerDispatch : k_MipsPerTile);
+			const uint32_t lastMip = baseMip + mipCount;
+			const vk::Extent2D groupCount = { (extent.width + k_TileSize - 1) / k_TileSize, (extent.height + k_TileSize - 1) / k_TileSize };
+
+			VulkanDescriptorSet set = m_DescriptorBinder.Allocate(*m_SetLayout);
+			m_DescriptorBinder.WriteImageView(set, 0, 0, vk::DescriptorType::eSampledImage, views[baseMip], nullptr);
+			for (uint32_t i = 0; i < k_MaxMipsPerDispatch; i++)
+			{
+				//Every array element must be valid, levels past this dispatch alias the last one it writes
+				m_DescriptorBinder.WriteImageView(set, 1, i, vk::DescriptorType::eStorageImage, views[std::min(baseMip + 1 + i, lastMip)], nullptr);
+			}
+			m_DescriptorBinder.WriteImageView(set, 2, 0, vk::DescriptorType::eStorageImage, views[std::min(baseMip + k_MipsPerTile, lastMip)], nullptr);
+			m_DescriptorBinder.WriteBuffer(set, 3, vk::DescriptorType::eStorageBuffer, m_WorkGroupCounter, 0, sizeof(uint32_t));
+			m_DescriptorBinder.BindSets(commandBuffer, vk::PipelineBindPoint::eCompute, pipelineLayout, 0, { &set, 1 });
+
+			const DownsampleConstants constants{ .MipCount = mipCount, .WorkGroupCount = groupCount.width * groupCount.height, .Filter = static_cast<uint32_t>(filter) };
+			commandBuffer.pushConstants<DownsampleConstants>(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+			commandBuffer.dispatch(groupCount.width, groupCount.height, 1);
+
+			//Finished levels become readable, the last of them is the next dispatch's source
+			const vk::ImageMemoryBarrier2 doneBarrier = MipBarrier(image, baseMip + 1, mipCount, vk::ImageLayout::eGeneral, vk::ImageLayout::eShaderReadOnlyOptimal,
+				vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+				vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead);
+			commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &doneBarrier });
+
+			baseMip = lastMip;
+		}
+	}
+}
@@ -0,0 +1,169 @@
+#include <VulkanPerDrawData.h>
+#include <VulkanCommon.h>
+#include <cstring>
+#include <stdexcept>
+
+namespace VRE
+{
+	constexpr vk::DeviceSize k_PerDrawRingSize = 4 * 1024 * 1024;
+	//Large enough for any scalar/vector/matrix load through a buffer device address
+	constexpr vk::DeviceSize k_PerDrawRingAlignment = 16;
+
+	static void CombineHash(size_t& hash, uint64_t value)
+	{
+		hash ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	}
+
+	size_t VulkanPerDrawData::BindingsKeyHash::operator()(const BindingsKey& key) const
+	{
+		size_t hash = std::hash<VkDescriptorSetLayout>{}(key.Layout);
+		for (const VulkanPerDrawBinding& binding : key.Bindings)
+		{
+			CombineHash(hash, binding.Binding);
+			CombineHash(hash, static_cast<uint64_t>(binding.Type));
+			CombineHash(hash, binding.Buffer.GetValue());
+			CombineHash(hash, binding.Offset);
+			CombineHash(hash, binding.Range);
+		}
+		return hash;
+	}
+
+	VulkanPerDrawData::VulkanPerDrawData(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, VulkanResourcePool& resourcePool,
+		VulkanDescriptorBinder& descriptorBinder, bool bPushDescriptorSupported)
+		: m_Device(device), m_ResourcePool(resourcePool), m_DescriptorBinder(descriptorBinder)
+	{
+		//Push descriptors and descriptor buffers only mix with bufferlessPushDescriptors, the descriptor buffer ring is just as cheap
+		m_bUsePushDescriptors = bPushDescriptorSupported && m_DescriptorBinder.GetBackend() == VulkanDescriptorBinder::Backend::DescriptorPool;
+		m_MaxPushConstantsSize = physicalDevice.getProperties().limits.maxPushConstantsSize;
+
+		m_RingBuffers.reserve(2 * k_MaxFramesInFlight);
+		for (uint32_t i = 0; i < 2 * k_MaxFramesInFlight; i++)
+		{
+			m_RingBuffers.push_back(m_ResourcePool.CreateBuffer({
+				.Size = k_PerDrawRingSize,
+				.Usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+				.MemoryProperties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			}));
+		}
+	}
+
+	VulkanPerDrawData::~VulkanPerDrawData()
+	{
+		for (BufferHandle ringBuffer : m_RingBuffers)
+		{
+			m_ResourcePool.DestroyBuffer(ringBuffer);
+		}
+	}
+
+	vk::PushConstantRange VulkanPerDrawData::GetPushConstantRange(uint32_t payloadSize, vk::ShaderStageFlags stages) const
+	{
+		const uint32_t pushSize = FitsInPushConstants(payloadSize) ? payloadSize : static_cast<uint32_t>(sizeof(vk::DeviceAddress));
+		return { .stageFlags = stages, .offset = 0, .size = pushSize };
+	}
+
+	vk::raii::DescriptorSetLayout VulkanPerDrawData::CreatePerDrawSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings)
+	{
+		if (!m_bUsePushDescriptors)
+		{
+			return m_DescriptorBinder.CreateSetLayout(bindings);
+		}
+
+		vk::DescriptorSetLayoutCreateInfo layoutInfo{
+			.flags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR,
+			.bindingCount = static_cast<uint32_t>(bindings.size()),
+			.pBindings = bindings.data()
+		};
+		return vk::raii::DescriptorSetLayout(m_Device, layoutInfo);
+	}
+
+	void VulkanPerDrawData::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		m_RingHead = 0;
+		m_Sets.clear();
+	}
+
+	void VulkanPerDrawData::BeginRetained()
+	{
+		std::lock_guard lock(m_Mutex);
+		m_bRetained = true;
+		m_RetainedRingHead = 0;
+		m_RetainedSets.clear();
+	}
+
+	void VulkanPerDrawData::EndRetained()
+	{
+		std::lock_guard lock(m_Mutex);
+		m_bRetained = false;
+	}
+
+	void VulkanPerDrawData::PushData(const vk::raii::CommandBuffer& commandBuffer, vk::PipelineLayout pipelineLayout, vk::ShaderStageFlags stages,
+		const void* data, uint32_t size)
+	{
+		if (FitsInPushConstants(size))
+		{
+			commandBuffer.pushConstants(pipelineLayout, stages, 0, vk::ArrayProxy<const std::byte>(size, static_cast<const std::byte*>(data)));
+			return;
+		}
+
+		const vk::DeviceAddress address = AllocateRing(data, size);
+		commandBuffer.pushConstants<vk::DeviceAddress>(pipelineLayout, stages, 0, address);
+	}
+
+	void VulkanPerDrawData::PushBindings(const vk::raii::CommandBuffer& commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout,
+		vk::DescriptorSetLayout setLayout, uint32_t set, std::span<const VulkanPerDrawBinding> bindings)
+	{
+		if (!m_bUsePushDescriptors)
+		{
+			std::lock_guard lock(m_Mutex);
+			auto& sets = m_bRetained ? m_RetainedSets : m_Sets;
+			BindingsKey key{ .Layout = setLayout, .Bindings = { bindings.begin(), bindings.end() } };
+			auto setIt = sets.find(key);
+			if (setIt == sets.end())
+			{
+				const VulkanDescriptorSet descriptorSet = m_DescriptorBinder.Allocate(setLayout);
+				for (const auto& binding : bindings)
+				{
+					m_DescriptorBinder.WriteBuffer(descriptorSet, binding.Binding, binding.Type, binding.Buffer, binding.Offset, binding.Range);
+				}
+				setIt = sets.emplace(std::move(key), descriptorSet).first;
+			}
+			m_DescriptorBinder.BindSets(commandBuffer, bindPoint, pipelineLayout, set, { &setIt->second, 1 });
+			return;
+		}
+
+		//Push descriptors copy the write data at record time, these only have to outlive the call
+		std::vector<vk::DescriptorBufferInfo> bufferInfos;
+		std::vector<vk::WriteDescriptorSet> writes;
+		bufferInfos.reserve(bindings.size());
+		writes.reserve(bindings.size());
+		for (const auto& binding : bindings)
+		{
+			bufferInfos.push_back({ .buffer = m_ResourcePool.GetBuffer(binding.Buffer), .offset = binding.Offset, .range = binding.Range });
+			writes.push_back({
+				.dstBinding = binding.Binding,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = binding.Type,
+				.pBufferInfo = &bufferInfos.back()
+			});
+		}
+		commandBuffer.pushDescriptorSetKHR(bindPoint, pipelineLayout, set, writes);
+	}
+
+	vk::DeviceAddress VulkanPerDrawData::AllocateRing(const void* data, uint32_t size)
+	{
+		std::lock_guard lock(m_Mutex);
+		vk::DeviceSize& ringHead = m_bRetained ? m_RetainedRingHead : m_RingHead;
+		const vk::DeviceSize offset = (ringHead + k_PerDrawRingAlignment - 1) & ~(k_PerDrawRingAlignment - 1);
+		if (offset + size > k_PerDrawRingSize)
+		{
+			throw std::runtime_error("Per-draw ring buffer exhausted!");
+		}
+		ringHead = offset + size;
+
+		const BufferHandle ringBuffer = m_RingBuffers[(m_bRetained ? k_MaxFramesInFlight : 0) + m_FrameIndex];
+		memcpy(static_cast<std::byte*>(m_ResourcePool.GetMappedData(ringBuffer)) + offset, data, size);
+		return m_ResourcePool.GetDeviceAddress(ringBuffer) + offset;
+	}
+}
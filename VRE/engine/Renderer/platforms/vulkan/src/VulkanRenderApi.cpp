@@ -2,14 +2,22 @@
 
 #include <../include/VulkanRenderApi.h>
 #include <assert.h>
+#include <array>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
 #include <ranges>
 #include <algorithm>
+#include <cstring>
 
 #include <vulkan/vulkan.hpp>
 #include <FileReader.h>
+#include <GltfLoader.h>
+#include <VulkanDescriptorBufferBinder.h>
+#include <VulkanDescriptorPoolBinder.h>
+#include <VulkanKtx2TextureSource.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_access.hpp>
 
 #ifdef __INTELLISENSE__
 #include <vulkan/vulkan_raii.hpp>
@@ -36,7 +44,11 @@ namespace VRE
         "VK_LAYER_KHRONOS_validation"
     };
 
-	const std::string k_VulkanShaderPath = {"../VRE/slang.spv"};
+	const std::string k_VulkanShaderPath = {"../VRE/triangleShader.spv"};
+	const std::string k_DownsampleShaderPath = {"../VRE/downsampleShader.spv"};
+	const std::string k_DecompressShaderPath = {"../VRE/decompressShader.spv"};
+	const std::string k_StaticMeshShaderPath = {"../VRE/staticMeshShader.spv"};
+	const std::string k_MeshletShaderPath = {"../VRE/meshletShader.spv"};
 
     #ifdef NDEBUG
     constexpr bool s_bEnableValidationLayers = false;
@@ -44,6 +56,113 @@ namespace VRE
     constexpr bool s_bEnableValidationLayers = true;
     #endif
 
+	//Descriptor pools stay the default so both backends can be benchmarked against each other
+	#ifdef VRE_USE_DESCRIPTOR_BUFFER
+	constexpr bool s_bPreferDescriptorBuffer = true;
+	#else
+	constexpr bool s_bPreferDescriptorBuffer = false;
+	#endif
+
+	#ifdef VRE_ENABLE_MESH_SHADING
+	constexpr bool s_bPreferMeshShading = true;
+	#else
+	constexpr bool s_bPreferMeshShading = false;
+	#endif
+
+	//Output limits meshletShader.slang is compiled for, meshes cooked with bigger meshlets take the vertex path
+	constexpr uint32_t k_MaxShadedMeshletVertices = 64;
+	constexpr uint32_t k_MaxShadedMeshletTriangles = 124;
+	constexpr uint32_t k_MeshletsPerTaskGroup = 32;
+	//Per-draw data and indirect commands of a frame start out with room for this many vertex path draws
+	constexpr uint32_t k_MinMeshDrawCapacity = 256;
+	//Vertex path draws go out in indirect calls of at most this many, so big batches still split across recording threads
+	constexpr uint32_t k_MaxDrawsPerMeshItem = 256;
+	//Fewer draws than this per recording thread aren't worth the secondary command buffer
+	constexpr uint32_t k_MinDrawsPerChunk = 512;
+
+	struct FrameUniforms
+	{
+		glm::mat4 ViewProjection;
+		//Camera position with w = 1, or the view direction with w = 0 for orthographic projections
+		glm::vec4 ViewOrigin;
+	};
+
+	struct DrawConstants
+	{
+		glm::mat4 Model;
+	};
+
+	//Matches MeshDrawData in staticMeshShader.slang, one per vertex path mesh draw of the frame
+	struct MeshDrawData
+	{
+		glm::mat4 Model;
+		glm::vec4 PositionOffset;
+		glm::vec4 PositionScale;
+	};
+
+	//Matches DrawConstants in staticMeshShader.slang, one push per multi draw
+	struct MeshDrawConstants
+	{
+		VulkanVertexFetch Fetch;
+		uint32_t FirstDraw;
+	};
+
+	//Matches DrawConstants in meshletShader.slang, exactly the 128 bytes of push constants every device has
+	struct MeshletDrawConstants
+	{
+		glm::mat4 Model;
+		glm::vec3 PositionOffset;
+		uint32_t BaseVertex;
+		glm::vec3 PositionScale;
+		uint32_t Padding;
+		glm::vec4 ObjectViewOrigin;
+		VulkanVertexFetch Fetch;
+		uint32_t FirstMeshlet;
+		uint32_t MeshletCount;
+	};
+	static_assert(sizeof(MeshletDrawConstants) == 128);
+
+	// Where the view rays of a projection start: the camera position for perspective projections, and the view
+	// direction as w = 0 for orthographic ones, whose rays are parallel. Found from the rows of viewProjection, the
+	// camera is the point that maps to clip x = y = w = 0.
+	static glm::vec4 GetViewOrigin(const glm::mat4& viewProjection)
+	{
+		const glm::vec4 rowX = glm::row(viewProjection, 0);
+		const glm::vec4 rowY = glm::row(viewProjection, 1);
+		const glm::vec4 rowZ = glm::row(viewProjection, 2);
+		const glm::vec4 rowW = glm::row(viewProjection, 3);
+		if (glm::length(glm::vec3(rowW)) == 0.0f)
+		{
+			const glm::vec3 direction = glm::normalize(glm::cross(glm::vec3(rowX), glm::vec3(rowY)));
+			return glm::vec4(glm::dot(glm::vec3(rowZ), direction) < 0.0f ? -direction : direction, 0.0f);
+		}
+		const glm::mat3 rows = glm::transpose(glm::mat3(glm::vec3(rowX), glm::vec3(rowY), glm::vec3(rowW)));
+		return glm::vec4(glm::inverse(rows) * -glm::vec3(rowX.w, rowY.w, rowW.w), 1.0f);
+	}
+
+	static size_t GetMeshPipelineIndex(MeshVertexLayout layout, MeshVertexFormat format)
+	{
+		return static_cast<size_t>(layout) * 2 + static_cast<size_t>(format);
+	}
+
+	//Vertex path meshes in one batch share the geometry pool's vertex and index buffers
+	static uint32_t GetMeshBatch(const VulkanMesh& mesh)
+	{
+		return static_cast<uint32_t>(GetMeshPipelineIndex(mesh.VertexLayout, mesh.VertexFormat)) * 2 + (mesh.IndexType == vk::IndexType::eUint16 ? 0 : 1);
+	}
+
+	//Quantized positions decode as offset + value * scale, float positions pass through
+	static std::pair<glm::vec3, glm::vec3> GetPositionDecode(const VulkanMesh& mesh)
+	{
+		if (mesh.VertexFormat != MeshVertexFormat::Quantized)
+		{
+			return { glm::vec3(0.0f), glm::vec3(1.0f) };
+		}
+		const glm::vec3 min(mesh.Bounds.Min[0], mesh.Bounds.Min[1], mesh.Bounds.Min[2]);
+		const glm::vec3 max(mesh.Bounds.Max[0], mesh.Bounds.Max[1], mesh.Bounds.Max[2]);
+		return { min, max - min };
+	}
+
 	void VulkanRenderApi::Init()
 	{
 		m_API = VRE::RenderApi::API::Vulkan;
@@ -51,11 +170,18 @@ namespace VRE
         CreateSurface();
 		PickPhysicalDevice(); 
         CreateLogicalDevice();
+		CreateDescriptorBinder();
+		CreatePerDrawData();
+		CreateTextureStreamer();
+		CreateMipGenerator();
+		CreateGpuDecompressor();
+		CreateMeshLoader();
 		CreateSwapChain();
 		CreateImageViews();
+		CreateDescriptorSetLayouts();
+		CreateUniformBuffers();
 		CreateGraphicsPipeline();
 		CreateCommandPool();
-		CreateCommandBuffer();
 		CreateSyncObjects();
 	}
 
@@ -154,9 +280,12 @@ namespace VRE
 
         	auto features = device.template getFeatures2<vk::PhysicalDeviceFeatures2,
 														 vk::PhysicalDeviceVulkan11Features,
+														 vk::PhysicalDeviceVulkan12Features,
 														 vk::PhysicalDeviceVulkan13Features,
 														 vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>();
         	bool supportsRequiredFeatures = features.template get<vk::PhysicalDeviceVulkan11Features>().shaderDrawParameters &&
+										   features.template get<vk::PhysicalDeviceVulkan12Features>().bufferDeviceAddress &&
+										   features.template get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore &&
 										   features.template get<vk::PhysicalDeviceVulkan13Features>().synchronization2 &&
 										   features.template get<vk::PhysicalDeviceVulkan13Features>().dynamicRendering &&
 										   features.template get<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>().extendedDynamicState;
@@ -194,17 +323,83 @@ namespace VRE
             throw std::runtime_error("Could not find a queue for graphics and present -> terminating");
         }
 
+        m_OptionalDeviceExtensions.push_back(vk::KHRPushDescriptorExtensionName);
+        m_OptionalDeviceExtensions.push_back(vk::EXTMemoryBudgetExtensionName);
+        if (s_bPreferMeshShading)
+        {
+            m_OptionalDeviceExtensions.push_back(vk::EXTMeshShaderExtensionName);
+        }
+        if (s_bPreferDescriptorBuffer)
+        {
+            m_OptionalDeviceExtensions.push_back(vk::EXTDescriptorBufferExtensionName);
+        }
+
+        // enable every optional extension the device supports on top of the required ones
+        m_EnabledDeviceExtensions = m_RequiredDeviceExtensions;
+        auto availableDeviceExtensions = m_PhysicalDevice.enumerateDeviceExtensionProperties();
+        for (auto const& optionalExtension : m_OptionalDeviceExtensions)
+        {
+            if (std::ranges::any_of(availableDeviceExtensions,
+                                    [optionalExtension](auto const& extensionProperty)
+                                    { return strcmp(extensionProperty.extensionName, optionalExtension) == 0; }))
+            {
+                m_EnabledDeviceExtensions.push_back(optionalExtension);
+            }
+        }
+
+        // the extension alone doesn't promise task shaders, both stages are needed for meshlet culling
+        if (IsDeviceExtensionEnabled(vk::EXTMeshShaderExtensionName))
+        {
+            auto supportedFeatures = m_PhysicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+            const auto& meshShaderFeatures = supportedFeatures.get<vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+            m_bMeshShadingSupported = meshShaderFeatures.taskShader && meshShaderFeatures.meshShader;
+            if (!m_bMeshShadingSupported)
+            {
+                std::erase_if(m_EnabledDeviceExtensions, [](const char* extension) { return strcmp(extension, vk::EXTMeshShaderExtensionName) == 0; });
+            }
+        }
+        m_bMeshShadingEnabled = m_bMeshShadingSupported;
+
+        // the extension can be exposed without the feature, the descriptor pool binder takes over then
+        if (IsDeviceExtensionEnabled(vk::EXTDescriptorBufferExtensionName))
+        {
+            auto supportedFeatures = m_PhysicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorBufferFeaturesEXT>();
+            if (!supportedFeatures.get<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>().descriptorBuffer)
+            {
+                std::erase_if(m_EnabledDeviceExtensions, [](const char* extension) { return strcmp(extension, vk::EXTDescriptorBufferExtensionName) == 0; });
+            }
+        }
+
+        // without multi draw indirect every indirect call draws one mesh, the vertex path then makes one call per mesh
+        const bool bMultiDrawIndirect = m_PhysicalDevice.getFeatures().multiDrawIndirect;
+        m_MaxDrawIndirectCount = bMultiDrawIndirect ? m_PhysicalDevice.getProperties().limits.maxDrawIndirectCount : 1;
+
         // query for Vulkan 1.3 features
         vk::StructureChain<vk::PhysicalDeviceFeatures2,
                            vk::PhysicalDeviceVulkan11Features,
+                           vk::PhysicalDeviceVulkan12Features,
                            vk::PhysicalDeviceVulkan13Features,
-                           vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>
+                           vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT,
+                           vk::PhysicalDeviceDescriptorBufferFeaturesEXT,
+                           vk::PhysicalDeviceMeshShaderFeaturesEXT>
           featureChain = {
             {},                                                     // vk::PhysicalDeviceFeatures2
             {.shaderDrawParameters = true },                        // vk::PhysicalDeviceVulkan11Features
+            {.timelineSemaphore = true, .bufferDeviceAddress = true }, // vk::PhysicalDeviceVulkan12Features
             {.synchronization2 = true, .dynamicRendering = true },  // vk::PhysicalDeviceVulkan13Features
-            {.extendedDynamicState = true }                         // vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT
+            {.extendedDynamicState = true },                        // vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT
+            {.descriptorBuffer = true },                            // vk::PhysicalDeviceDescriptorBufferFeaturesEXT
+            {.taskShader = true, .meshShader = true }               // vk::PhysicalDeviceMeshShaderFeaturesEXT
         };
+        featureChain.get<vk::PhysicalDeviceFeatures2>().features.multiDrawIndirect = bMultiDrawIndirect;
+        if (!IsDeviceExtensionEnabled(vk::EXTDescriptorBufferExtensionName))
+        {
+            featureChain.unlink<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>();
+        }
+        if (!m_bMeshShadingSupported)
+        {
+            featureChain.unlink<vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+        }
 
         // create a Device
         float                     queuePriority = 0.0f;
@@ -212,11 +407,421 @@ namespace VRE
         vk::DeviceCreateInfo      deviceCreateInfo{ .pNext = &featureChain.get<vk::PhysicalDeviceFeatures2>(),
                                                     .queueCreateInfoCount = 1,
                                                     .pQueueCreateInfos = &deviceQueueCreateInfo,
-                                                    .enabledExtensionCount = static_cast<uint32_t>(m_RequiredDeviceExtensions.size()),
-                                                    .ppEnabledExtensionNames = m_RequiredDeviceExtensions.data() };
+                                                    .enabledExtensionCount = static_cast<uint32_t>(m_EnabledDeviceExtensions.size()),
+                                                    .ppEnabledExtensionNames = m_EnabledDeviceExtensions.data() };
 
         m_Device = vk::raii::Device( m_PhysicalDevice, deviceCreateInfo );
         m_Queue = vk::raii::Queue( m_Device, m_QueueIndex, 0 );
+        m_DeletionQueue = std::make_unique<VulkanDeletionQueue>(m_Device);
+        m_MemoryBudget = std::make_unique<VulkanMemoryBudget>(m_PhysicalDevice, IsDeviceExtensionEnabled(vk::EXTMemoryBudgetExtensionName));
+        m_ResidencyManager = std::make_unique<VulkanResidencyManager>(*m_MemoryBudget);
+        m_ResourcePool = std::make_unique<VulkanResourcePool>(m_Device, m_PhysicalDevice, *m_DeletionQueue, *m_MemoryBudget, *m_ResidencyManager);
+        m_TransientPool = std::make_unique<VulkanTransientPool>(m_Device, m_PhysicalDevice, *m_DeletionQueue, *m_MemoryBudget, *m_ResidencyManager);
+        m_BarrierBatcher = std::make_unique<VulkanBarrierBatcher>(m_Device);
+        m_RenderGraph = std::make_unique<VulkanRenderGraph>(*m_TransientPool, *m_BarrierBatcher);
+	}
+
+	bool VulkanRenderApi::IsDeviceExtensionEnabled(const char* extensionName) const
+	{
+		return std::ranges::any_of(m_EnabledDeviceExtensions,
+			[extensionName](const char* enabledExtension) { return strcmp(enabledExtension, extensionName) == 0; });
+	}
+
+	void VulkanRenderApi::CreateDescriptorBinder()
+	{
+		if (s_bPreferDescriptorBuffer && IsDeviceExtensionEnabled(vk::EXTDescriptorBufferExtensionName))
+		{
+			m_DescriptorBinder = std::make_unique<VulkanDescriptorBufferBinder>(m_Device, m_PhysicalDevice, *m_ResourcePool);
+		}
+		else
+		{
+			m_DescriptorBinder = std::make_unique<VulkanDescriptorPoolBinder>(m_Device, *m_ResourcePool);
+		}
+	}
+
+	void VulkanRenderApi::CreatePerDrawData()
+	{
+		m_PerDrawData = std::make_unique<VulkanPerDrawData>(m_Device, m_PhysicalDevice, *m_ResourcePool, *m_DescriptorBinder,
+			IsDeviceExtensionEnabled(vk::KHRPushDescriptorExtensionName));
+	}
+
+	void VulkanRenderApi::CreateTextureStreamer()
+	{
+		m_ThreadPool = std::make_unique<ThreadPool>();
+		m_UploadContext = std::make_unique<VulkanUploadContext>(*m_ResourcePool);
+		m_TextureStreamer = std::make_unique<VulkanTextureStreamer>(*m_ResourcePool, *m_ResidencyManager, *m_UploadContext, *m_ThreadPool);
+	}
+
+	void VulkanRenderApi::CreateMipGenerator()
+	{
+		if (VulkanMipGenerator::IsSupported(m_PhysicalDevice))
+		{
+			m_MipGenerator = std::make_unique<VulkanMipGenerator>(m_Device, m_PhysicalDevice, *m_ResourcePool, *m_DescriptorBinder, *m_DeletionQueue,
+				k_DownsampleShaderPath);
+		}
+	}
+
+	void VulkanRenderApi::CreateGpuDecompressor()
+	{
+		m_GpuDecompressor = std::make_unique<VulkanGpuDecompressor>(m_Device, m_PhysicalDevice, *m_ResourcePool, *m_UploadContext, *m_DescriptorBinder,
+			k_DecompressShaderPath);
+	}
+
+	void VulkanRenderApi::CreateMeshLoader()
+	{
+		m_GeometryPool = std::make_unique<VulkanGeometryPool>(*m_ResourcePool, *m_DeletionQueue);
+		m_MeshLoader = std::make_unique<VulkanMeshLoader>(*m_ResourcePool, *m_GeometryPool, *m_UploadContext, *m_ThreadPool, m_GpuDecompressor.get(),
+			m_bMeshShadingSupported);
+	}
+
+	MeshHandle VulkanRenderApi::LoadMesh(const std::string& path)
+	{
+		return m_MeshLoader->LoadMesh(path);
+	}
+
+	std::vector<VulkanMeshInstance> VulkanRenderApi::LoadGltfScene(const std::string& path)
+	{
+		//Images stay with the texture streaming path, only geometry is imported here
+		const GltfScene scene = LoadGltf(path, { .Cook = MeshCookSettings{}, .bLoadImages = false }, m_ThreadPool.get());
+
+		//Meshes used by several nodes upload once
+		std::vector<std::vector<MeshHandle>> meshes(scene.Meshes.size());
+		for (size_t i = 0; i < scene.Meshes.size(); i++)
+		{
+			for (const GltfPrimitive& primitive : scene.Meshes[i].Primitives)
+			{
+				if (primitive.Cooked)
+				{
+					meshes[i].push_back(m_MeshLoader->LoadMesh(primitive.Cooked));
+				}
+			}
+		}
+
+		std::vector<VulkanMeshInstance> instances;
+		for (const GltfNode& node : scene.Nodes)
+		{
+			if (node.bInScene && node.Mesh >= 0)
+			{
+				for (const MeshHandle mesh : meshes[node.Mesh])
+				{
+					instances.push_back({ .Mesh = mesh, .Transform = node.WorldTransform });
+				}
+			}
+		}
+		return instances;
+	}
+
+	void VulkanRenderApi::LoadScene(const std::string& path)
+	{
+		m_SceneInstances = LoadGltfScene(path);
+	}
+
+	void VulkanRenderApi::DrawMesh(MeshHandle mesh, const glm::mat4& transform)
+	{
+		m_MeshDraws.push_back({ .Mesh = mesh, .Transform = transform });
+	}
+
+	void VulkanRenderApi::PrepareMeshDraws()
+	{
+		for (const VulkanMeshInstance& draw : m_MeshDraws)
+		{
+			if (!m_MeshLoader->IsValid(draw.Mesh) || !m_MeshLoader->IsReady(draw.Mesh))
+			{
+				continue;
+			}
+			const VulkanMesh& mesh = m_MeshLoader->GetMesh(draw.Mesh);
+			if (mesh.Lods.empty())
+			{
+				continue;
+			}
+			if (m_bMeshShadingEnabled && mesh.MaxMeshletVertices <= k_MaxShadedMeshletVertices && mesh.MaxMeshletTriangles <= k_MaxShadedMeshletTriangles)
+			{
+				if (mesh.Lods[0].MeshletCount > 0)
+				{
+					m_MeshDrawItems.push_back({ .Mesh = &mesh, .Transform = &draw.Transform, .bMeshlets = true });
+				}
+				continue;
+			}
+			m_MeshBatchDraws.push_back({ .Batch = GetMeshBatch(mesh), .Mesh = &mesh, .Transform = &draw.Transform });
+		}
+		m_Stats.MeshDraws = static_cast<uint32_t>(m_MeshDrawItems.size() + m_MeshBatchDraws.size());
+		if (m_MeshBatchDraws.empty())
+		{
+			return;
+		}
+
+		//Every mesh lives in the geometry pool, so draws sharing its buffers only differ in their indirect command
+		std::stable_sort(m_MeshBatchDraws.begin(), m_MeshBatchDraws.end(), [](const MeshBatchDraw& a, const MeshBatchDraw& b) { return a.Batch < b.Batch; });
+		ReserveMeshDrawBuffers(static_cast<uint32_t>(m_MeshBatchDraws.size()));
+		//Without multiDrawIndirect the limit is 1 and every draw is an item of its own
+		const uint32_t maxItemDraws = std::min(m_MaxDrawIndirectCount, k_MaxDrawsPerMeshItem);
+		for (uint32_t begin = 0; begin < m_MeshBatchDraws.size();)
+		{
+			uint32_t end = begin + 1;
+			while (end < m_MeshBatchDraws.size() && m_MeshBatchDraws[end].Batch == m_MeshBatchDraws[begin].Batch)
+			{
+				end++;
+			}
+			for (uint32_t first = begin; first < end; first += maxItemDraws)
+			{
+				m_MeshDrawItems.push_back({ .Mesh = m_MeshBatchDraws[begin].Mesh, .Batch = m_MeshBatchDraws[begin].Batch, .First = first,
+					.Count = std::min(end - first, maxItemDraws) });
+			}
+			begin = end;
+		}
+	}
+
+	void VulkanRenderApi::ReservePerDrawSets()
+	{
+		if (m_PerDrawData->UsesPushDescriptors())
+		{
+			return;
+		}
+		//Upper bound: every queued draw a mesh of its own, meshlet sets being the bigger ones. Vertex path draws share
+		//one set per batch, so they never need more
+		const vk::DescriptorSetLayout setLayout = m_bMeshShadingSupported ? *m_MeshletSetLayout : *m_MeshDrawSetLayout;
+		if (m_DescriptorBinder->Reserve(setLayout, static_cast<uint32_t>(m_MeshDraws.size())))
+		{
+			//Their retained sets went away with the old storage
+			for (CachedMainPass& cachedPass : m_CachedMainPasses)
+			{
+				cachedPass.bValid = false;
+			}
+		}
+	}
+
+	uint32_t VulkanRenderApi::RecordMeshDrawItems(const vk::raii::CommandBuffer& commandBuffer, const VulkanDescriptorSet& frameSet, size_t begin, size_t end)
+	{
+		uint32_t drawCalls = 0;
+		PipelineHandle boundPipeline;
+		uint32_t boundBatch = UINT32_MAX;
+		const auto bindPipeline = [&](PipelineHandle pipeline)
+		{
+			if (pipeline != boundPipeline)
+			{
+				//The push constant ranges differ from the triangle's layout, so set 0 has to be bound again
+				commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_ResourcePool->GetPipeline(pipeline));
+				m_DescriptorBinder->BindSets(commandBuffer, vk::PipelineBindPoint::eGraphics, m_ResourcePool->GetPipelineLayout(pipeline), 0,
+					{ &frameSet, 1 });
+				boundPipeline = pipeline;
+				boundBatch = UINT32_MAX;
+			}
+		};
+
+		for (size_t i = begin; i < end; i++)
+		{
+			const MeshDrawItem& item = m_MeshDrawItems[i];
+			const VulkanMesh& mesh = *item.Mesh;
+			if (item.bMeshlets)
+			{
+				bindPipeline(m_MeshletPipeline);
+				RecordMeshletDraw(commandBuffer, mesh, *item.Transform);
+				drawCalls++;
+				continue;
+			}
+
+			//Written by whichever thread records the item, so filling the draw buffers is spread out as well
+			const MeshDrawBuffers& drawBuffers = m_MeshDrawBuffers[m_CurrentFrame];
+			auto* drawData = static_cast<MeshDrawData*>(m_ResourcePool->GetMappedData(drawBuffers.DrawData));
+			auto* commands = static_cast<vk::DrawIndexedIndirectCommand*>(m_ResourcePool->GetMappedData(drawBuffers.Commands));
+			for (uint32_t draw = item.First; draw < item.First + item.Count; draw++)
+			{
+				const VulkanMesh& drawMesh = *m_MeshBatchDraws[draw].Mesh;
+				const VulkanGeometry& geometry = m_GeometryPool->Get(drawMesh.Geometry);
+				const auto [positionOffset, positionScale] = GetPositionDecode(drawMesh);
+				drawData[draw] = { .Model = *m_MeshBatchDraws[draw].Transform, .PositionOffset = glm::vec4(positionOffset, 0.0f),
+					.PositionScale = glm::vec4(positionScale, 0.0f) };
+				commands[draw] = { .indexCount = drawMesh.Lods[0].IndexCount, .instanceCount = 1,
+					.firstIndex = geometry.FirstIndex + drawMesh.Lods[0].FirstIndex, .vertexOffset = static_cast<int32_t>(geometry.FirstVertex),
+					.firstInstance = 0 };
+			}
+
+			const PipelineHandle pipeline = m_bVertexPullingEnabled ? m_PulledMeshPipeline
+				: m_MeshPipelines[GetMeshPipelineIndex(mesh.VertexLayout, mesh.VertexFormat)];
+			bindPipeline(pipeline);
+			const vk::PipelineLayout pipelineLayout = m_ResourcePool->GetPipelineLayout(pipeline);
+			const BufferHandle vertexBuffer = m_GeometryPool->GetVertexBuffer(mesh.VertexLayout, mesh.VertexFormat);
+			const vk::DeviceSize attributeOffset = m_GeometryPool->GetAttributeOffset(mesh.VertexLayout, mesh.VertexFormat);
+			if (item.Batch != boundBatch)
+			{
+				const VulkanPerDrawBinding bindings[] = {
+					{ .Binding = 0, .Type = vk::DescriptorType::eStorageBuffer, .Buffer = vertexBuffer },
+					{ .Binding = 1, .Type = vk::DescriptorType::eStorageBuffer, .Buffer = drawBuffers.DrawData }
+				};
+				m_PerDrawData->PushBindings(commandBuffer, vk::PipelineBindPoint::eGraphics, pipelineLayout, *m_MeshDrawSetLayout, 1, bindings);
+				if (!m_bVertexPullingEnabled)
+				{
+					//The streamed layout reads its attributes through binding 1 from the same buffer
+					const vk::Buffer buffer = m_ResourcePool->GetBuffer(vertexBuffer);
+					const std::array<vk::Buffer, 2> buffers = { buffer, buffer };
+					const std::array<vk::DeviceSize, 2> offsets = { 0, attributeOffset };
+					const uint32_t bindingCount = mesh.VertexLayout == MeshVertexLayout::Streamed ? 2 : 1;
+					commandBuffer.bindVertexBuffers(0, vk::ArrayProxy<const vk::Buffer>(bindingCount, buffers.data()),
+						vk::ArrayProxy<const vk::DeviceSize>(bindingCount, offsets.data()));
+				}
+				commandBuffer.bindIndexBuffer(m_ResourcePool->GetBuffer(m_GeometryPool->GetIndexBuffer(mesh.IndexType)), 0, mesh.IndexType);
+				boundBatch = item.Batch;
+			}
+
+			const MeshDrawConstants drawConstants{
+				.Fetch = GetMeshVertexFetch(mesh.VertexLayout, mesh.VertexFormat, attributeOffset),
+				.FirstDraw = item.First
+			};
+			m_PerDrawData->PushData(commandBuffer, pipelineLayout, vk::ShaderStageFlagBits::eVertex, &drawConstants, sizeof(drawConstants));
+			commandBuffer.drawIndexedIndirect(m_ResourcePool->GetBuffer(drawBuffers.Commands), item.First * sizeof(vk::DrawIndexedIndirectCommand),
+				item.Count, sizeof(vk::DrawIndexedIndirectCommand));
+			drawCalls++;
+		}
+		return drawCalls;
+	}
+
+	uint32_t VulkanRenderApi::GetMeshDrawChunks(std::vector<size_t>& bounds) const
+	{
+		//Meshlet items are one draw each, vertex path items write the per-draw data of all of theirs
+		size_t totalDraws = 0;
+		for (const MeshDrawItem& item : m_MeshDrawItems)
+		{
+			totalDraws += item.bMeshlets ? 1 : item.Count;
+		}
+		const uint32_t chunkCount = static_cast<uint32_t>(std::min<size_t>(m_CommandRecorder->GetWorkerCount(), totalDraws / k_MinDrawsPerChunk));
+		if (chunkCount < 2)
+		{
+			return 0;
+		}
+
+		bounds.assign(1, 0);
+		size_t draws = 0;
+		for (size_t i = 0; i < m_MeshDrawItems.size() && bounds.size() < chunkCount; i++)
+		{
+			draws += m_MeshDrawItems[i].bMeshlets ? 1 : m_MeshDrawItems[i].Count;
+			if (i + 1 < m_MeshDrawItems.size() && draws * chunkCount >= totalDraws * bounds.size())
+			{
+				bounds.push_back(i + 1);
+			}
+		}
+		bounds.push_back(m_MeshDrawItems.size());
+		return static_cast<uint32_t>(bounds.size() - 1);
+	}
+
+	void VulkanRenderApi::ReserveMeshDrawBuffers(uint32_t drawCount)
+	{
+		MeshDrawBuffers& drawBuffers = m_MeshDrawBuffers[m_CurrentFrame];
+		if (drawBuffers.Capacity >= drawCount)
+		{
+			return;
+		}
+		if (drawBuffers.Capacity > 0)
+		{
+			m_ResourcePool->DestroyBuffer(drawBuffers.DrawData);
+			m_ResourcePool->DestroyBuffer(drawBuffers.Commands);
+		}
+		drawBuffers.Capacity = std::max({ drawCount, drawBuffers.Capacity * 2, k_MinMeshDrawCapacity });
+		const vk::MemoryPropertyFlags hostVisible = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+		drawBuffers.DrawData = m_ResourcePool->CreateBuffer({
+			.Size = drawBuffers.Capacity * sizeof(MeshDrawData),
+			.Usage = vk::BufferUsageFlagBits::eStorageBuffer,
+			.MemoryProperties = hostVisible
+		});
+		drawBuffers.Commands = m_ResourcePool->CreateBuffer({
+			.Size = drawBuffers.Capacity * sizeof(vk::DrawIndexedIndirectCommand),
+			.Usage = vk::BufferUsageFlagBits::eIndirectBuffer,
+			.MemoryProperties = hostVisible
+		});
+	}
+
+	void VulkanRenderApi::RecordMeshletDraw(const vk::raii::CommandBuffer& commandBuffer, const VulkanMesh& mesh, const glm::mat4& transform)
+	{
+		const MeshLod& lod = mesh.Lods[0];
+		if (lod.MeshletCount == 0)
+		{
+			return;
+		}
+		const vk::PipelineLayout pipelineLayout = m_ResourcePool->GetPipelineLayout(m_MeshletPipeline);
+		const VulkanPerDrawBinding bindings[] = {
+			{ .Binding = 0, .Type = vk::DescriptorType::eStorageBuffer, .Buffer = m_GeometryPool->GetVertexBuffer(mesh.VertexLayout, mesh.VertexFormat) },
+			{ .Binding = 1, .Type = vk::DescriptorType::eStorageBuffer, .Buffer = mesh.MeshletBuffer },
+			{ .Binding = 2, .Type = vk::DescriptorType::eStorageBuffer, .Buffer = mesh.MeshletVertexBuffer },
+			{ .Binding = 3, .Type = vk::DescriptorType::eStorageBuffer, .Buffer = mesh.MeshletTriangleBuffer }
+		};
+		m_PerDrawData->PushBindings(commandBuffer, vk::PipelineBindPoint::eGraphics, pipelineLayout, *m_MeshletSetLayout, 1, bindings);
+
+		//Culling runs against the cooked meshlet bounds and cones, so the viewer moves into object space instead
+		glm::vec4 objectViewOrigin = glm::inverse(transform) * GetViewOrigin(m_ViewProjection);
+		if (objectViewOrigin.w == 0.0f)
+		{
+			objectViewOrigin = glm::vec4(glm::normalize(glm::vec3(objectViewOrigin)), 0.0f);
+		}
+		const auto [positionOffset, positionScale] = GetPositionDecode(mesh);
+		const MeshletDrawConstants drawConstants{
+			.Model = transform,
+			.PositionOffset = positionOffset,
+			.BaseVertex = m_GeometryPool->Get(mesh.Geometry).FirstVertex,
+			.PositionScale = positionScale,
+			.Padding = 0,
+			.ObjectViewOrigin = objectViewOrigin,
+			.Fetch = GetMeshVertexFetch(mesh.VertexLayout, mesh.VertexFormat, m_GeometryPool->GetAttributeOffset(mesh.VertexLayout, mesh.VertexFormat)),
+			.FirstMeshlet = lod.FirstMeshlet,
+			.MeshletCount = lod.MeshletCount
+		};
+		m_PerDrawData->PushData(commandBuffer, pipelineLayout, vk::ShaderStageFlagBits::eTaskEXT | vk::ShaderStageFlagBits::eMeshEXT,
+			&drawConstants, sizeof(drawConstants));
+		commandBuffer.drawMeshTasksEXT((lod.MeshletCount + k_MeshletsPerTaskGroup - 1) / k_MeshletsPerTaskGroup, 1, 1);
+	}
+
+	void VulkanRenderApi::GenerateMips(TextureHandle texture, MipFilter filter)
+	{
+		if (!m_MipGenerator)
+		{
+			throw std::runtime_error("GPU mip generation is not supported on this device!");
+		}
+		m_MipGenerator->GenerateMips(texture, filter);
+	}
+
+	TextureHandle VulkanRenderApi::LoadKtx2Texture(const std::string& path)
+	{
+		return m_TextureStreamer->LoadTexture(std::make_shared<VulkanKtx2TextureSource>(path, m_PhysicalDevice));
+	}
+
+	VulkanVirtualTexture& VulkanRenderApi::CreateVirtualTexture(const VirtualTextureDesc& desc, std::shared_ptr<VulkanVirtualTextureSource> source)
+	{
+		m_VirtualTextures.push_back(std::make_unique<VulkanVirtualTexture>(*m_ResourcePool, *m_UploadContext, *m_ThreadPool, desc, std::move(source)));
+		return *m_VirtualTextures.back();
+	}
+
+	void VulkanRenderApi::CreateDescriptorSetLayouts()
+	{
+		vk::ShaderStageFlags frameStages = vk::ShaderStageFlagBits::eVertex;
+		if (m_bMeshShadingSupported)
+		{
+			frameStages |= vk::ShaderStageFlagBits::eTaskEXT | vk::ShaderStageFlagBits::eMeshEXT;
+		}
+		std::vector<vk::DescriptorSetLayoutBinding> frameBindings = {
+			{ .binding = 0, .descriptorType = vk::DescriptorType::eUniformBuffer, .descriptorCount = 1, .stageFlags = frameStages }
+		};
+		m_FrameSetLayout = m_DescriptorBinder->CreateSetLayout(frameBindings);
+	}
+
+	void VulkanRenderApi::CreateUniformBuffers()
+	{
+		for (BufferHandle uniformBuffer : m_UniformBuffers)
+		{
+			m_ResourcePool->DestroyBuffer(uniformBuffer);
+		}
+		m_UniformBuffers.clear();
+		for (uint32_t i = 0; i < k_MaxFramesInFlight; i++)
+		{
+			m_UniformBuffers.push_back(m_ResourcePool->CreateBuffer({
+				.Size = sizeof(FrameUniforms),
+				.Usage = vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+				.MemoryProperties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			}));
+		}
+	}
+
+	void VulkanRenderApi::UpdateUniformBuffer(uint32_t currentFrame)
+	{
+		FrameUniforms uniforms{ .ViewProjection = m_ViewProjection, .ViewOrigin = GetViewOrigin(m_ViewProjection) };
+		memcpy(m_ResourcePool->GetMappedData(m_UniformBuffers[currentFrame]), &uniforms, sizeof(uniforms));
 	}
 
 	void VulkanRenderApi::CreateSwapChain()
@@ -246,184 +851,452 @@ namespace VRE
 		CreateShaderModule();
 		if (m_ShaderModule != nullptr)
 		{
-			vk::PipelineShaderStageCreateInfo vertShaderStageInfo{ .stage = vk::ShaderStageFlagBits::eVertex, .module = m_ShaderModule, .pName = "vertMain" };
-
-			vk::PipelineShaderStageCreateInfo fragShaderStageInfo{ .stage = vk::ShaderStageFlagBits::eFragment, .module = m_ShaderModule, .pName = "fragMain" };
-
-			vk::PipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
 			//TO-DO: move input assembly to a member variable and config primitive topology
 			vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+			const vk::PipelineShaderStageCreateInfo shaderStages[] = {
+				{ .stage = vk::ShaderStageFlagBits::eVertex, .module = m_ShaderModule, .pName = "vertMain" },
+				{ .stage = vk::ShaderStageFlagBits::eFragment, .module = m_ShaderModule, .pName = "fragMain" }
+			};
+			m_GraphicsPipeline = BuildGraphicsPipeline(shaderStages, &vertexInputInfo, nullptr, vk::ShaderStageFlagBits::eVertex, sizeof(DrawConstants));
+		}
+		CreateMeshPipelines();
+	}
 
-			vk::PipelineInputAssemblyStateCreateInfo inputAssembly = { .topology = vk::PrimitiveTopology::eTriangleList };
-			vk::PipelineViewportStateCreateInfo viewportState{ .viewportCount = 1, .scissorCount = 1 };
-			vk::Rect2D rect = { vk::Offset2D{0,0}, m_SwapChainExtent };
+	void VulkanRenderApi::CreateMeshPipelines()
+	{
+		const std::vector<char> shaderCode = FileReader::ReadShaderFile(k_StaticMeshShaderPath);
+		vk::raii::ShaderModule shaderModule(m_Device, vk::ShaderModuleCreateInfo{
+			.codeSize = shaderCode.size(),
+			.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data())
+		});
+		//The geometry pool's vertex buffer for vertex pulling, and the frame's per-draw data
+		m_MeshDrawSetLayout = m_PerDrawData->CreatePerDrawSetLayout({
+			{ .binding = 0, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eVertex },
+			{ .binding = 1, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eVertex }
+		});
+
+		for (MeshVertexLayout layout : { MeshVertexLayout::Interleaved, MeshVertexLayout::Streamed })
+		{
+			for (MeshVertexFormat format : { MeshVertexFormat::Float, MeshVertexFormat::Quantized })
+			{
+				const VulkanVertexInputState vertexInput = GetMeshVertexInputState(layout, format);
+				const vk::PipelineVertexInputStateCreateInfo vertexInputInfo = vertexInput.GetCreateInfo();
+				const vk::PipelineShaderStageCreateInfo shaderStages[] = {
+					{ .stage = vk::ShaderStageFlagBits::eVertex, .module = shaderModule,
+						.pName = format == MeshVertexFormat::Quantized ? "vertQuantized" : "vertFloat" },
+					{ .stage = vk::ShaderStageFlagBits::eFragment, .module = shaderModule, .pName = "fragMain" }
+				};
+				m_MeshPipelines[GetMeshPipelineIndex(layout, format)] = BuildGraphicsPipeline(shaderStages, &vertexInputInfo, *m_MeshDrawSetLayout,
+					vk::ShaderStageFlagBits::eVertex, sizeof(MeshDrawConstants));
+			}
+		}
 
-			vk::PipelineRasterizationStateCreateInfo rasterizer{
-				.depthClampEnable = vk::False, .rasterizerDiscardEnable = vk::False,
-				.polygonMode = vk::PolygonMode::eFill, .cullMode = vk::CullModeFlagBits::eBack,
-				.frontFace = vk::FrontFace::eClockwise, .depthBiasEnable = vk::False,
-				.depthBiasSlopeFactor = 1.0f, .lineWidth = 1.0f
-			};
+		const vk::PipelineVertexInputStateCreateInfo noVertexInput;
+		const vk::PipelineShaderStageCreateInfo pulledShaderStages[] = {
+			{ .stage = vk::ShaderStageFlagBits::eVertex, .module = shaderModule, .pName = "vertPulled" },
+			{ .stage = vk::ShaderStageFlagBits::eFragment, .module = shaderModule, .pName = "fragMain" }
+		};
+		m_PulledMeshPipeline = BuildGraphicsPipeline(pulledShaderStages, &noVertexInput, *m_MeshDrawSetLayout, vk::ShaderStageFlagBits::eVertex,
+			sizeof(MeshDrawConstants));
 
-			vk::PipelineMultisampleStateCreateInfo multisampling{.rasterizationSamples = vk::SampleCountFlagBits::e1, .sampleShadingEnable = vk::False};
+		if (!m_bMeshShadingSupported)
+		{
+			return;
+		}
+		const vk::ShaderStageFlags meshletStages = vk::ShaderStageFlagBits::eTaskEXT | vk::ShaderStageFlagBits::eMeshEXT;
+		m_MeshletSetLayout = m_PerDrawData->CreatePerDrawSetLayout({
+			{ .binding = 0, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = meshletStages },
+			{ .binding = 1, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = meshletStages },
+			{ .binding = 2, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = meshletStages },
+			{ .binding = 3, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = meshletStages }
+		});
+
+		const std::vector<char> meshletShaderCode = FileReader::ReadShaderFile(k_MeshletShaderPath);
+		vk::raii::ShaderModule meshletShaderModule(m_Device, vk::ShaderModuleCreateInfo{
+			.codeSize = meshletShaderCode.size(),
+			.pCode = reinterpret_cast<const uint32_t*>(meshletShaderCode.data())
+		});
+		const vk::PipelineShaderStageCreateInfo meshletShaderStages[] = {
+			{ .stage = vk::ShaderStageFlagBits::eTaskEXT, .module = meshletShaderModule, .pName = "taskMain" },
+			{ .stage = vk::ShaderStageFlagBits::eMeshEXT, .module = meshletShaderModule, .pName = "meshMain" },
+			{ .stage = vk::ShaderStageFlagBits::eFragment, .module = meshletShaderModule, .pName = "fragMain" }
+		};
+		m_MeshletPipeline = BuildGraphicsPipeline(meshletShaderStages, nullptr, *m_MeshletSetLayout, meshletStages, sizeof(MeshletDrawConstants));
+	}
 
-			vk::PipelineColorBlendAttachmentState colorBlendAttachment{ .blendEnable = vk::False,
-			.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
-			};
+	PipelineHandle VulkanRenderApi::BuildGraphicsPipeline(std::span<const vk::PipelineShaderStageCreateInfo> stages,
+		const vk::PipelineVertexInputStateCreateInfo* vertexInput, vk::DescriptorSetLayout drawSetLayout,
+		vk::ShaderStageFlags drawConstantStages, uint32_t drawConstantsSize)
+	{
+		vk::PipelineInputAssemblyStateCreateInfo inputAssembly = { .topology = vk::PrimitiveTopology::eTriangleList };
+		vk::PipelineViewportStateCreateInfo viewportState{ .viewportCount = 1, .scissorCount = 1 };
+
+		vk::PipelineRasterizationStateCreateInfo rasterizer{
+			.depthClampEnable = vk::False, .rasterizerDiscardEnable = vk::False,
+			.polygonMode = vk::PolygonMode::eFill, .cullMode = vk::CullModeFlagBits::eBack,
+			.frontFace = vk::FrontFace::eClockwise, .depthBiasEnable = vk::False,
+			.depthBiasSlopeFactor = 1.0f, .lineWidth = 1.0f
+		};
 
-			vk::PipelineColorBlendStateCreateInfo colorBlending{.logicOpEnable = vk::False, .logicOp =  vk::LogicOp::eCopy, .attachmentCount = 1, .pAttachments =  &colorBlendAttachment };
+		vk::PipelineMultisampleStateCreateInfo multisampling{.rasterizationSamples = vk::SampleCountFlagBits::e1, .sampleShadingEnable = vk::False};
 
-			//TO-DO: read about dynamic state. what can be config?
-			vk::PipelineDynamicStateCreateInfo dynamicState = {
-				.dynamicStateCount = static_cast<uint32_t>(m_DynamicStates.size()),
-				.pDynamicStates = m_DynamicStates.data()
-			};
+		vk::PipelineColorBlendAttachmentState colorBlendAttachment{ .blendEnable = vk::False,
+		.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
+		};
 
-			vk::PipelineLayoutCreateInfo pipelineLayoutInfo{  .setLayoutCount = 0, .pushConstantRangeCount = 0 };
-
-			m_PipelineLayout = vk::raii::PipelineLayout(m_Device, pipelineLayoutInfo);
-
-			vk::StructureChain<vk::GraphicsPipelineCreateInfo, vk::PipelineRenderingCreateInfo> pipelineCreateInfoChain = {
-				{.stageCount = 2,
-				  .pStages = shaderStages,
-				  .pVertexInputState = &vertexInputInfo,
-				  .pInputAssemblyState = &inputAssembly,
-				  .pViewportState = &viewportState,
-				  .pRasterizationState = &rasterizer,
-				  .pMultisampleState = &multisampling,
-				  .pColorBlendState = &colorBlending,
-				  .pDynamicState = &dynamicState,
-				  .layout = m_PipelineLayout,
-				  .renderPass = nullptr },
-				{.colorAttachmentCount = 1, .pColorAttachmentFormats = &m_SwapChainSurfaceFormat.format }
-			};
+		vk::PipelineColorBlendStateCreateInfo colorBlending{.logicOpEnable = vk::False, .logicOp =  vk::LogicOp::eCopy, .attachmentCount = 1, .pAttachments =  &colorBlendAttachment };
 
-			m_GraphicsPipeline =  vk::raii::Pipeline(m_Device, nullptr, pipelineCreateInfoChain.get<vk::GraphicsPipelineCreateInfo>());
-		}
+		//TO-DO: read about dynamic state. what can be config?
+		vk::PipelineDynamicStateCreateInfo dynamicState = {
+			.dynamicStateCount = static_cast<uint32_t>(m_DynamicStates.size()),
+			.pDynamicStates = m_DynamicStates.data()
+		};
+
+		vk::PushConstantRange drawConstantRange = m_PerDrawData->GetPushConstantRange(drawConstantsSize, drawConstantStages);
+		const vk::DescriptorSetLayout setLayouts[] = { *m_FrameSetLayout, drawSetLayout };
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo{  .setLayoutCount = drawSetLayout ? 2u : 1u, .pSetLayouts = setLayouts,
+			.pushConstantRangeCount = 1, .pPushConstantRanges = &drawConstantRange };
+
+		vk::raii::PipelineLayout pipelineLayout(m_Device, pipelineLayoutInfo);
+
+		vk::StructureChain<vk::GraphicsPipelineCreateInfo, vk::PipelineRenderingCreateInfo> pipelineCreateInfoChain = {
+			{.flags = m_DescriptorBinder->GetPipelineCreateFlags(),
+			  .stageCount = static_cast<uint32_t>(stages.size()),
+			  .pStages = stages.data(),
+			  //Mesh shading pipelines assemble their own primitives
+			  .pVertexInputState = vertexInput,
+			  .pInputAssemblyState = vertexInput ? &inputAssembly : nullptr,
+			  .pViewportState = &viewportState,
+			  .pRasterizationState = &rasterizer,
+			  .pMultisampleState = &multisampling,
+			  .pColorBlendState = &colorBlending,
+			  .pDynamicState = &dynamicState,
+			  .layout = pipelineLayout,
+			  .renderPass = nullptr },
+			{.colorAttachmentCount = 1, .pColorAttachmentFormats = &m_SwapChainSurfaceFormat.format }
+		};
+
+		vk::raii::Pipeline pipeline(m_Device, nullptr, pipelineCreateInfoChain.get<vk::GraphicsPipelineCreateInfo>());
+		return m_ResourcePool->AddPipeline(std::move(pipeline), std::move(pipelineLayout), vk::PipelineBindPoint::eGraphics);
 	}
 
 	void VulkanRenderApi::CreateCommandPool()
 	{
-		vk::CommandPoolCreateInfo poolInfo{ .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer, .queueFamilyIndex = m_QueueIndex };
-		m_CommandPool = vk::raii::CommandPool(m_Device, poolInfo);
+		m_CommandPool = std::make_unique<VulkanFrameCommandPool>(m_Device, m_QueueIndex);
+		m_CommandRecorder = std::make_unique<VulkanCommandRecorder>(m_Device, m_QueueIndex);
+
+		m_CachedCommandPool = vk::raii::CommandPool(m_Device, { .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer, .queueFamilyIndex = m_QueueIndex });
+		vk::raii::CommandBuffers cachedCommandBuffers(m_Device, { .commandPool = m_CachedCommandPool, .level = vk::CommandBufferLevel::eSecondary,
+			.commandBufferCount = k_MaxFramesInFlight });
+		for (uint32_t i = 0; i < k_MaxFramesInFlight; i++)
+		{
+			m_CachedMainPasses[i].CommandBuffer = std::move(cachedCommandBuffers[i]);
+		}
 	}
 
-	void VulkanRenderApi::CreateCommandBuffer()
+	vk::CommandBuffer VulkanRenderApi::RecordCommandBuffer(uint32_t imageIndex)
 	{
-		vk::CommandBufferAllocateInfo allocInfo{ .commandPool = m_CommandPool, .level = vk::CommandBufferLevel::ePrimary, .commandBufferCount = 1 };
+		vk::raii::CommandBuffer& commandBuffer = m_CommandPool->Allocate(vk::CommandBufferLevel::ePrimary);
+		commandBuffer.begin({ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+		m_DescriptorBinder->BeginCommandBuffer(commandBuffer);
+
+		//The acquire semaphore is waited on at color attachment output, the old contents are cleared anyway
+		const VulkanRenderGraphResource backBuffer = m_RenderGraph->ImportImage("BackBuffer", m_SwapChainImages[imageIndex], vk::ImageAspectFlagBits::eColor,
+			{ .Layout = vk::ImageLayout::eUndefined, .Stages = vk::PipelineStageFlagBits2::eColorAttachmentOutput },
+			VulkanResourceState{ .Layout = vk::ImageLayout::ePresentSrcKHR, .Stages = vk::PipelineStageFlagBits2::eBottomOfPipe });
 
-		m_CommandBuffer = std::move(vk::raii::CommandBuffers(m_Device, allocInfo).front());
+		//The upload recorders place their own barriers, before anything else reads what they write
+		m_RenderGraph->AddPass("Uploads", [this](const vk::raii::CommandBuffer& commandBuffer)
+		{
+			//First, so everything recorded after it can read the decompressed data
+			m_GpuDecompressor->Record(commandBuffer);
+			//Grows and compacts before the loader copies into the pool's current buffers
+			m_GeometryPool->Record(commandBuffer);
+			m_MeshLoader->Record(commandBuffer);
+			m_TextureStreamer->Record(commandBuffer);
+			for (auto& virtualTexture : m_VirtualTextures)
+			{
+				virtualTexture->Record(commandBuffer);
+			}
+			if (m_MipGenerator)
+			{
+				m_MipGenerator->Record(commandBuffer);
+			}
+		}).SetSideEffects();
+
+		//Own target and barriers, read back once the frame slot comes around again
+		if (!m_VirtualTextures.empty())
+		{
+			m_RenderGraph->AddPass("VirtualTextureFeedback", [this](const vk::raii::CommandBuffer& commandBuffer)
+			{
+				for (auto& virtualTexture : m_VirtualTextures)
+				{
+					virtualTexture->RecordFeedbackPass(commandBuffer);
+				}
+			}).SetSideEffects();
+		}
+
+		m_RenderGraph->AddPass("Main", [this, imageIndex](const vk::raii::CommandBuffer& commandBuffer) { RecordMainPass(commandBuffer, imageIndex); })
+			.Write(backBuffer, VulkanResourceUsage::ColorAttachment);
+
+		m_RenderGraph->Execute(commandBuffer);
+		m_Stats.RenderPasses = m_RenderGraph->GetPassCount();
+		m_Stats.CulledRenderPasses = m_RenderGraph->GetCulledPassCount();
+		m_Stats.RenderGraphBarriers = m_BarrierBatcher->GetBarrierCount();
+		m_Stats.RenderGraphSplitBarriers = m_BarrierBatcher->GetSplitBarrierCount();
+		commandBuffer.end();
+		return *commandBuffer;
 	}
 
-	void VulkanRenderApi::RecordCommandBuffer(uint32_t imageIndex)
+	void VulkanRenderApi::RecordMainPass(const vk::raii::CommandBuffer& commandBuffer, uint32_t imageIndex)
 	{
-		m_CommandBuffer.begin( {} );
-        // Before starting rendering, transition the swapchain image to COLOR_ATTACHMENT_OPTIMAL
-        transition_image_layout(
-            imageIndex,
-            vk::ImageLayout::eUndefined,
-            vk::ImageLayout::eColorAttachmentOptimal,
-            {},                                                         // srcAccessMask (no need to wait for previous operations)
-            vk::AccessFlagBits2::eColorAttachmentWrite,                 // dstAccessMask
-            vk::PipelineStageFlagBits2::eColorAttachmentOutput,         // srcStage
-            vk::PipelineStageFlagBits2::eColorAttachmentOutput          // dstStage
-        );
-
 		const vk::ClearColorValue clearColorValue {std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f}};
-        vk::RenderingAttachmentInfo attachmentInfo = {
-            .imageView = m_SwapChainImageViews[imageIndex],
-            .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
-            .loadOp = vk::AttachmentLoadOp::eClear,
-            .storeOp = vk::AttachmentStoreOp::eStore,
-            .clearValue = static_cast<vk::ClearValue>(clearColorValue)
-        };
+		vk::RenderingAttachmentInfo attachmentInfo = {
+			.imageView = m_SwapChainImageViews[imageIndex],
+			.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+			.loadOp = vk::AttachmentLoadOp::eClear,
+			.storeOp = vk::AttachmentStoreOp::eStore,
+			.clearValue = static_cast<vk::ClearValue>(clearColorValue)
+		};
 
-        const vk::RenderingInfo renderingInfo = {
-            .renderArea = { .offset = { 0, 0 }, .extent = m_SwapChainExtent },
-            .layerCount = 1,
-            .colorAttachmentCount = 1,
-            .pColorAttachments = &attachmentInfo
-        };
+		vk::RenderingInfo renderingInfo = {
+			.renderArea = { .offset = { 0, 0 }, .extent = m_SwapChainExtent },
+			.layerCount = 1,
+			.colorAttachmentCount = 1,
+			.pColorAttachments = &attachmentInfo
+		};
 
-        m_CommandBuffer.beginRendering(renderingInfo);
-        m_CommandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_GraphicsPipeline);
-        m_CommandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(m_SwapChainExtent.width), static_cast<float>(m_SwapChainExtent.height), 0.0f, 1.0f));
-        m_CommandBuffer.setScissor( 0, vk::Rect2D( vk::Offset2D( 0, 0 ), m_SwapChainExtent ) );
-        m_CommandBuffer.draw(3, 1, 0, 0);
-        m_CommandBuffer.endRendering();
-        // After rendering, transition the swapchain image to PRESENT_SRC
-        transition_image_layout(
-            imageIndex,
-            vk::ImageLayout::eColorAttachmentOptimal,
-            vk::ImageLayout::ePresentSrcKHR,
-            vk::AccessFlagBits2::eColorAttachmentWrite,                 // srcAccessMask
-            {},                                                         // dstAccessMask
-            vk::PipelineStageFlagBits2::eColorAttachmentOutput,         // srcStage
-            vk::PipelineStageFlagBits2::eBottomOfPipe                   // dstStage
-        );
-        m_CommandBuffer.end();
-	}
-
-	void VulkanRenderApi::transition_image_layout(uint32_t currentFrame, vk::ImageLayout old_layout, vk::ImageLayout new_layout, vk::AccessFlags2 src_access_mask,
-			vk::AccessFlags2 dst_access_mask, vk::PipelineStageFlags2 src_stage_mask, vk::PipelineStageFlags2 dst_stage_mask)
-	{
-		vk::ImageMemoryBarrier2 barrier = {
-			.srcStageMask = src_stage_mask,
-			.srcAccessMask = src_access_mask,
-			.dstStageMask = dst_stage_mask,
-			.dstAccessMask = dst_access_mask,
-			.oldLayout = old_layout,
-			.newLayout = new_layout,
-			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.image = m_SwapChainImages[currentFrame],
-			.subresourceRange = {
-				.aspectMask = vk::ImageAspectFlagBits::eColor,
-				.baseMipLevel = 0,
-				.levelCount = 1,
-				.baseArrayLayer = 0,
-				.layerCount = 1
+		//A still valid recording needs neither the draws prepared nor anything allocated
+		CachedMainPass* cachedPass = m_bStaticFrameCaching ? GetCachedMainPass() : nullptr;
+		const bool bReplay = cachedPass && cachedPass->bValid;
+		m_Stats.CachedRenderPasses = bReplay ? 1 : 0;
+		if (!bReplay)
+		{
+			PrepareMeshDraws();
+		}
+		std::vector<size_t> chunkBounds;
+		const uint32_t chunkCount = cachedPass ? 0 : GetMeshDrawChunks(chunkBounds);
+		m_Stats.MeshDrawCalls = 0;
+		if (cachedPass)
+		{
+			if (!cachedPass->bValid)
+			{
+				RecordCachedMainPass(*cachedPass);
 			}
+			renderingInfo.flags = vk::RenderingFlagBits::eContentsSecondaryCommandBuffers;
+			commandBuffer.beginRendering(renderingInfo);
+			commandBuffer.executeCommands(*cachedPass->CommandBuffer);
+			m_Stats.MeshDraws = cachedPass->MeshDraws;
+			m_Stats.MeshDrawCalls = cachedPass->MeshDrawCalls;
+		}
+		else if (chunkCount == 0)
+		{
+			const VulkanDescriptorSet frameSet = AllocateFrameSet();
+			commandBuffer.beginRendering(renderingInfo);
+			m_Stats.MeshDrawCalls = RecordMainPassCommands(commandBuffer, frameSet, 0, m_MeshDrawItems.size(), true);
+		}
+		else
+		{
+			//Secondaries don't inherit any state, each one sets up its own dynamic state and bindings
+			const VulkanDescriptorSet frameSet = AllocateFrameSet();
+			renderingInfo.flags = vk::RenderingFlagBits::eContentsSecondaryCommandBuffers;
+			commandBuffer.beginRendering(renderingInfo);
+			const vk::CommandBufferInheritanceRenderingInfo inheritanceRendering = GetMainPassInheritance();
+			std::vector<uint32_t> drawCalls(chunkCount);
+			const std::vector<vk::CommandBuffer> secondaries = m_CommandRecorder->Record(chunkCount, { .pNext = &inheritanceRendering },
+				[&](const vk::raii::CommandBuffer& secondary, uint32_t chunk)
+				{
+					m_DescriptorBinder->BeginCommandBuffer(secondary);
+					drawCalls[chunk] = RecordMainPassCommands(secondary, frameSet, chunkBounds[chunk], chunkBounds[chunk + 1], chunk == 0);
+				});
+			commandBuffer.executeCommands(secondaries);
+			for (uint32_t chunkDrawCalls : drawCalls)
+			{
+				m_Stats.MeshDrawCalls += chunkDrawCalls;
+			}
+		}
+		commandBuffer.endRendering();
+
+		//Items point into the queued draws
+		m_MeshDrawItems.clear();
+		m_MeshBatchDraws.clear();
+		m_MeshDraws.clear();
+	}
+
+	VulkanDescriptorSet VulkanRenderApi::AllocateFrameSet()
+	{
+		const VulkanDescriptorSet frameSet = m_DescriptorBinder->Allocate(*m_FrameSetLayout);
+		m_DescriptorBinder->WriteBuffer(frameSet, 0, vk::DescriptorType::eUniformBuffer, m_UniformBuffers[m_CurrentFrame], 0, sizeof(FrameUniforms));
+		return frameSet;
+	}
+
+	vk::CommandBufferInheritanceRenderingInfo VulkanRenderApi::GetMainPassInheritance() const
+	{
+		return {
+			.colorAttachmentCount = 1,
+			.pColorAttachmentFormats = &m_SwapChainSurfaceFormat.format,
+			.rasterizationSamples = vk::SampleCountFlagBits::e1
 		};
-		vk::DependencyInfo dependency_info = {
-			.dependencyFlags = {},
-			.imageMemoryBarrierCount = 1,
-			.pImageMemoryBarriers = &barrier
+	}
+
+	void VulkanRenderApi::SetStaticFrameCaching(bool bEnabled)
+	{
+		m_bStaticFrameCaching = bEnabled;
+		//The draw buffers they read get overwritten by every frame recorded without the cache
+		for (CachedMainPass& cachedPass : m_CachedMainPasses)
+		{
+			cachedPass.bValid = false;
+		}
+	}
+
+	VulkanRenderApi::CachedMainPass* VulkanRenderApi::GetCachedMainPass()
+	{
+		MainPassKey key{
+			.GeometryVersion = m_GeometryPool->GetVersion(),
+			.ViewProjection = m_ViewProjection,
+			.Extent = m_SwapChainExtent,
+			.Format = m_SwapChainSurfaceFormat.format,
+			.bMeshShading = m_bMeshShadingEnabled,
+			.bVertexPulling = m_bVertexPullingEnabled
 		};
-		m_CommandBuffer.pipelineBarrier2(dependency_info);
+		//Draws of meshes still uploading are skipped, they count once they become ready
+		key.Draws.reserve(m_MeshDraws.size());
+		for (const VulkanMeshInstance& draw : m_MeshDraws)
+		{
+			if (m_MeshLoader->IsValid(draw.Mesh) && m_MeshLoader->IsReady(draw.Mesh))
+			{
+				key.Draws.push_back(draw);
+			}
+		}
+		if (key == m_MainPassKey)
+		{
+			return &m_CachedMainPasses[m_CurrentFrame];
+		}
+
+		//Only cache once the inputs held still for a frame, a scene that changes every frame never pays for it
+		m_MainPassKey = std::move(key);
+		for (CachedMainPass& cachedPass : m_CachedMainPasses)
+		{
+			cachedPass.bValid = false;
+		}
+		return nullptr;
+	}
+
+	void VulkanRenderApi::RecordCachedMainPass(CachedMainPass& cachedPass)
+	{
+		//Recycles what the slot's previous recording allocated, the GPU finished the frame that last replayed it
+		m_DescriptorBinder->BeginRetained();
+		m_PerDrawData->BeginRetained();
+		const VulkanDescriptorSet frameSet = AllocateFrameSet();
+		const vk::CommandBufferInheritanceRenderingInfo inheritanceRendering = GetMainPassInheritance();
+		const vk::CommandBufferInheritanceInfo inheritance{ .pNext = &inheritanceRendering };
+		//Neither one time submit nor simultaneous use, it runs again once the slot's previous frame finished
+		cachedPass.CommandBuffer.begin({ .flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue, .pInheritanceInfo = &inheritance });
+		m_DescriptorBinder->BeginCommandBuffer(cachedPass.CommandBuffer);
+		cachedPass.MeshDrawCalls = RecordMainPassCommands(cachedPass.CommandBuffer, frameSet, 0, m_MeshDrawItems.size(), true);
+		cachedPass.CommandBuffer.end();
+		m_PerDrawData->EndRetained();
+		m_DescriptorBinder->EndRetained();
+		cachedPass.MeshDraws = m_Stats.MeshDraws;
+		cachedPass.bValid = true;
+	}
+
+	uint32_t VulkanRenderApi::RecordMainPassCommands(const vk::raii::CommandBuffer& commandBuffer, const VulkanDescriptorSet& frameSet, size_t begin,
+		size_t end, bool bTriangle)
+	{
+		commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(m_SwapChainExtent.width), static_cast<float>(m_SwapChainExtent.height), 0.0f, 1.0f));
+		commandBuffer.setScissor( 0, vk::Rect2D( vk::Offset2D( 0, 0 ), m_SwapChainExtent ) );
+
+		if (bTriangle)
+		{
+			const vk::PipelineLayout pipelineLayout = m_ResourcePool->GetPipelineLayout(m_GraphicsPipeline);
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_ResourcePool->GetPipeline(m_GraphicsPipeline));
+			m_DescriptorBinder->BindSets(commandBuffer, vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, { &frameSet, 1 });
+			DrawConstants drawConstants{ .Model = glm::mat4(1.0f) };
+			m_PerDrawData->PushData(commandBuffer, pipelineLayout, vk::ShaderStageFlagBits::eVertex, &drawConstants, sizeof(drawConstants));
+			commandBuffer.draw(3, 1, 0, 0);
+		}
+		return RecordMeshDrawItems(commandBuffer, frameSet, begin, end);
 	}
 
 	void VulkanRenderApi::CreateSyncObjects()
 	{
-		m_PresentCompleteSemaphore = vk::raii::Semaphore(m_Device, vk::SemaphoreCreateInfo());
-		m_RenderFinishedSemaphore = vk::raii::Semaphore(m_Device, vk::SemaphoreCreateInfo());
-		m_DrawFence = vk::raii::Fence(m_Device, {.flags = vk::FenceCreateFlagBits::eSignaled});
+		m_PresentCompleteSemaphores.clear();
+		m_RenderFinishedSemaphores.clear();
+		for (uint32_t i = 0; i < k_MaxFramesInFlight; i++)
+		{
+			m_PresentCompleteSemaphores.emplace_back(m_Device, vk::SemaphoreCreateInfo());
+		}
+		//Presentation may still hold the semaphore of an image, so render finished semaphores are per swapchain image
+		for (size_t i = 0; i < m_SwapChainImages.size(); i++)
+		{
+			m_RenderFinishedSemaphores.emplace_back(m_Device, vk::SemaphoreCreateInfo());
+		}
+
+		vk::SemaphoreTypeCreateInfo timelineInfo{ .semaphoreType = vk::SemaphoreType::eTimeline, .initialValue = 0 };
+		m_FrameTimeline = vk::raii::Semaphore(m_Device, vk::SemaphoreCreateInfo{ .pNext = &timelineInfo });
 	}
 
 	void VulkanRenderApi::DrawFrame()
 	{
-		//Wait for the previous frame to finish
-		m_Queue.waitIdle();
+		//Frame N signals N on the frame timeline, wait for the frame that last used this frame slot
+		m_FrameNumber++;
+		if (m_FrameNumber > k_MaxFramesInFlight)
+		{
+			const uint64_t waitValue = m_FrameNumber - k_MaxFramesInFlight;
+			vk::SemaphoreWaitInfo waitInfo{ .semaphoreCount = 1, .pSemaphores = &*m_FrameTimeline, .pValues = &waitValue };
+			while ( vk::Result::eTimeout == m_Device.waitSemaphores( waitInfo, UINT64_MAX ) )
+				;
+		}
+		//Free everything released by frames the GPU has finished, then tag new releases with this frame
+		const uint64_t completedFrame = m_FrameTimeline.getCounterValue();
+		m_DeletionQueue->Collect(completedFrame);
+		m_GeometryPool->Collect(completedFrame);
+		m_DeletionQueue->SetRetireValue(m_FrameNumber);
+		//Evict before anything this frame allocates, streamed resources get touched again while recording
+		m_MemoryBudget->Poll();
+		m_ResidencyManager->Update(m_FrameNumber);
+		for (const VulkanMeshInstance& instance : m_SceneInstances)
+		{
+			DrawMesh(instance.Mesh, instance.Transform);
+		}
+
 		//Acquire an image from the swap chain
-		auto [result, imageIndex] = m_SwapChain.acquireNextImage(UINT64_MAX, *m_PresentCompleteSemaphore, nullptr);
+		auto [result, imageIndex] = m_SwapChain.acquireNextImage(UINT64_MAX, *m_PresentCompleteSemaphores[m_CurrentFrame], nullptr);
+		m_DescriptorBinder->BeginFrame(m_CurrentFrame);
+		ReservePerDrawSets();
+		m_PerDrawData->BeginFrame(m_CurrentFrame);
+		m_UploadContext->BeginFrame(m_CurrentFrame);
+		m_BarrierBatcher->BeginFrame(m_CurrentFrame);
+		m_CommandPool->BeginFrame(m_CurrentFrame);
+		m_CommandRecorder->BeginFrame(m_CurrentFrame);
+		m_MeshLoader->BeginFrame();
+		m_TextureStreamer->BeginFrame();
+		for (auto& virtualTexture : m_VirtualTextures)
+		{
+			virtualTexture->BeginFrame(m_CurrentFrame);
+		}
+		UpdateUniformBuffer(m_CurrentFrame);
 		//Record a command buffer which draws the scene onto that image
-		RecordCommandBuffer(imageIndex);
-		m_Device.resetFences(*m_DrawFence);
+		const vk::CommandBuffer commandBuffer = RecordCommandBuffer(imageIndex);
 		//Submit the recorded command buffer
 		vk::PipelineStageFlags waitDestinationStageMask( vk::PipelineStageFlagBits::eColorAttachmentOutput );
 
-		const vk::SubmitInfo submitInfo{ .waitSemaphoreCount = 1, .pWaitSemaphores = &*m_PresentCompleteSemaphore,
-							.pWaitDstStageMask = &waitDestinationStageMask, .commandBufferCount = 1, .pCommandBuffers = &*m_CommandBuffer,
-							.signalSemaphoreCount = 1, .pSignalSemaphores = &*m_RenderFinishedSemaphore };
-
-		m_Queue.submit(submitInfo, *m_DrawFence);
+		const std::array<vk::Semaphore, 2> signalSemaphores = { *m_RenderFinishedSemaphores[imageIndex], *m_FrameTimeline };
+		const std::array<uint64_t, 2> signalValues = { 0, m_FrameNumber };	// binary semaphores ignore their value
+		vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo{
+			.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size()),
+			.pSignalSemaphoreValues = signalValues.data()
+		};
+		const vk::SubmitInfo submitInfo{ .pNext = &timelineSubmitInfo,
+							.waitSemaphoreCount = 1, .pWaitSemaphores = &*m_PresentCompleteSemaphores[m_CurrentFrame],
+							.pWaitDstStageMask = &waitDestinationStageMask, .commandBufferCount = 1, .pCommandBuffers = &commandBuffer,
+							.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size()), .pSignalSemaphores = signalSemaphores.data() };
 
-		while ( vk::Result::eTimeout == m_Device.waitForFences( *m_DrawFence, vk::True, UINT64_MAX ) )
-			;
+		m_Queue.submit(submitInfo);
 
 		//Present the swap chain image
-		const vk::PresentInfoKHR presentInfoKHR{ .waitSemaphoreCount = 1, .pWaitSemaphores = &*m_RenderFinishedSemaphore,
+		const vk::PresentInfoKHR presentInfoKHR{ .waitSemaphoreCount = 1, .pWaitSemaphores = &*m_RenderFinishedSemaphores[imageIndex],
 												.swapchainCount = 1, .pSwapchains = &*m_SwapChain, .pImageIndices = &imageIndex };
 		result = m_Queue.presentKHR( presentInfoKHR );
 		switch ( result )
@@ -432,6 +1305,7 @@ namespace VRE
 			case vk::Result::eSuboptimalKHR: std::cout << "vk::Queue::presentKHR returned vk::Result::eSuboptimalKHR !\n"; break;
 			default: break;  // an unexpected result is returned!
 		}
+		m_CurrentFrame = (m_CurrentFrame + 1) % k_MaxFramesInFlight;
 	}
 
 	void VulkanRenderApi::CreateImageViews() {
@@ -509,8 +1383,22 @@ namespace VRE
         return extensions;
     }
 
+	const RenderStats& VulkanRenderApi::GetStats()
+	{
+		m_Stats.FrameNumber = m_FrameNumber;
+		m_Stats.MemoryHeaps = m_MemoryBudget->GetHeapStats();
+		m_Stats.StreamableResourceCount = m_ResidencyManager->GetResourceCount();
+		m_Stats.StreamableResidentBytes = m_ResidencyManager->GetResidentBytes();
+		m_Stats.EvictedBytes = m_ResidencyManager->GetEvictedBytes();
+		m_Stats.DeclinedAllocations = m_ResidencyManager->GetDeclinedAllocations();
+		m_Stats.TransientMemoryBytes = m_TransientPool->GetMemorySize();
+		m_Stats.TransientRequestedBytes = m_TransientPool->GetRequestedSize();
+		return m_Stats;
+	}
+
 	void VulkanRenderApi::CleanUp()
 	{
 		m_Device.waitIdle();
+		m_DeletionQueue->Flush();
 	}
 }
\ No newline at end of file
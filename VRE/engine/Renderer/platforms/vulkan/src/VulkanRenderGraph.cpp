@@ -0,0 +1,508 @@
+#include <VulkanRenderGraph.h>
+#include <algorithm>
+#include <cassert>
+
+namespace VRE
+{
+	constexpr vk::AccessFlags2 k_WriteAccess = vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eShaderStorageWrite
+		| vk::AccessFlagBits2::eColorAttachmentWrite | vk::AccessFlagBits2::eDepthStencilAttachmentWrite | vk::AccessFlagBits2::eTransferWrite
+		| vk::AccessFlagBits2::eHostWrite | vk::AccessFlagBits2::eMemoryWrite;
+	//Passes from producer to consumer for a barrier to be split, 2 means at least one pass runs in between
+	constexpr uint32_t k_MinSplitDistance = 2;
+
+	//Buffers ignore the layout
+	static VulkanResourceState GetUsageState(VulkanResourceUsage usage)
+	{
+		using Stage = vk::PipelineStageFlagBits2;
+		using Access = vk::AccessFlagBits2;
+		switch (usage)
+		{
+			case VulkanResourceUsage::ColorAttachment:
+				return { vk::ImageLayout::eColorAttachmentOptimal, Stage::eColorAttachmentOutput, Access::eColorAttachmentRead | Access::eColorAttachmentWrite };
+			case VulkanResourceUsage::DepthAttachment:
+				return { vk::ImageLayout::eDepthAttachmentOptimal, Stage::eEarlyFragmentTests | Stage::eLateFragmentTests,
+					Access::eDepthStencilAttachmentRead | Access::eDepthStencilAttachmentWrite };
+			case VulkanResourceUsage::DepthRead:
+				return { vk::ImageLayout::eDepthReadOnlyOptimal, Stage::eEarlyFragmentTests | Stage::eLateFragmentTests, Access::eDepthStencilAttachmentRead };
+			case VulkanResourceUsage::Sampled:
+				return { vk::ImageLayout::eShaderReadOnlyOptimal, Stage::eFragmentShader | Stage::eComputeShader, Access::eShaderSampledRead };
+			case VulkanResourceUsage::StorageRead:
+				return { vk::ImageLayout::eGeneral, Stage::eFragmentShader | Stage::eComputeShader, Access::eShaderStorageRead };
+			case VulkanResourceUsage::StorageWrite:
+				return { vk::ImageLayout::eGeneral, Stage::eFragmentShader | Stage::eComputeShader, Access::eShaderStorageRead | Access::eShaderStorageWrite };
+			case VulkanResourceUsage::TransferSrc:
+				return { vk::ImageLayout::eTransferSrcOptimal, Stage::eAllTransfer, Access::eTransferRead };
+			case VulkanResourceUsage::TransferDst:
+				return { vk::ImageLayout::eTransferDstOptimal, Stage::eAllTransfer, Access::eTransferWrite };
+			case VulkanResourceUsage::VertexInput:
+				return { vk::ImageLayout::eUndefined, Stage::eVertexAttributeInput | Stage::eIndexInput, Access::eVertexAttributeRead | Access::eIndexRead };
+			case VulkanResourceUsage::IndirectRead:
+				return { vk::ImageLayout::eUndefined, Stage::eDrawIndirect, Access::eIndirectCommandRead };
+			case VulkanResourceUsage::UniformRead:
+				return { vk::ImageLayout::eUndefined, Stage::eVertexShader | Stage::eFragmentShader | Stage::eComputeShader, Access::eUniformRead };
+		}
+		return {};
+	}
+
+	static vk::ImageUsageFlags GetImageUsage(VulkanResourceUsage usage)
+	{
+		switch (usage)
+		{
+			case VulkanResourceUsage::ColorAttachment:
+				return vk::ImageUsageFlagBits::eColorAttachment;
+			case VulkanResourceUsage::DepthAttachment:
+			case VulkanResourceUsage::DepthRead:
+				return vk::ImageUsageFlagBits::eDepthStencilAttachment;
+			case VulkanResourceUsage::Sampled:
+				return vk::ImageUsageFlagBits::eSampled;
+			case VulkanResourceUsage::StorageRead:
+			case VulkanResourceUsage::StorageWrite:
+				return vk::ImageUsageFlagBits::eStorage;
+			case VulkanResourceUsage::TransferSrc:
+				return vk::ImageUsageFlagBits::eTransferSrc;
+			case VulkanResourceUsage::TransferDst:
+				return vk::ImageUsageFlagBits::eTransferDst;
+			default:
+				return {};
+		}
+	}
+
+	VulkanRenderGraphPass& VulkanRenderGraphPass::Read(VulkanRenderGraphResource resource, VulkanResourceUsage usage, vk::PipelineStageFlags2 stages)
+	{
+		return Use(resource, usage, stages, false);
+	}
+
+	VulkanRenderGraphPass& VulkanRenderGraphPass::Write(VulkanRenderGraphResource resource, VulkanResourceUsage usage, vk::PipelineStageFlags2 stages)
+	{
+		return Use(resource, usage, stages, true);
+	}
+
+	VulkanRenderGraphPass& VulkanRenderGraphPass::Use(VulkanRenderGraphResource resource, VulkanResourceUsage usage, vk::PipelineStageFlags2 stages,
+		bool bWrite)
+	{
+		assert(resource.IsValid());
+		VulkanResourceState state = GetUsageState(usage);
+		if (stages)
+		{
+			state.Stages = stages;
+		}
+		//One access per resource and pass, an image can only be in one layout while the pass runs
+		for (Access& access : m_Accesses)
+		{
+			if (access.Resource == resource.Index)
+			{
+				access.State.Stages |= state.Stages;
+				access.State.Access |= state.Access;
+				access.ImageUsage |= GetImageUsage(usage);
+				access.bWrite |= bWrite;
+				access.bRead |= !bWrite;
+				return *this;
+			}
+		}
+		m_Accesses.push_back({ .Resource = resource.Index, .State = state, .ImageUsage = GetImageUsage(usage), .bWrite = bWrite, .bRead = !bWrite });
+		return *this;
+	}
+
+	VulkanRenderGraph::VulkanRenderGraph(VulkanTransientPool& transientPool, VulkanBarrierBatcher& barrierBatcher)
+		: m_TransientPool(transientPool), m_BarrierBatcher(barrierBatcher)
+	{
+	}
+
+	VulkanRenderGraphResource VulkanRenderGraph::ImportImage(std::string_view name, vk::Image image, vk::ImageAspectFlags aspect,
+		const VulkanResourceState& initialState, std::optional<VulkanResourceState> finalState)
+	{
+		m_Resources.push_back({ .Name = name, .Image = image, .Aspect = aspect, .FinalState = finalState, .Layout = initialState.Layout,
+			.WriteStages = initialState.Stages, .WriteAccess = initialState.Access });
+		return { static_cast<uint32_t>(m_Resources.size() - 1) };
+	}
+
+	VulkanRenderGraphResource VulkanRenderGraph::ImportBuffer(std::string_view name, vk::Buffer buffer, const VulkanResourceState& initialState,
+		std::optional<VulkanResourceState> finalState)
+	{
+		m_Resources.push_back({ .Name = name, .Buffer = buffer, .FinalState = finalState, .WriteStages = initialState.Stages,
+			.WriteAccess = initialState.Access });
+		return { static_cast<uint32_t>(m_Resources.size() - 1) };
+	}
+
+	VulkanRenderGraphResource VulkanRenderGraph::CreateImage(std::string_view name, const VulkanTransientImageDesc& desc)
+	{
+		m_Resources.push_back({ .Name = name, .Aspect = desc.Aspect, .TransientDesc = desc });
+		return { static_cast<uint32_t>(m_Resources.size() - 1) };
+	}
+
+	VulkanRenderGraphPass& VulkanRenderGraph::AddPass(std::string_view name, std::function<void(const vk::raii::CommandBuffer&)> execute)
+	{
+		VulkanRenderGraphPass& pass = m_Passes.emplace_back();
+		pass.m_Name = name;
+		pass.m_Execute = std::move(execute);
+		return pass;
+	}
+
+	std::vector<bool> VulkanRenderGraph::CullPasses() const
+	{
+		//Walking backwards, a resource is needed while some live pass or the end of the frame reads what's in it
+		std::vector<bool> needed(m_Resources.size());
+		for (size_t i = 0; i < m_Resources.size(); i++)
+		{
+			needed[i] = m_Resources[i].FinalState.has_value();
+		}
+		std::vector<bool> live(m_Passes.size());
+		for (size_t i = m_Passes.size(); i-- > 0;)
+		{
+			const VulkanRenderGraphPass& pass = m_Passes[i];
+			live[i] = pass.m_bSideEffects || std::any_of(pass.m_Accesses.begin(), pass.m_Accesses.end(),
+				[&](const VulkanRenderGraphPass::Access& access) { return access.bWrite && needed[access.Resource]; });
+			if (!live[i])
+			{
+				continue;
+			}
+			//A pass that only writes a resource hides every earlier write from later readers
+			for (const VulkanRenderGraphPass::Access& access : pass.m_Accesses)
+			{
+				needed[access.Resource] = access.bRead || (needed[access.Resource] && !access.bWrite);
+			}
+		}
+		return live;
+	}
+
+	std::vector<uint32_t> VulkanRenderGraph::OrderPasses(const std::vector<bool>& live) const
+	{
+		const uint32_t passCount = static_cast<uint32_t>(m_Passes.size());
+		std::vector<std::vector<uint32_t>> successors(passCount);
+		std::vector<uint32_t> waitCounts(passCount);
+		const auto addEdge = [&](uint32_t from, uint32_t to)
+		{
+			if (from != to && std::find(successors[from].begin(), successors[from].end(), to) == successors[from].end())
+			{
+				successors[from].push_back(to);
+				waitCounts[to]++;
+			}
+		};
+
+		//Reads wait for the last write, writes for the last write and every read since
+		std::vector<uint32_t> lastWriters(m_Resources.size(), UINT32_MAX);
+		std::vector<std::vector<uint32_t>> readers(m_Resources.size());
+		uint32_t fence = UINT32_MAX;
+		std::vector<uint32_t> sinceFence;
+		for (uint32_t i = 0; i < passCount; i++)
+		{
+			if (!live[i])
+			{
+				continue;
+			}
+			const VulkanRenderGraphPass& pass = m_Passes[i];
+			if (fence != UINT32_MAX)
+			{
+				addEdge(fence, i);
+			}
+			if (pass.m_bSideEffects)
+			{
+				for (uint32_t previous : sinceFence)
+				{
+					addEdge(previous, i);
+				}
+				sinceFence.clear();
+				fence = i;
+			}
+			else
+			{
+				sinceFence.push_back(i);
+			}
+			for (const VulkanRenderGraphPass::Access& access : pass.m_Accesses)
+			{
+				if (lastWriters[access.Resource] != UINT32_MAX)
+				{
+					addEdge(lastWriters[access.Resource], i);
+				}
+				if (access.bWrite)
+				{
+					for (uint32_t reader : readers[access.Resource])
+					{
+						addEdge(reader, i);
+					}
+				}
+			}
+			for (const VulkanRenderGraphPass::Access& access : pass.m_Accesses)
+			{
+				if (access.bWrite)
+				{
+					lastWriters[access.Resource] = i;
+					readers[access.Resource].clear();
+				}
+				else
+				{
+					readers[access.Resource].push_back(i);
+				}
+			}
+		}
+
+		//Kahn's algorithm over the ready passes in declaration order. Taking one that doesn't wait on the pass just
+		//scheduled leaves that pass time to drain before anything has to barrier on it.
+		std::vector<uint32_t> ready;
+		for (uint32_t i = 0; i < passCount; i++)
+		{
+			if (live[i] && waitCounts[i] == 0)
+			{
+				ready.push_back(i);
+			}
+		}
+		std::vector<uint32_t> order;
+		uint32_t previous = UINT32_MAX;
+		while (!ready.empty())
+		{
+			auto next = ready.begin();
+			if (previous != UINT32_MAX)
+			{
+				const std::vector<uint32_t>& waiting = successors[previous];
+				const auto independent = std::find_if(ready.begin(), ready.end(),
+					[&](uint32_t candidate) { return std::find(waiting.begin(), waiting.end(), candidate) == waiting.end(); });
+				if (independent != ready.end())
+				{
+					next = independent;
+				}
+			}
+			previous = *next;
+			ready.erase(next);
+			order.push_back(previous);
+			for (uint32_t successor : successors[previous])
+			{
+				if (--waitCounts[successor] == 0)
+				{
+					ready.insert(std::lower_bound(ready.begin(), ready.end(), successor), successor);
+				}
+			}
+		}
+		return order;
+	}
+
+	void VulkanRenderGraph::AllocateTransients(const std::vector<uint32_t>& order)
+	{
+		std::vector<uint32_t> lastPasses(m_Resources.size());
+		std::vector<vk::ImageUsageFlags> usages(m_Resources.size());
+		for (uint32_t position = 0; position < order.size(); position++)
+		{
+			for (const VulkanRenderGraphPass::Access& access : m_Passes[order[position]].m_Accesses)
+			{
+				Resource& resource = m_Resources[access.Resource];
+				resource.FirstPass = std::min(resource.FirstPass, position);
+				lastPasses[access.Resource] = position;
+				usages[access.Resource] |= access.ImageUsage;
+			}
+		}
+
+		//Transient images no live pass uses are never created
+		for (uint32_t i = 0; i < m_Resources.size(); i++)
+		{
+			Resource& resource = m_Resources[i];
+			if (resource.TransientDesc && resource.FirstPass != UINT32_MAX)
+			{
+				VulkanTransientImageDesc desc = *resource.TransientDesc;
+				desc.Usage |= usages[i];
+				resource.TransientRequest = m_TransientPool.Request(desc, resource.FirstPass, lastPasses[i]);
+				m_TransientResources.push_back(i);
+			}
+		}
+		m_TransientPool.Allocate();
+		for (uint32_t resourceIndex : m_TransientResources)
+		{
+			Resource& resource = m_Resources[resourceIndex];
+			const VulkanTransientImage& image = m_TransientPool.Get(resource.TransientRequest);
+			resource.Image = image.Image;
+			resource.View = image.View;
+			//Last frame's users of the memory; the contents are garbage, so the first use transitions from undefined
+			resource.WriteStages = image.PreviousStages;
+		}
+	}
+
+	void VulkanRenderGraph::WaitForAliases(Resource& resource) const
+	{
+		//They are all done by now, their last state is what the aliasing barrier waits for
+		for (uint32_t alias : m_TransientPool.Get(resource.TransientRequest).Aliases)
+		{
+			const Resource& previous = m_Resources[m_TransientResources[alias]];
+			resource.WriteStages |= previous.WriteStages | previous.ReadStages;
+			resource.WriteAccess |= previous.WriteAccess;
+			for (uint32_t pass : { previous.WritePass, previous.ReadPass })
+			{
+				if (pass != UINT32_MAX && (resource.WritePass == UINT32_MAX || pass > resource.WritePass))
+				{
+					resource.WritePass = pass;
+				}
+			}
+		}
+	}
+
+	void VulkanRenderGraph::Transition(Resource& resource, const VulkanResourceState& state, bool bWrite, uint32_t position,
+		std::vector<PlannedBarrier>& barriers) const
+	{
+		const bool bImage = static_cast<bool>(resource.Image);
+		const bool bLayoutChange = bImage && state.Layout != resource.Layout;
+		vk::PipelineStageFlags2 srcStages;
+		vk::AccessFlags2 srcAccess;
+		uint32_t producer = UINT32_MAX;
+		if (bWrite || bLayoutChange)
+		{
+			//Reads since the last write already waited for it, so waiting for them covers both
+			srcStages = resource.ReadStages ? resource.ReadStages : resource.WriteStages;
+			srcAccess = resource.ReadStages ? vk::AccessFlags2{} : resource.WriteAccess;
+			producer = resource.ReadStages ? resource.ReadPass : resource.WritePass;
+		}
+		else if ((state.Stages & ~resource.ReadStages) || (state.Access & ~resource.ReadAccess))
+		{
+			//A read in a stage or of a kind the last write wasn't made visible to yet
+			srcStages = resource.WriteStages;
+			srcAccess = resource.WriteAccess;
+			producer = resource.WritePass;
+		}
+
+		if (bLayoutChange || srcStages || srcAccess)
+		{
+			PlannedBarrier& barrier = barriers.emplace_back(PlannedBarrier{ .Producer = producer, .bImage = bImage });
+			if (bImage)
+			{
+				barrier.Image = {
+					.srcStageMask = srcStages,
+					.srcAccessMask = srcAccess,
+					.dstStageMask = state.Stages,
+					.dstAccessMask = state.Access,
+					.oldLayout = resource.Layout,
+					.newLayout = state.Layout,
+					.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+					.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+					.image = resource.Image,
+					.subresourceRange = { .aspectMask = resource.Aspect, .baseMipLevel = 0, .levelCount = vk::RemainingMipLevels,
+						.baseArrayLayer = 0, .layerCount = vk::RemainingArrayLayers }
+				};
+			}
+			else
+			{
+				barrier.Memory = { .srcStageMask = srcStages, .srcAccessMask = srcAccess, .dstStageMask = state.Stages, .dstAccessMask = state.Access };
+			}
+		}
+
+		if (bWrite)
+		{
+			resource.WriteStages = state.Stages;
+			resource.WriteAccess = state.Access & k_WriteAccess;
+			resource.ReadStages = {};
+			resource.ReadAccess = {};
+			resource.WritePass = position;
+			resource.ReadPass = UINT32_MAX;
+		}
+		else if (bLayoutChange)
+		{
+			//The transition is a write the barrier already made visible to this read
+			resource.WriteStages = state.Stages;
+			resource.WriteAccess = {};
+			resource.ReadStages = state.Stages;
+			resource.ReadAccess = state.Access;
+			resource.WritePass = position;
+			resource.ReadPass = position;
+		}
+		else
+		{
+			resource.ReadStages |= state.Stages;
+			resource.ReadAccess |= state.Access;
+			resource.ReadPass = position;
+		}
+		if (bImage)
+		{
+			resource.Layout = state.Layout;
+		}
+	}
+
+	void VulkanRenderGraph::AddBarrier(const PlannedBarrier& barrier)
+	{
+		if (barrier.bImage)
+		{
+			m_BarrierBatcher.AddImageBarrier(barrier.Image);
+		}
+		else
+		{
+			m_BarrierBatcher.AddMemoryBarrier(barrier.Memory);
+		}
+	}
+
+	void VulkanRenderGraph::Execute(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		const std::vector<uint32_t> order = OrderPasses(CullPasses());
+		const uint32_t passCount = static_cast<uint32_t>(order.size());
+		m_PassCount = passCount;
+		m_CulledPassCount = static_cast<uint32_t>(m_Passes.size() - order.size());
+		AllocateTransients(order);
+
+		//Every barrier is planned before recording, a split one has to be started right after its producer. The
+		//barriers ahead of position passCount bring exported resources into their final state.
+		std::vector<std::vector<PlannedBarrier>> planned(passCount + 1);
+		for (uint32_t position = 0; position < passCount; position++)
+		{
+			for (const VulkanRenderGraphPass::Access& access : m_Passes[order[position]].m_Accesses)
+			{
+				Resource& resource = m_Resources[access.Resource];
+				if (resource.TransientRequest != UINT32_MAX && resource.FirstPass == position)
+				{
+					WaitForAliases(resource);
+				}
+				Transition(resource, access.State, access.bWrite, position, planned[position]);
+			}
+		}
+		for (Resource& resource : m_Resources)
+		{
+			if (resource.FinalState)
+			{
+				Transition(resource, *resource.FinalState, false, passCount, planned[passCount]);
+			}
+		}
+		for (uint32_t resourceIndex : m_TransientResources)
+		{
+			const Resource& resource = m_Resources[resourceIndex];
+			m_TransientPool.SetUsedStages(resource.TransientRequest, resource.WriteStages | resource.ReadStages);
+		}
+
+		//Split when at least one pass runs between producer and consumer
+		const auto isSplit = [](const PlannedBarrier& barrier, uint32_t consumer)
+		{
+			return barrier.Producer != UINT32_MAX && consumer - barrier.Producer >= k_MinSplitDistance;
+		};
+		std::vector<std::vector<uint32_t>> waits(passCount + 1);
+		for (uint32_t position = 0; position <= passCount; position++)
+		{
+			for (const PlannedBarrier& barrier : planned[position])
+			{
+				if (!isSplit(barrier, position))
+				{
+					AddBarrier(barrier);
+				}
+			}
+			m_BarrierBatcher.Wait(commandBuffer, waits[position]);
+			m_BarrierBatcher.Flush(commandBuffer);
+			if (position == passCount)
+			{
+				break;
+			}
+
+			m_Passes[order[position]].m_Execute(commandBuffer);
+
+			//One event per later consumer, set and wait need the same dependency info
+			for (uint32_t consumer = position + k_MinSplitDistance; consumer <= passCount; consumer++)
+			{
+				for (const PlannedBarrier& barrier : planned[consumer])
+				{
+					if (barrier.Producer == position)
+					{
+						AddBarrier(barrier);
+					}
+				}
+				if (!m_BarrierBatcher.IsEmpty())
+				{
+					waits[consumer].push_back(m_BarrierBatcher.Signal(commandBuffer));
+				}
+			}
+		}
+		m_TransientPool.EndFrame();
+
+		m_Passes.clear();
+		m_Resources.clear();
+		m_TransientResources.clear();
+	}
+}
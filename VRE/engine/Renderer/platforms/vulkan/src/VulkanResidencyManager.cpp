@@ -0,0 +1,170 @@
+#include <VulkanResidencyManager.h>
+#include <algorithm>
+
+namespace VRE
+{
+	//Start evicting above the high water mark and stop below the low one, so eviction doesn't run every frame
+	constexpr double k_HighWaterMark = 0.95;
+	constexpr double k_LowWaterMark = 0.85;
+	constexpr double k_OptionalAllocationLimit = 0.9;
+
+	static vk::DeviceSize ScaleBudget(vk::DeviceSize budget, double fraction)
+	{
+		return static_cast<vk::DeviceSize>(budget * fraction);
+	}
+
+	VulkanResidencyManager::VulkanResidencyManager(VulkanMemoryBudget& memoryBudget)
+		: m_MemoryBudget(memoryBudget)
+	{
+	}
+
+	ResidencyHandle VulkanResidencyManager::Register(uint32_t heapIndex, vk::DeviceSize residentBytes, EvictCallback onEvict)
+	{
+		ResidencyHandle handle = m_Handles.Allocate();
+		const uint32_t capacity = m_Handles.GetCapacity();
+		if (m_HeapIndices.size() < capacity)
+		{
+			m_HeapIndices.resize(capacity);
+			m_ResidentBytes.resize(capacity);
+			m_LastUsedFrames.resize(capacity);
+			m_EvictCallbacks.resize(capacity);
+			m_Prev.resize(capacity);
+			m_Next.resize(capacity);
+		}
+
+		const uint32_t index = handle.GetIndex();
+		m_HeapIndices[index] = heapIndex;
+		m_ResidentBytes[index] = residentBytes;
+		m_LastUsedFrames[index] = m_FrameNumber;
+		m_EvictCallbacks[index] = std::move(onEvict);
+		m_TotalResidentBytes += residentBytes;
+		LinkBack(index);
+		return handle;
+	}
+
+	void VulkanResidencyManager::Unregister(ResidencyHandle handle)
+	{
+		assert(IsValid(handle));
+		const uint32_t index = handle.GetIndex();
+		Unlink(index);
+		m_TotalResidentBytes -= m_ResidentBytes[index];
+		m_ResidentBytes[index] = 0;
+		m_EvictCallbacks[index] = nullptr;
+		m_Handles.Free(handle);
+	}
+
+	void VulkanResidencyManager::Touch(ResidencyHandle handle)
+	{
+		assert(IsValid(handle));
+		const uint32_t index = handle.GetIndex();
+		m_LastUsedFrames[index] = m_FrameNumber;
+		if (index != m_Tail)
+		{
+			Unlink(index);
+			LinkBack(index);
+		}
+	}
+
+	void VulkanResidencyManager::SetResidentBytes(ResidencyHandle handle, vk::DeviceSize residentBytes)
+	{
+		assert(IsValid(handle));
+		const uint32_t index = handle.GetIndex();
+		m_TotalResidentBytes = m_TotalResidentBytes - m_ResidentBytes[index] + residentBytes;
+		m_ResidentBytes[index] = residentBytes;
+	}
+
+	bool VulkanResidencyManager::ReserveOptional(uint32_t heapIndex, vk::DeviceSize size)
+	{
+		if (m_MemoryBudget.GetUsage(heapIndex) + size > ScaleBudget(m_MemoryBudget.GetBudget(heapIndex), k_OptionalAllocationLimit))
+		{
+			m_DeclinedAllocations++;
+			return false;
+		}
+		return true;
+	}
+
+	void VulkanResidencyManager::MakeRoom(uint32_t heapIndex, vk::DeviceSize size)
+	{
+		const vk::DeviceSize budget = m_MemoryBudget.GetBudget(heapIndex);
+		if (m_MemoryBudget.GetUsage(heapIndex) + size > ScaleBudget(budget, k_HighWaterMark))
+		{
+			const vk::DeviceSize target = ScaleBudget(budget, k_LowWaterMark);
+			EvictUntil(heapIndex, target > size ? target - size : 0);
+		}
+	}
+
+	void VulkanResidencyManager::Update(uint64_t frameNumber)
+	{
+		m_FrameNumber = frameNumber;
+		for (uint32_t heapIndex = 0; heapIndex < m_MemoryBudget.GetHeapCount(); heapIndex++)
+		{
+			const vk::DeviceSize budget = m_MemoryBudget.GetBudget(heapIndex);
+			if (m_MemoryBudget.GetUsage(heapIndex) > ScaleBudget(budget, k_HighWaterMark))
+			{
+				EvictUntil(heapIndex, ScaleBudget(budget, k_LowWaterMark));
+			}
+		}
+	}
+
+	void VulkanResidencyManager::EvictUntil(uint32_t heapIndex, vk::DeviceSize targetUsage)
+	{
+		//Track progress from what the callbacks report, a polled budget keeps showing the old usage until
+		//the deletion queue actually frees the memory a few frames later
+		vk::DeviceSize usage = m_MemoryBudget.GetUsage(heapIndex);
+		uint32_t index = m_Head;
+		while (index != k_InvalidIndex && usage > targetUsage)
+		{
+			const uint32_t next = m_Next[index];
+			//The list is ordered by last use, everything from here on is needed by the frame being recorded
+			if (m_LastUsedFrames[index] >= m_FrameNumber)
+			{
+				break;
+			}
+			if (m_HeapIndices[index] == heapIndex && m_ResidentBytes[index] > 0)
+			{
+				const ResidencyHandle handle(index, m_Handles.GetGeneration(index));
+				const vk::DeviceSize residentBytes = m_EvictCallbacks[index](handle);
+				const vk::DeviceSize freedBytes = m_ResidentBytes[index] - std::min(residentBytes, m_ResidentBytes[index]);
+				SetResidentBytes(handle, residentBytes);
+				m_EvictedBytes += freedBytes;
+				usage -= std::min(usage, freedBytes);
+			}
+			index = next;
+		}
+	}
+
+	void VulkanResidencyManager::LinkBack(uint32_t index)
+	{
+		m_Prev[index] = m_Tail;
+		m_Next[index] = k_InvalidIndex;
+		if (m_Tail != k_InvalidIndex)
+		{
+			m_Next[m_Tail] = index;
+		}
+		else
+		{
+			m_Head = index;
+		}
+		m_Tail = index;
+	}
+
+	void VulkanResidencyManager::Unlink(uint32_t index)
+	{
+		if (m_Prev[index] != k_InvalidIndex)
+		{
+			m_Next[m_Prev[index]] = m_Next[index];
+		}
+		else
+		{
+			m_Head = m_Next[index];
+		}
+		if (m_Next[index] != k_InvalidIndex)
+		{
+			m_Prev[m_Next[index]] = m_Prev[index];
+		}
+		else
+		{
+			m_Tail = m_Prev[index];
+		}
+	}
+}
@@ -0,0 +1,309 @@
+#include <VulkanResourcePool.h>
+#include <stdexcept>
+
+namespace VRE
+{
+	template<typename T> static void GrowTo(std::vector<T>& storage, uint32_t capacity)
+	{
+		if (storage.size() < capacity)
+		{
+			storage.resize(capacity);
+		}
+	}
+
+	VulkanResourcePool::VulkanResourcePool(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, VulkanDeletionQueue& deletionQueue,
+		VulkanMemoryBudget& memoryBudget, VulkanResidencyManager& residencyManager)
+		: m_Device(device), m_DeletionQueue(deletionQueue), m_MemoryBudget(memoryBudget), m_ResidencyManager(residencyManager),
+		m_MemoryProperties(physicalDevice.getMemoryProperties())
+	{
+	}
+
+	VulkanResourcePool::~VulkanResourcePool()
+	{
+		//Freed slots are nulled out, anything still set here was never destroyed by its owner.
+		//The deletion queue outlives the pool and frees these once the device is idle.
+		for (uint32_t i = 0; i < m_Pipelines.Pipelines.size(); i++)
+		{
+			ReleasePipeline(i);
+		}
+		for (uint32_t i = 0; i < m_Textures.Images.size(); i++)
+		{
+			ReleaseTexture(i);
+		}
+		for (uint32_t i = 0; i < m_Buffers.Buffers.size(); i++)
+		{
+			ReleaseBuffer(i);
+		}
+	}
+
+	BufferHandle VulkanResourcePool::CreateBuffer(const BufferDesc& desc)
+	{
+		const auto& dispatcher = *m_Device.getDispatcher();
+		vk::Device device = *m_Device;
+
+		vk::BufferCreateInfo bufferInfo{ .size = desc.Size, .usage = desc.Usage, .sharingMode = vk::SharingMode::eExclusive };
+		vk::Buffer buffer = device.createBuffer(bufferInfo, nullptr, dispatcher);
+
+		const bool bDeviceAddress = !!(desc.Usage & vk::BufferUsageFlagBits::eShaderDeviceAddress);
+		Allocation allocation;
+		vk::DeviceAddress address = 0;
+		void* mappedData = nullptr;
+		try
+		{
+			allocation = AllocateMemory(device.getBufferMemoryRequirements(buffer, dispatcher), desc.MemoryProperties, bDeviceAddress, desc.bOptional);
+			if (!allocation.Memory)
+			{
+				device.destroyBuffer(buffer, nullptr, dispatcher);
+				return {};
+			}
+			device.bindBufferMemory(buffer, allocation.Memory, 0, dispatcher);
+			address = bDeviceAddress ? device.getBufferAddress({ .buffer = buffer }, dispatcher) : 0;
+			mappedData = (desc.MemoryProperties & vk::MemoryPropertyFlagBits::eHostVisible)
+				? device.mapMemory(allocation.Memory, 0, desc.Size, {}, dispatcher) : nullptr;
+		}
+		catch (...)
+		{
+			//No slot owns them yet, e.g. the residency manager couldn't make room or the device is out of memory
+			if (allocation.Memory)
+			{
+				FreeMemory(allocation);
+			}
+			device.destroyBuffer(buffer, nullptr, dispatcher);
+			throw;
+		}
+
+		BufferHandle handle = m_Buffers.Handles.Allocate();
+		const uint32_t capacity = m_Buffers.Handles.GetCapacity();
+		GrowTo(m_Buffers.Buffers, capacity);
+		GrowTo(m_Buffers.Memory, capacity);
+		GrowTo(m_Buffers.Addresses, capacity);
+		GrowTo(m_Buffers.MappedData, capacity);
+		GrowTo(m_Buffers.Sizes, capacity);
+
+		const uint32_t index = handle.GetIndex();
+		m_Buffers.Buffers[index] = buffer;
+		m_Buffers.Memory[index] = allocation;
+		m_Buffers.Sizes[index] = desc.Size;
+		m_Buffers.Addresses[index] = address;
+		m_Buffers.MappedData[index] = mappedData;
+		return handle;
+	}
+
+	void VulkanResourcePool::DestroyBuffer(BufferHandle handle)
+	{
+		if (!IsValid(handle))
+		{
+			throw std::runtime_error("Destroying a stale or invalid buffer handle!");
+		}
+		ReleaseBuffer(handle.GetIndex());
+		m_Buffers.Handles.Free(handle);
+	}
+
+	TextureHandle VulkanResourcePool::CreateTexture(const TextureDesc& desc)
+	{
+		const auto& dispatcher = *m_Device.getDispatcher();
+		vk::Device device = *m_Device;
+
+		vk::ImageCreateInfo imageInfo{
+			.imageType = desc.Extent.depth > 1 ? vk::ImageType::e3D : vk::ImageType::e2D,
+			.format = desc.Format,
+			.extent = desc.Extent,
+			.mipLevels = desc.MipLevels,
+			.arrayLayers = desc.ArrayLayers,
+			.samples = vk::SampleCountFlagBits::e1,
+			.tiling = vk::ImageTiling::eOptimal,
+			.usage = desc.Usage,
+			.sharingMode = vk::SharingMode::eExclusive,
+			.initialLayout = vk::ImageLayout::eUndefined
+		};
+		vk::Image image = device.createImage(imageInfo, nullptr, dispatcher);
+
+		Allocation allocation;
+		vk::ImageView view;
+		try
+		{
+			allocation = AllocateMemory(device.getImageMemoryRequirements(image, dispatcher), desc.MemoryProperties, false, desc.bOptional);
+			if (!allocation.Memory)
+			{
+				device.destroyImage(image, nullptr, dispatcher);
+				return {};
+			}
+			device.bindImageMemory(image, allocation.Memory, 0, dispatcher);
+
+			vk::ImageViewCreateInfo viewInfo{
+				.image = image,
+				.viewType = desc.ViewType,
+				.format = desc.Format,
+				.subresourceRange = { desc.Aspect, 0, desc.MipLevels, 0, desc.ArrayLayers }
+			};
+			view = device.createImageView(viewInfo, nullptr, dispatcher);
+		}
+		catch (...)
+		{
+			//No slot owns them yet
+			if (allocation.Memory)
+			{
+				FreeMemory(allocation);
+			}
+			device.destroyImage(image, nullptr, dispatcher);
+			throw;
+		}
+
+		TextureHandle handle = m_Textures.Handles.Allocate();
+		const uint32_t capacity = m_Textures.Handles.GetCapacity();
+		GrowTo(m_Textures.Images, capacity);
+		GrowTo(m_Textures.Views, capacity);
+		GrowTo(m_Textures.Memory, capacity);
+		GrowTo(m_Textures.Descs, capacity);
+
+		const uint32_t index = handle.GetIndex();
+		m_Textures.Images[index] = image;
+		m_Textures.Views[index] = view;
+		m_Textures.Memory[index] = allocation;
+		m_Textures.Descs[index] = desc;
+		return handle;
+	}
+
+	void VulkanResourcePool::DestroyTexture(TextureHandle handle)
+	{
+		if (!IsValid(handle))
+		{
+			throw std::runtime_error("Destroying a stale or invalid texture handle!");
+		}
+		ReleaseTexture(handle.GetIndex());
+		m_Textures.Handles.Free(handle);
+	}
+
+	uint32_t VulkanResourcePool::GetMemoryHeap(TextureHandle handle) const
+	{
+		assert(IsValid(handle));
+		return m_MemoryBudget.GetHeapIndex(m_Textures.Memory[handle.GetIndex()].MemoryType);
+	}
+
+	void VulkanResourcePool::SwapTextures(TextureHandle first, TextureHandle second)
+	{
+		if (!IsValid(first) || !IsValid(second))
+		{
+			throw std::runtime_error("Swapping a stale or invalid texture handle!");
+		}
+		const uint32_t a = first.GetIndex();
+		const uint32_t b = second.GetIndex();
+		std::swap(m_Textures.Images[a], m_Textures.Images[b]);
+		std::swap(m_Textures.Views[a], m_Textures.Views[b]);
+		std::swap(m_Textures.Memory[a], m_Textures.Memory[b]);
+		std::swap(m_Textures.Descs[a], m_Textures.Descs[b]);
+	}
+
+	PipelineHandle VulkanResourcePool::AddPipeline(vk::raii::Pipeline&& pipeline, vk::raii::PipelineLayout&& layout, vk::PipelineBindPoint bindPoint)
+	{
+		PipelineHandle handle = m_Pipelines.Handles.Allocate();
+		const uint32_t capacity = m_Pipelines.Handles.GetCapacity();
+		GrowTo(m_Pipelines.Pipelines, capacity);
+		GrowTo(m_Pipelines.Layouts, capacity);
+		GrowTo(m_Pipelines.BindPoints, capacity);
+
+		const uint32_t index = handle.GetIndex();
+		m_Pipelines.Pipelines[index] = pipeline.release();
+		m_Pipelines.Layouts[index] = layout.release();
+		m_Pipelines.BindPoints[index] = bindPoint;
+		return handle;
+	}
+
+	void VulkanResourcePool::DestroyPipeline(PipelineHandle handle)
+	{
+		if (!IsValid(handle))
+		{
+			throw std::runtime_error("Destroying a stale or invalid pipeline handle!");
+		}
+		ReleasePipeline(handle.GetIndex());
+		m_Pipelines.Handles.Free(handle);
+	}
+
+	uint32_t VulkanResourcePool::FindMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+		{
+			if ((typeFilter & (1 << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return i;
+			}
+		}
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	VulkanResourcePool::Allocation VulkanResourcePool::AllocateMemory(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties,
+		bool bDeviceAddress, bool bOptional)
+	{
+		const uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+		const uint32_t heapIndex = m_MemoryBudget.GetHeapIndex(memoryType);
+		if (bOptional)
+		{
+			if (!m_ResidencyManager.ReserveOptional(heapIndex, requirements.size))
+			{
+				return {};
+			}
+		}
+		else
+		{
+			m_ResidencyManager.MakeRoom(heapIndex, requirements.size);
+		}
+
+		vk::MemoryAllocateFlagsInfo allocFlagsInfo{ .flags = vk::MemoryAllocateFlagBits::eDeviceAddress };
+		vk::MemoryAllocateInfo allocInfo{
+			.pNext = bDeviceAddress ? &allocFlagsInfo : nullptr,
+			.allocationSize = requirements.size,
+			.memoryTypeIndex = memoryType
+		};
+		Allocation allocation{ .Memory = (*m_Device).allocateMemory(allocInfo, nullptr, *m_Device.getDispatcher()), .MemoryType = memoryType, .Size = requirements.size };
+		m_MemoryBudget.OnAllocate(memoryType, allocation.Size);
+		return allocation;
+	}
+
+	void VulkanResourcePool::FreeMemory(const Allocation& allocation)
+	{
+		//Counted as free right away even though the deletion queue holds on to it for a few more frames
+		m_MemoryBudget.OnFree(allocation.MemoryType, allocation.Size);
+		m_DeletionQueue.Enqueue(allocation.Memory);
+	}
+
+	void VulkanResourcePool::ReleaseBuffer(uint32_t index)
+	{
+		if (!m_Buffers.Buffers[index])
+		{
+			return;
+		}
+		m_DeletionQueue.Enqueue(m_Buffers.Buffers[index]);
+		FreeMemory(m_Buffers.Memory[index]);
+		m_Buffers.Buffers[index] = nullptr;
+		m_Buffers.Memory[index] = {};
+		m_Buffers.Addresses[index] = 0;
+		m_Buffers.MappedData[index] = nullptr;
+		m_Buffers.Sizes[index] = 0;
+	}
+
+	void VulkanResourcePool::ReleaseTexture(uint32_t index)
+	{
+		if (!m_Textures.Images[index])
+		{
+			return;
+		}
+		m_DeletionQueue.Enqueue(m_Textures.Views[index]);
+		m_DeletionQueue.Enqueue(m_Textures.Images[index]);
+		FreeMemory(m_Textures.Memory[index]);
+		m_Textures.Images[index] = nullptr;
+		m_Textures.Views[index] = nullptr;
+		m_Textures.Memory[index] = {};
+	}
+
+	void VulkanResourcePool::ReleasePipeline(uint32_t index)
+	{
+		if (!m_Pipelines.Pipelines[index])
+		{
+			return;
+		}
+		m_DeletionQueue.Enqueue(m_Pipelines.Pipelines[index]);
+		m_DeletionQueue.Enqueue(m_Pipelines.Layouts[index]);
+		m_Pipelines.Pipelines[index] = nullptr;
+		m_Pipelines.Layouts[index] = nullptr;
+	}
+}
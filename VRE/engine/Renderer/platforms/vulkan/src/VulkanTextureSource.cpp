@@ -0,0 +1,28 @@
+#include <VulkanTextureSource.h>
+#include <VulkanFormats.h>
+#include <FileReader.h>
+
+namespace VRE
+{
+	VulkanRawTextureFileSource::VulkanRawTextureFileSource(std::string path, const TextureSourceInfo& info)
+		: m_Path(std::move(path)), m_Info(info)
+	{
+		uint64_t offset = 0;
+		m_MipOffsets.reserve(m_Info.MipLevels + 1);
+		for (uint32_t mip = 0; mip < m_Info.MipLevels; mip++)
+		{
+			m_MipOffsets.push_back(offset);
+			offset += GetMipSize(m_Info.Format, m_Info.Extent, mip);
+		}
+		m_MipOffsets.push_back(offset);
+	}
+
+	bool VulkanRawTextureFileSource::ReadMip(uint32_t mipLevel, std::vector<std::byte>& data) const
+	{
+		if (mipLevel >= m_Info.MipLevels)
+		{
+			return false;
+		}
+		return FileReader::ReadFileRange(m_Path, m_MipOffsets[mipLevel], m_MipOffsets[mipLevel + 1] - m_MipOffsets[mipLevel], data);
+	}
+}
@@ -0,0 +1,488 @@
+#include <VulkanTextureStreamer.h>
+#include <VulkanCommon.h>
+#include <VulkanFormats.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+
+namespace VRE
+{
+	//Levels at or below this size in texels stay resident for as long as the texture is loaded
+	constexpr uint32_t k_MipTailSize = 64;
+	constexpr uint32_t k_MaxPendingLoads = 32;
+	//Frames to wait before asking again after the budget declined a grow
+	constexpr uint64_t k_DeclinedRetryFrames = 60;
+	constexpr vk::DeviceSize k_StagingAlignment = 16;
+
+	constexpr vk::PipelineStageFlags2 k_SampleStages = vk::PipelineStageFlagBits2::eVertexShader | vk::PipelineStageFlagBits2::eFragmentShader
+		| vk::PipelineStageFlagBits2::eComputeShader;
+
+	static vk::ImageMemoryBarrier2 ImageBarrier(vk::Image image, uint32_t levelCount, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+		vk::PipelineStageFlags2 srcStage, vk::AccessFlags2 srcAccess, vk::PipelineStageFlags2 dstStage, vk::AccessFlags2 dstAccess)
+	{
+		return {
+			.srcStageMask = srcStage,
+			.srcAccessMask = srcAccess,
+			.dstStageMask = dstStage,
+			.dstAccessMask = dstAccess,
+			.oldLayout = oldLayout,
+			.newLayout = newLayout,
+			.srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+			.dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+			.image = image,
+			.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, levelCount, 0, 1 }
+		};
+	}
+
+	static vk::DeviceSize AlignStaging(vk::DeviceSize offset)
+	{
+		return (offset + k_StagingAlignment - 1) & ~(k_StagingAlignment - 1);
+	}
+
+	//Staging bytes the mips take once StageLoad has aligned each of them
+	static vk::DeviceSize GetStagingSize(std::span<const std::vector<std::byte>> mips)
+	{
+		vk::DeviceSize size = 0;
+		for (const auto& mip : mips)
+		{
+			size = AlignStaging(size) + mip.size();
+		}
+		return size;
+	}
+
+	static void PipelineBarrier(const vk::raii::CommandBuffer& commandBuffer, std::span<const vk::ImageMemoryBarrier2> barriers)
+	{
+		vk::DependencyInfo dependencyInfo{
+			.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size()),
+			.pImageMemoryBarriers = barriers.data()
+		};
+		commandBuffer.pipelineBarrier2(dependencyInfo);
+	}
+
+	VulkanTextureStreamer::VulkanTextureStreamer(VulkanResourcePool& resourcePool, VulkanResidencyManager& residencyManager,
+		VulkanUploadContext& uploadContext, ThreadPool& threadPool)
+		: m_ResourcePool(resourcePool), m_ResidencyManager(residencyManager), m_UploadContext(uploadContext), m_ThreadPool(threadPool)
+	{
+	}
+
+	VulkanTextureStreamer::~VulkanTextureStreamer()
+	{
+		//Workers write into m_CompletedLoads, let them finish before anything goes away
+		m_ThreadPool.WaitIdle();
+		for (uint32_t slot = 0; slot < m_Textures.size(); slot++)
+		{
+			if (m_Textures[slot].Source)
+			{
+				UnloadTexture(m_Textures[slot].Texture);
+			}
+		}
+	}
+
+	TextureHandle VulkanTextureStreamer::LoadTexture(std::shared_ptr<VulkanTextureSource> source)
+	{
+		uint32_t slot;
+		if (!m_FreeSlots.empty())
+		{
+			slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else
+		{
+			slot = static_cast<uint32_t>(m_Textures.size());
+			m_Textures.emplace_back();
+		}
+
+		//Only holds the handle until the source is open, nothing samples it before IsReady
+		StreamedTexture& texture = m_Textures[slot];
+		texture.Texture = m_ResourcePool.CreateTexture({
+			.Extent = { 1, 1, 1 },
+			.Format = vk::Format::eR8G8B8A8Unorm,
+			.MipLevels = 1,
+			.Usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst
+		});
+		texture.Source = std::move(source);
+		m_SlotLookup.emplace(texture.Texture, slot);
+
+		//Opening may read headers, the caller never waits on the disk
+		m_ThreadPool.Submit([this, source = texture.Source, open = SourceOpen{ .Slot = slot, .Serial = texture.LoadSerial }]()
+		{
+			if (source->Open() && source->GetInfo().MipLevels > 0)
+			{
+				std::lock_guard lock(m_CompletedMutex);
+				m_CompletedOpens.push_back(open);
+			}
+		});
+		return texture.Texture;
+	}
+
+	void VulkanTextureStreamer::CreateStreamedTexture(uint32_t slot)
+	{
+		StreamedTexture& texture = m_Textures[slot];
+		const TextureSourceInfo& info = texture.Source->GetInfo();
+		uint32_t tailMip = 0;
+		while (tailMip + 1 < info.MipLevels && std::max(info.Extent.width >> tailMip, info.Extent.height >> tailMip) > k_MipTailSize)
+		{
+			tailMip++;
+		}
+
+		const TextureHandle streamed = m_ResourcePool.CreateTexture({
+			.Extent = GetMipExtent(info.Extent, tailMip),
+			.Format = info.Format,
+			.MipLevels = info.MipLevels - tailMip,
+			.Usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst
+		});
+		//The placeholder ends up behind the temporary handle
+		m_ResourcePool.SwapTextures(texture.Texture, streamed);
+		m_ResourcePool.DestroyTexture(streamed);
+		texture.Residency = m_ResidencyManager.Register(m_ResourcePool.GetMemoryHeap(texture.Texture), m_ResourcePool.GetMemorySize(texture.Texture),
+			[this, slot](ResidencyHandle) { return Evict(slot); });
+		texture.ResidentMip = info.MipLevels;
+		texture.TailMip = tailMip;
+		texture.bOpen = true;
+
+		//The tail is read on a worker like any other load
+		ScheduleLoad(slot, tailMip);
+	}
+
+	void VulkanTextureStreamer::UnloadTexture(TextureHandle texture)
+	{
+		const uint32_t slot = GetSlot(texture);
+		StreamedTexture& streamed = m_Textures[slot];
+		if (streamed.bOpen)
+		{
+			m_ResidencyManager.Unregister(streamed.Residency);
+		}
+		m_ResourcePool.DestroyTexture(streamed.Texture);
+		m_SlotLookup.erase(texture);
+
+		//Keep the serial running so reads still in flight for the old texture are dropped
+		m_Textures[slot] = { .LoadSerial = streamed.LoadSerial + 1 };
+		m_FreeSlots.push_back(slot);
+	}
+
+	void VulkanTextureStreamer::RequestMip(TextureHandle texture, uint32_t mipLevel)
+	{
+		StreamedTexture& streamed = m_Textures[GetSlot(texture)];
+		//The source's info is still being read
+		if (!streamed.bOpen)
+		{
+			return;
+		}
+		streamed.RequestedMip = std::min({ streamed.RequestedMip, mipLevel, streamed.Source->GetInfo().MipLevels - 1 });
+	}
+
+	uint32_t VulkanTextureStreamer::EstimateMip(uint32_t textureSize, float screenSize)
+	{
+		if (screenSize >= static_cast<float>(textureSize))
+		{
+			return 0;
+		}
+		if (screenSize < 1.0f)
+		{
+			return k_NoRequest;
+		}
+		return static_cast<uint32_t>(std::floor(std::log2(static_cast<float>(textureSize) / screenSize)));
+	}
+
+	void VulkanTextureStreamer::BeginFrame()
+	{
+		m_FrameCounter++;
+
+		std::vector<SourceOpen> opens;
+		{
+			std::lock_guard lock(m_CompletedMutex);
+			opens.swap(m_CompletedOpens);
+		}
+		for (const SourceOpen& open : opens)
+		{
+			//Unloaded while it was opening
+			if (m_Textures[open.Slot].Source && m_Textures[open.Slot].LoadSerial == open.Serial)
+			{
+				CreateStreamedTexture(open.Slot);
+			}
+		}
+
+		for (uint32_t slot = 0; slot < m_Textures.size(); slot++)
+		{
+			StreamedTexture& texture = m_Textures[slot];
+			if (!texture.Source || texture.RequestedMip == k_NoRequest)
+			{
+				continue;
+			}
+
+			m_ResidencyManager.Touch(texture.Residency);
+			if (texture.RequestedMip < texture.ResidentMip && !texture.bLoading && texture.ShrinkMip == k_NoRequest
+				&& m_FrameCounter >= texture.RetryFrame && m_PendingLoads < k_MaxPendingLoads)
+			{
+				//Until the tail is in, the only thing to load is the tail
+				ScheduleLoad(slot, texture.bReady ? texture.RequestedMip : texture.TailMip);
+			}
+			texture.RequestedMip = k_NoRequest;
+		}
+	}
+
+	void VulkanTextureStreamer::Record(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		{
+			std::lock_guard lock(m_CompletedMutex);
+			std::ranges::move(m_CompletedLoads, std::back_inserter(m_ReadyLoads));
+			m_CompletedLoads.clear();
+		}
+
+		//Shrink first, the memory it frees makes room for this frame's grows
+		for (uint32_t slot = 0; slot < m_Textures.size(); slot++)
+		{
+			StreamedTexture& texture = m_Textures[slot];
+			if (texture.Source && texture.ShrinkMip != k_NoRequest && Resize(commandBuffer, slot, texture.ShrinkMip, nullptr) == ResizeResult::Done)
+			{
+				texture.ShrinkMip = k_NoRequest;
+			}
+		}
+
+		std::vector<MipLoad> waitingLoads;
+		for (MipLoad& load : m_ReadyLoads)
+		{
+			StreamedTexture& texture = m_Textures[load.Slot];
+			if (!texture.Source || texture.LoadSerial != load.Serial)
+			{
+				//Unloaded or evicted while the read was in flight
+				m_PendingLoads--;
+				continue;
+			}
+			if (load.Mips.empty())
+			{
+				//Read failed, try again later
+				texture.bLoading = false;
+				texture.RetryFrame = m_FrameCounter + k_DeclinedRetryFrames;
+				m_PendingLoads--;
+				continue;
+			}
+
+			const ResizeResult result = load.bInitial ? UploadInitial(commandBuffer, load) : Resize(commandBuffer, load.Slot, load.FirstMip, &load);
+			if (result == ResizeResult::OutOfStaging && GetStagingSize(load.Mips) <= m_UploadContext.GetCapacity())
+			{
+				waitingLoads.push_back(std::move(load));
+				continue;
+			}
+			//Declined, or mips larger than the source claimed that no frame could ever stage
+			if (result != ResizeResult::Done)
+			{
+				texture.RetryFrame = m_FrameCounter + k_DeclinedRetryFrames;
+			}
+			texture.bLoading = false;
+			m_PendingLoads--;
+		}
+		m_ReadyLoads = std::move(waitingLoads);
+	}
+
+	uint32_t VulkanTextureStreamer::GetSlot(TextureHandle texture) const
+	{
+		const auto slotIt = m_SlotLookup.find(texture);
+		if (slotIt == m_SlotLookup.end())
+		{
+			throw std::runtime_error("Texture is not managed by the texture streamer!");
+		}
+		return slotIt->second;
+	}
+
+	void VulkanTextureStreamer::ScheduleLoad(uint32_t slot, uint32_t firstMip)
+	{
+		StreamedTexture& texture = m_Textures[slot];
+		if (texture.bReady)
+		{
+			//A load is staged within one frame, so grow only by as many mips as the ring holds and leave the rest to
+			//the loads of later frames. The tail is small enough to always fit
+			const TextureSourceInfo& info = texture.Source->GetInfo();
+			uint32_t loadMip = texture.ResidentMip;
+			vk::DeviceSize stagingSize = 0;
+			while (loadMip > firstMip)
+			{
+				const vk::DeviceSize size = AlignStaging(stagingSize) + GetMipSize(info.Format, info.Extent, loadMip - 1);
+				if (size > m_UploadContext.GetCapacity())
+				{
+					break;
+				}
+				stagingSize = size;
+				loadMip--;
+			}
+			if (loadMip == texture.ResidentMip)
+			{
+				//Not even the next mip fits, it can never be streamed in
+				return;
+			}
+			firstMip = loadMip;
+		}
+
+		texture.bLoading = true;
+		m_PendingLoads++;
+
+		MipLoad load{ .Slot = slot, .Serial = ++texture.LoadSerial, .FirstMip = firstMip, .bInitial = !texture.bReady };
+		const uint32_t mipCount = texture.ResidentMip - firstMip;
+		m_ThreadPool.Submit([this, source = texture.Source, load = std::move(load), mipCount]() mutable
+		{
+			load.Mips.resize(mipCount);
+			for (uint32_t i = 0; i < mipCount; i++)
+			{
+				if (!source->ReadMip(load.FirstMip + i, load.Mips[i]))
+				{
+					load.Mips.clear();
+					break;
+				}
+			}
+			std::lock_guard lock(m_CompletedMutex);
+			m_CompletedLoads.push_back(std::move(load));
+		});
+	}
+
+	vk::DeviceSize VulkanTextureStreamer::Evict(uint32_t slot)
+	{
+		StreamedTexture& texture = m_Textures[slot];
+		const vk::DeviceSize residentBytes = m_ResourcePool.GetMemorySize(texture.Texture);
+		if (texture.ResidentMip >= texture.TailMip || texture.ShrinkMip != k_NoRequest)
+		{
+			return residentBytes;
+		}
+
+		//Drop any grow still in flight, it would just undo the eviction
+		texture.LoadSerial++;
+		texture.bLoading = false;
+		texture.ShrinkMip = texture.TailMip;
+
+		//The actual size is only known after Record reallocates, report what the tail needs until then
+		const TextureSourceInfo& info = texture.Source->GetInfo();
+		vk::DeviceSize tailBytes = 0;
+		for (uint32_t mip = texture.TailMip; mip < info.MipLevels; mip++)
+		{
+			tailBytes += GetMipSize(info.Format, info.Extent, mip);
+		}
+		return std::min(tailBytes, residentBytes);
+	}
+
+	VulkanTextureStreamer::ResizeResult VulkanTextureStreamer::UploadInitial(const vk::raii::CommandBuffer& commandBuffer, const MipLoad& load)
+	{
+		StreamedTexture& texture = m_Textures[load.Slot];
+		vk::Buffer stagingBuffer;
+		std::vector<vk::BufferImageCopy> regions;
+		if (!StageLoad(load, load.FirstMip, stagingBuffer, regions))
+		{
+			return ResizeResult::OutOfStaging;
+		}
+
+		const vk::Image image = m_ResourcePool.GetImage(texture.Texture);
+		const uint32_t levelCount = m_ResourcePool.GetDesc(texture.Texture).MipLevels;
+		const std::array toTransfer = { ImageBarrier(image, levelCount, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+			vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone, vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite) };
+		PipelineBarrier(commandBuffer, toTransfer);
+
+		commandBuffer.copyBufferToImage(stagingBuffer, image, vk::ImageLayout::eTransferDstOptimal, regions);
+
+		const std::array toShader = { ImageBarrier(image, levelCount, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite, k_SampleStages, vk::AccessFlagBits2::eShaderSampledRead) };
+		PipelineBarrier(commandBuffer, toShader);
+		texture.ResidentMip = load.FirstMip;
+		texture.bReady = true;
+		return ResizeResult::Done;
+	}
+
+	VulkanTextureStreamer::ResizeResult VulkanTextureStreamer::Resize(const vk::raii::CommandBuffer& commandBuffer, uint32_t slot, uint32_t newFirstMip,
+		const MipLoad* load)
+	{
+		StreamedTexture& texture = m_Textures[slot];
+		if (newFirstMip == texture.ResidentMip)
+		{
+			return ResizeResult::Done;
+		}
+
+		vk::Buffer stagingBuffer;
+		std::vector<vk::BufferImageCopy> uploadRegions;
+		if (load && !StageLoad(*load, newFirstMip, stagingBuffer, uploadRegions))
+		{
+			return ResizeResult::OutOfStaging;
+		}
+
+		const TextureSourceInfo& info = texture.Source->GetInfo();
+		TextureDesc desc = m_ResourcePool.GetDesc(texture.Texture);
+		desc.Extent = GetMipExtent(info.Extent, newFirstMip);
+		desc.MipLevels = info.MipLevels - newFirstMip;
+		//Growing is a nice to have, shrinking has to go through since it is what frees memory
+		desc.bOptional = newFirstMip < texture.ResidentMip;
+		const TextureHandle resized = m_ResourcePool.CreateTexture(desc);
+		if (!resized.IsValid())
+		{
+			return ResizeResult::Declined;
+		}
+
+		const vk::Image oldImage = m_ResourcePool.GetImage(texture.Texture);
+		const vk::Image newImage = m_ResourcePool.GetImage(resized);
+		const uint32_t oldLevelCount = info.MipLevels - texture.ResidentMip;
+		const std::array toTransfer = {
+			ImageBarrier(oldImage, oldLevelCount, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferSrcOptimal,
+				k_SampleStages, vk::AccessFlagBits2::eNone, vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferRead),
+			ImageBarrier(newImage, desc.MipLevels, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+				vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone, vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite)
+		};
+		PipelineBarrier(commandBuffer, toTransfer);
+
+		//Levels resident in both images move over on the GPU, only the new ones come from staging
+		std::vector<vk::ImageCopy> copyRegions;
+		for (uint32_t mip = std::max(newFirstMip, texture.ResidentMip); mip < info.MipLevels; mip++)
+		{
+			copyRegions.push_back({
+				.srcSubresource = { vk::ImageAspectFlagBits::eColor, mip - texture.ResidentMip, 0, 1 },
+				.dstSubresource = { vk::ImageAspectFlagBits::eColor, mip - newFirstMip, 0, 1 },
+				.extent = GetMipExtent(info.Extent, mip)
+			});
+		}
+		commandBuffer.copyImage(oldImage, vk::ImageLayout::eTransferSrcOptimal, newImage, vk::ImageLayout::eTransferDstOptimal, copyRegions);
+		if (!uploadRegions.empty())
+		{
+			commandBuffer.copyBufferToImage(stagingBuffer, newImage, vk::ImageLayout::eTransferDstOptimal, uploadRegions);
+		}
+
+		const std::array toShader = { ImageBarrier(newImage, desc.MipLevels, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite, k_SampleStages, vk::AccessFlagBits2::eShaderSampledRead) };
+		PipelineBarrier(commandBuffer, toShader);
+
+		//The old image ends up behind the temporary handle and retires with this frame
+		m_ResourcePool.SwapTextures(texture.Texture, resized);
+		m_ResourcePool.DestroyTexture(resized);
+		texture.ResidentMip = newFirstMip;
+		m_ResidencyManager.SetResidentBytes(texture.Residency, m_ResourcePool.GetMemorySize(texture.Texture));
+		return ResizeResult::Done;
+	}
+
+	bool VulkanTextureStreamer::StageLoad(const MipLoad& load, uint32_t imageFirstMip, vk::Buffer& stagingBuffer, std::vector<vk::BufferImageCopy>& regions)
+	{
+		//All of the load goes into this frame or none of it, so don't start on mips the rest won't follow
+		if (GetStagingSize(load.Mips) > m_UploadContext.GetRemaining())
+		{
+			return false;
+		}
+
+		//One allocation per mip, like the mesh loader's sections. They all come out of this frame's ring buffer
+		const TextureSourceInfo& info = m_Textures[load.Slot].Source->GetInfo();
+		for (uint32_t i = 0; i < load.Mips.size(); i++)
+		{
+			const std::optional<VulkanStagingAllocation> staging = m_UploadContext.Allocate(load.Mips[i].size(), k_StagingAlignment);
+			if (!staging)
+			{
+				regions.clear();
+				return false;
+			}
+			std::memcpy(staging->Data, load.Mips[i].data(), load.Mips[i].size());
+			stagingBuffer = staging->Buffer;
+
+			const uint32_t mip = load.FirstMip + i;
+			regions.push_back({
+				.bufferOffset = staging->Offset,
+				.imageSubresource = { vk::ImageAspectFlagBits::eColor, mip - imageFirstMip, 0, 1 },
+				.imageExtent = GetMipExtent(info.Extent, mip)
+			});
+		}
+		return true;
+	}
+}
@@ -0,0 +1,337 @@
+#include <VulkanTransientPool.h>
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <stdexcept>
+
+namespace VRE
+{
+	//Blocks are at least this big so a handful of them covers a frame, bigger images get a block of their own size
+	constexpr vk::DeviceSize k_TransientBlockSize = 64ull * 1024 * 1024;
+	//Frames an image or block may go unused before it is released, resizing the window shouldn't thrash them
+	constexpr uint32_t k_MaxUnusedFrames = 8;
+	constexpr vk::ImageUsageFlags k_AttachmentUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment
+		| vk::ImageUsageFlagBits::eInputAttachment | vk::ImageUsageFlagBits::eTransientAttachment;
+
+	static vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static void CombineHash(size_t& hash, uint64_t value)
+	{
+		hash ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	}
+
+	static vk::ImageCreateInfo GetImageInfo(const VulkanTransientImageDesc& desc)
+	{
+		return {
+			.imageType = vk::ImageType::e2D,
+			.format = desc.Format,
+			.extent = { desc.Extent.width, desc.Extent.height, 1 },
+			.mipLevels = desc.MipLevels,
+			.arrayLayers = desc.ArrayLayers,
+			.samples = vk::SampleCountFlagBits::e1,
+			.tiling = vk::ImageTiling::eOptimal,
+			.usage = desc.Usage,
+			.sharingMode = vk::SharingMode::eExclusive,
+			.initialLayout = vk::ImageLayout::eUndefined
+		};
+	}
+
+	size_t VulkanTransientPool::DescHash::operator()(const VulkanTransientImageDesc& desc) const
+	{
+		size_t hash = std::hash<uint32_t>{}(desc.Extent.width);
+		CombineHash(hash, desc.Extent.height);
+		CombineHash(hash, static_cast<uint64_t>(desc.Format));
+		CombineHash(hash, static_cast<VkImageUsageFlags>(desc.Usage));
+		CombineHash(hash, static_cast<VkImageAspectFlags>(desc.Aspect));
+		CombineHash(hash, desc.MipLevels);
+		CombineHash(hash, desc.ArrayLayers);
+		return hash;
+	}
+
+	size_t VulkanTransientPool::ImageKeyHash::operator()(const ImageKey& key) const
+	{
+		size_t hash = DescHash{}(key.Desc);
+		CombineHash(hash, key.Block);
+		CombineHash(hash, key.Offset);
+		return hash;
+	}
+
+	VulkanTransientPool::VulkanTransientPool(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+		VulkanDeletionQueue& deletionQueue, VulkanMemoryBudget& memoryBudget, VulkanResidencyManager& residencyManager)
+		: m_Device(device), m_DeletionQueue(deletionQueue), m_MemoryBudget(memoryBudget), m_ResidencyManager(residencyManager),
+		m_MemoryProperties(physicalDevice.getMemoryProperties())
+	{
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+		{
+			if (m_MemoryProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated)
+			{
+				m_LazyMemoryTypeBits |= 1u << i;
+			}
+		}
+	}
+
+	VulkanTransientPool::~VulkanTransientPool()
+	{
+		for (const auto& [key, image] : m_Images)
+		{
+			m_DeletionQueue.Enqueue(image.View);
+			m_DeletionQueue.Enqueue(image.Image);
+		}
+		for (Block& block : m_Blocks)
+		{
+			ReleaseBlock(block);
+		}
+	}
+
+	uint32_t VulkanTransientPool::Request(const VulkanTransientImageDesc& desc, uint32_t firstPass, uint32_t lastPass)
+	{
+		assert(firstPass <= lastPass);
+		ImageRequest& request = m_Requests.emplace_back(ImageRequest{ .Desc = desc, .FirstPass = firstPass, .LastPass = lastPass });
+		//Nothing but attachment access means the contents never leave the tile memory
+		request.bLazy = m_LazyMemoryTypeBits && !(desc.Usage & ~k_AttachmentUsage);
+		if (request.bLazy)
+		{
+			request.Desc.Usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+		}
+		request.Requirements = GetRequirements(request.Desc);
+		request.bLazy = request.bLazy && (request.Requirements.memoryTypeBits & m_LazyMemoryTypeBits);
+		return static_cast<uint32_t>(m_Requests.size() - 1);
+	}
+
+	void VulkanTransientPool::Allocate()
+	{
+		//Largest first packs best; stable, so an unchanged frame lands on the same placements and cached images
+		std::vector<uint32_t> order(m_Requests.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(),
+			[&](uint32_t a, uint32_t b) { return m_Requests[a].Requirements.size > m_Requests[b].Requirements.size; });
+
+		m_RequestedSize = 0;
+		for (uint32_t index : order)
+		{
+			if (!m_Requests[index].bLazy)
+			{
+				m_RequestedSize += m_Requests[index].Requirements.size;
+			}
+			bool bPlaced = false;
+			for (uint32_t block = 0; block < m_Blocks.size() && !bPlaced; block++)
+			{
+				bPlaced = Place(block, index);
+			}
+			if (!bPlaced)
+			{
+				bPlaced = Place(AllocateBlock(m_Requests[index]), index);
+				assert(bPlaced);
+			}
+		}
+
+		for (uint32_t index = 0; index < m_Requests.size(); index++)
+		{
+			ImageRequest& request = m_Requests[index];
+			const Block& block = m_Blocks[request.Block];
+			const CachedImage& image = GetImage({ .Desc = request.Desc, .Block = request.Block, .Offset = request.Offset });
+			request.Image.Image = image.Image;
+			request.Image.View = image.View;
+			request.Image.PreviousStages = block.Stages;
+			for (uint32_t other : block.Requests)
+			{
+				const ImageRequest& previous = m_Requests[other];
+				if (previous.LastPass < request.FirstPass && previous.Offset < request.Offset + request.Requirements.size
+					&& request.Offset < previous.Offset + previous.Requirements.size)
+				{
+					request.Image.Aliases.push_back(other);
+				}
+			}
+		}
+	}
+
+	void VulkanTransientPool::SetUsedStages(uint32_t request, vk::PipelineStageFlags2 stages)
+	{
+		m_Blocks[m_Requests[request].Block].NextStages |= stages;
+	}
+
+	void VulkanTransientPool::EndFrame()
+	{
+		for (Block& block : m_Blocks)
+		{
+			if (!block.Memory)
+			{
+				continue;
+			}
+			//An unused block keeps the stages of the last frame that used it, the next user still has to wait for them
+			if (block.Requests.empty())
+			{
+				block.UnusedFrames++;
+			}
+			else
+			{
+				block.UnusedFrames = 0;
+				block.Stages = block.NextStages;
+			}
+			block.NextStages = {};
+			block.Requests.clear();
+		}
+		for (auto image = m_Images.begin(); image != m_Images.end();)
+		{
+			if (++image->second.UnusedFrames > k_MaxUnusedFrames || m_Blocks[image->first.Block].UnusedFrames > k_MaxUnusedFrames)
+			{
+				m_DeletionQueue.Enqueue(image->second.View);
+				m_DeletionQueue.Enqueue(image->second.Image);
+				image = m_Images.erase(image);
+			}
+			else
+			{
+				++image;
+			}
+		}
+		for (Block& block : m_Blocks)
+		{
+			if (block.Memory && block.UnusedFrames > k_MaxUnusedFrames)
+			{
+				ReleaseBlock(block);
+			}
+		}
+		m_Requests.clear();
+	}
+
+	vk::MemoryRequirements VulkanTransientPool::GetRequirements(const VulkanTransientImageDesc& desc)
+	{
+		const auto cached = m_Requirements.find(desc);
+		if (cached != m_Requirements.end())
+		{
+			return cached->second;
+		}
+		const vk::ImageCreateInfo imageInfo = GetImageInfo(desc);
+		const vk::MemoryRequirements requirements = m_Device.getImageMemoryRequirements(vk::DeviceImageMemoryRequirements{ .pCreateInfo = &imageInfo })
+			.memoryRequirements;
+		m_Requirements.emplace(desc, requirements);
+		return requirements;
+	}
+
+	bool VulkanTransientPool::Place(uint32_t blockIndex, uint32_t requestIndex)
+	{
+		Block& block = m_Blocks[blockIndex];
+		ImageRequest& request = m_Requests[requestIndex];
+		if (!block.Memory || block.bLazy != request.bLazy || !(request.Requirements.memoryTypeBits & (1u << block.MemoryType)))
+		{
+			return false;
+		}
+
+		//Memory taken by requests alive at the same time, everything else in the block is free to alias
+		std::vector<std::pair<vk::DeviceSize, vk::DeviceSize>> taken;
+		for (uint32_t other : block.Requests)
+		{
+			const ImageRequest& placed = m_Requests[other];
+			if (placed.FirstPass <= request.LastPass && request.FirstPass <= placed.LastPass)
+			{
+				taken.push_back({ placed.Offset, placed.Offset + placed.Requirements.size });
+			}
+		}
+		std::sort(taken.begin(), taken.end());
+
+		vk::DeviceSize offset = 0;
+		for (const auto& [begin, end] : taken)
+		{
+			if (AlignUp(offset, request.Requirements.alignment) + request.Requirements.size <= begin)
+			{
+				break;
+			}
+			offset = std::max(offset, end);
+		}
+		offset = AlignUp(offset, request.Requirements.alignment);
+		if (offset + request.Requirements.size > block.Size)
+		{
+			return false;
+		}
+		request.Block = blockIndex;
+		request.Offset = offset;
+		block.Requests.push_back(requestIndex);
+		return true;
+	}
+
+	uint32_t VulkanTransientPool::AllocateBlock(const ImageRequest& request)
+	{
+		const uint32_t typeBits = request.bLazy ? request.Requirements.memoryTypeBits & m_LazyMemoryTypeBits : request.Requirements.memoryTypeBits;
+		const vk::MemoryPropertyFlags properties = request.bLazy
+			? vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated : vk::MemoryPropertyFlagBits::eDeviceLocal;
+		uint32_t memoryType = UINT32_MAX;
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount && memoryType == UINT32_MAX; i++)
+		{
+			if ((typeBits & (1u << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				memoryType = i;
+			}
+		}
+		if (memoryType == UINT32_MAX)
+		{
+			throw std::runtime_error("failed to find a memory type for transient images!");
+		}
+
+		//Lazily allocated blocks are sized for the image they were made for and commit next to nothing anyway
+		const vk::DeviceSize size = request.bLazy ? request.Requirements.size : std::max(k_TransientBlockSize, request.Requirements.size);
+		if (!request.bLazy)
+		{
+			m_ResidencyManager.MakeRoom(m_MemoryBudget.GetHeapIndex(memoryType), size);
+		}
+		const vk::MemoryAllocateInfo allocInfo{ .allocationSize = size, .memoryTypeIndex = memoryType };
+		Block block{ .Memory = (*m_Device).allocateMemory(allocInfo, nullptr, *m_Device.getDispatcher()), .MemoryType = memoryType, .Size = size,
+			.bLazy = request.bLazy };
+		if (!request.bLazy)
+		{
+			m_MemoryBudget.OnAllocate(memoryType, size);
+			m_MemorySize += size;
+		}
+
+		const auto slot = std::find_if(m_Blocks.begin(), m_Blocks.end(), [](const Block& candidate) { return !candidate.Memory; });
+		if (slot != m_Blocks.end())
+		{
+			*slot = std::move(block);
+			return static_cast<uint32_t>(slot - m_Blocks.begin());
+		}
+		m_Blocks.push_back(std::move(block));
+		return static_cast<uint32_t>(m_Blocks.size() - 1);
+	}
+
+	void VulkanTransientPool::ReleaseBlock(Block& block)
+	{
+		if (!block.Memory)
+		{
+			return;
+		}
+		if (!block.bLazy)
+		{
+			m_MemoryBudget.OnFree(block.MemoryType, block.Size);
+			m_MemorySize -= block.Size;
+		}
+		m_DeletionQueue.Enqueue(block.Memory);
+		block = Block{};
+	}
+
+	const VulkanTransientPool::CachedImage& VulkanTransientPool::GetImage(const ImageKey& key)
+	{
+		auto [cached, bInserted] = m_Images.try_emplace(key);
+		CachedImage& image = cached->second;
+		image.UnusedFrames = 0;
+		if (!bInserted)
+		{
+			return image;
+		}
+
+		const auto& dispatcher = *m_Device.getDispatcher();
+		vk::Device device = *m_Device;
+		image.Image = device.createImage(GetImageInfo(key.Desc), nullptr, dispatcher);
+		device.bindImageMemory(image.Image, m_Blocks[key.Block].Memory, key.Offset, dispatcher);
+
+		vk::ImageViewCreateInfo viewInfo{
+			.image = image.Image,
+			.viewType = key.Desc.ArrayLayers > 1 ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D,
+			.format = key.Desc.Format,
+			.subresourceRange = { key.Desc.Aspect, 0, key.Desc.MipLevels, 0, key.Desc.ArrayLayers }
+		};
+		image.View = device.createImageView(viewInfo, nullptr, dispatcher);
+		return image;
+	}
+}
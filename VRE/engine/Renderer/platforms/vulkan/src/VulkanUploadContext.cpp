@@ -0,0 +1,62 @@
+#include <VulkanUploadContext.h>
+#include <VulkanCommon.h>
+
+namespace VRE
+{
+	constexpr vk::DeviceSize k_StagingRingSize = 32 * 1024 * 1024;
+
+	VulkanUploadContext::VulkanUploadContext(VulkanResourcePool& resourcePool)
+		: m_ResourcePool(resourcePool)
+	{
+		m_StagingBuffers.reserve(k_MaxFramesInFlight);
+		for (uint32_t i = 0; i < k_MaxFramesInFlight; i++)
+		{
+			m_StagingBuffers.push_back(m_ResourcePool.CreateBuffer({
+				.Size = k_StagingRingSize,
+				.Usage = vk::BufferUsageFlagBits::eTransferSrc,
+				.MemoryProperties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			}));
+		}
+	}
+
+	VulkanUploadContext::~VulkanUploadContext()
+	{
+		for (BufferHandle stagingBuffer : m_StagingBuffers)
+		{
+			m_ResourcePool.DestroyBuffer(stagingBuffer);
+		}
+	}
+
+	void VulkanUploadContext::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		m_Head = 0;
+	}
+
+	std::optional<VulkanStagingAllocation> VulkanUploadContext::Allocate(vk::DeviceSize size, vk::DeviceSize alignment)
+	{
+		const vk::DeviceSize offset = (m_Head + alignment - 1) & ~(alignment - 1);
+		if (offset + size > k_StagingRingSize)
+		{
+			return std::nullopt;
+		}
+		m_Head = offset + size;
+
+		const BufferHandle stagingBuffer = m_StagingBuffers[m_FrameIndex];
+		return VulkanStagingAllocation{
+			.Buffer = m_ResourcePool.GetBuffer(stagingBuffer),
+			.Offset = offset,
+			.Data = static_cast<std::byte*>(m_ResourcePool.GetMappedData(stagingBuffer)) + offset
+		};
+	}
+
+	vk::DeviceSize VulkanUploadContext::GetRemaining() const
+	{
+		return k_StagingRingSize - m_Head;
+	}
+
+	vk::DeviceSize VulkanUploadContext::GetCapacity() const
+	{
+		return k_StagingRingSize;
+	}
+}
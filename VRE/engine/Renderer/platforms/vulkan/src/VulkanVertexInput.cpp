@@ -0,0 +1,78 @@
+#include <VulkanVertexInput.h>
+#include <cstddef>
+
+namespace VRE
+{
+	vk::PipelineVertexInputStateCreateInfo VulkanVertexInputState::GetCreateInfo() const
+	{
+		return {
+			.vertexBindingDescriptionCount = static_cast<uint32_t>(Bindings.size()),
+			.pVertexBindingDescriptions = Bindings.data(),
+			.vertexAttributeDescriptionCount = static_cast<uint32_t>(Attributes.size()),
+			.pVertexAttributeDescriptions = Attributes.data()
+		};
+	}
+
+	VulkanVertexStrides GetMeshVertexStrides(MeshVertexLayout layout, MeshVertexFormat format)
+	{
+		const bool bQuantized = format == MeshVertexFormat::Quantized;
+		if (layout == MeshVertexLayout::Interleaved)
+		{
+			return { .PositionStride = static_cast<uint32_t>(bQuantized ? sizeof(MeshVertexQuantized) : sizeof(MeshVertex)) };
+		}
+		return {
+			.PositionStride = static_cast<uint32_t>(bQuantized ? sizeof(MeshPositionQuantized) : sizeof(float) * 3),
+			.AttributeStride = static_cast<uint32_t>(bQuantized ? sizeof(MeshVertexAttributesQuantized) : sizeof(MeshVertexAttributes))
+		};
+	}
+
+	VulkanVertexInputState GetMeshVertexInputState(MeshVertexLayout layout, MeshVertexFormat format)
+	{
+		VulkanVertexInputState state;
+		const bool bQuantized = format == MeshVertexFormat::Quantized;
+		const vk::Format positionFormat = bQuantized ? vk::Format::eR16G16B16A16Unorm : vk::Format::eR32G32B32Sfloat;
+		const vk::Format normalFormat = bQuantized ? vk::Format::eR16G16Snorm : vk::Format::eR32G32B32Sfloat;
+		const vk::Format texCoordFormat = bQuantized ? vk::Format::eR16G16Sfloat : vk::Format::eR32G32Sfloat;
+		const VulkanVertexStrides strides = GetMeshVertexStrides(layout, format);
+
+		if (layout == MeshVertexLayout::Interleaved)
+		{
+			state.Bindings = { { .binding = 0, .stride = strides.PositionStride, .inputRate = vk::VertexInputRate::eVertex } };
+			state.Attributes = {
+				{ .location = k_PositionLocation, .binding = 0, .format = positionFormat,
+					.offset = static_cast<uint32_t>(bQuantized ? offsetof(MeshVertexQuantized, Position) : offsetof(MeshVertex, Position)) },
+				{ .location = k_NormalLocation, .binding = 0, .format = normalFormat,
+					.offset = static_cast<uint32_t>(bQuantized ? offsetof(MeshVertexQuantized, Normal) : offsetof(MeshVertex, Normal)) },
+				{ .location = k_TexCoordLocation, .binding = 0, .format = texCoordFormat,
+					.offset = static_cast<uint32_t>(bQuantized ? offsetof(MeshVertexQuantized, TexCoord) : offsetof(MeshVertex, TexCoord)) }
+			};
+			return state;
+		}
+
+		state.Bindings = {
+			{ .binding = 0, .stride = strides.PositionStride, .inputRate = vk::VertexInputRate::eVertex },
+			{ .binding = 1, .stride = strides.AttributeStride, .inputRate = vk::VertexInputRate::eVertex }
+		};
+		state.Attributes = {
+			{ .location = k_PositionLocation, .binding = 0, .format = positionFormat, .offset = 0 },
+			{ .location = k_NormalLocation, .binding = 1, .format = normalFormat,
+				.offset = static_cast<uint32_t>(bQuantized ? offsetof(MeshVertexAttributesQuantized, Normal) : offsetof(MeshVertexAttributes, Normal)) },
+			{ .location = k_TexCoordLocation, .binding = 1, .format = texCoordFormat,
+				.offset = static_cast<uint32_t>(bQuantized ? offsetof(MeshVertexAttributesQuantized, TexCoord) : offsetof(MeshVertexAttributes, TexCoord)) }
+		};
+		return state;
+	}
+
+	VulkanVertexFetch GetMeshVertexFetch(MeshVertexLayout layout, MeshVertexFormat format, vk::DeviceSize attributeStreamOffset)
+	{
+		const bool bQuantized = format == MeshVertexFormat::Quantized;
+		if (layout == MeshVertexLayout::Streamed)
+		{
+			return { .Flags = k_VertexFetchStreamed | (bQuantized ? k_VertexFetchQuantized : 0), .AttributeOffset = static_cast<uint32_t>(attributeStreamOffset) };
+		}
+		return {
+			.Flags = bQuantized ? k_VertexFetchQuantized : 0,
+			.AttributeOffset = static_cast<uint32_t>(bQuantized ? offsetof(MeshVertexQuantized, Normal) : offsetof(MeshVertex, Normal))
+		};
+	}
+}
@@ -0,0 +1,442 @@
+#include <VulkanVirtualTexture.h>
+#include <VulkanCommon.h>
+#include <VulkanFormats.h>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+
+namespace VRE
+{
+	constexpr uint32_t k_MaxPagesInFlight = 64;
+	constexpr uint32_t k_MaxPageUploadsPerFrame = 32;
+	constexpr vk::DeviceSize k_StagingAlignment = 16;
+
+	VulkanVirtualTexture::VulkanVirtualTexture(VulkanResourcePool& resourcePool, VulkanUploadContext& uploadContext, ThreadPool& threadPool,
+		const VirtualTextureDesc& desc, std::shared_ptr<VulkanVirtualTextureSource> source)
+		: m_ResourcePool(resourcePool), m_UploadContext(uploadContext), m_ThreadPool(threadPool), m_Desc(desc), m_Source(std::move(source))
+	{
+		const uint32_t pagesX = m_Desc.VirtualExtent.width / m_Desc.PageSize;
+		const uint32_t pagesY = m_Desc.VirtualExtent.height / m_Desc.PageSize;
+		if (pagesX == 0 || pagesY == 0 || !std::has_single_bit(pagesX) || !std::has_single_bit(pagesY) || std::max(pagesX, pagesY) > 0x3FFF)
+		{
+			throw std::runtime_error("Virtual texture extent must be a power of two multiple of the page size!");
+		}
+		if (m_Desc.AtlasPagesPerSide == 0 || m_Desc.AtlasPagesPerSide > 255)
+		{
+			throw std::runtime_error("Virtual texture atlas must be between 1 and 255 pages per side!");
+		}
+		m_MipCount = std::bit_width(std::max(pagesX, pagesY));
+		m_TileSize = m_Desc.PageSize + 2 * m_Desc.PageBorder;
+		m_TileBytes = GetMipSize(m_Desc.Format, { m_TileSize, m_TileSize, 1 }, 0);
+
+		const uint32_t atlasSize = m_TileSize * m_Desc.AtlasPagesPerSide;
+		m_Atlas = m_ResourcePool.CreateTexture({
+			.Extent = { atlasSize, atlasSize, 1 },
+			.Format = m_Desc.Format,
+			.Usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst
+		});
+		m_PageTable = m_ResourcePool.CreateTexture({
+			.Extent = { pagesX, pagesY, 1 },
+			.Format = vk::Format::eR8G8B8A8Uint,
+			.MipLevels = m_MipCount,
+			.Usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst
+		});
+		m_FeedbackTarget = m_ResourcePool.CreateTexture({
+			.Extent = { m_Desc.FeedbackExtent.width, m_Desc.FeedbackExtent.height, 1 },
+			.Format = GetFeedbackFormat(),
+			.Usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc
+		});
+		for (uint32_t i = 0; i < k_MaxFramesInFlight; i++)
+		{
+			m_FeedbackReadback.push_back(m_ResourcePool.CreateBuffer({
+				.Size = vk::DeviceSize(m_Desc.FeedbackExtent.width) * m_Desc.FeedbackExtent.height * sizeof(uint32_t),
+				.Usage = vk::BufferUsageFlagBits::eTransferDst,
+				.MemoryProperties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			}));
+		}
+		m_FeedbackWritten.resize(k_MaxFramesInFlight, false);
+
+		vk::DeviceSize pageTableSize = 0;
+		for (uint32_t mip = 0; mip < m_MipCount; mip++)
+		{
+			m_PageTableMipOffsets.push_back(pageTableSize);
+			const vk::Extent2D pageCount = GetPageCount(mip);
+			pageTableSize += vk::DeviceSize(pageCount.width) * pageCount.height;
+		}
+		m_PageTableData.resize(pageTableSize, 0);
+
+		const uint32_t slotCount = m_Desc.AtlasPagesPerSide * m_Desc.AtlasPagesPerSide;
+		m_SlotPages.resize(slotCount, k_InvalidPage);
+		m_SlotLastUsed.resize(slotCount, 0);
+		//Slot 0 is reserved for the coarsest mip, hand out the rest lowest first
+		for (uint32_t slot = slotCount - 1; slot > m_LockedSlot; slot--)
+		{
+			m_FreeSlots.push_back(slot);
+		}
+
+		PageLoad rootPage{ .Page = PackPage(m_MipCount - 1, 0, 0) };
+		if (!m_Source->ReadPage(m_MipCount - 1, 0, 0, rootPage.Data))
+		{
+			throw std::runtime_error("Failed to read the root page of a virtual texture!");
+		}
+		m_InFlight.insert(rootPage.Page);
+		m_ReadyLoads.push_back(std::move(rootPage));
+	}
+
+	VulkanVirtualTexture::~VulkanVirtualTexture()
+	{
+		m_ThreadPool.WaitIdle();
+		for (BufferHandle readback : m_FeedbackReadback)
+		{
+			m_ResourcePool.DestroyBuffer(readback);
+		}
+		m_ResourcePool.DestroyTexture(m_FeedbackTarget);
+		m_ResourcePool.DestroyTexture(m_PageTable);
+		m_ResourcePool.DestroyTexture(m_Atlas);
+	}
+
+	void VulkanVirtualTexture::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		m_FrameCounter++;
+		if (!m_FeedbackWritten[frameIndex])
+		{
+			return;
+		}
+		m_FeedbackWritten[frameIndex] = false;
+
+		const uint32_t* feedback = static_cast<const uint32_t*>(m_ResourcePool.GetMappedData(m_FeedbackReadback[frameIndex]));
+		const size_t feedbackCount = size_t(m_Desc.FeedbackExtent.width) * m_Desc.FeedbackExtent.height;
+		std::vector<uint32_t> pages;
+		pages.reserve(feedbackCount);
+		std::copy_if(feedback, feedback + feedbackCount, std::back_inserter(pages), [this](uint32_t page) {
+			return page != k_InvalidPage && GetPageMip(page) < m_MipCount;
+		});
+
+		//The mip sits in the top bits, so descending order loads coarse pages before the fine ones they fall back to
+		std::ranges::sort(pages, std::greater<>());
+		pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+		for (uint32_t page : pages)
+		{
+			const auto slotIt = m_PageToSlot.find(page);
+			if (slotIt != m_PageToSlot.end())
+			{
+				m_SlotLastUsed[slotIt->second] = m_FrameCounter;
+			}
+			else
+			{
+				RequestPage(page);
+			}
+		}
+	}
+
+	void VulkanVirtualTexture::Record(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		{
+			std::lock_guard lock(m_CompletedMutex);
+			std::ranges::move(m_CompletedLoads, std::back_inserter(m_ReadyLoads));
+			m_CompletedLoads.clear();
+		}
+		if (m_ReadyLoads.empty() && !m_bPageTableDirty)
+		{
+			return;
+		}
+
+		//Reserve the page table first, pages must never land in the atlas without the table pointing at them
+		const vk::DeviceSize pageTableBytes = m_PageTableData.size() * sizeof(uint32_t);
+		const std::optional<VulkanStagingAllocation> pageTableStaging = m_UploadContext.Allocate(pageTableBytes, k_StagingAlignment);
+		if (!pageTableStaging)
+		{
+			return;
+		}
+
+		const uint32_t rootPage = PackPage(m_MipCount - 1, 0, 0);
+		std::vector<vk::BufferImageCopy> atlasCopies;
+		vk::Buffer atlasStagingBuffer;
+		std::vector<PageLoad> waitingLoads;
+		for (PageLoad& load : m_ReadyLoads)
+		{
+			if (load.Data.empty())
+			{
+				m_InFlight.erase(load.Page);
+				continue;
+			}
+			if (atlasCopies.size() >= k_MaxPageUploadsPerFrame)
+			{
+				waitingLoads.push_back(std::move(load));
+				continue;
+			}
+			const std::optional<VulkanStagingAllocation> staging = m_UploadContext.Allocate(m_TileBytes, k_StagingAlignment);
+			if (!staging)
+			{
+				waitingLoads.push_back(std::move(load));
+				continue;
+			}
+
+			m_InFlight.erase(load.Page);
+			const uint32_t slot = load.Page == rootPage ? m_LockedSlot : AcquireSlot();
+			if (slot == k_InvalidPage)
+			{
+				//Every page is needed this frame, feedback asks for it again once something frees up
+				continue;
+			}
+
+			std::memcpy(staging->Data, load.Data.data(), std::min<size_t>(load.Data.size(), m_TileBytes));
+			atlasStagingBuffer = staging->Buffer;
+			atlasCopies.push_back({
+				.bufferOffset = staging->Offset,
+				.imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+				.imageOffset = { int32_t(slot % m_Desc.AtlasPagesPerSide * m_TileSize), int32_t(slot / m_Desc.AtlasPagesPerSide * m_TileSize), 0 },
+				.imageExtent = { m_TileSize, m_TileSize, 1 }
+			});
+			m_SlotPages[slot] = load.Page;
+			m_SlotLastUsed[slot] = m_FrameCounter;
+			m_PageToSlot[load.Page] = slot;
+			m_bPageTableDirty = true;
+		}
+		m_ReadyLoads = std::move(waitingLoads);
+
+		if (!m_bPageTableDirty)
+		{
+			return;
+		}
+		RebuildPageTable();
+		std::memcpy(pageTableStaging->Data, m_PageTableData.data(), pageTableBytes);
+		std::vector<vk::BufferImageCopy> pageTableCopies;
+		for (uint32_t mip = 0; mip < m_MipCount; mip++)
+		{
+			const vk::Extent2D pageCount = GetPageCount(mip);
+			pageTableCopies.push_back({
+				.bufferOffset = pageTableStaging->Offset + m_PageTableMipOffsets[mip] * sizeof(uint32_t),
+				.imageSubresource = { vk::ImageAspectFlagBits::eColor, mip, 0, 1 },
+				.imageExtent = { pageCount.width, pageCount.height, 1 }
+			});
+		}
+
+		//Previous frames may still sample both images, the barriers wait for them before anything is overwritten
+		const vk::Image atlas = m_ResourcePool.GetImage(m_Atlas);
+		const vk::Image pageTable = m_ResourcePool.GetImage(m_PageTable);
+		const vk::ImageSubresourceRange atlasRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+		const vk::ImageSubresourceRange pageTableRange = { vk::ImageAspectFlagBits::eColor, 0, m_MipCount, 0, 1 };
+		std::vector<vk::ImageMemoryBarrier2> toTransfer = { {
+			.srcStageMask = vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eComputeShader,
+			.dstStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.oldLayout = m_bPageTableInitialized ? vk::ImageLayout::eShaderReadOnlyOptimal : vk::ImageLayout::eUndefined,
+			.newLayout = vk::ImageLayout::eTransferDstOptimal,
+			.image = pageTable,
+			.subresourceRange = pageTableRange
+		} };
+		if (!atlasCopies.empty())
+		{
+			toTransfer.push_back({
+				.srcStageMask = vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eComputeShader,
+				.dstStageMask = vk::PipelineStageFlagBits2::eCopy,
+				.dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+				.oldLayout = m_bAtlasInitialized ? vk::ImageLayout::eShaderReadOnlyOptimal : vk::ImageLayout::eUndefined,
+				.newLayout = vk::ImageLayout::eTransferDstOptimal,
+				.image = atlas,
+				.subresourceRange = atlasRange
+			});
+		}
+		commandBuffer.pipelineBarrier2({ .imageMemoryBarrierCount = static_cast<uint32_t>(toTransfer.size()), .pImageMemoryBarriers = toTransfer.data() });
+
+		commandBuffer.copyBufferToImage(pageTableStaging->Buffer, pageTable, vk::ImageLayout::eTransferDstOptimal, pageTableCopies);
+		if (!atlasCopies.empty())
+		{
+			commandBuffer.copyBufferToImage(atlasStagingBuffer, atlas, vk::ImageLayout::eTransferDstOptimal, atlasCopies);
+		}
+
+		std::vector<vk::ImageMemoryBarrier2> toShader;
+		for (const auto& barrier : toTransfer)
+		{
+			toShader.push_back({
+				.srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+				.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+				.dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eComputeShader,
+				.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead,
+				.oldLayout = vk::ImageLayout::eTransferDstOptimal,
+				.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+				.image = barrier.image,
+				.subresourceRange = barrier.subresourceRange
+			});
+		}
+		commandBuffer.pipelineBarrier2({ .imageMemoryBarrierCount = static_cast<uint32_t>(toShader.size()), .pImageMemoryBarriers = toShader.data() });
+
+		m_bPageTableInitialized = true;
+		m_bAtlasInitialized = m_bAtlasInitialized || !atlasCopies.empty();
+		m_bPageTableDirty = false;
+	}
+
+	void VulkanVirtualTexture::RecordFeedbackPass(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		if (!m_FeedbackCallback)
+		{
+			return;
+		}
+		BeginFeedbackPass(commandBuffer);
+		m_FeedbackCallback(commandBuffer);
+		EndFeedbackPass(commandBuffer);
+	}
+
+	void VulkanVirtualTexture::BeginFeedbackPass(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		//Last frame's readback copy only read the target, an execution dependency is enough before clearing it
+		const vk::ImageMemoryBarrier2 toAttachment{
+			.srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.dstStageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+			.dstAccessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
+			.oldLayout = vk::ImageLayout::eUndefined,
+			.newLayout = vk::ImageLayout::eColorAttachmentOptimal,
+			.image = m_ResourcePool.GetImage(m_FeedbackTarget),
+			.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+		};
+		commandBuffer.pipelineBarrier2({ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toAttachment });
+
+		vk::RenderingAttachmentInfo attachmentInfo{
+			.imageView = m_ResourcePool.GetImageView(m_FeedbackTarget),
+			.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+			.loadOp = vk::AttachmentLoadOp::eClear,
+			.storeOp = vk::AttachmentStoreOp::eStore,
+			.clearValue = vk::ClearColorValue{ .uint32 = std::array<uint32_t, 4>{ k_InvalidPage, k_InvalidPage, k_InvalidPage, k_InvalidPage } }
+		};
+		const vk::RenderingInfo renderingInfo{
+			.renderArea = { .offset = { 0, 0 }, .extent = m_Desc.FeedbackExtent },
+			.layerCount = 1,
+			.colorAttachmentCount = 1,
+			.pColorAttachments = &attachmentInfo
+		};
+		commandBuffer.beginRendering(renderingInfo);
+		commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(m_Desc.FeedbackExtent.width), static_cast<float>(m_Desc.FeedbackExtent.height), 0.0f, 1.0f));
+		commandBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), m_Desc.FeedbackExtent));
+	}
+
+	void VulkanVirtualTexture::EndFeedbackPass(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		commandBuffer.endRendering();
+
+		const vk::Image feedbackImage = m_ResourcePool.GetImage(m_FeedbackTarget);
+		const vk::ImageMemoryBarrier2 toTransfer{
+			.srcStageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+			.srcAccessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferRead,
+			.oldLayout = vk::ImageLayout::eColorAttachmentOptimal,
+			.newLayout = vk::ImageLayout::eTransferSrcOptimal,
+			.image = feedbackImage,
+			.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+		};
+		commandBuffer.pipelineBarrier2({ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toTransfer });
+
+		const vk::BufferImageCopy region{
+			.imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+			.imageExtent = { m_Desc.FeedbackExtent.width, m_Desc.FeedbackExtent.height, 1 }
+		};
+		const vk::Buffer readback = m_ResourcePool.GetBuffer(m_FeedbackReadback[m_FrameIndex]);
+		commandBuffer.copyImageToBuffer(feedbackImage, vk::ImageLayout::eTransferSrcOptimal, readback, region);
+
+		const vk::BufferMemoryBarrier2 toHost{
+			.srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eHost,
+			.dstAccessMask = vk::AccessFlagBits2::eHostRead,
+			.buffer = readback,
+			.offset = 0,
+			.size = vk::WholeSize
+		};
+		commandBuffer.pipelineBarrier2({ .bufferMemoryBarrierCount = 1, .pBufferMemoryBarriers = &toHost });
+		m_FeedbackWritten[m_FrameIndex] = true;
+	}
+
+	void VulkanVirtualTexture::RequestPage(uint32_t page)
+	{
+		if (m_InFlight.size() >= k_MaxPagesInFlight || !m_InFlight.insert(page).second)
+		{
+			return;
+		}
+		m_ThreadPool.Submit([this, source = m_Source, page]()
+		{
+			PageLoad load{ .Page = page };
+			if (!source->ReadPage(GetPageMip(page), GetPageX(page), GetPageY(page), load.Data))
+			{
+				load.Data.clear();
+			}
+			std::lock_guard lock(m_CompletedMutex);
+			m_CompletedLoads.push_back(std::move(load));
+		});
+	}
+
+	uint32_t VulkanVirtualTexture::AcquireSlot()
+	{
+		if (!m_FreeSlots.empty())
+		{
+			const uint32_t slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+			return slot;
+		}
+
+		uint32_t oldestSlot = k_InvalidPage;
+		for (uint32_t slot = 0; slot < m_SlotPages.size(); slot++)
+		{
+			if (slot != m_LockedSlot && m_SlotLastUsed[slot] < m_FrameCounter
+				&& (oldestSlot == k_InvalidPage || m_SlotLastUsed[slot] < m_SlotLastUsed[oldestSlot]))
+			{
+				oldestSlot = slot;
+			}
+		}
+		if (oldestSlot != k_InvalidPage)
+		{
+			m_PageToSlot.erase(m_SlotPages[oldestSlot]);
+			m_SlotPages[oldestSlot] = k_InvalidPage;
+		}
+		return oldestSlot;
+	}
+
+	void VulkanVirtualTexture::RebuildPageTable()
+	{
+		//Coarse to fine, so a missing page can inherit its parent's entry with the resident bit cleared
+		for (uint32_t mip = m_MipCount; mip-- > 0;)
+		{
+			const vk::Extent2D pageCount = GetPageCount(mip);
+			uint32_t* entries = m_PageTableData.data() + m_PageTableMipOffsets[mip];
+			const bool bHasParent = mip + 1 < m_MipCount;
+			const vk::Extent2D parentCount = bHasParent ? GetPageCount(mip + 1) : vk::Extent2D{ 1, 1 };
+			const uint32_t* parentEntries = bHasParent ? m_PageTableData.data() + m_PageTableMipOffsets[mip + 1] : nullptr;
+
+			for (uint32_t y = 0; y < pageCount.height; y++)
+			{
+				for (uint32_t x = 0; x < pageCount.width; x++)
+				{
+					uint32_t& entry = entries[y * pageCount.width + x];
+					const auto slotIt = m_PageToSlot.find(PackPage(mip, x, y));
+					if (slotIt != m_PageToSlot.end())
+					{
+						const uint32_t slot = slotIt->second;
+						entry = (slot % m_Desc.AtlasPagesPerSide) | ((slot / m_Desc.AtlasPagesPerSide) << 8) | (mip << 16) | (0xFFu << 24);
+					}
+					else if (bHasParent)
+					{
+						const uint32_t parentX = std::min(x / 2, parentCount.width - 1);
+						const uint32_t parentY = std::min(y / 2, parentCount.height - 1);
+						entry = parentEntries[parentY * parentCount.width + parentX] & 0x00FFFFFFu;
+					}
+					else
+					{
+						//Root page not uploaded yet, point at its reserved slot anyway
+						entry = (m_LockedSlot % m_Desc.AtlasPagesPerSide) | ((m_LockedSlot / m_Desc.AtlasPagesPerSide) << 8) | (mip << 16);
+					}
+				}
+			}
+		}
+	}
+
+	vk::Extent2D VulkanVirtualTexture::GetPageCount(uint32_t mipLevel) const
+	{
+		const uint32_t pagesX = m_Desc.VirtualExtent.width / m_Desc.PageSize;
+		const uint32_t pagesY = m_Desc.VirtualExtent.height / m_Desc.PageSize;
+		return { std::max(1u, pagesX >> mipLevel), std::max(1u, pagesY >> mipLevel) };
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <ThreadPool.h>
+
+namespace VRE
+{
+	//Size that reads from the offset to the end of the file
+	constexpr uint64_t k_ReadWholeFile = ~0ull;
+
+	enum class IOPriority : uint8_t
+	{
+		High = 0,
+		Normal = 1,
+		Low = 2
+	};
+
+	struct FileReadResult
+	{
+		//Short only when the file ends first
+		uint64_t BytesRead = 0;
+		//Holds the data when the request had no destination
+		std::vector<std::byte> Data;
+		//errno value, 0 on success
+		int Error = 0;
+		bool bCancelled = false;
+
+		bool IsSuccess() const { return Error == 0 && !bCancelled; }
+	};
+
+	struct FileReadRequest
+	{
+		std::string Path;
+		uint64_t Offset = 0;
+		uint64_t Size = k_ReadWholeFile;
+		//Caller owned memory of at least Size bytes, e.g. mapped staging memory; has to stay valid until completion
+		std::byte* Destination = nullptr;
+		IOPriority Priority = IOPriority::Normal;
+		//Runs on an I/O thread: keep it short, hand heavy work to a ThreadPool and never wait on another read in it
+		std::function<void(FileReadResult&)> OnComplete;
+	};
+
+	// Asynchronous file reads. On Linux requests go through an io_uring driven by one service thread, which keeps up
+	// to k_QueueDepth reads in flight and picks the next request by priority; elsewhere, or when the kernel refuses
+	// io_uring, a small thread pool does blocking preads in the same order. Callers never block: completion comes
+	// through a callback or a future, and requests can be cancelled until they complete.
+	class AsyncFileIO
+	{
+		public:
+			using RequestId = uint64_t;
+			static constexpr uint32_t k_QueueDepth = 64;
+
+		public:
+			AsyncFileIO(uint32_t fallbackThreadCount = 2);
+			//Cancels everything still queued and waits for reads in flight
+			~AsyncFileIO();
+
+			AsyncFileIO(const AsyncFileIO&) = delete;
+			AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+			RequestId Read(FileReadRequest request);
+			//Queues every request under one lock and one wake up
+			std::vector<RequestId> ReadBatch(std::vector<FileReadRequest> requests);
+			//OnComplete still runs, right before the future becomes ready
+			std::future<FileReadResult> ReadAsync(FileReadRequest request);
+
+			//Queued requests complete as cancelled right away, reads in flight are aborted where possible and complete as
+			//cancelled either way. False if the request already completed.
+			bool Cancel(RequestId id);
+			//Blocks until every request has completed, not for the main or render thread
+			void WaitIdle();
+
+			bool IsUsingIoUring() const { return m_Ring != nullptr; }
+
+		private:
+			struct Request
+			{
+				RequestId Id = 0;
+				FileReadRequest Desc;
+				FileReadResult Result;
+				std::byte* Buffer = nullptr;
+				uint64_t Size = 0;
+				uint64_t Done = 0;
+				int File = -1;
+				std::atomic<bool> bCancelRequested = false;
+			};
+
+			//Defined only when io_uring is available
+			struct IoUring;
+
+			RequestId Enqueue(FileReadRequest&& request);
+			void Wake();
+			std::shared_ptr<Request> PopPending();
+			//Opens the file and sets up the destination, false if the request already failed
+			bool Prepare(Request& request);
+			void Complete(const std::shared_ptr<Request>& request);
+
+			void RingLoop();
+			void SubmitRead(Request& request);
+			void RunFallbackRead();
+
+		private:
+			std::mutex m_Mutex;
+			std::condition_variable m_Idle;
+			std::array<std::deque<std::shared_ptr<Request>>, 3> m_Pending;
+			//Everything not yet completed, pending or in flight
+			std::unordered_map<RequestId, std::shared_ptr<Request>> m_Active;
+			std::vector<RequestId> m_CancelQueue;
+			RequestId m_NextId = 1;
+			bool m_bStopping = false;
+
+			std::unique_ptr<IoUring> m_Ring;
+			std::thread m_RingThread;
+			//Owned by the ring thread
+			std::unordered_map<RequestId, std::shared_ptr<Request>> m_InFlight;
+
+			std::unique_ptr<ThreadPool> m_FallbackPool;
+	};
+}
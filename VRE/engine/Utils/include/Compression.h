@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace VRE
+{
+	enum class CompressionCodec : uint8_t
+	{
+		None = 0,
+		//In tree LZ4 block format, fast to decode
+		Lz4 = 1,
+		//Smaller output, only available with VRE_ENABLE_ZSTD
+		Zstd = 2
+	};
+
+	bool IsCodecAvailable(CompressionCodec codec);
+	//Worst case compressed size of size bytes
+	size_t GetCompressBound(CompressionCodec codec, size_t size);
+	//Appends the compressed data to output, returns the number of bytes appended or 0 on failure
+	size_t Compress(CompressionCodec codec, std::span<const std::byte> input, std::vector<std::byte>& output);
+	//The decompressed size has to be known up front, it is stored next to the data everywhere we compress
+	bool Decompress(CompressionCodec codec, std::span<const std::byte> input, std::span<std::byte> output);
+}
@@ -1,6 +1,10 @@
 #pragma once
-#include <fstream>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <vector>
+#include <AsyncFileIO.h>
+#include <VirtualFileSystem.h>
 
 namespace VRE
 {
@@ -8,8 +12,16 @@ namespace VRE
 	class FileReader
 	{
 		public:
+			//Shared I/O service, asset loading should go through it directly instead of the blocking helpers below
+			static AsyncFileIO& GetAsyncIO();
+			//Shared file system on top of GetAsyncIO(), nothing is mounted until the application does it
+			static VirtualFileSystem& GetFileSystem();
+
+			//Blocking wrappers around GetAsyncIO() for startup and worker threads, never call them from an I/O callback
 			static std::vector<char> ReadShaderFile(const std::string& fileName);
+			static std::vector<std::byte> ReadFile(const std::string& fileName);
+			//Reads size bytes at offset, false if the file is missing or too short. Safe to call from several threads.
+			static bool ReadFileRange(const std::string& fileName, uint64_t offset, uint64_t size, std::vector<std::byte>& data);
 	};
 
 }
-
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace VRE
+{
+	//64-bit MurmurHash2 (MurmurHash64A), for content hashes; not meant to resist deliberate collisions
+	uint64_t HashBytes(std::span<const std::byte> data, uint64_t seed = 0);
+
+	inline uint64_t HashString(std::string_view text, uint64_t seed = 0)
+	{
+		return HashBytes(std::as_bytes(std::span(text.data(), text.size())), seed);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace VRE
+{
+	// Parsed JSON document. Objects keep their members in file order and are searched linearly, which beats hashing
+	// for the handful of keys a typical object has; big collections in formats like glTF are arrays anyway.
+	class JsonValue
+	{
+		public:
+			enum class Type : uint8_t
+			{
+				Null,
+				Bool,
+				Number,
+				String,
+				Array,
+				Object
+			};
+
+			using Array = std::vector<JsonValue>;
+			using Object = std::vector<std::pair<std::string, JsonValue>>;
+
+		public:
+			JsonValue() = default;
+
+			//Strict RFC 8259, throws std::runtime_error with the byte offset of the first error
+			static JsonValue Parse(std::string_view text);
+
+			Type GetType() const { return static_cast<Type>(m_Value.index()); }
+			bool IsNull() const { return GetType() == Type::Null; }
+			bool IsNumber() const { return GetType() == Type::Number; }
+			bool IsString() const { return GetType() == Type::String; }
+			bool IsArray() const { return GetType() == Type::Array; }
+			bool IsObject() const { return GetType() == Type::Object; }
+
+			//Throw when the value has a different type
+			bool AsBool() const;
+			double AsNumber() const;
+			const std::string& AsString() const;
+			const Array& AsArray() const;
+			const Object& AsObject() const;
+
+			//nullptr when this isn't an object or has no such member
+			const JsonValue* Find(std::string_view key) const;
+			//A null value when the member is missing, so optional members chain without checks
+			const JsonValue& operator[](std::string_view key) const;
+			size_t GetSize() const;
+
+			//Defaults apply to missing members only, a member of the wrong type still throws
+			double GetNumber(std::string_view key, double defaultValue) const;
+			//Throws unless the member is a whole number in [0, 2^32)
+			uint32_t GetIndex(std::string_view key, uint32_t defaultValue) const;
+			std::string_view GetString(std::string_view key, std::string_view defaultValue = {}) const;
+			bool GetBool(std::string_view key, bool defaultValue) const;
+
+		private:
+			friend class JsonParser;
+
+			std::variant<std::monostate, bool, double, std::string, Array, Object> m_Value;
+	};
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace VRE
+{
+	// Read only memory mapping of a whole file. Pages are faulted in on first touch, so slicing a mapping costs
+	// nothing until the bytes are actually read.
+	class MappedFile
+	{
+		public:
+			//nullptr if the file can't be opened or mapped
+			static std::shared_ptr<MappedFile> Open(const std::string& path);
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			std::span<const std::byte> GetBytes() const { return { static_cast<const std::byte*>(m_Data), m_Size }; }
+			size_t GetSize() const { return m_Size; }
+
+		private:
+			MappedFile() = default;
+
+		private:
+			const void* m_Data = nullptr;
+			size_t m_Size = 0;
+#ifdef _WIN32
+			void* m_File = nullptr;
+			void* m_Mapping = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Compression.h>
+#include <MappedFile.h>
+#include <ThreadPool.h>
+
+namespace VRE
+{
+	// On disk layout: header, file data, then the chunk table, the file index sorted by path hash and the path
+	// strings. Every file is split into ChunkSize pieces compressed independently, so a read only decompresses the
+	// chunks it needs and chunks of one file decompress in parallel. Chunks that don't shrink are stored raw. File
+	// data starts 16 byte aligned.
+	constexpr uint32_t k_PakMagic = 0x4B415056; // "VPAK"
+	constexpr uint32_t k_PakVersion = 1;
+
+	struct PakHeader
+	{
+		uint32_t Magic = k_PakMagic;
+		uint32_t Version = k_PakVersion;
+		uint32_t FileCount = 0;
+		uint32_t ChunkCount = 0;
+		uint32_t ChunkSize = 0;
+		uint32_t Reserved = 0;
+		uint64_t ChunkTableOffset = 0;
+		uint64_t FileIndexOffset = 0;
+		uint64_t NamesOffset = 0;
+		uint64_t NamesSize = 0;
+	};
+
+	struct PakChunk
+	{
+		uint64_t Offset = 0;
+		uint32_t CompressedSize = 0;
+		uint32_t Size = 0;
+		CompressionCodec Codec = CompressionCodec::None;
+		uint8_t Padding[7] = {};
+	};
+
+	struct PakFileEntry
+	{
+		uint64_t PathHash = 0;
+		uint64_t Size = 0;
+		uint32_t FirstChunk = 0;
+		uint32_t ChunkCount = 0;
+		uint32_t NameOffset = 0;
+		uint32_t NameLength = 0;
+	};
+
+	static_assert(sizeof(PakHeader) == 56 && sizeof(PakChunk) == 24 && sizeof(PakFileEntry) == 32, "Pak structures are read straight from disk");
+
+	//FNV-1a over the normalized path
+	uint64_t HashPakPath(std::string_view path);
+
+	// Read side of a pak, the whole archive stays memory mapped. Lookups are a binary search over the path hashes.
+	class PakArchive
+	{
+		public:
+			//nullptr if the file is missing or not a valid pak
+			static std::shared_ptr<PakArchive> Open(const std::string& path);
+
+			//Expects a path normalized like VirtualFileSystem::NormalizePath does
+			const PakFileEntry* Find(std::string_view path) const;
+			std::string_view GetName(const PakFileEntry& entry) const;
+			std::span<const PakFileEntry> GetFiles() const { return m_Files; }
+			uint32_t GetChunkSize() const { return m_Header.ChunkSize; }
+
+			//Chunk i of a file holds its bytes from i * GetChunkSize()
+			std::span<const PakChunk> GetChunks(const PakFileEntry& entry) const { return m_Chunks.subspan(entry.FirstChunk, entry.ChunkCount); }
+			//Compressed bytes of a chunk as stored in the mapping
+			std::span<const std::byte> GetChunkData(const PakChunk& chunk) const { return m_Mapping->GetBytes().subspan(chunk.Offset, chunk.CompressedSize); }
+
+			//Files whose chunks are all raw can be handed out as slices of the mapping without copying
+			bool IsStored(const PakFileEntry& entry) const;
+			std::span<const std::byte> GetStoredBytes(const PakFileEntry& entry) const;
+
+			//Decompresses one chunk of entry into its place in fileBytes, which holds the whole file
+			bool ReadChunk(const PakFileEntry& entry, uint32_t chunkIndex, std::span<std::byte> fileBytes) const;
+			bool ReadFile(const PakFileEntry& entry, std::span<std::byte> fileBytes) const;
+			//Decompresses only the chunks holding the file's bytes from offset on, e.g. to read a header
+			bool ReadRange(const PakFileEntry& entry, uint64_t offset, std::span<std::byte> bytes) const;
+
+			const std::shared_ptr<MappedFile>& GetMapping() const { return m_Mapping; }
+
+		private:
+			std::shared_ptr<MappedFile> m_Mapping;
+			PakHeader m_Header;
+			std::span<const PakChunk> m_Chunks;
+			std::span<const PakFileEntry> m_Files;
+			std::string_view m_Names;
+	};
+
+	// Builds pak archives, used by the asset cooker
+	class PakWriter
+	{
+		public:
+			//Files up to rawFileSize are always stored raw so they can be mapped without a copy
+			PakWriter(CompressionCodec codec = CompressionCodec::Lz4, uint32_t chunkSize = 64 * 1024, uint64_t rawFileSize = 16 * 1024);
+
+			void AddFile(std::string_view path, std::vector<std::byte> data);
+			//Compresses chunks on threadPool when given
+			bool Write(const std::string& outputPath, ThreadPool* threadPool = nullptr) const;
+
+		private:
+			struct File
+			{
+				std::string Path;
+				std::vector<std::byte> Data;
+			};
+
+		private:
+			CompressionCodec m_Codec;
+			uint32_t m_ChunkSize;
+			uint64_t m_RawFileSize;
+			std::vector<File> m_Files;
+	};
+}
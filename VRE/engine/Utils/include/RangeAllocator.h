@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+
+namespace VRE
+{
+	// Suballocates a linear range, e.g. a buffer many meshes share, in whatever unit the caller counts in. Allocations
+	// take the smallest free range they fit in and freed ranges merge with their free neighbours right away, so the
+	// free list only holds real holes plus the tail.
+	class RangeAllocator
+	{
+		public:
+			explicit RangeAllocator(uint64_t capacity = 0);
+
+			//Empty when no free range is big enough
+			std::optional<uint64_t> Allocate(uint64_t size);
+			//The lowest free range that fits and ends at or below limit, for compaction
+			std::optional<uint64_t> AllocateBelow(uint64_t size, uint64_t limit);
+			void Free(uint64_t offset, uint64_t size);
+			//Adds the space between the old and the new capacity as free
+			void Grow(uint64_t capacity);
+
+			uint64_t GetCapacity() const { return m_Capacity; }
+			uint64_t GetFreeSize() const { return m_FreeSize; }
+			uint64_t GetLargestFreeRange() const { return m_BySize.empty() ? 0 : m_BySize.rbegin()->first; }
+			size_t GetFreeRangeCount() const { return m_ByOffset.size(); }
+
+		private:
+			void Take(std::map<uint64_t, uint64_t>::iterator range, uint64_t offset, uint64_t size);
+			void Insert(uint64_t offset, uint64_t size);
+			void Erase(std::map<uint64_t, uint64_t>::iterator range);
+
+		private:
+			uint64_t m_Capacity = 0;
+			uint64_t m_FreeSize = 0;
+			//Free ranges by offset for merging, and by (size, offset) for best fit
+			std::map<uint64_t, uint64_t> m_ByOffset;
+			std::set<std::pair<uint64_t, uint64_t>> m_BySize;
+	};
+}
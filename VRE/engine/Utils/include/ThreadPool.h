@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VRE
+{
+	// Fixed set of worker threads pulling tasks from one FIFO queue. Meant for blocking work like file reads and
+	// decompression that must stay off the render thread; tasks report back through their own synchronization.
+	class ThreadPool
+	{
+		public:
+			ThreadPool(uint32_t threadCount = GetDefaultThreadCount());
+			~ThreadPool();
+
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator=(const ThreadPool&) = delete;
+
+			void Submit(std::function<void()> task);
+			//Blocks until the queue is empty and no task is running
+			void WaitIdle();
+
+			uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+			static uint32_t GetDefaultThreadCount();
+
+		private:
+			void WorkerLoop();
+
+		private:
+			std::vector<std::thread> m_Workers;
+			std::deque<std::function<void()>> m_Tasks;
+			std::mutex m_Mutex;
+			std::condition_variable m_TaskAvailable;
+			std::condition_variable m_Idle;
+			uint32_t m_ActiveTasks = 0;
+			bool m_bStopping = false;
+	};
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <AsyncFileIO.h>
+#include <PakArchive.h>
+#include <ThreadPool.h>
+
+namespace VRE
+{
+	// Contents of a file read through the VirtualFileSystem. Blocking reads of loose files and raw files inside a pak
+	// are memory mapped and keep the mapping alive for as long as they live, everything else owns its bytes.
+	class FileData
+	{
+		public:
+			FileData() = default;
+			explicit FileData(std::vector<std::byte> data) : m_Data(std::move(data)) {}
+			FileData(std::shared_ptr<MappedFile> mapping, std::span<const std::byte> bytes) : m_Mapping(std::move(mapping)), m_Bytes(bytes) {}
+
+			FileData(FileData&&) = default;
+			FileData& operator=(FileData&&) = default;
+			FileData(const FileData&) = delete;
+			FileData& operator=(const FileData&) = delete;
+
+			std::span<const std::byte> GetBytes() const { return m_Mapping ? m_Bytes : std::span<const std::byte>(m_Data); }
+			size_t GetSize() const { return GetBytes().size(); }
+			bool IsMapped() const { return m_Mapping != nullptr; }
+
+		private:
+			std::shared_ptr<MappedFile> m_Mapping;
+			std::span<const std::byte> m_Bytes;
+			std::vector<std::byte> m_Data;
+	};
+
+	// One namespace over loose directories and pak archives. Sources are mounted under a mount point; a lookup walks
+	// them from the highest priority down, the most recent mount first among equal priorities, so a patch pak or a
+	// loose override directory shadows the shipped data. Raw pak files are returned as zero copy slices of the
+	// mapping, compressed ones decompress chunk by chunk on the worker pool and loose files go through AsyncFileIO.
+	// A path no mount resolves falls back to the OS path, relative to the working directory, so nothing has to be
+	// mounted to load loose files.
+	class VirtualFileSystem
+	{
+		public:
+			struct PakFileRef
+			{
+				std::shared_ptr<PakArchive> Pak;
+				const PakFileEntry* Entry = nullptr;
+			};
+
+			//Runs on an I/O thread, a worker or inline in ReadFileAsync; nullopt if the file is missing or unreadable
+			using ReadCallback = std::function<void(std::optional<FileData>)>;
+
+		public:
+			VirtualFileSystem(AsyncFileIO& asyncIO, uint32_t workerCount = ThreadPool::GetDefaultThreadCount());
+
+			VirtualFileSystem(const VirtualFileSystem&) = delete;
+			VirtualFileSystem& operator=(const VirtualFileSystem&) = delete;
+
+			//source is a directory or a .pak file, false if it is neither
+			bool Mount(const std::string& source, std::string_view mountPoint = "", int32_t priority = 0);
+			//Reads already started keep the archive alive until they complete
+			bool Unmount(const std::string& source);
+
+			bool Exists(std::string_view path) const;
+			std::optional<uint64_t> GetFileSize(std::string_view path) const;
+			//Set when path resolves into a pak, lets uploads hand its compressed chunks to the GPU decompressor
+			std::optional<PakFileRef> FindPakFile(std::string_view path) const;
+
+			//Blocking, for startup and worker threads
+			std::optional<FileData> ReadFile(std::string_view path) const;
+			void ReadFileAsync(std::string_view path, ReadCallback callback, IOPriority priority = IOPriority::Normal);
+
+			//Forward slashes, no leading "./" or "/", "." and ".." segments folded, ".." never leaves the root
+			static std::string NormalizePath(std::string_view path);
+
+		private:
+			struct MountedSource
+			{
+				std::string Source;
+				std::string MountPoint;
+				int32_t Priority = 0;
+				std::shared_ptr<PakArchive> Pak;
+				std::filesystem::path Directory;
+			};
+
+			struct ResolvedFile
+			{
+				std::shared_ptr<PakArchive> Pak;
+				const PakFileEntry* Entry = nullptr;
+				std::string LoosePath;
+				uint64_t Size = 0;
+			};
+
+			std::optional<ResolvedFile> Resolve(std::string_view path) const;
+
+		private:
+			AsyncFileIO& m_AsyncIO;
+			ThreadPool m_Workers;
+			mutable std::shared_mutex m_Mutex;
+			//Kept in lookup order
+			std::vector<MountedSource> m_Mounts;
+	};
+}
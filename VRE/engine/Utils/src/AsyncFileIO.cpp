@@ -0,0 +1,618 @@
+#include <AsyncFileIO.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define VRE_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define VRE_HAS_PREAD 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VRE
+{
+	//Single reads are capped so huge requests don't hog the disk ahead of higher priority ones
+	constexpr uint64_t k_MaxReadChunk = 8ull << 20;
+
+#ifdef VRE_HAS_IO_URING
+	//user_data values that never collide with request ids, which count up from 1
+	constexpr uint64_t k_WakeTag = ~0ull;
+	constexpr uint64_t k_CancelTag = ~0ull - 1;
+
+	// Minimal io_uring set up through the raw syscalls so there is no liburing dependency. Only the ring thread
+	// touches the queues, so the tails it owns need no atomics; the shared indices use acquire/release.
+	struct AsyncFileIO::IoUring
+	{
+		int Fd = -1;
+		//Written to whenever new work arrives, a poll on it wakes the ring thread out of io_uring_enter
+		int WakeFd = -1;
+
+		void* SqRing = MAP_FAILED;
+		size_t SqRingSize = 0;
+		void* CqRing = MAP_FAILED;
+		size_t CqRingSize = 0;
+		io_uring_sqe* Sqes = nullptr;
+		size_t SqesSize = 0;
+
+		unsigned* SqHead = nullptr;
+		unsigned* SqTail = nullptr;
+		unsigned* SqArray = nullptr;
+		unsigned SqMask = 0;
+		unsigned SqEntries = 0;
+		unsigned* CqHead = nullptr;
+		unsigned* CqTail = nullptr;
+		io_uring_cqe* Cqes = nullptr;
+		unsigned CqMask = 0;
+
+		unsigned LocalTail = 0;
+		unsigned ToSubmit = 0;
+
+		~IoUring()
+		{
+			if (Sqes)
+			{
+				munmap(Sqes, SqesSize);
+			}
+			if (CqRing != MAP_FAILED && CqRing != SqRing)
+			{
+				munmap(CqRing, CqRingSize);
+			}
+			if (SqRing != MAP_FAILED)
+			{
+				munmap(SqRing, SqRingSize);
+			}
+			if (WakeFd >= 0)
+			{
+				close(WakeFd);
+			}
+			if (Fd >= 0)
+			{
+				close(Fd);
+			}
+		}
+
+		//nullptr when io_uring is missing, disabled or too old for IORING_OP_READ
+		static std::unique_ptr<IoUring> Create(unsigned entries)
+		{
+			io_uring_params params{};
+			const int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+			if (fd < 0)
+			{
+				return nullptr;
+			}
+			auto ring = std::make_unique<IoUring>();
+			ring->Fd = fd;
+			//Same kernel release (5.6) as IORING_OP_READ, which has no feature bit of its own
+			if (!(params.features & IORING_FEAT_RW_CUR_POS))
+			{
+				return nullptr;
+			}
+
+			ring->SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			ring->CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			const bool bSingleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+			if (bSingleMmap)
+			{
+				ring->SqRingSize = ring->CqRingSize = std::max(ring->SqRingSize, ring->CqRingSize);
+			}
+			ring->SqRing = mmap(nullptr, ring->SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+			if (ring->SqRing == MAP_FAILED)
+			{
+				return nullptr;
+			}
+			ring->CqRing = bSingleMmap ? ring->SqRing : mmap(nullptr, ring->CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+			if (ring->CqRing == MAP_FAILED)
+			{
+				return nullptr;
+			}
+			ring->SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			void* sqes = mmap(nullptr, ring->SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+			if (sqes == MAP_FAILED)
+			{
+				return nullptr;
+			}
+			ring->Sqes = static_cast<io_uring_sqe*>(sqes);
+
+			std::byte* sq = static_cast<std::byte*>(ring->SqRing);
+			ring->SqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+			ring->SqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+			ring->SqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+			ring->SqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+			ring->SqEntries = params.sq_entries;
+			ring->LocalTail = *ring->SqTail;
+			std::byte* cq = static_cast<std::byte*>(ring->CqRing);
+			ring->CqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+			ring->CqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+			ring->Cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+			ring->CqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+
+			ring->WakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+			if (ring->WakeFd < 0)
+			{
+				return nullptr;
+			}
+			return ring;
+		}
+
+		//nullptr when the submission queue is full
+		io_uring_sqe* GetSqe()
+		{
+			const unsigned head = std::atomic_ref(*SqHead).load(std::memory_order_acquire);
+			if (LocalTail - head >= SqEntries)
+			{
+				return nullptr;
+			}
+			const unsigned index = LocalTail & SqMask;
+			SqArray[index] = index;
+			LocalTail++;
+			ToSubmit++;
+			io_uring_sqe* sqe = &Sqes[index];
+			std::memset(sqe, 0, sizeof(io_uring_sqe));
+			return sqe;
+		}
+
+		void ArmWakePoll()
+		{
+			if (io_uring_sqe* sqe = GetSqe())
+			{
+				sqe->opcode = IORING_OP_POLL_ADD;
+				sqe->fd = WakeFd;
+				sqe->poll32_events = POLLIN;
+				sqe->user_data = k_WakeTag;
+			}
+		}
+
+		//Submits everything queued and blocks until at least minComplete completions are ready
+		void Enter(unsigned minComplete)
+		{
+			std::atomic_ref(*SqTail).store(LocalTail, std::memory_order_release);
+			while (true)
+			{
+				const long submitted = syscall(__NR_io_uring_enter, Fd, ToSubmit, minComplete, IORING_ENTER_GETEVENTS, nullptr, 0);
+				if (submitted >= 0)
+				{
+					ToSubmit -= static_cast<unsigned>(submitted);
+					return;
+				}
+				//EBUSY means the completion queue is full, reaping makes room
+				if (errno != EINTR)
+				{
+					return;
+				}
+			}
+		}
+
+		template<typename Callback> void Reap(Callback&& callback)
+		{
+			unsigned head = *CqHead;
+			const unsigned tail = std::atomic_ref(*CqTail).load(std::memory_order_acquire);
+			for (; head != tail; head++)
+			{
+				const io_uring_cqe& cqe = Cqes[head & CqMask];
+				callback(cqe.user_data, cqe.res);
+			}
+			std::atomic_ref(*CqHead).store(head, std::memory_order_release);
+		}
+	};
+#else
+	struct AsyncFileIO::IoUring
+	{
+	};
+#endif
+
+	AsyncFileIO::AsyncFileIO(uint32_t fallbackThreadCount)
+	{
+#ifdef VRE_HAS_IO_URING
+		//Room for a read and a cancel per request in flight plus the wake poll
+		m_Ring = IoUring::Create(k_QueueDepth * 4);
+#endif
+		if (m_Ring)
+		{
+			m_RingThread = std::thread(&AsyncFileIO::RingLoop, this);
+		}
+		else
+		{
+			m_FallbackPool = std::make_unique<ThreadPool>(std::max(1u, fallbackThreadCount));
+		}
+	}
+
+	AsyncFileIO::~AsyncFileIO()
+	{
+		std::vector<std::shared_ptr<Request>> cancelled;
+		{
+			std::lock_guard lock(m_Mutex);
+			m_bStopping = true;
+			for (auto& queue : m_Pending)
+			{
+				std::ranges::move(queue, std::back_inserter(cancelled));
+				queue.clear();
+			}
+			for (auto& [id, request] : m_Active)
+			{
+				request->bCancelRequested = true;
+				m_CancelQueue.push_back(id);
+			}
+		}
+		for (const auto& request : cancelled)
+		{
+			Complete(request);
+		}
+
+		if (m_Ring)
+		{
+			Wake();
+			m_RingThread.join();
+		}
+		m_FallbackPool.reset();
+	}
+
+	AsyncFileIO::RequestId AsyncFileIO::Read(FileReadRequest request)
+	{
+		RequestId id;
+		{
+			std::lock_guard lock(m_Mutex);
+			id = Enqueue(std::move(request));
+		}
+		Wake();
+		return id;
+	}
+
+	std::vector<AsyncFileIO::RequestId> AsyncFileIO::ReadBatch(std::vector<FileReadRequest> requests)
+	{
+		std::vector<RequestId> ids;
+		ids.reserve(requests.size());
+		{
+			std::lock_guard lock(m_Mutex);
+			for (FileReadRequest& request : requests)
+			{
+				ids.push_back(Enqueue(std::move(request)));
+			}
+		}
+		if (m_Ring)
+		{
+			Wake();
+		}
+		else
+		{
+			for (size_t i = 0; i < ids.size(); i++)
+			{
+				Wake();
+			}
+		}
+		return ids;
+	}
+
+	std::future<FileReadResult> AsyncFileIO::ReadAsync(FileReadRequest request)
+	{
+		auto promise = std::make_shared<std::promise<FileReadResult>>();
+		std::future<FileReadResult> future = promise->get_future();
+		request.OnComplete = [onComplete = std::move(request.OnComplete), promise](FileReadResult& result)
+		{
+			if (onComplete)
+			{
+				onComplete(result);
+			}
+			promise->set_value(std::move(result));
+		};
+		Read(std::move(request));
+		return future;
+	}
+
+	bool AsyncFileIO::Cancel(RequestId id)
+	{
+		std::shared_ptr<Request> request;
+		{
+			std::lock_guard lock(m_Mutex);
+			const auto activeIt = m_Active.find(id);
+			if (activeIt == m_Active.end())
+			{
+				return false;
+			}
+			activeIt->second->bCancelRequested = true;
+
+			auto& queue = m_Pending[static_cast<size_t>(activeIt->second->Desc.Priority)];
+			const auto pendingIt = std::ranges::find(queue, activeIt->second);
+			if (pendingIt == queue.end())
+			{
+				//Already in flight, the ring thread aborts it; the fallback checks the flag between chunks
+				if (m_Ring)
+				{
+					m_CancelQueue.push_back(id);
+				}
+			}
+			else
+			{
+				request = std::move(*pendingIt);
+				queue.erase(pendingIt);
+			}
+		}
+
+		if (request)
+		{
+			Complete(request);
+		}
+		else if (m_Ring)
+		{
+			Wake();
+		}
+		return true;
+	}
+
+	void AsyncFileIO::WaitIdle()
+	{
+		std::unique_lock lock(m_Mutex);
+		m_Idle.wait(lock, [this] { return m_Active.empty(); });
+	}
+
+	AsyncFileIO::RequestId AsyncFileIO::Enqueue(FileReadRequest&& request)
+	{
+		auto pending = std::make_shared<Request>();
+		pending->Id = m_NextId++;
+		pending->Desc = std::move(request);
+		m_Pending[static_cast<size_t>(pending->Desc.Priority)].push_back(pending);
+		m_Active.emplace(pending->Id, pending);
+		return pending->Id;
+	}
+
+	void AsyncFileIO::Wake()
+	{
+#ifdef VRE_HAS_IO_URING
+		if (m_Ring)
+		{
+			const uint64_t value = 1;
+			[[maybe_unused]] const ssize_t written = write(m_Ring->WakeFd, &value, sizeof(value));
+			return;
+		}
+#endif
+		//One task per request, each runs whatever has the highest priority by the time it starts
+		m_FallbackPool->Submit([this] { RunFallbackRead(); });
+	}
+
+	std::shared_ptr<AsyncFileIO::Request> AsyncFileIO::PopPending()
+	{
+		std::lock_guard lock(m_Mutex);
+		for (auto& queue : m_Pending)
+		{
+			if (!queue.empty())
+			{
+				std::shared_ptr<Request> request = std::move(queue.front());
+				queue.pop_front();
+				return request;
+			}
+		}
+		return nullptr;
+	}
+
+	bool AsyncFileIO::Prepare(Request& request)
+	{
+		uint64_t fileSize = 0;
+#ifdef VRE_HAS_PREAD
+		request.File = open(request.Desc.Path.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat fileStat;
+		if (request.File < 0 || fstat(request.File, &fileStat) != 0)
+		{
+			request.Result.Error = errno;
+			return false;
+		}
+		fileSize = static_cast<uint64_t>(fileStat.st_size);
+#else
+		std::error_code error;
+		fileSize = std::filesystem::file_size(request.Desc.Path, error);
+		if (error)
+		{
+			request.Result.Error = error.value();
+			return false;
+		}
+#endif
+		const uint64_t available = fileSize - std::min(fileSize, request.Desc.Offset);
+		request.Size = request.Desc.Size == k_ReadWholeFile ? available : request.Desc.Size;
+		if (request.Desc.Destination)
+		{
+			request.Buffer = request.Desc.Destination;
+		}
+		else
+		{
+			//Only allocate what the file can actually deliver
+			request.Result.Data.resize(std::min(request.Size, available));
+			request.Buffer = request.Result.Data.data();
+			request.Size = request.Result.Data.size();
+		}
+		return true;
+	}
+
+	void AsyncFileIO::Complete(const std::shared_ptr<Request>& request)
+	{
+#ifdef VRE_HAS_PREAD
+		if (request->File >= 0)
+		{
+			close(request->File);
+			request->File = -1;
+		}
+#endif
+		FileReadResult& result = request->Result;
+		result.BytesRead = request->Done;
+		result.bCancelled = request->bCancelRequested;
+		if (!request->Desc.Destination)
+		{
+			result.Data.resize(request->Done);
+		}
+		if (request->Desc.OnComplete)
+		{
+			request->Desc.OnComplete(result);
+		}
+
+		std::lock_guard lock(m_Mutex);
+		m_Active.erase(request->Id);
+		if (m_Active.empty())
+		{
+			m_Idle.notify_all();
+		}
+	}
+
+	void AsyncFileIO::RingLoop()
+	{
+#ifdef VRE_HAS_IO_URING
+		m_Ring->ArmWakePoll();
+		while (true)
+		{
+			std::vector<RequestId> cancels;
+			bool bStopping;
+			{
+				std::lock_guard lock(m_Mutex);
+				cancels.swap(m_CancelQueue);
+				bStopping = m_bStopping;
+			}
+			if (bStopping && m_InFlight.empty())
+			{
+				break;
+			}
+
+			while (!bStopping && m_InFlight.size() < k_QueueDepth)
+			{
+				std::shared_ptr<Request> request = PopPending();
+				if (!request)
+				{
+					break;
+				}
+				if (!Prepare(*request) || request->Size == 0 || request->bCancelRequested)
+				{
+					Complete(request);
+					continue;
+				}
+				m_InFlight.emplace(request->Id, request);
+				SubmitRead(*request);
+			}
+			for (RequestId id : cancels)
+			{
+				io_uring_sqe* sqe = m_InFlight.contains(id) ? m_Ring->GetSqe() : nullptr;
+				if (sqe)
+				{
+					sqe->opcode = IORING_OP_ASYNC_CANCEL;
+					sqe->addr = id;
+					sqe->user_data = k_CancelTag;
+				}
+			}
+
+			m_Ring->Enter(1);
+			m_Ring->Reap([this](uint64_t userData, int32_t res)
+			{
+				if (userData == k_WakeTag)
+				{
+					uint64_t value;
+					[[maybe_unused]] const ssize_t drained = read(m_Ring->WakeFd, &value, sizeof(value));
+					m_Ring->ArmWakePoll();
+					return;
+				}
+				const auto requestIt = m_InFlight.find(userData);
+				if (userData == k_CancelTag || requestIt == m_InFlight.end())
+				{
+					return;
+				}
+
+				Request& request = *requestIt->second;
+				if (res == -EINTR || res == -EAGAIN)
+				{
+					SubmitRead(request);
+					return;
+				}
+				if (res == -ECANCELED)
+				{
+					request.bCancelRequested = true;
+				}
+				else if (res < 0)
+				{
+					request.Result.Error = -res;
+				}
+				else
+				{
+					request.Done += static_cast<uint64_t>(res);
+					//res == 0 is the end of the file
+					if (res > 0 && request.Done < request.Size && !request.bCancelRequested)
+					{
+						SubmitRead(request);
+						return;
+					}
+				}
+				std::shared_ptr<Request> finished = std::move(requestIt->second);
+				m_InFlight.erase(requestIt);
+				Complete(finished);
+			});
+		}
+#endif
+	}
+
+	void AsyncFileIO::SubmitRead(Request& request)
+	{
+#ifdef VRE_HAS_IO_URING
+		//Sized so there is always room, see the constructor
+		io_uring_sqe* sqe = m_Ring->GetSqe();
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = request.File;
+		sqe->addr = reinterpret_cast<uint64_t>(request.Buffer + request.Done);
+		sqe->len = static_cast<uint32_t>(std::min(request.Size - request.Done, k_MaxReadChunk));
+		sqe->off = request.Desc.Offset + request.Done;
+		sqe->user_data = request.Id;
+#else
+		(void)request;
+#endif
+	}
+
+	void AsyncFileIO::RunFallbackRead()
+	{
+		std::shared_ptr<Request> request = PopPending();
+		if (!request)
+		{
+			//Cancelled before a worker got to it
+			return;
+		}
+		if (!Prepare(*request))
+		{
+			Complete(request);
+			return;
+		}
+
+#ifdef VRE_HAS_PREAD
+		while (request->Done < request->Size && !request->bCancelRequested)
+		{
+			const size_t chunk = static_cast<size_t>(std::min(request->Size - request->Done, k_MaxReadChunk));
+			const ssize_t bytesRead = pread(request->File, request->Buffer + request->Done, chunk, static_cast<off_t>(request->Desc.Offset + request->Done));
+			if (bytesRead < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (bytesRead < 0)
+			{
+				request->Result.Error = errno;
+				break;
+			}
+			if (bytesRead == 0)
+			{
+				break;
+			}
+			request->Done += static_cast<uint64_t>(bytesRead);
+		}
+#else
+		std::ifstream file(request->Desc.Path, std::ios::binary);
+		file.seekg(static_cast<std::streamoff>(request->Desc.Offset));
+		while (file && request->Done < request->Size && !request->bCancelRequested)
+		{
+			const uint64_t chunk = std::min(request->Size - request->Done, k_MaxReadChunk);
+			file.read(reinterpret_cast<char*>(request->Buffer + request->Done), static_cast<std::streamsize>(chunk));
+			request->Done += static_cast<uint64_t>(file.gcount());
+		}
+#endif
+		Complete(request);
+	}
+}
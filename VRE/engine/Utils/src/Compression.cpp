@@ -0,0 +1,275 @@
+#include <Compression.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#ifdef VRE_ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace VRE
+{
+	//LZ4 block format constants, see lz4_Block_format.md in the LZ4 repository
+	constexpr size_t k_Lz4MinMatch = 4;
+	//The last match has to start this far from the end and the last 5 bytes are always literals
+	constexpr size_t k_Lz4MatchFindLimit = 12;
+	constexpr size_t k_Lz4LastLiterals = 5;
+	constexpr size_t k_Lz4MaxOffset = 65535;
+	constexpr uint32_t k_Lz4HashBits = 14;
+
+	static uint32_t ReadU32(const std::byte* data)
+	{
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static uint32_t HashLz4(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - k_Lz4HashBits);
+	}
+
+	static void WriteLz4Length(std::vector<std::byte>& output, size_t length)
+	{
+		for (; length >= 255; length -= 255)
+		{
+			output.push_back(std::byte{ 255 });
+		}
+		output.push_back(static_cast<std::byte>(length));
+	}
+
+	static void WriteLz4Sequence(std::vector<std::byte>& output, const std::byte* literals, size_t literalLength, size_t offset, size_t matchLength)
+	{
+		const bool bHasMatch = matchLength != 0;
+		const size_t matchCode = bHasMatch ? matchLength - k_Lz4MinMatch : 0;
+		const uint8_t token = static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15));
+		output.push_back(static_cast<std::byte>(token));
+		if (literalLength >= 15)
+		{
+			WriteLz4Length(output, literalLength - 15);
+		}
+		output.insert(output.end(), literals, literals + literalLength);
+		if (!bHasMatch)
+		{
+			return;
+		}
+		output.push_back(static_cast<std::byte>(offset & 0xFF));
+		output.push_back(static_cast<std::byte>(offset >> 8));
+		if (matchCode >= 15)
+		{
+			WriteLz4Length(output, matchCode - 15);
+		}
+	}
+
+	//Greedy single probe matcher, favours speed over ratio like LZ4's default level
+	static size_t CompressLz4(std::span<const std::byte> input, std::vector<std::byte>& output)
+	{
+		const size_t start = output.size();
+		const std::byte* base = input.data();
+		const size_t size = input.size();
+		size_t anchor = 0;
+
+		if (size > k_Lz4MatchFindLimit)
+		{
+			std::vector<uint32_t> table(size_t(1) << k_Lz4HashBits, 0);
+			const size_t matchLimit = size - k_Lz4LastLiterals;
+			size_t position = 1;
+			table[HashLz4(ReadU32(base))] = 0;
+			while (position < size - k_Lz4MatchFindLimit)
+			{
+				const uint32_t sequence = ReadU32(base + position);
+				const uint32_t hash = HashLz4(sequence);
+				const size_t candidate = table[hash];
+				table[hash] = static_cast<uint32_t>(position);
+				if (position - candidate > k_Lz4MaxOffset || candidate >= position || ReadU32(base + candidate) != sequence)
+				{
+					position++;
+					continue;
+				}
+
+				size_t matchLength = k_Lz4MinMatch;
+				while (position + matchLength < matchLimit && base[candidate + matchLength] == base[position + matchLength])
+				{
+					matchLength++;
+				}
+				WriteLz4Sequence(output, base + anchor, position - anchor, position - candidate, matchLength);
+				position += matchLength;
+				anchor = position;
+			}
+		}
+
+		WriteLz4Sequence(output, base + anchor, size - anchor, 0, 0);
+		return output.size() - start;
+	}
+
+	static bool DecompressLz4(std::span<const std::byte> input, std::span<std::byte> output)
+	{
+		const std::byte* in = input.data();
+		const std::byte* inEnd = in + input.size();
+		std::byte* out = output.data();
+		std::byte* const outEnd = out + output.size();
+
+		auto readLength = [&](size_t length) -> size_t
+		{
+			if (length != 15)
+			{
+				return length;
+			}
+			uint8_t extra;
+			do
+			{
+				if (in >= inEnd)
+				{
+					return SIZE_MAX;
+				}
+				extra = static_cast<uint8_t>(*in++);
+				length += extra;
+			} while (extra == 255);
+			return length;
+		};
+
+		while (in < inEnd)
+		{
+			const uint8_t token = static_cast<uint8_t>(*in++);
+			const size_t literalLength = readLength(token >> 4);
+			if (literalLength == SIZE_MAX || literalLength > size_t(inEnd - in) || literalLength > size_t(outEnd - out))
+			{
+				return false;
+			}
+			if (literalLength != 0)
+			{
+				std::memcpy(out, in, literalLength);
+			}
+			in += literalLength;
+			out += literalLength;
+			//The last sequence is literals only
+			if (in == inEnd)
+			{
+				break;
+			}
+
+			if (inEnd - in < 2)
+			{
+				return false;
+			}
+			const size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+			in += 2;
+			size_t matchLength = readLength(token & 0x0F);
+			if (matchLength == SIZE_MAX || offset == 0 || offset > size_t(out - output.data()))
+			{
+				return false;
+			}
+			matchLength += k_Lz4MinMatch;
+			if (matchLength > size_t(outEnd - out))
+			{
+				return false;
+			}
+			//Overlapping matches repeat the last offset bytes, copy them one at a time
+			const std::byte* match = out - offset;
+			if (offset >= matchLength)
+			{
+				std::memcpy(out, match, matchLength);
+				out += matchLength;
+			}
+			else
+			{
+				for (size_t i = 0; i < matchLength; i++)
+				{
+					*out++ = *match++;
+				}
+			}
+		}
+		return out == outEnd;
+	}
+
+	bool IsCodecAvailable(CompressionCodec codec)
+	{
+		switch (codec)
+		{
+			case CompressionCodec::None:
+			case CompressionCodec::Lz4:
+				return true;
+			case CompressionCodec::Zstd:
+#ifdef VRE_ENABLE_ZSTD
+				return true;
+#else
+				return false;
+#endif
+		}
+		return false;
+	}
+
+	size_t GetCompressBound(CompressionCodec codec, size_t size)
+	{
+		switch (codec)
+		{
+			case CompressionCodec::Lz4:
+				return size + size / 255 + 16;
+			case CompressionCodec::Zstd:
+#ifdef VRE_ENABLE_ZSTD
+				return ZSTD_compressBound(size);
+#else
+				return 0;
+#endif
+			default:
+				return size;
+		}
+	}
+
+	size_t Compress(CompressionCodec codec, std::span<const std::byte> input, std::vector<std::byte>& output)
+	{
+		switch (codec)
+		{
+			case CompressionCodec::None:
+				output.insert(output.end(), input.begin(), input.end());
+				return input.size();
+			case CompressionCodec::Lz4:
+				output.reserve(output.size() + GetCompressBound(codec, input.size()));
+				return CompressLz4(input, output);
+			case CompressionCodec::Zstd:
+			{
+#ifdef VRE_ENABLE_ZSTD
+				const size_t start = output.size();
+				output.resize(start + ZSTD_compressBound(input.size()));
+				const size_t written = ZSTD_compress(output.data() + start, output.size() - start, input.data(), input.size(), 19);
+				if (ZSTD_isError(written))
+				{
+					output.resize(start);
+					return 0;
+				}
+				output.resize(start + written);
+				return written;
+#else
+				return 0;
+#endif
+			}
+		}
+		return 0;
+	}
+
+	bool Decompress(CompressionCodec codec, std::span<const std::byte> input, std::span<std::byte> output)
+	{
+		switch (codec)
+		{
+			case CompressionCodec::None:
+				if (input.size() != output.size())
+				{
+					return false;
+				}
+				std::memcpy(output.data(), input.data(), input.size());
+				return true;
+			case CompressionCodec::Lz4:
+				return DecompressLz4(input, output);
+			case CompressionCodec::Zstd:
+			{
+#ifdef VRE_ENABLE_ZSTD
+				const size_t written = ZSTD_decompress(output.data(), output.size(), input.data(), input.size());
+				return !ZSTD_isError(written) && written == output.size();
+#else
+				return false;
+#endif
+			}
+		}
+		return false;
+	}
+}
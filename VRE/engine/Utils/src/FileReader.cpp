@@ -1,18 +1,44 @@
 #include <FileReader.h>
+#include <stdexcept>
 
 namespace VRE
 {
+	AsyncFileIO& FileReader::GetAsyncIO()
+	{
+		static AsyncFileIO s_AsyncIO;
+		return s_AsyncIO;
+	}
+
+	VirtualFileSystem& FileReader::GetFileSystem()
+	{
+		//Constructed after the I/O service it reads through, so it is also destroyed first
+		static VirtualFileSystem s_FileSystem(GetAsyncIO());
+		return s_FileSystem;
+	}
+
 	std::vector<char> FileReader::ReadShaderFile(const std::string &fileName) {
-		std::ifstream file(fileName, std::ios::ate | std::ios::binary);
-		if (!file.is_open())
+		const std::vector<std::byte> data = ReadFile(fileName);
+		const char* begin = reinterpret_cast<const char*>(data.data());
+		return std::vector<char>(begin, begin + data.size());
+	}
+
+	std::vector<std::byte> FileReader::ReadFile(const std::string& fileName)
+	{
+		FileReadResult result = GetAsyncIO().ReadAsync({ .Path = fileName, .Offset = 0, .Size = k_ReadWholeFile, .Destination = nullptr,
+			.Priority = IOPriority::High, .OnComplete = {} }).get();
+		if (!result.IsSuccess())
 		{
 			throw std::runtime_error("Could not open file!");
 		}
-		std::vector<char> buffer(file.tellg());
-		file.seekg(0, std::ios::beg);
-		file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
-		file.close();
-		return buffer;
+		return std::move(result.Data);
+	}
+
+	bool FileReader::ReadFileRange(const std::string& fileName, uint64_t offset, uint64_t size, std::vector<std::byte>& data)
+	{
+		data.resize(size);
+		const FileReadResult result = GetAsyncIO().ReadAsync({ .Path = fileName, .Offset = offset, .Size = size, .Destination = data.data(),
+			.Priority = IOPriority::Normal, .OnComplete = {} }).get();
+		return result.IsSuccess() && result.BytesRead == size;
 	}
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,39 @@
+#include <Hash.h>
+#include <cstring>
+
+namespace VRE
+{
+	uint64_t HashBytes(std::span<const std::byte> data, uint64_t seed)
+	{
+		constexpr uint64_t k_Multiplier = 0xc6a4a7935bd1e995ull;
+		constexpr int k_Shift = 47;
+
+		uint64_t hash = seed ^ (data.size() * k_Multiplier);
+		const size_t blockCount = data.size() / sizeof(uint64_t);
+		for (size_t i = 0; i < blockCount; i++)
+		{
+			uint64_t block;
+			std::memcpy(&block, data.data() + i * sizeof(uint64_t), sizeof(block));
+			block *= k_Multiplier;
+			block ^= block >> k_Shift;
+			block *= k_Multiplier;
+			hash ^= block;
+			hash *= k_Multiplier;
+		}
+
+		const std::span<const std::byte> tail = data.subspan(blockCount * sizeof(uint64_t));
+		if (!tail.empty())
+		{
+			for (size_t i = tail.size(); i-- > 0;)
+			{
+				hash ^= static_cast<uint64_t>(tail[i]) << (i * 8);
+			}
+			hash *= k_Multiplier;
+		}
+
+		hash ^= hash >> k_Shift;
+		hash *= k_Multiplier;
+		hash ^= hash >> k_Shift;
+		return hash;
+	}
+}
@@ -0,0 +1,427 @@
+#include <Json.h>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace VRE
+{
+	//Deeper documents are rejected instead of overflowing the stack
+	constexpr uint32_t k_MaxJsonDepth = 512;
+
+	class JsonParser
+	{
+		public:
+			explicit JsonParser(std::string_view text) : m_Text(text) {}
+
+			JsonValue ParseDocument()
+			{
+				JsonValue value = ParseValue(0);
+				SkipWhitespace();
+				if (m_Position != m_Text.size())
+				{
+					Fail("trailing characters");
+				}
+				return value;
+			}
+
+		private:
+			[[noreturn]] void Fail(const char* reason) const
+			{
+				throw std::runtime_error("Invalid JSON at byte " + std::to_string(m_Position) + ": " + reason + "!");
+			}
+
+			void SkipWhitespace()
+			{
+				while (m_Position < m_Text.size() && (m_Text[m_Position] == ' ' || m_Text[m_Position] == '\t' || m_Text[m_Position] == '\n' || m_Text[m_Position] == '\r'))
+				{
+					m_Position++;
+				}
+			}
+
+			bool Consume(char c)
+			{
+				SkipWhitespace();
+				if (m_Position < m_Text.size() && m_Text[m_Position] == c)
+				{
+					m_Position++;
+					return true;
+				}
+				return false;
+			}
+
+			void Expect(char c, const char* reason)
+			{
+				if (!Consume(c))
+				{
+					Fail(reason);
+				}
+			}
+
+			bool ConsumeLiteral(std::string_view literal)
+			{
+				if (m_Text.substr(m_Position, literal.size()) != literal)
+				{
+					return false;
+				}
+				m_Position += literal.size();
+				return true;
+			}
+
+			JsonValue ParseValue(uint32_t depth)
+			{
+				if (depth > k_MaxJsonDepth)
+				{
+					Fail("nesting too deep");
+				}
+				SkipWhitespace();
+				if (m_Position >= m_Text.size())
+				{
+					Fail("unexpected end of input");
+				}
+
+				JsonValue value;
+				const char c = m_Text[m_Position];
+				if (c == '{')
+				{
+					m_Position++;
+					JsonValue::Object members;
+					if (!Consume('}'))
+					{
+						do
+						{
+							SkipWhitespace();
+							std::string key = ParseString();
+							Expect(':', "expected ':'");
+							members.emplace_back(std::move(key), ParseValue(depth + 1));
+						}
+						while (Consume(','));
+						Expect('}', "expected ',' or '}'");
+					}
+					value.m_Value = std::move(members);
+				}
+				else if (c == '[')
+				{
+					m_Position++;
+					JsonValue::Array elements;
+					if (!Consume(']'))
+					{
+						do
+						{
+							elements.push_back(ParseValue(depth + 1));
+						}
+						while (Consume(','));
+						Expect(']', "expected ',' or ']'");
+					}
+					value.m_Value = std::move(elements);
+				}
+				else if (c == '"')
+				{
+					value.m_Value = ParseString();
+				}
+				else if (ConsumeLiteral("true"))
+				{
+					value.m_Value = true;
+				}
+				else if (ConsumeLiteral("false"))
+				{
+					value.m_Value = false;
+				}
+				else if (!ConsumeLiteral("null"))
+				{
+					value.m_Value = ParseNumber();
+				}
+				return value;
+			}
+
+			double ParseNumber()
+			{
+				//from_chars alone would also take "inf", "nan" and leading '+', so check the JSON grammar first
+				const size_t begin = m_Position;
+				const auto digits = [this]
+				{
+					const size_t start = m_Position;
+					while (m_Position < m_Text.size() && m_Text[m_Position] >= '0' && m_Text[m_Position] <= '9')
+					{
+						m_Position++;
+					}
+					return m_Position - start;
+				};
+				const auto peek = [this](char c) { return m_Position < m_Text.size() && m_Text[m_Position] == c; };
+
+				if (peek('-'))
+				{
+					m_Position++;
+				}
+				const size_t integerStart = m_Position;
+				const size_t integerDigits = digits();
+				if (integerDigits == 0 || (integerDigits > 1 && m_Text[integerStart] == '0'))
+				{
+					m_Position = begin;
+					Fail("invalid value");
+				}
+				if (peek('.'))
+				{
+					m_Position++;
+					if (digits() == 0)
+					{
+						Fail("invalid number");
+					}
+				}
+				if (peek('e') || peek('E'))
+				{
+					m_Position++;
+					if (peek('+') || peek('-'))
+					{
+						m_Position++;
+					}
+					if (digits() == 0)
+					{
+						Fail("invalid number");
+					}
+				}
+
+				double number = 0.0;
+				const auto result = std::from_chars(m_Text.data() + begin, m_Text.data() + m_Position, number);
+				if (result.ec == std::errc::result_out_of_range)
+				{
+					Fail("number out of range");
+				}
+				return number;
+			}
+
+			uint32_t ParseHex4()
+			{
+				uint32_t code = 0;
+				if (m_Position + 4 > m_Text.size() || std::from_chars(m_Text.data() + m_Position, m_Text.data() + m_Position + 4, code, 16).ptr != m_Text.data() + m_Position + 4)
+				{
+					Fail("invalid \\u escape");
+				}
+				m_Position += 4;
+				return code;
+			}
+
+			static void AppendUtf8(std::string& out, uint32_t code)
+			{
+				if (code < 0x80)
+				{
+					out += static_cast<char>(code);
+				}
+				else if (code < 0x800)
+				{
+					out += static_cast<char>(0xC0 | (code >> 6));
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else if (code < 0x10000)
+				{
+					out += static_cast<char>(0xE0 | (code >> 12));
+					out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else
+				{
+					out += static_cast<char>(0xF0 | (code >> 18));
+					out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+					out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+			}
+
+			std::string ParseString()
+			{
+				if (m_Position >= m_Text.size() || m_Text[m_Position] != '"')
+				{
+					Fail("expected a string");
+				}
+				m_Position++;
+
+				std::string out;
+				while (true)
+				{
+					//Copy runs without escapes in one go, most strings have none at all
+					const size_t runEnd = m_Text.find_first_of("\"\\", m_Position);
+					if (runEnd == std::string_view::npos)
+					{
+						m_Position = m_Text.size();
+						Fail("unterminated string");
+					}
+					for (size_t i = m_Position; i < runEnd; i++)
+					{
+						if (static_cast<unsigned char>(m_Text[i]) < 0x20)
+						{
+							m_Position = i;
+							Fail("control character in string");
+						}
+					}
+					out.append(m_Text.substr(m_Position, runEnd - m_Position));
+					m_Position = runEnd + 1;
+					if (m_Text[runEnd] == '"')
+					{
+						return out;
+					}
+
+					if (m_Position >= m_Text.size())
+					{
+						Fail("unterminated string");
+					}
+					const char escape = m_Text[m_Position++];
+					switch (escape)
+					{
+						case '"': out += '"'; break;
+						case '\\': out += '\\'; break;
+						case '/': out += '/'; break;
+						case 'b': out += '\b'; break;
+						case 'f': out += '\f'; break;
+						case 'n': out += '\n'; break;
+						case 'r': out += '\r'; break;
+						case 't': out += '\t'; break;
+						case 'u':
+						{
+							uint32_t code = ParseHex4();
+							if (code >= 0xD800 && code < 0xDC00)
+							{
+								if (!ConsumeLiteral("\\u"))
+								{
+									Fail("unpaired surrogate");
+								}
+								const uint32_t low = ParseHex4();
+								if (low < 0xDC00 || low >= 0xE000)
+								{
+									Fail("unpaired surrogate");
+								}
+								code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+							}
+							else if (code >= 0xDC00 && code < 0xE000)
+							{
+								Fail("unpaired surrogate");
+							}
+							AppendUtf8(out, code);
+							break;
+						}
+						default: m_Position--; Fail("invalid escape");
+					}
+				}
+			}
+
+		private:
+			std::string_view m_Text;
+			size_t m_Position = 0;
+	};
+
+	JsonValue JsonValue::Parse(std::string_view text)
+	{
+		return JsonParser(text).ParseDocument();
+	}
+
+	bool JsonValue::AsBool() const
+	{
+		if (const bool* value = std::get_if<bool>(&m_Value))
+		{
+			return *value;
+		}
+		throw std::runtime_error("JSON value is not a boolean!");
+	}
+
+	double JsonValue::AsNumber() const
+	{
+		if (const double* value = std::get_if<double>(&m_Value))
+		{
+			return *value;
+		}
+		throw std::runtime_error("JSON value is not a number!");
+	}
+
+	const std::string& JsonValue::AsString() const
+	{
+		if (const std::string* value = std::get_if<std::string>(&m_Value))
+		{
+			return *value;
+		}
+		throw std::runtime_error("JSON value is not a string!");
+	}
+
+	const JsonValue::Array& JsonValue::AsArray() const
+	{
+		if (const Array* value = std::get_if<Array>(&m_Value))
+		{
+			return *value;
+		}
+		throw std::runtime_error("JSON value is not an array!");
+	}
+
+	const JsonValue::Object& JsonValue::AsObject() const
+	{
+		if (const Object* value = std::get_if<Object>(&m_Value))
+		{
+			return *value;
+		}
+		throw std::runtime_error("JSON value is not an object!");
+	}
+
+	const JsonValue* JsonValue::Find(std::string_view key) const
+	{
+		if (const Object* members = std::get_if<Object>(&m_Value))
+		{
+			for (const auto& [name, value] : *members)
+			{
+				if (name == key)
+				{
+					return &value;
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	const JsonValue& JsonValue::operator[](std::string_view key) const
+	{
+		static const JsonValue k_Null;
+		const JsonValue* value = Find(key);
+		return value ? *value : k_Null;
+	}
+
+	size_t JsonValue::GetSize() const
+	{
+		if (const Array* elements = std::get_if<Array>(&m_Value))
+		{
+			return elements->size();
+		}
+		if (const Object* members = std::get_if<Object>(&m_Value))
+		{
+			return members->size();
+		}
+		return 0;
+	}
+
+	double JsonValue::GetNumber(std::string_view key, double defaultValue) const
+	{
+		const JsonValue* value = Find(key);
+		return value ? value->AsNumber() : defaultValue;
+	}
+
+	uint32_t JsonValue::GetIndex(std::string_view key, uint32_t defaultValue) const
+	{
+		const JsonValue* value = Find(key);
+		if (!value)
+		{
+			return defaultValue;
+		}
+		const double number = value->AsNumber();
+		if (number < 0.0 || number > 4294967295.0 || std::floor(number) != number)
+		{
+			throw std::runtime_error("JSON member " + std::string(key) + " is not a valid index!");
+		}
+		return static_cast<uint32_t>(number);
+	}
+
+	std::string_view JsonValue::GetString(std::string_view key, std::string_view defaultValue) const
+	{
+		const JsonValue* value = Find(key);
+		return value ? std::string_view(value->AsString()) : defaultValue;
+	}
+
+	bool JsonValue::GetBool(std::string_view key, bool defaultValue) const
+	{
+		const JsonValue* value = Find(key);
+		return value ? value->AsBool() : defaultValue;
+	}
+}
@@ -0,0 +1,86 @@
+#include <MappedFile.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VRE
+{
+	std::shared_ptr<MappedFile> MappedFile::Open(const std::string& path)
+	{
+		std::shared_ptr<MappedFile> mappedFile(new MappedFile());
+#ifdef _WIN32
+		mappedFile->m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		LARGE_INTEGER size;
+		if (mappedFile->m_File == INVALID_HANDLE_VALUE || !GetFileSizeEx(mappedFile->m_File, &size))
+		{
+			mappedFile->m_File = nullptr;
+			return nullptr;
+		}
+		mappedFile->m_Size = static_cast<size_t>(size.QuadPart);
+		//Empty files can't be mapped, they are still valid files
+		if (mappedFile->m_Size == 0)
+		{
+			return mappedFile;
+		}
+		mappedFile->m_Mapping = CreateFileMappingA(mappedFile->m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mappedFile->m_Mapping)
+		{
+			return nullptr;
+		}
+		mappedFile->m_Data = MapViewOfFile(mappedFile->m_Mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+		const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat fileStat;
+		if (file < 0 || fstat(file, &fileStat) != 0)
+		{
+			if (file >= 0)
+			{
+				close(file);
+			}
+			return nullptr;
+		}
+		mappedFile->m_Size = static_cast<size_t>(fileStat.st_size);
+		if (mappedFile->m_Size == 0)
+		{
+			close(file);
+			return mappedFile;
+		}
+		void* data = mmap(nullptr, mappedFile->m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+		//The mapping keeps its own reference to the file
+		close(file);
+		mappedFile->m_Data = data == MAP_FAILED ? nullptr : data;
+#endif
+		return mappedFile->m_Data ? mappedFile : nullptr;
+	}
+
+	MappedFile::~MappedFile()
+	{
+#ifdef _WIN32
+		if (m_Data)
+		{
+			UnmapViewOfFile(m_Data);
+		}
+		if (m_Mapping)
+		{
+			CloseHandle(m_Mapping);
+		}
+		if (m_File)
+		{
+			CloseHandle(m_File);
+		}
+#else
+		if (m_Data)
+		{
+			munmap(const_cast<void*>(m_Data), m_Size);
+		}
+#endif
+	}
+}
@@ -0,0 +1,319 @@
+#include <PakArchive.h>
+#include <VirtualFileSystem.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <latch>
+
+namespace VRE
+{
+	constexpr uint64_t k_PakTableAlignment = 8;
+	//Stored files are handed out in place, so their data gets the alignment cooked formats expect from a mapping
+	constexpr uint64_t k_PakFileAlignment = 16;
+
+	uint64_t HashPakPath(std::string_view path)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (char character : path)
+		{
+			hash ^= static_cast<uint8_t>(character);
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	std::shared_ptr<PakArchive> PakArchive::Open(const std::string& path)
+	{
+		std::shared_ptr<MappedFile> mapping = MappedFile::Open(path);
+		if (!mapping || mapping->GetSize() < sizeof(PakHeader))
+		{
+			return nullptr;
+		}
+		const std::span<const std::byte> bytes = mapping->GetBytes();
+		auto archive = std::make_shared<PakArchive>();
+		std::memcpy(&archive->m_Header, bytes.data(), sizeof(PakHeader));
+		const PakHeader& header = archive->m_Header;
+
+		const auto fits = [&bytes](uint64_t offset, uint64_t size) { return offset <= bytes.size() && size <= bytes.size() - offset; };
+		if (header.Magic != k_PakMagic || header.Version != k_PakVersion || header.ChunkSize == 0
+			|| header.ChunkTableOffset % k_PakTableAlignment != 0 || header.FileIndexOffset % k_PakTableAlignment != 0
+			|| !fits(header.ChunkTableOffset, uint64_t(header.ChunkCount) * sizeof(PakChunk))
+			|| !fits(header.FileIndexOffset, uint64_t(header.FileCount) * sizeof(PakFileEntry))
+			|| !fits(header.NamesOffset, header.NamesSize))
+		{
+			return nullptr;
+		}
+
+		//Mappings are page aligned and the tables 8 byte aligned inside the file, so they can be used in place
+		archive->m_Chunks = { reinterpret_cast<const PakChunk*>(bytes.data() + header.ChunkTableOffset), header.ChunkCount };
+		archive->m_Files = { reinterpret_cast<const PakFileEntry*>(bytes.data() + header.FileIndexOffset), header.FileCount };
+		archive->m_Names = { reinterpret_cast<const char*>(bytes.data() + header.NamesOffset), header.NamesSize };
+		for (const PakChunk& chunk : archive->m_Chunks)
+		{
+			if (!fits(chunk.Offset, chunk.CompressedSize) || chunk.Size > header.ChunkSize)
+			{
+				return nullptr;
+			}
+		}
+		for (const PakFileEntry& entry : archive->m_Files)
+		{
+			if (uint64_t(entry.FirstChunk) + entry.ChunkCount > header.ChunkCount || uint64_t(entry.NameOffset) + entry.NameLength > header.NamesSize)
+			{
+				return nullptr;
+			}
+			//Stored files are sliced straight out of the mapping from their first chunk on, see GetStoredBytes
+			uint64_t chunkBytes = 0;
+			bool bStored = true;
+			for (const PakChunk& chunk : archive->m_Chunks.subspan(entry.FirstChunk, entry.ChunkCount))
+			{
+				chunkBytes += chunk.Size;
+				bStored = bStored && chunk.Codec == CompressionCodec::None;
+			}
+			if (entry.Size > chunkBytes || (bStored && entry.ChunkCount > 0 && !fits(archive->m_Chunks[entry.FirstChunk].Offset, entry.Size)))
+			{
+				return nullptr;
+			}
+		}
+		archive->m_Mapping = std::move(mapping);
+		return archive;
+	}
+
+	const PakFileEntry* PakArchive::Find(std::string_view path) const
+	{
+		const uint64_t hash = HashPakPath(path);
+		auto entryIt = std::ranges::lower_bound(m_Files, hash, {}, &PakFileEntry::PathHash);
+		//Colliding hashes sit next to each other, the name settles it
+		for (; entryIt != m_Files.end() && entryIt->PathHash == hash; ++entryIt)
+		{
+			if (GetName(*entryIt) == path)
+			{
+				return &*entryIt;
+			}
+		}
+		return nullptr;
+	}
+
+	std::string_view PakArchive::GetName(const PakFileEntry& entry) const
+	{
+		return m_Names.substr(entry.NameOffset, entry.NameLength);
+	}
+
+	bool PakArchive::IsStored(const PakFileEntry& entry) const
+	{
+		return std::ranges::all_of(GetChunks(entry), [](const PakChunk& chunk) { return chunk.Codec == CompressionCodec::None; });
+	}
+
+	std::span<const std::byte> PakArchive::GetStoredBytes(const PakFileEntry& entry) const
+	{
+		if (entry.ChunkCount == 0)
+		{
+			return {};
+		}
+		//The writer lays the chunks of a file out back to back
+		return m_Mapping->GetBytes().subspan(m_Chunks[entry.FirstChunk].Offset, entry.Size);
+	}
+
+	bool PakArchive::ReadChunk(const PakFileEntry& entry, uint32_t chunkIndex, std::span<std::byte> fileBytes) const
+	{
+		if (chunkIndex >= entry.ChunkCount || fileBytes.size() != entry.Size)
+		{
+			return false;
+		}
+		const PakChunk& chunk = m_Chunks[entry.FirstChunk + chunkIndex];
+		const uint64_t offset = uint64_t(chunkIndex) * m_Header.ChunkSize;
+		if (offset + chunk.Size > fileBytes.size())
+		{
+			return false;
+		}
+		return Decompress(chunk.Codec, GetChunkData(chunk), fileBytes.subspan(offset, chunk.Size));
+	}
+
+	bool PakArchive::ReadFile(const PakFileEntry& entry, std::span<std::byte> fileBytes) const
+	{
+		for (uint32_t chunkIndex = 0; chunkIndex < entry.ChunkCount; chunkIndex++)
+		{
+			if (!ReadChunk(entry, chunkIndex, fileBytes))
+			{
+				return false;
+			}
+		}
+		return fileBytes.size() == entry.Size;
+	}
+
+	bool PakArchive::ReadRange(const PakFileEntry& entry, uint64_t offset, std::span<std::byte> bytes) const
+	{
+		if (offset > entry.Size || bytes.size() > entry.Size - offset)
+		{
+			return false;
+		}
+		std::vector<std::byte> chunkBytes;
+		uint64_t done = 0;
+		while (done < bytes.size())
+		{
+			const uint64_t chunkIndex = (offset + done) / m_Header.ChunkSize;
+			const uint64_t chunkOffset = (offset + done) % m_Header.ChunkSize;
+			if (chunkIndex >= entry.ChunkCount || chunkOffset >= m_Chunks[entry.FirstChunk + chunkIndex].Size)
+			{
+				return false;
+			}
+			const PakChunk& chunk = m_Chunks[entry.FirstChunk + chunkIndex];
+			chunkBytes.resize(chunk.Size);
+			if (!Decompress(chunk.Codec, GetChunkData(chunk), chunkBytes))
+			{
+				return false;
+			}
+			const uint64_t size = std::min<uint64_t>(chunk.Size - chunkOffset, bytes.size() - done);
+			std::memcpy(bytes.data() + done, chunkBytes.data() + chunkOffset, size);
+			done += size;
+		}
+		return true;
+	}
+
+	PakWriter::PakWriter(CompressionCodec codec, uint32_t chunkSize, uint64_t rawFileSize)
+		: m_Codec(codec), m_ChunkSize(chunkSize), m_RawFileSize(rawFileSize)
+	{
+	}
+
+	void PakWriter::AddFile(std::string_view path, std::vector<std::byte> data)
+	{
+		std::string normalizedPath = VirtualFileSystem::NormalizePath(path);
+		//Adding the same path again replaces it
+		const auto fileIt = std::ranges::find(m_Files, normalizedPath, &File::Path);
+		if (fileIt != m_Files.end())
+		{
+			fileIt->Data = std::move(data);
+			return;
+		}
+		m_Files.push_back({ std::move(normalizedPath), std::move(data) });
+	}
+
+	bool PakWriter::Write(const std::string& outputPath, ThreadPool* threadPool) const
+	{
+		if (!IsCodecAvailable(m_Codec) || m_ChunkSize == 0)
+		{
+			return false;
+		}
+
+		std::vector<const File*> files;
+		for (const File& file : m_Files)
+		{
+			files.push_back(&file);
+		}
+		std::ranges::sort(files, [](const File* a, const File* b)
+		{
+			const uint64_t hashA = HashPakPath(a->Path);
+			const uint64_t hashB = HashPakPath(b->Path);
+			return hashA != hashB ? hashA < hashB : a->Path < b->Path;
+		});
+
+		struct ChunkJob
+		{
+			std::span<const std::byte> Input;
+			bool bRaw = false;
+			bool bFirstChunk = false;
+			std::vector<std::byte> Compressed;
+		};
+		std::vector<ChunkJob> jobs;
+		for (const File* file : files)
+		{
+			const bool bRaw = m_Codec == CompressionCodec::None || file->Data.size() <= m_RawFileSize;
+			for (size_t offset = 0; offset < file->Data.size(); offset += m_ChunkSize)
+			{
+				jobs.push_back({ .Input = std::span(file->Data).subspan(offset, std::min<size_t>(m_ChunkSize, file->Data.size() - offset)),
+					.bRaw = bRaw, .bFirstChunk = offset == 0, .Compressed = {} });
+			}
+		}
+
+		const auto compressChunk = [this](ChunkJob& job)
+		{
+			//Chunks that don't shrink are kept raw
+			if (!job.bRaw && (Compress(m_Codec, job.Input, job.Compressed) == 0 || job.Compressed.size() >= job.Input.size()))
+			{
+				job.bRaw = true;
+			}
+		};
+		if (threadPool)
+		{
+			std::latch done(static_cast<std::ptrdiff_t>(jobs.size()));
+			for (ChunkJob& job : jobs)
+			{
+				threadPool->Submit([&compressChunk, &job, &done] { compressChunk(job); done.count_down(); });
+			}
+			done.wait();
+		}
+		else
+		{
+			std::ranges::for_each(jobs, compressChunk);
+		}
+
+		std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+		if (!output)
+		{
+			return false;
+		}
+		PakHeader header{ .FileCount = static_cast<uint32_t>(files.size()), .ChunkCount = static_cast<uint32_t>(jobs.size()), .ChunkSize = m_ChunkSize };
+		output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		std::vector<PakChunk> chunks;
+		chunks.reserve(jobs.size());
+		uint64_t offset = sizeof(header);
+		const auto writePadding = [&output, &offset](uint64_t alignment)
+		{
+			const char zeros[k_PakFileAlignment] = {};
+			const uint64_t padding = (alignment - offset % alignment) % alignment;
+			output.write(zeros, static_cast<std::streamsize>(padding));
+			offset += padding;
+		};
+		for (const ChunkJob& job : jobs)
+		{
+			if (job.bFirstChunk)
+			{
+				writePadding(k_PakFileAlignment);
+			}
+			const std::span<const std::byte> data = job.bRaw ? job.Input : std::span<const std::byte>(job.Compressed);
+			chunks.push_back({
+				.Offset = offset,
+				.CompressedSize = static_cast<uint32_t>(data.size()),
+				.Size = static_cast<uint32_t>(job.Input.size()),
+				.Codec = job.bRaw ? CompressionCodec::None : m_Codec
+			});
+			output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			offset += data.size();
+		}
+
+		std::vector<PakFileEntry> entries;
+		std::string names;
+		uint32_t firstChunk = 0;
+		for (const File* file : files)
+		{
+			const uint32_t chunkCount = static_cast<uint32_t>((file->Data.size() + m_ChunkSize - 1) / m_ChunkSize);
+			entries.push_back({
+				.PathHash = HashPakPath(file->Path),
+				.Size = file->Data.size(),
+				.FirstChunk = firstChunk,
+				.ChunkCount = chunkCount,
+				.NameOffset = static_cast<uint32_t>(names.size()),
+				.NameLength = static_cast<uint32_t>(file->Path.size())
+			});
+			names += file->Path;
+			firstChunk += chunkCount;
+		}
+
+		const auto writeTable = [&output, &offset, &writePadding](const void* data, size_t size) -> uint64_t
+		{
+			writePadding(k_PakTableAlignment);
+			const uint64_t tableOffset = offset;
+			output.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			offset += size;
+			return tableOffset;
+		};
+		header.ChunkTableOffset = writeTable(chunks.data(), chunks.size() * sizeof(PakChunk));
+		header.FileIndexOffset = writeTable(entries.data(), entries.size() * sizeof(PakFileEntry));
+		header.NamesOffset = writeTable(names.data(), names.size());
+		header.NamesSize = names.size();
+
+		output.seekp(0);
+		output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		return output.good();
+	}
+}
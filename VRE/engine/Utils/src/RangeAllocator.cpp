@@ -0,0 +1,98 @@
+#include <RangeAllocator.h>
+#include <cassert>
+
+namespace VRE
+{
+	RangeAllocator::RangeAllocator(uint64_t capacity)
+	{
+		Grow(capacity);
+	}
+
+	std::optional<uint64_t> RangeAllocator::Allocate(uint64_t size)
+	{
+		assert(size > 0);
+		const auto fit = m_BySize.lower_bound({ size, 0 });
+		if (fit == m_BySize.end())
+		{
+			return std::nullopt;
+		}
+		const uint64_t offset = fit->second;
+		Take(m_ByOffset.find(offset), offset, size);
+		return offset;
+	}
+
+	std::optional<uint64_t> RangeAllocator::AllocateBelow(uint64_t size, uint64_t limit)
+	{
+		assert(size > 0);
+		for (auto range = m_ByOffset.begin(); range != m_ByOffset.end() && range->first + size <= limit; ++range)
+		{
+			if (range->second >= size)
+			{
+				const uint64_t offset = range->first;
+				Take(range, offset, size);
+				return offset;
+			}
+		}
+		return std::nullopt;
+	}
+
+	void RangeAllocator::Free(uint64_t offset, uint64_t size)
+	{
+		assert(size > 0 && offset + size <= m_Capacity);
+		m_FreeSize += size;
+		auto next = m_ByOffset.lower_bound(offset);
+		assert(next == m_ByOffset.end() || next->first >= offset + size);
+		if (next != m_ByOffset.end() && next->first == offset + size)
+		{
+			size += next->second;
+			next = std::next(next);
+			Erase(std::prev(next));
+		}
+		if (next != m_ByOffset.begin())
+		{
+			const auto previous = std::prev(next);
+			assert(previous->first + previous->second <= offset);
+			if (previous->first + previous->second == offset)
+			{
+				offset = previous->first;
+				size += previous->second;
+				Erase(previous);
+			}
+		}
+		Insert(offset, size);
+	}
+
+	void RangeAllocator::Grow(uint64_t capacity)
+	{
+		assert(capacity >= m_Capacity);
+		if (capacity > m_Capacity)
+		{
+			const uint64_t offset = m_Capacity;
+			m_Capacity = capacity;
+			Free(offset, capacity - offset);
+		}
+	}
+
+	void RangeAllocator::Take(std::map<uint64_t, uint64_t>::iterator range, uint64_t offset, uint64_t size)
+	{
+		const uint64_t rangeSize = range->second;
+		Erase(range);
+		if (rangeSize > size)
+		{
+			Insert(offset + size, rangeSize - size);
+		}
+		m_FreeSize -= size;
+	}
+
+	void RangeAllocator::Insert(uint64_t offset, uint64_t size)
+	{
+		m_ByOffset.emplace(offset, size);
+		m_BySize.emplace(size, offset);
+	}
+
+	void RangeAllocator::Erase(std::map<uint64_t, uint64_t>::iterator range)
+	{
+		m_BySize.erase({ range->second, range->first });
+		m_ByOffset.erase(range);
+	}
+}
@@ -0,0 +1,80 @@
+#include <ThreadPool.h>
+#include <algorithm>
+
+namespace VRE
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		m_Workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock(m_Mutex);
+			m_bStopping = true;
+		}
+		m_TaskAvailable.notify_all();
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::Submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Tasks.push_back(std::move(task));
+		}
+		m_TaskAvailable.notify_one();
+	}
+
+	void ThreadPool::WaitIdle()
+	{
+		std::unique_lock lock(m_Mutex);
+		m_Idle.wait(lock, [this] { return m_Tasks.empty() && m_ActiveTasks == 0; });
+	}
+
+	uint32_t ThreadPool::GetDefaultThreadCount()
+	{
+		//Leave a core for the render thread
+		const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		return std::max(1u, hardwareThreads > 1 ? hardwareThreads - 1 : 1u);
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock lock(m_Mutex);
+				m_TaskAvailable.wait(lock, [this] { return m_bStopping || !m_Tasks.empty(); });
+				//Drain the queue before stopping so nobody waits on a task that never runs
+				if (m_Tasks.empty())
+				{
+					return;
+				}
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop_front();
+				m_ActiveTasks++;
+			}
+
+			task();
+
+			{
+				std::lock_guard lock(m_Mutex);
+				m_ActiveTasks--;
+				if (m_Tasks.empty() && m_ActiveTasks == 0)
+				{
+					m_Idle.notify_all();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,233 @@
+#include <VirtualFileSystem.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace VRE
+{
+	VirtualFileSystem::VirtualFileSystem(AsyncFileIO& asyncIO, uint32_t workerCount)
+		: m_AsyncIO(asyncIO), m_Workers(workerCount)
+	{
+	}
+
+	bool VirtualFileSystem::Mount(const std::string& source, std::string_view mountPoint, int32_t priority)
+	{
+		MountedSource mount{ .Source = source, .MountPoint = NormalizePath(mountPoint), .Priority = priority, .Pak = nullptr, .Directory = {} };
+		std::error_code error;
+		if (std::filesystem::is_directory(source, error))
+		{
+			mount.Directory = source;
+		}
+		else if (!(mount.Pak = PakArchive::Open(source)))
+		{
+			return false;
+		}
+
+		std::unique_lock lock(m_Mutex);
+		const auto insertIt = std::ranges::find_if(m_Mounts, [priority](const MountedSource& other) { return other.Priority <= priority; });
+		m_Mounts.insert(insertIt, std::move(mount));
+		return true;
+	}
+
+	bool VirtualFileSystem::Unmount(const std::string& source)
+	{
+		std::unique_lock lock(m_Mutex);
+		return std::erase_if(m_Mounts, [&source](const MountedSource& mount) { return mount.Source == source; }) != 0;
+	}
+
+	bool VirtualFileSystem::Exists(std::string_view path) const
+	{
+		return Resolve(path).has_value();
+	}
+
+	std::optional<uint64_t> VirtualFileSystem::GetFileSize(std::string_view path) const
+	{
+		const std::optional<ResolvedFile> file = Resolve(path);
+		return file ? std::optional(file->Size) : std::nullopt;
+	}
+
+	std::optional<VirtualFileSystem::PakFileRef> VirtualFileSystem::FindPakFile(std::string_view path) const
+	{
+		std::optional<ResolvedFile> file = Resolve(path);
+		if (!file || !file->Pak)
+		{
+			return std::nullopt;
+		}
+		return PakFileRef{ .Pak = std::move(file->Pak), .Entry = file->Entry };
+	}
+
+	std::optional<FileData> VirtualFileSystem::ReadFile(std::string_view path) const
+	{
+		std::optional<ResolvedFile> file = Resolve(path);
+		if (!file)
+		{
+			return std::nullopt;
+		}
+		if (!file->Pak)
+		{
+			//Mapping beats a blocking read here, pages only come in as the caller touches them
+			std::shared_ptr<MappedFile> mapping = MappedFile::Open(file->LoosePath);
+			if (!mapping)
+			{
+				return std::nullopt;
+			}
+			const std::span<const std::byte> bytes = mapping->GetBytes();
+			return FileData(std::move(mapping), bytes);
+		}
+		if (file->Pak->IsStored(*file->Entry))
+		{
+			return FileData(file->Pak->GetMapping(), file->Pak->GetStoredBytes(*file->Entry));
+		}
+		std::vector<std::byte> data(file->Size);
+		if (!file->Pak->ReadFile(*file->Entry, data))
+		{
+			return std::nullopt;
+		}
+		return FileData(std::move(data));
+	}
+
+	void VirtualFileSystem::ReadFileAsync(std::string_view path, ReadCallback callback, IOPriority priority)
+	{
+		std::optional<ResolvedFile> file = Resolve(path);
+		if (!file)
+		{
+			callback(std::nullopt);
+			return;
+		}
+		if (!file->Pak)
+		{
+			m_AsyncIO.Read({
+				.Path = std::move(file->LoosePath),
+				.Priority = priority,
+				.OnComplete = [callback = std::move(callback)](FileReadResult& result)
+				{
+					callback(result.IsSuccess() ? std::optional(FileData(std::move(result.Data))) : std::nullopt);
+				}
+			});
+			return;
+		}
+		const PakFileEntry& entry = *file->Entry;
+		if (file->Pak->IsStored(entry))
+		{
+			callback(FileData(file->Pak->GetMapping(), file->Pak->GetStoredBytes(entry)));
+			return;
+		}
+
+		//Every chunk decompresses as its own task, the last one to finish hands the file over
+		struct PendingRead
+		{
+			std::shared_ptr<PakArchive> Pak;
+			const PakFileEntry* Entry = nullptr;
+			std::vector<std::byte> Data;
+			std::atomic<uint32_t> RemainingChunks = 0;
+			std::atomic<bool> bFailed = false;
+			ReadCallback Callback;
+		};
+		auto pending = std::make_shared<PendingRead>();
+		pending->Pak = std::move(file->Pak);
+		pending->Entry = &entry;
+		pending->Data.resize(entry.Size);
+		pending->RemainingChunks = entry.ChunkCount;
+		pending->Callback = std::move(callback);
+		for (uint32_t chunkIndex = 0; chunkIndex < entry.ChunkCount; chunkIndex++)
+		{
+			m_Workers.Submit([pending, chunkIndex]
+			{
+				if (!pending->bFailed && !pending->Pak->ReadChunk(*pending->Entry, chunkIndex, pending->Data))
+				{
+					pending->bFailed = true;
+				}
+				if (pending->RemainingChunks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					pending->Callback(pending->bFailed ? std::nullopt : std::optional(FileData(std::move(pending->Data))));
+				}
+			});
+		}
+	}
+
+	std::string VirtualFileSystem::NormalizePath(std::string_view path)
+	{
+		std::vector<std::string_view> segments;
+		std::string unified(path);
+		std::ranges::replace(unified, '\\', '/');
+		for (size_t begin = 0; begin <= unified.size();)
+		{
+			size_t end = unified.find('/', begin);
+			end = end == std::string::npos ? unified.size() : end;
+			const std::string_view segment = std::string_view(unified).substr(begin, end - begin);
+			if (segment == "..")
+			{
+				if (!segments.empty())
+				{
+					segments.pop_back();
+				}
+			}
+			else if (!segment.empty() && segment != ".")
+			{
+				segments.push_back(segment);
+			}
+			begin = end + 1;
+		}
+
+		std::string normalized;
+		for (const std::string_view segment : segments)
+		{
+			if (!normalized.empty())
+			{
+				normalized += '/';
+			}
+			normalized += segment;
+		}
+		return normalized;
+	}
+
+	std::optional<VirtualFileSystem::ResolvedFile> VirtualFileSystem::Resolve(std::string_view path) const
+	{
+		const std::string normalized = NormalizePath(path);
+		std::shared_lock lock(m_Mutex);
+		for (const MountedSource& mount : m_Mounts)
+		{
+			std::string_view relative = normalized;
+			if (!mount.MountPoint.empty())
+			{
+				if (!relative.starts_with(mount.MountPoint) || relative.size() <= mount.MountPoint.size() || relative[mount.MountPoint.size()] != '/')
+				{
+					continue;
+				}
+				relative.remove_prefix(mount.MountPoint.size() + 1);
+			}
+
+			if (mount.Pak)
+			{
+				if (const PakFileEntry* entry = mount.Pak->Find(relative))
+				{
+					return ResolvedFile{ .Pak = mount.Pak, .Entry = entry, .LoosePath = {}, .Size = entry->Size };
+				}
+				continue;
+			}
+			const std::filesystem::path loosePath = mount.Directory / relative;
+			std::error_code error;
+			if (std::filesystem::is_regular_file(loosePath, error))
+			{
+				const uint64_t size = std::filesystem::file_size(loosePath, error);
+				if (!error)
+				{
+					return ResolvedFile{ .Pak = nullptr, .Entry = nullptr, .LoosePath = loosePath.string(), .Size = size };
+				}
+			}
+		}
+
+		//Not normalized, so absolute paths and ones leaving the working directory still resolve
+		const std::filesystem::path osPath(path);
+		std::error_code error;
+		if (std::filesystem::is_regular_file(osPath, error))
+		{
+			const uint64_t size = std::filesystem::file_size(osPath, error);
+			if (!error)
+			{
+				return ResolvedFile{ .Pak = nullptr, .Entry = nullptr, .LoosePath = osPath.string(), .Size = size };
+			}
+		}
+		return std::nullopt;
+	}
+}
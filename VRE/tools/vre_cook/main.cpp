@@ -0,0 +1,324 @@
+// vre_cook converts source meshes (.obj, .gltf, .glb) into .vmesh files the engine loads without any parsing.
+//
+//   vre_cook [options] <file or directory>...
+//     -o <directory>   output directory, default "cooked"; directories keep their layout below it
+//     -j <count>       worker threads, default every core but one
+//     --pak <file>     also pack every cooked file into a pak archive
+//     --streamed       put positions into their own vertex stream
+//     --lods <count>   LODs per mesh including full detail, default 4
+//     --float-vertices keep 32-bit float attributes instead of quantizing them
+//     --no-optimize    keep the source triangle and vertex order
+//     --force          recook sources whose content hash didn't change
+
+#include <GltfLoader.h>
+#include <MeshCooker.h>
+#include <MeshFile.h>
+#include <ObjLoader.h>
+#include <Hash.h>
+#include <MappedFile.h>
+#include <PakArchive.h>
+#include <ThreadPool.h>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <latch>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace VRE
+{
+	struct CookJob
+	{
+		std::filesystem::path Source;
+		//Relative to the output directory
+		std::filesystem::path Output;
+	};
+
+	struct CookOptions
+	{
+		std::filesystem::path OutputDirectory = "cooked";
+		std::filesystem::path PakPath;
+		uint32_t ThreadCount = ThreadPool::GetDefaultThreadCount();
+		bool bForce = false;
+		MeshCookSettings Settings;
+	};
+
+	static bool IsGltf(const std::filesystem::path& path)
+	{
+		return path.extension() == ".gltf" || path.extension() == ".glb";
+	}
+
+	static bool IsSourceMesh(const std::filesystem::path& path)
+	{
+		return path.extension() == ".obj" || IsGltf(path);
+	}
+
+	static SourceMesh LoadSourceMesh(const std::filesystem::path& path, std::span<const std::byte> bytes)
+	{
+		if (path.extension() == ".obj")
+		{
+			return LoadObj({ reinterpret_cast<const char*>(bytes.data()), bytes.size() });
+		}
+		if (IsGltf(path))
+		{
+			//Already on a cook worker, so the glTF decodes inline; the whole scene becomes one mesh
+			const GltfFileLoader fileLoader = [](const std::string& filePath) -> std::optional<FileData>
+			{
+				std::shared_ptr<MappedFile> mapping = MappedFile::Open(filePath);
+				if (!mapping)
+				{
+					return std::nullopt;
+				}
+				const std::span<const std::byte> fileBytes = mapping->GetBytes();
+				return FileData(std::move(mapping), fileBytes);
+			};
+			return FlattenGltfScene(LoadGltf(path.string(), fileLoader, { .Cook = std::nullopt, .bLoadImages = false }));
+		}
+		throw std::runtime_error("Unsupported source format!");
+	}
+
+	//Covers the source file and, for glTF, the buffers and images next to it
+	static uint64_t HashSource(const std::filesystem::path& path, std::span<const std::byte> bytes, uint64_t seed)
+	{
+		uint64_t hash = HashBytes(bytes, seed);
+		if (IsGltf(path))
+		{
+			for (const std::string& dependency : GetGltfDependencies(bytes))
+			{
+				const std::shared_ptr<MappedFile> mapping = MappedFile::Open((path.parent_path() / dependency).string());
+				if (!mapping)
+				{
+					throw std::runtime_error("Could not open " + dependency + "!");
+				}
+				hash = HashBytes(mapping->GetBytes(), hash);
+			}
+		}
+		return hash;
+	}
+
+	static bool IsUpToDate(const std::filesystem::path& output, uint64_t sourceHash)
+	{
+		std::shared_ptr<MappedFile> mapping = MappedFile::Open(output.string());
+		if (!mapping)
+		{
+			return false;
+		}
+		const std::span<const std::byte> bytes = mapping->GetBytes();
+		const std::shared_ptr<MeshFile> mesh = MeshFile::Load(FileData(std::move(mapping), bytes));
+		return mesh && mesh->GetHeader().SourceHash == sourceHash;
+	}
+
+	static void WriteFile(const std::filesystem::path& path, std::span<const std::byte> data)
+	{
+		std::filesystem::create_directories(path.parent_path());
+		//Written next to the target and renamed, so an interrupted cook never leaves a truncated file that looks valid
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			if (!file)
+			{
+				throw std::runtime_error("Could not write " + temporaryPath.string() + "!");
+			}
+		}
+		std::filesystem::rename(temporaryPath, path);
+	}
+
+	enum class CookResult
+	{
+		Cooked,
+		UpToDate,
+		Failed
+	};
+
+	static CookResult Cook(const CookJob& job, const CookOptions& options, std::string& message)
+	{
+		try
+		{
+			const std::shared_ptr<MappedFile> source = MappedFile::Open(job.Source.string());
+			if (!source)
+			{
+				throw std::runtime_error("Could not open source!");
+			}
+			const uint64_t sourceHash = HashSource(job.Source, source->GetBytes(), HashCookSettings(options.Settings));
+			const std::filesystem::path output = options.OutputDirectory / job.Output;
+			if (!options.bForce && IsUpToDate(output, sourceHash))
+			{
+				return CookResult::UpToDate;
+			}
+
+			const SourceMesh mesh = LoadSourceMesh(job.Source, source->GetBytes());
+			MeshCookStatistics statistics;
+			const std::vector<std::byte> cooked = CookMesh(mesh, options.Settings, sourceHash, &statistics);
+			WriteFile(output, cooked);
+			const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(cooked.data());
+			const auto format = [](float value) { char text[16]; std::snprintf(text, sizeof(text), "%.2f", value); return std::string(text); };
+			message = std::to_string(header->VertexCount) + " vertices, " + std::to_string(header->IndexCount / 3) + " triangles in "
+				+ std::to_string(header->LodCount) + " LODs, " + std::to_string(header->MeshletCount) + " meshlets, ACMR "
+				+ format(statistics.Before.Acmr) + " -> " + format(statistics.After.Acmr) + ", ATVR " + format(statistics.Before.Atvr)
+				+ " -> " + format(statistics.After.Atvr);
+			return CookResult::Cooked;
+		}
+		catch (const std::exception& e)
+		{
+			message = e.what();
+			return CookResult::Failed;
+		}
+	}
+
+	static std::vector<CookJob> CollectJobs(const std::vector<std::filesystem::path>& inputs)
+	{
+		std::vector<CookJob> jobs;
+		for (const std::filesystem::path& input : inputs)
+		{
+			if (std::filesystem::is_directory(input))
+			{
+				for (const auto& entry : std::filesystem::recursive_directory_iterator(input))
+				{
+					if (entry.is_regular_file() && IsSourceMesh(entry.path()))
+					{
+						jobs.push_back({ .Source = entry.path(), .Output = std::filesystem::relative(entry.path(), input).replace_extension(".vmesh") });
+					}
+				}
+			}
+			else
+			{
+				jobs.push_back({ .Source = input, .Output = input.filename().replace_extension(".vmesh") });
+			}
+		}
+		return jobs;
+	}
+
+	static bool WritePak(const std::vector<CookJob>& jobs, const CookOptions& options, ThreadPool& threadPool)
+	{
+		PakWriter writer;
+		for (const CookJob& job : jobs)
+		{
+			const std::shared_ptr<MappedFile> cooked = MappedFile::Open((options.OutputDirectory / job.Output).string());
+			if (!cooked)
+			{
+				return false;
+			}
+			const std::span<const std::byte> bytes = cooked->GetBytes();
+			writer.AddFile(job.Output.generic_string(), std::vector<std::byte>(bytes.begin(), bytes.end()));
+		}
+		return writer.Write(options.PakPath.string(), &threadPool);
+	}
+
+	static int Run(int argc, char** argv)
+	{
+		CookOptions options;
+		std::vector<std::filesystem::path> inputs;
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string_view argument = argv[i];
+			const bool bHasValue = i + 1 < argc;
+			const auto parseCount = [](std::string_view text)
+			{
+				uint32_t value = 0;
+				if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc() || value == 0)
+				{
+					throw std::runtime_error("Expected a positive number, got " + std::string(text) + "!");
+				}
+				return value;
+			};
+			if (argument == "-o" && bHasValue)
+			{
+				options.OutputDirectory = argv[++i];
+			}
+			else if (argument == "-j" && bHasValue)
+			{
+				options.ThreadCount = parseCount(argv[++i]);
+			}
+			else if (argument == "--pak" && bHasValue)
+			{
+				options.PakPath = argv[++i];
+			}
+			else if (argument == "--lods" && bHasValue)
+			{
+				options.Settings.MaxLodCount = parseCount(argv[++i]);
+			}
+			else if (argument == "--streamed")
+			{
+				options.Settings.VertexLayout = MeshVertexLayout::Streamed;
+			}
+			else if (argument == "--float-vertices")
+			{
+				options.Settings.VertexFormat = MeshVertexFormat::Float;
+			}
+			else if (argument == "--no-optimize")
+			{
+				options.Settings.bOptimize = false;
+			}
+			else if (argument == "--force")
+			{
+				options.bForce = true;
+			}
+			else if (argument.starts_with("-"))
+			{
+				throw std::runtime_error("Unknown option " + std::string(argument) + "!");
+			}
+			else
+			{
+				inputs.emplace_back(argument);
+			}
+		}
+		if (inputs.empty())
+		{
+			std::cerr << "Usage: vre_cook [-o directory] [-j count] [--pak file] [--streamed] [--float-vertices] [--lods count] [--no-optimize] [--force] <file or directory>...\n";
+			return EXIT_FAILURE;
+		}
+
+		const std::vector<CookJob> jobs = CollectJobs(inputs);
+		ThreadPool threadPool(options.ThreadCount);
+		std::mutex outputMutex;
+		std::atomic<uint32_t> counts[3] = {};
+		std::latch done(static_cast<std::ptrdiff_t>(jobs.size()));
+		for (const CookJob& job : jobs)
+		{
+			threadPool.Submit([&, job]
+			{
+				std::string message;
+				const CookResult result = Cook(job, options, message);
+				counts[static_cast<uint32_t>(result)]++;
+				if (result != CookResult::UpToDate)
+				{
+					std::lock_guard lock(outputMutex);
+					(result == CookResult::Failed ? std::cerr : std::cout) << (result == CookResult::Failed ? "failed " : "cooked ")
+						<< job.Source.string() << ": " << message << "\n";
+				}
+				done.count_down();
+			});
+		}
+		done.wait();
+
+		const uint32_t failed = counts[static_cast<uint32_t>(CookResult::Failed)];
+		std::cout << counts[static_cast<uint32_t>(CookResult::Cooked)] << " cooked, " << counts[static_cast<uint32_t>(CookResult::UpToDate)]
+			<< " up to date, " << failed << " failed\n";
+		if (failed == 0 && !options.PakPath.empty() && !WritePak(jobs, options, threadPool))
+		{
+			std::cerr << "Could not write " << options.PakPath.string() << "\n";
+			return EXIT_FAILURE;
+		}
+		return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		return VRE::Run(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+}
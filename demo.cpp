@@ -1,8 +1,12 @@
 #include <iostream>
 #include <Application.h>
 
-int main() {
+int main(int argc, char* argv[]) {
 	VRE::Application MyApplication;
+	//Optional glTF scene to draw, e.g. demo Sponza/glTF/Sponza.gltf
+	if (argc > 1) {
+		MyApplication.SetScenePath(argv[1]);
+	}
 	try {
 		MyApplication.Run();
 	}